@@ -2,23 +2,12 @@
 
 cd ../..
 
-for run in 1
+# Each run mode builds its topology once, then the loads run on all the
+# processors and append their results to one CSV file per transport
+for trans in DcTcp Tcp
 do
-
-    for load in 0.5 0.8
-	do
-		for trans in DcTcp Tcp
-		do
-			for runMode in Conga Conga-flow ECMP 
-			do
-                nohup ./waf --run "conga-simulation-large --spineCount=2 --leafCount=2 --serverCount=32 --linkCount=2 --spineLeafCapacity=40 --leafServerCapacity=10 --asym=true --runMode=$runMode --transportProt=$trans --randomSeed=$run --cdfFileName=examples/load-balance/VL2_CDF.txt --load=$load" > /tmp/large-conga-$runMode-$trans-$load-$run.out 2>&1 &
-			done
-            for runMode in Presto DRB 
-            do
-				nohup ./waf --run "conga-simulation-large --spineCount=2 --leafCount=2 --serverCount=32 --linkCount=2 --spineLeafCapacity=40 --leafServerCapacity=10 --asym=true --runMode=$runMode --transportProt=$trans --resequenceBuffer=true --randomSeed=$run --cdfFileName=examples/load-balance/VL2_CDF.txt --load=$load" > /tmp/large-conga-$runMode-$trans-$load-$run.out 2>&1 &
-			done
-        done
-	done
+    nohup ./waf --run "conga-simulation-large --spineCount=2 --leafCount=2 --serverCount=32 --linkCount=2 --spineLeafCapacity=40 --leafServerCapacity=10 --asym=true --sweepModes=Conga,Conga-flow,ECMP --transportProt=$trans --sweepSeeds=1 --cdfFileName=examples/load-balance/VL2_CDF.txt --sweepLoads=0.5,0.8 --sweepResults=/tmp/large-conga-2x2-asym-$trans-sweep-results.csv" > /tmp/large-conga-2x2-asym-$trans.out 2>&1
+    nohup ./waf --run "conga-simulation-large --spineCount=2 --leafCount=2 --serverCount=32 --linkCount=2 --spineLeafCapacity=40 --leafServerCapacity=10 --asym=true --sweepModes=Presto,DRB --transportProt=$trans --resequenceBuffer=true --sweepSeeds=1 --cdfFileName=examples/load-balance/VL2_CDF.txt --sweepLoads=0.5,0.8 --sweepResults=/tmp/large-conga-2x2-asym-$trans-rb-sweep-results.csv" > /tmp/large-conga-2x2-asym-$trans-rb.out 2>&1
 done
 
 exit
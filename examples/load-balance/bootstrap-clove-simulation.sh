@@ -8,19 +8,15 @@ export LD_LIBRARY_PATH=$LD_LIBRARY_PATH:../..
 
 echo "Starting Simulation: $1"
 
-for seed in {21..25}
+# The topology is built once per Clove run mode, then the seeds and loads
+# run on all the processors
+for CloveRunMode in 0  1
 do
-    for CloveRunMode in 0  1
-    do
-        for Ld in 0.4 0.6
-        do
-           nohup ./ns3-dev-conga-simulation-large-optimized --ID=$1 --runMode=Clove --cloveRunMode=$CloveRunMode --cloveDisToUncongestedPath=false --StartTime=0 --EndTime=7 --FlowLaunchEndTime=2 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --transportProt=DcTcp --cdfFileName=../../../examples/load-balance/DCTCP_CDF.txt --load=$Ld --randomSeed=$seed > /dev/null 2>&1 &
- #          nohup ./ns3-dev-conga-simulation-large-optimized --ID=$1 --runMode=Clove --cloveRunMode=$CloveRunMode --cloveDisToUncongestedPath=true --StartTime=0 --EndTime=7 --FlowLaunchEndTime=2 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --transportProt=DcTcp --cdfFileName=../../../examples/load-balance/VL2_CDF.txt --load=$Ld --randomSeed=$seed > /dev/null 2>&1 &
-        #  nohup ./ns3-dev-conga-simulation-large-optimized --ID=$1 --runMode=TLB --StartTime=0 --EndTime=3 --FlowLaunchEndTime=0.5 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --TLBRunMode=12 --TLBSmooth=true --TLBProbingEnable=true --TLBMinRTT=63 --TLBT1=66 --TLBRerouting=true --TcpPause=false --TLBProbingInterval=500 --transportProt=DcTcp  --TLBBetterPathRTT=100 --TLBHighRTT=180 --TLBS=640000 --cdfFileName=../../../examples/load-balance/VL2_CDF.txt --load=$Ld --asymCapacity=false --asymCapacityPoss=20 --randomSeed=$seed > /dev/null 2>&1 &
- #          nohup ./ns3-dev-conga-simulation-large-optimized --ID=$1 --runMode=ECMP --StartTime=0 --EndTime=3 --FlowLaunchEndTime=0.5 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --transportProt=DcTcp --cdfFileName=../../../examples/load-balance/VL2_CDF.txt --load=$Ld --asymCapacity=false --asymCapacityPoss=20 --randomSeed=$seed > /dev/null 2>&1 &
-  #         nohup ./ns3-dev-conga-simulation-large-optimized --ID=$1 --runMode=Conga --StartTime=0 --EndTime=3 --FlowLaunchEndTime=0.5 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --transportProt=DcTcp --cdfFileName=../../../examples/load-balance/VL2_CDF.txt --load=$Ld --asymCapacity=false --asymCapacityPoss=20 --randomSeed=$seed > /dev/null 2>&1 &
-        done
-    done
+    ./ns3-dev-conga-simulation-large-optimized --ID=$1 --runMode=Clove --cloveRunMode=$CloveRunMode --cloveDisToUncongestedPath=false --StartTime=0 --EndTime=7 --FlowLaunchEndTime=2 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --transportProt=DcTcp --cdfFileName=../../../examples/load-balance/DCTCP_CDF.txt --sweepLoads=0.4,0.6 --sweepSeeds=21,22,23,24,25 --sweepResults=$1-clove-$CloveRunMode-sweep-results.csv > /dev/null 2>&1
+#   ./ns3-dev-conga-simulation-large-optimized --ID=$1 --runMode=Clove --cloveRunMode=$CloveRunMode --cloveDisToUncongestedPath=true --StartTime=0 --EndTime=7 --FlowLaunchEndTime=2 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --transportProt=DcTcp --cdfFileName=../../../examples/load-balance/VL2_CDF.txt --sweepLoads=0.4,0.6 --sweepSeeds=21,22,23,24,25 --sweepResults=$1-clove-$CloveRunMode-sweep-results.csv > /dev/null 2>&1
 done
+# The other load balancers on the same loads and seeds
+# ./ns3-dev-conga-simulation-large-optimized --ID=$1 --sweepModes=TLB --StartTime=0 --EndTime=3 --FlowLaunchEndTime=0.5 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --TLBRunMode=12 --TLBSmooth=true --TLBProbingEnable=true --TLBMinRTT=63 --TLBT1=66 --TLBRerouting=true --TcpPause=false --TLBProbingInterval=500 --transportProt=DcTcp  --TLBBetterPathRTT=100 --TLBHighRTT=180 --TLBS=640000 --cdfFileName=../../../examples/load-balance/VL2_CDF.txt --sweepLoads=0.4,0.6 --asymCapacity=false --asymCapacityPoss=20 --sweepSeeds=21,22,23,24,25 --sweepResults=$1-tlb-sweep-results.csv > /dev/null 2>&1
+# ./ns3-dev-conga-simulation-large-optimized --ID=$1 --sweepModes=ECMP,Conga --StartTime=0 --EndTime=3 --FlowLaunchEndTime=0.5 --leafCount=8 --spineCount=8 --leafServerCapacity=10  --serverCount=16 --transportProt=DcTcp --cdfFileName=../../../examples/load-balance/VL2_CDF.txt --sweepLoads=0.4,0.6 --asymCapacity=false --asymCapacityPoss=20 --sweepSeeds=21,22,23,24,25 --sweepResults=$1-ecmp-conga-sweep-results.csv > /dev/null 2>&1
 exit
 
@@ -2,16 +2,10 @@
 
 cd ../..
 
-for run in 1
+# The topology is built once per T, then the loads run on all the processors
+for T in 0.05 0.10 0.15 0.20 0.25 0.5
 do
-
-    for load in 0.5 0.8
-	do
-        for T in 0.05 0.10 0.15 0.20 0.25 0.5
-        do
-            nohup ./waf --run "conga-simulation-large --runMode=FlowBender --flowBenderT=$T --transportProt=DcTcp --randomSeed=$run --cdfFileName=examples/load-balance/VL2_CDF.txt --load=$load" > /tmp/large-conga-flowBender-DcTcp-$T-$load-$run.out 2>&1 &
-		done
-	done
+    nohup ./waf --run "conga-simulation-large --runMode=FlowBender --flowBenderT=$T --transportProt=DcTcp --sweepSeeds=1 --cdfFileName=examples/load-balance/VL2_CDF.txt --sweepLoads=0.5,0.8 --sweepResults=/tmp/large-conga-flowBender-DcTcp-$T-sweep-results.csv" > /tmp/large-conga-flowBender-DcTcp-$T.out 2>&1
 done
 
 exit
@@ -2,19 +2,11 @@
 
 cd ../..
 
-for run in 1
+# Each run mode builds its topology once, then the seeds and loads run on
+# all the processors and append their results to one CSV file
+for trans in DcTcp Tcp
 do
-
-        for load in 0.3 0.5 0.8
-	do
-		for trans in DcTcp Tcp
-		do
-			for runMode in Conga Conga-flow ECMP Presto
-			do
-				nohup ./waf --run "conga-simulation-large --runMode=$runMode --transportProt=$trans --randomSeed=$run --cdfFileName=examples/load-balance/VL2_CDF.txt --load=$load" > /tmp/large-conga-$runMode-$trans-$load-$run.out 2>&1 &
-			done
-		done
-	done
+	nohup ./waf --run "conga-simulation-large --ID=$trans --sweepModes=Conga,Conga-flow,ECMP,Presto --transportProt=$trans --sweepSeeds=1 --cdfFileName=examples/load-balance/VL2_CDF.txt --sweepLoads=0.3,0.5,0.8" > /tmp/large-conga-$trans.out 2>&1
 done
 
 exit
@@ -10,6 +10,10 @@
 #include "ns3/ipv4-drb-routing-helper.h"
 #include "ns3/ipv4-xpath-routing-helper.h"
 #include "ns3/ipv4-tlb.h"
+#include "ns3/tlb-bible-writer.h"
+#include "ns3/fct-recorder.h"
+#include "ns3/flow-size-random-variable.h"
+#include "ns3/flow-trace.h"
 #include "ns3/ipv4-clove.h"
 #include "ns3/ipv4-tlb-probing.h"
 #include "ns3/link-monitor-module.h"
@@ -22,12 +26,13 @@
 #include <map>
 #include <utility>
 #include <set>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
 
-// The CDF in TrafficGenerator
-extern "C"
-{
-#include "cdf.h"
-}
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #define LINK_CAPACITY_BASE    1000000000          // 1Gbps
 #define BUFFER_SIZE 600                           // 250 packets
@@ -37,7 +42,6 @@ extern "C"
 
 // The flow port range, each flow will be assigned a random port number within this range
 #define PORT_START 10000
-#define PORT_END 50000
 
 // Adopted from the simulation from WANG PENG
 // Acknowledged to https://williamcityu@bitbucket.org/williamcityu/2016-socc-simulation.git
@@ -65,77 +69,10 @@ enum RunMode {
 };
 
 std::stringstream tlbBibleFilename;
-std::stringstream tlbBibleFilename2;
+TLBBibleWriter tlbBibleWriter;
+FctRecorder fctRecorder;
 std::stringstream rbTraceFilename;
 
-void TLBPathSelectTrace (uint32_t flowId, uint32_t fromTor, uint32_t destTor, uint32_t path, bool isRandom, PathInfo pathInfo, std::vector<PathInfo> parallelPaths)
-{
-    NS_LOG_UNCOND ("Flow: " << flowId << " (" << fromTor << " -> " << destTor << ") selects path: " << path << " at: " << Simulator::Now ());
-    NS_LOG_UNCOND ("\t Is random select: " << isRandom);
-    NS_LOG_UNCOND ("\t Path info: type -> " << Ipv4TLB::GetPathType (pathInfo.pathType) << ", min RTT -> " << pathInfo.rttMin
-            << ", ECN Portion -> " << pathInfo.ecnPortion << ", Flow counter -> " << pathInfo.counter
-            << ", Quantified DRE -> " << pathInfo.quantifiedDre);
-
-    NS_LOG_UNCOND ("\t Parallel path info: ");
-    std::vector<PathInfo>::iterator itr = parallelPaths.begin ();
-    for (; itr != parallelPaths.end (); ++itr)
-    {
-        struct PathInfo path = *itr;
-        NS_LOG_UNCOND ("\t\t Path info: " << path.pathId << ", type -> " << Ipv4TLB::GetPathType (path.pathType) << ", min RTT -> " << path.rttMin
-            << ", Path size -> " << path.size << ", ECN Portion -> " << path.ecnPortion << ", Flow counter -> " << path.counter
-            << ", Quantified DRE -> " << path.quantifiedDre);
-    }
-    NS_LOG_UNCOND ("\n");
-
-    std::ofstream out (tlbBibleFilename.str ().c_str (), std::ios::out|std::ios::app);
-    out << "Flow: " << flowId << " (" << fromTor << " -> " << destTor << ") selects path: " << path << " at: " << Simulator::Now () << std::endl;
-    out << "\t Is random select: " << isRandom << std::endl;
-    out << "\t Path info: type -> " << Ipv4TLB::GetPathType (pathInfo.pathType) << ", min RTT -> " << pathInfo.rttMin
-            << ", ECN Portion -> " << pathInfo.ecnPortion << ", Flow counter -> " << pathInfo.counter
-            << ", Quantified DRE -> " << pathInfo.quantifiedDre << std::endl;
-
-    out << "\t Parallel path info: " << std::endl;
-    itr = parallelPaths.begin ();
-    for (; itr != parallelPaths.end (); ++itr)
-    {
-        struct PathInfo path = *itr;
-        out << "\t\t Path info: " << path.pathId << ", type -> " << Ipv4TLB::GetPathType (path.pathType) << ", min RTT -> " << path.rttMin
-            << ", Path size -> " << path.size << ", ECN Portion -> " << path.ecnPortion << ", Flow counter -> " << path.counter
-            << ", Quantified DRE -> " << path.quantifiedDre << std::endl;
-    }
-    out << std::endl;
-}
-
-void TLBPathChangeTrace (uint32_t flowId, uint32_t fromTor, uint32_t destTor, uint32_t newPath, uint32_t oldPath, bool isRandom, std::vector<PathInfo> parallelPaths)
-{
-    NS_LOG_UNCOND ("Flow: " << flowId << " (" << fromTor << " -> " << destTor << ") changes path from: " << oldPath << " to " << newPath << " at: " << Simulator::Now ());
-    NS_LOG_UNCOND ("\t Is random select: " << isRandom);
-    NS_LOG_UNCOND ("\t Parallel path info: ");
-    std::vector<PathInfo>::iterator itr = parallelPaths.begin ();
-    for (; itr != parallelPaths.end (); ++itr)
-    {
-        struct PathInfo path = *itr;
-        NS_LOG_UNCOND ("\t\t Path info: " << path.pathId << ", type -> " << Ipv4TLB::GetPathType (path.pathType) << ", min RTT -> " << path.rttMin
-            << ", Path size -> " << path.size << ", ECN Portion -> " << path.ecnPortion << ", Flow counter -> " << path.counter
-            << ", Quantified DRE -> " << path.quantifiedDre);
-    }
-    NS_LOG_UNCOND ("\n");
-
-    std::ofstream out (tlbBibleFilename2.str ().c_str (), std::ios::out|std::ios::app);
-    out << "Flow: " << flowId << " (" << fromTor << " -> " << destTor << ") changes path from: " << oldPath << " to " << newPath << " at: " << Simulator::Now ();
-    out << "\t Is random select: " << isRandom << std::endl;
-    out << "\t Parallel path info: " << std::endl;
-    itr = parallelPaths.begin ();
-    for (; itr != parallelPaths.end (); ++itr)
-    {
-        struct PathInfo path = *itr;
-        out << "\t\t Path info: " << path.pathId << ", type -> " << Ipv4TLB::GetPathType (path.pathType) << ", min RTT -> " << path.rttMin
-            << ", Path size -> " << path.size << ", ECN Portion -> " << path.ecnPortion << ", Flow counter -> " << path.counter
-            << ", Quantified DRE -> " << path.quantifiedDre << std::endl;
-    }
-    out << std::endl;
-}
-
 void RBTraceBuffer (uint32_t flowId, Time time, SequenceNumber32 revSeq, SequenceNumber32 expectSeq)
 {
     NS_LOG_UNCOND ("Flow: " << flowId << " (at time: " << time << "), receives: " << revSeq << ", while expecting: " << expectSeq);
@@ -158,77 +95,252 @@ void RBTrace (void)
     Config::ConnectWithoutContext ("/NodeList/*/$ns3::TcpL4Protocol/SocketList/*/ResequenceBufferPointer/Flush", MakeCallback (&RBTraceFlush));
 }
 
-// Port from Traffic Generator
-// Acknowledged to https://github.com/HKUST-SING/TrafficGenerator/blob/master/src/common/common.c
-double poission_gen_interval(double avg_rate)
+// Records the scheduler operations for utils/bench-scheduler, one 17 bytes
+// record per operation: the op ('i' insert, 'n' remove next, 'r' remove),
+// then the uint64_t time stamp and the uint64_t uid of the event
+class EventTraceScheduler : public MapScheduler
 {
-    if (avg_rate > 0)
-       return -logf(1.0 - (double)rand() / RAND_MAX) / avg_rate;
-    else
-       return 0;
-}
+public:
+    static TypeId GetTypeId (void)
+    {
+        static TypeId tid = TypeId ("ns3::EventTraceScheduler")
+            .SetParent<MapScheduler> ()
+            .AddConstructor<EventTraceScheduler> ()
+            ;
+        return tid;
+    }
 
-template<typename T>
-T rand_range (T min, T max)
-{
-    return min + ((double)max - min) * rand () / RAND_MAX;
-}
+    static std::ofstream s_out;
+    static uint64_t s_limit;
+
+    virtual void Insert (const Scheduler::Event &ev)
+    {
+        Record ('i', ev);
+        MapScheduler::Insert (ev);
+    }
+
+    virtual Scheduler::Event RemoveNext (void)
+    {
+        Scheduler::Event ev = MapScheduler::RemoveNext ();
+        Record ('n', ev);
+        return ev;
+    }
+
+    virtual void Remove (const Scheduler::Event &ev)
+    {
+        Record ('r', ev);
+        MapScheduler::Remove (ev);
+    }
 
-void install_applications (int fromLeafId, NodeContainer servers, double requestRate, struct cdf_table *cdfTable,
-        long &flowCount, long &totalFlowSize, int SERVER_COUNT, int LEAF_COUNT, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME, uint32_t applicationPauseThresh, uint32_t applicationPauseTime)
+private:
+    void Record (char op, const Scheduler::Event &ev)
+    {
+        if (s_limit == 0 || !s_out.is_open ())
+        {
+            return;
+        }
+        s_limit--;
+        s_out.write (&op, sizeof (op));
+        s_out.write (reinterpret_cast<const char *> (&ev.key.m_ts), sizeof (ev.key.m_ts));
+        s_out.write (reinterpret_cast<const char *> (&ev.key.m_uid), sizeof (ev.key.m_uid));
+    }
+};
+
+std::ofstream EventTraceScheduler::s_out;
+uint64_t EventTraceScheduler::s_limit = 0;
+
+NS_OBJECT_ENSURE_REGISTERED (EventTraceScheduler);
+
+void install_applications (int fromLeafId, NodeContainer servers, double requestRate, std::string cdfFileName,
+        std::vector<Ptr<FlowWorkloadGenerator> > &generators, int SERVER_COUNT, int LEAF_COUNT, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME, uint32_t applicationPauseThresh, uint32_t applicationPauseTime)
 {
     NS_LOG_INFO ("Install applications:");
     for (int i = 0; i < SERVER_COUNT; i++)
     {
         int fromServerIndex = fromLeafId * SERVER_COUNT + i;
 
-        double startTime = START_TIME + poission_gen_interval (requestRate);
-        while (startTime < FLOW_LAUNCH_END_TIME)
+        Ptr<ExponentialRandomVariable> interArrival = CreateObject<ExponentialRandomVariable> ();
+        interArrival->SetAttribute ("Mean", DoubleValue (1 / requestRate));
+
+        Ptr<FlowWorkloadGenerator> generator = CreateObject<FlowWorkloadGenerator> ();
+        generator->SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
+        generator->SetAttribute ("InterArrival", PointerValue (interArrival));
+        Ptr<FlowSizeRandomVariable> flowSize = CreateObject<FlowSizeRandomVariable> ();
+        flowSize->SetAttribute ("CdfFile", StringValue (cdfFileName));
+        generator->SetAttribute ("FlowSize", PointerValue (flowSize));
+        generator->SetAttribute ("LaunchEnd", TimeValue (Seconds (FLOW_LAUNCH_END_TIME)));
+        generator->SetAttribute ("DelayThresh", UintegerValue (applicationPauseThresh));
+        generator->SetAttribute ("DelayTime", TimeValue (MicroSeconds (applicationPauseTime)));
+
+        // Every server of the other leaves listens on PORT_START
+        for (int destServerIndex = 0; destServerIndex < SERVER_COUNT * LEAF_COUNT; destServerIndex++)
+        {
+            if (destServerIndex / SERVER_COUNT == fromLeafId)
+            {
+                continue;
+            }
+            Ptr<Ipv4> ipv4 = servers.Get (destServerIndex)->GetObject<Ipv4> ();
+            Ipv4Address destAddress = ipv4->GetAddress (1, 0).GetLocal ();
+            generator->AddDestination (InetSocketAddress (destAddress, PORT_START));
+        }
+
+        servers.Get (fromServerIndex)->AddApplication (generator);
+        generator->SetStartTime (Seconds (START_TIME));
+        generator->SetStopTime (Seconds (END_TIME));
+        generators.push_back (generator);
+    }
+}
+
+// Parse a comma separated list of sweep values, an empty list keeps the
+// value of the single run
+template <typename T>
+std::vector<T> parse_sweep_list (std::string list, T single)
+{
+    std::vector<T> values;
+    std::stringstream items (list);
+    std::string item;
+    while (std::getline (items, item, ','))
+    {
+        std::istringstream input (item);
+        T value;
+        if (!(input >> value))
         {
-            flowCount ++;
-            uint16_t port = rand_range (PORT_START, PORT_END);
+            NS_FATAL_ERROR ("Invalid sweep value: " << item);
+        }
+        values.push_back (value);
+    }
+    if (values.empty ())
+    {
+        values.push_back (single);
+    }
+    return values;
+}
 
-            int destServerIndex = fromServerIndex;
-	        while (destServerIndex >= fromLeafId * SERVER_COUNT && destServerIndex < fromLeafId * SERVER_COUNT + SERVER_COUNT)
+// Wait for a sweep worker, returns false if it failed or crashed
+bool wait_sweep_worker (void)
+{
+    int status;
+    pid_t pid = wait (&status);
+    if (pid < 0)
+    {
+        NS_LOG_ERROR ("Cannot wait for the sweep workers");
+        return false;
+    }
+    if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+        NS_LOG_ERROR ("Sweep worker " << pid << " failed");
+        return false;
+    }
+    return true;
+}
+
+// Fork one worker per sweep point, at most jobs at a time. Returns the point
+// in the worker, and -1 in the parent once all the workers have exited, with
+// the number of the workers which failed in failures.
+int fork_sweep_workers (uint32_t count, uint32_t jobs, uint32_t &failures)
+{
+    failures = 0;
+    uint32_t running = 0;
+    for (uint32_t point = 0; point < count; point++)
+    {
+        if (running == jobs)
+        {
+            if (!wait_sweep_worker ())
             {
-		        destServerIndex = rand_range (0, SERVER_COUNT * LEAF_COUNT);
+                failures++;
             }
+            running--;
+        }
+        // Otherwise the worker prints the buffered output again
+        std::cout.flush ();
+        pid_t pid = fork ();
+        if (pid < 0)
+        {
+            NS_FATAL_ERROR ("Cannot fork the sweep worker " << point);
+        }
+        if (pid == 0)
+        {
+            return point;
+        }
+        running++;
+    }
+    while (running > 0)
+    {
+        if (!wait_sweep_worker ())
+        {
+            failures++;
+        }
+        running--;
+    }
+    return -1;
+}
+
+// Append a line to the sweep results with a single write, so that the lines
+// of concurrent workers do not interleave
+void append_sweep_results (std::string filename, std::string line)
+{
+    int fd = open (filename.c_str (), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0 || write (fd, line.c_str (), line.size ()) != static_cast<ssize_t> (line.size ()))
+    {
+        NS_LOG_ERROR ("Cannot write the sweep results to " << filename);
+    }
+    if (fd >= 0)
+    {
+        close (fd);
+    }
+}
 
-	        Ptr<Node> destServer = servers.Get (destServerIndex);
-	        Ptr<Ipv4> ipv4 = destServer->GetObject<Ipv4> ();
-	        Ipv4InterfaceAddress destInterface = ipv4->GetAddress (1,0);
-	        Ipv4Address destAddress = destInterface.GetLocal ();
-
-            BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (destAddress, port));
-            uint32_t flowSize = gen_random_cdf (cdfTable);
-
-            totalFlowSize += flowSize;
- 	        source.SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
-            source.SetAttribute ("MaxBytes", UintegerValue(flowSize));
-            source.SetAttribute ("DelayThresh", UintegerValue (applicationPauseThresh));
-            source.SetAttribute ("DelayTime", TimeValue (MicroSeconds (applicationPauseTime)));
-
-            // Install apps
-            ApplicationContainer sourceApp = source.Install (servers.Get (fromServerIndex));
-            sourceApp.Start (Seconds (startTime));
-            sourceApp.Stop (Seconds (END_TIME));
-
-            // Install packet sinks
-            PacketSinkHelper sink ("ns3::TcpSocketFactory",
-                    InetSocketAddress (Ipv4Address::GetAny (), port));
-            ApplicationContainer sinkApp = sink.Install (servers. Get (destServerIndex));
-            sinkApp.Start (Seconds (START_TIME));
-            sinkApp.Stop (Seconds (END_TIME));
-
-            /*
-            NS_LOG_INFO ("\tFlow from server: " << fromServerIndex << " to server: "
-                    << destServerIndex << " on port: " << port << " with flow size: "
-                    << flowSize << " [start time: " << startTime <<"]");
-            */
-
-            startTime += poission_gen_interval (requestRate);
+// The sweep results hold one row per run: its parameters, the run time and,
+// for each flow size bucket of the FctRecorder, the flow count, the FCT and
+// the slowdown
+std::string sweep_results_header (const FctRecorder &recorder)
+{
+    std::stringstream header;
+    header << "mode,transport,workload,load,seed,flows,completed,run_s";
+    for (uint32_t bucket = 0; bucket < recorder.GetBucketCount (); bucket++)
+    {
+        header << ",b" << bucket << "_flows"
+               << ",b" << bucket << "_fct_avg_us"
+               << ",b" << bucket << "_fct_p50_us"
+               << ",b" << bucket << "_fct_p99_us"
+               << ",b" << bucket << "_fct_p999_us"
+               << ",b" << bucket << "_slowdown_avg"
+               << ",b" << bucket << "_slowdown_p99";
+    }
+    header << std::endl;
+    return header.str ();
+}
+
+std::string sweep_results_row (const FctRecorder &recorder)
+{
+    std::stringstream row;
+    for (uint32_t bucket = 0; bucket < recorder.GetBucketCount (); bucket++)
+    {
+        const QuantileSketch &fct = recorder.GetFctSketch (bucket);
+        const QuantileSketch &slowdown = recorder.GetSlowdownSketch (bucket);
+        row << "," << fct.Count ();
+        if (fct.Count () != 0)
+        {
+            row << "," << fct.Avg () * 1e6
+                << "," << fct.GetQuantile (0.5) * 1e6
+                << "," << fct.GetQuantile (0.99) * 1e6
+                << "," << fct.GetQuantile (0.999) * 1e6;
+        }
+        else
+        {
+            row << ",,,,";
+        }
+        if (slowdown.Count () != 0)
+        {
+            row << "," << slowdown.Avg ()
+                << "," << slowdown.GetQuantile (0.99);
+        }
+        else
+        {
+            row << ",,";
         }
     }
+    return row.str ();
 }
 
 int main (int argc, char *argv[])
@@ -263,6 +375,13 @@ int main (int argc, char *argv[])
     uint32_t resequenceOutOrderTimer = 100; // MicroSeconds
     bool resequenceBufferLog = false;
 
+    bool prestoFlowcell = false;
+
+    bool enableFlowMonitor = true;
+    bool flowMonitorLight = false;
+    bool fctCsv = false;
+    bool linkMonitorText = false;
+
     double flowBenderT = 0.05;
     uint32_t flowBenderN = 1;
 
@@ -325,6 +444,18 @@ int main (int argc, char *argv[])
 
     bool enableFastReConnection = false;
 
+    std::string flowTrace = "";
+
+    std::string eventTrace = "";
+    uint64_t eventTraceLimit = 10000000;
+
+    std::string sweepModes = "";
+    std::string sweepSeeds = "";
+    std::string sweepLoads = "";
+    std::string sweepWorkloads = "";
+    uint32_t sweepJobs = 0;
+    std::string sweepResults = "";
+
     CommandLine cmd;
     cmd.AddValue ("ID", "Running ID", id);
     cmd.AddValue ("StartTime", "Start time of the simulation", START_TIME);
@@ -338,11 +469,17 @@ int main (int argc, char *argv[])
     cmd.AddValue ("linkLatency", "Link latency, should be in MicroSeconds", linkLatency);
 
     cmd.AddValue ("resequenceBuffer", "Whether enabling the resequence buffer", resequenceBuffer);
+    cmd.AddValue ("prestoFlowcell", "Presto sends 64KB flowcells instead of spraying packets and the receiver merges them with GRO", prestoFlowcell);
     cmd.AddValue ("resequenceInOrderTimer", "In order queue timeout in resequence buffer", resequenceInOrderTimer);
     cmd.AddValue ("resequenceOutOrderTimer", "Out order queue timeout in resequence buffer", resequenceOutOrderTimer);
     cmd.AddValue ("resequenceInOrderSize", "In order queue size in resequence buffer", resequenceInOrderSize);
     cmd.AddValue ("resequenceBufferLog", "Whether enabling the resequence buffer logging system", resequenceBufferLog);
 
+    cmd.AddValue ("enableFlowMonitor", "Whether writing the flow monitor XML file", enableFlowMonitor);
+    cmd.AddValue ("flowMonitorLight", "Whether the flow monitor only records the flow counters and times", flowMonitorLight);
+    cmd.AddValue ("fctCsv", "Whether writing the flow completion times as CSV instead of binary", fctCsv);
+    cmd.AddValue ("linkMonitorText", "Whether writing the link utility as text, kept in memory until the end, instead of streaming it as binary", linkMonitorText);
+
     cmd.AddValue ("asymCapacity", "Whether the capacity is asym, which means some link will have only 1/10 the capacity of others", asymCapacity);
     cmd.AddValue ("asymCapacityPoss", "The possibility that a path will have only 1/10 capacity", asymCapacityPoss);
 
@@ -406,8 +543,68 @@ int main (int argc, char *argv[])
     cmd.AddValue ("enableFastReConnection", "Whether the SYN gap will be very small when reconnecting", enableFastReConnection);
     cmd.AddValue ("enableLargeDataRetries", "Whether the data retransmission will be more than 6 times", enableLargeDataRetries);
 
+    cmd.AddValue ("flowTrace", "Binary flow trace replayed instead of the flows drawn from the CDF, the hosts being the servers in order", flowTrace);
+
+    cmd.AddValue ("eventTrace", "File recording the scheduler operations for utils/bench-scheduler, empty to disable", eventTrace);
+    cmd.AddValue ("eventTraceLimit", "Number of scheduler operations recorded", eventTraceLimit);
+
+    cmd.AddValue ("sweepModes", "Comma separated run modes of a sweep, instead of runMode", sweepModes);
+    cmd.AddValue ("sweepSeeds", "Comma separated random seeds of a sweep, instead of randomSeed", sweepSeeds);
+    cmd.AddValue ("sweepLoads", "Comma separated loads of a sweep, instead of load", sweepLoads);
+    cmd.AddValue ("sweepWorkloads", "Comma separated CDF file names of a sweep, instead of cdfFileName", sweepWorkloads);
+    cmd.AddValue ("sweepJobs", "Number of sweep runs at the same time, 0 for one per processor", sweepJobs);
+    cmd.AddValue ("sweepResults", "File name of the sweep results, <ID>-sweep-results.csv by default", sweepResults);
+
     cmd.Parse (argc, argv);
 
+    // A sweep builds the topology and the routes once per run mode, in a
+    // process of its own, which then forks a worker per seed, load and
+    // workload. The run modes are built one after the other.
+    bool sweep = sweepModes != "" || sweepSeeds != "" || sweepLoads != "" || sweepWorkloads != "";
+    std::vector<std::string> modes = parse_sweep_list (sweepModes, runModeStr);
+    std::vector<unsigned> seeds = parse_sweep_list (sweepSeeds, randomSeed);
+    std::vector<double> loads = parse_sweep_list (sweepLoads, load);
+    std::vector<std::string> workloads = parse_sweep_list (sweepWorkloads, cdfFileName);
+    if (sweep)
+    {
+        if (eventTrace != "")
+        {
+            NS_FATAL_ERROR ("The event trace records a single run, not a sweep");
+        }
+        if (sweepJobs == 0)
+        {
+            sweepJobs = std::max (1L, sysconf (_SC_NPROCESSORS_ONLN));
+        }
+        if (sweepResults == "")
+        {
+            sweepResults = id + "-sweep-results.csv";
+        }
+        remove (sweepResults.c_str ());
+        append_sweep_results (sweepResults, sweep_results_header (fctRecorder));
+
+        uint32_t failures;
+        int mode = fork_sweep_workers (modes.size (), 1, failures);
+        if (mode < 0)
+        {
+            NS_LOG_INFO ("Sweep results: " << sweepResults);
+            if (failures > 0)
+            {
+                NS_LOG_ERROR (failures << " of the " << modes.size () << " run modes had failed runs");
+                return 1;
+            }
+            return 0;
+        }
+        runModeStr = modes[mode];
+    }
+
+    if (eventTrace != "")
+    {
+        EventTraceScheduler::s_out.open (eventTrace.c_str (), std::ios::out | std::ios::binary);
+        EventTraceScheduler::s_limit = eventTraceLimit;
+        ObjectFactory schedulerFactory ("ns3::EventTraceScheduler");
+        Simulator::SetScheduler (schedulerFactory);
+    }
+
     uint64_t SPINE_LEAF_CAPACITY = spineLeafCapacity * LINK_CAPACITY_BASE;
     uint64_t LEAF_SERVER_CAPACITY = leafServerCapacity * LINK_CAPACITY_BASE;
     Time LINK_LATENCY = MicroSeconds (linkLatency);
@@ -493,6 +690,17 @@ int main (int argc, char *argv[])
         return 0;
     }
 
+    if (prestoFlowcell)
+    {
+        if (runMode != PRESTO && runMode != WEIGHTED_PRESTO)
+        {
+            NS_LOG_ERROR ("The flowcells can only be used with Presto and Weighted-Presto");
+            return 0;
+        }
+        // The GRO stage lives in the resequence buffer
+        resequenceBuffer = true;
+    }
+
     if (load < 0.0 || load >= 1.0)
     {
         NS_LOG_ERROR ("The network load should within 0.0 and 1.0");
@@ -519,6 +727,18 @@ int main (int argc, char *argv[])
         Config::SetDefault ("ns3::TcpResequenceBuffer::OutOrderQueueTimerLimit", TimeValue (MicroSeconds (resequenceOutOrderTimer)));
     }
 
+    if (prestoFlowcell)
+    {
+        NS_LOG_INFO ("Enabling Presto flowcells and GRO");
+        Config::SetDefault ("ns3::Ipv4DrbRouting::FlowcellSize", UintegerValue (65536));
+        Config::SetDefault ("ns3::TcpResequenceBuffer::Gro", BooleanValue (true));
+        Config::SetDefault ("ns3::TcpResequenceBuffer::SizeLimit", UintegerValue (65536));
+        // The merged segments are acked by stretch ACKs, which open the window
+        // by up to a flowcell, sent at once like a 64KB TSO segment
+        Config::SetDefault ("ns3::TcpNewReno::ByteCounting", BooleanValue (true));
+        Config::SetDefault ("ns3::TcpSocketBase::MaxBurst", UintegerValue (65536 / PACKET_SIZE + 1));
+    }
+
     if (runMode == TLB)
     {
         NS_LOG_INFO ("Enabling TLB");
@@ -589,6 +809,11 @@ int main (int argc, char *argv[])
         Config::SetDefault ("ns3::TcpSocket::DataRetries", UintegerValue (10000));
     }
 
+    // The load balancers and the queues draw their streams from the run as
+    // they are created, so it is set before the topology is built
+    NS_LOG_INFO ("Initialize random seed: " << randomSeed);
+    RngSeedManager::SetRun (randomSeed == 0 ? (unsigned)time (NULL) : randomSeed);
+
     NodeContainer spines;
     spines.Create (SPINE_COUNT);
     NodeContainer leaves;
@@ -622,6 +847,10 @@ int main (int argc, char *argv[])
         {
             Config::SetDefault ("ns3::Ipv4DrbRouting::Mode", UintegerValue (0)); // Per dest
         }
+        else if (prestoFlowcell)
+        {
+            Config::SetDefault ("ns3::Ipv4DrbRouting::Mode", UintegerValue (2)); // Per flowcell
+        }
         else
         {
             Config::SetDefault ("ns3::Ipv4DrbRouting::Mode", UintegerValue (1)); // Per flow
@@ -957,10 +1186,10 @@ int main (int argc, char *argv[])
 
             if (runMode == TLB || runMode == DRB || runMode == PRESTO || runMode == WEIGHTED_PRESTO || runMode == Clove)
             {
-                std::pair<int, int> leafToSpine = std::make_pair<int, int> (i, j);
+                std::pair<int, int> leafToSpine = std::make_pair (i, j);
                 leafToSpinePath[leafToSpine] = netDeviceContainer.Get (0)->GetIfIndex ();
 
-                std::pair<int, int> spineToLeaf = std::make_pair<int, int> (j, i);
+                std::pair<int, int> spineToLeaf = std::make_pair (j, i);
                 spineToLeafPath[spineToLeaf] = netDeviceContainer.Get (1)->GetIfIndex ();
             }
 
@@ -1213,19 +1442,72 @@ int main (int argc, char *argv[])
         }
     }
 
+    if (sweep)
+    {
+        NS_LOG_INFO ("Sweeping " << seeds.size () * loads.size () * workloads.size () << " runs of " << runModeStr
+                << " with " << sweepJobs << " jobs");
+        uint32_t failures;
+        int point = fork_sweep_workers (seeds.size () * loads.size () * workloads.size (), sweepJobs, failures);
+        if (point < 0)
+        {
+            // The exit status tells the parent process that runs failed
+            if (failures > 0)
+            {
+                NS_LOG_ERROR (failures << " runs of " << runModeStr << " failed");
+                return 1;
+            }
+            return 0;
+        }
+        randomSeed = seeds[point % seeds.size ()];
+        load = loads[(point / seeds.size ()) % loads.size ()];
+        cdfFileName = workloads[point / (seeds.size () * loads.size ())];
+        // The topology was built with the run of --randomSeed, the streams
+        // assigned below are drawn again from the run of this seed
+        RngSeedManager::SetRun (randomSeed == 0 ? (unsigned)time (NULL) : randomSeed);
+    }
+
+    NS_LOG_INFO ("Assign the random streams of the load balancers and the queues");
+    NodeContainer allNodes (spines, leaves, servers);
+    int64_t stream = internet.AssignStreams (allNodes, 0);
+    stream += congaRoutingHelper.AssignStreams (allNodes, stream);
+    stream += drbRoutingHelper.AssignStreams (allNodes, stream);
+    stream += drillRoutingHelper.AssignStreams (allNodes, stream);
+    stream += letFlowRoutingHelper.AssignStreams (allNodes, stream);
+    for (int i = 0; i < SERVER_COUNT * LEAF_COUNT; i++)
+    {
+        if (probings[i] != 0)
+        {
+            stream += probings[i]->AssignStreams (stream);
+        }
+    }
+    for (NodeContainer::Iterator node = allNodes.Begin (); node != allNodes.End (); ++node)
+    {
+        Ptr<TrafficControlLayer> tcLayer = (*node)->GetObject<TrafficControlLayer> ();
+        for (uint32_t i = 0; i < (*node)->GetNDevices (); i++)
+        {
+            Ptr<RedQueueDisc> red = DynamicCast<RedQueueDisc> (tcLayer->GetRootQueueDiscOnDevice ((*node)->GetDevice (i)));
+            if (red != 0)
+            {
+                stream += red->AssignStreams (stream);
+            }
+        }
+    }
+
     double oversubRatio = static_cast<double>(SERVER_COUNT * LEAF_SERVER_CAPACITY) / (SPINE_LEAF_CAPACITY * SPINE_COUNT * LINK_COUNT);
     NS_LOG_INFO ("Over-subscription ratio: " << oversubRatio);
 
     NS_LOG_INFO ("Initialize CDF table");
-    struct cdf_table* cdfTable = new cdf_table ();
-    init_cdf (cdfTable);
-    load_cdf (cdfTable, cdfFileName.c_str ());
+    Ptr<FlowSizeRandomVariable> flowSizeCdf = CreateObject<FlowSizeRandomVariable> ();
+    if (!flowSizeCdf->LoadCdf (cdfFileName))
+    {
+        NS_FATAL_ERROR ("Cannot open the CDF file " << cdfFileName);
+    }
 
     NS_LOG_INFO ("Calculating request rate");
-    double requestRate = load * LEAF_SERVER_CAPACITY * SERVER_COUNT / oversubRatio / (8 * avg_cdf (cdfTable)) / SERVER_COUNT;
+    double requestRate = load * LEAF_SERVER_CAPACITY * SERVER_COUNT / oversubRatio / (8 * flowSizeCdf->GetMean ()) / SERVER_COUNT;
     NS_LOG_INFO ("Average request rate: " << requestRate << " per second");
 
-    NS_LOG_INFO ("Initialize random seed: " << randomSeed);
+    // The asymmetric links above are drawn before srand, the same for any seed
     if (randomSeed == 0)
     {
         srand ((unsigned)time (NULL));
@@ -1237,23 +1519,57 @@ int main (int argc, char *argv[])
 
     NS_LOG_INFO ("Create applications");
 
-    long flowCount = 0;
-    long totalFlowSize = 0;
+    std::vector<Ptr<FlowWorkloadGenerator> > generators;
 
     for (int fromLeafId = 0; fromLeafId < LEAF_COUNT; fromLeafId ++)
     {
-        install_applications(fromLeafId, servers, requestRate, cdfTable, flowCount, totalFlowSize, SERVER_COUNT, LEAF_COUNT, START_TIME, END_TIME, FLOW_LAUNCH_END_TIME, applicationPauseThresh, applicationPauseTime);
+        install_applications(fromLeafId, servers, requestRate, cdfFileName, generators, SERVER_COUNT, LEAF_COUNT, START_TIME, END_TIME,
+                flowTrace != "" ? START_TIME : FLOW_LAUNCH_END_TIME, applicationPauseThresh, applicationPauseTime);
     }
 
-    NS_LOG_INFO ("Total flow: " << flowCount);
-
-    NS_LOG_INFO ("Actual average flow size: " << static_cast<double> (totalFlowSize) / flowCount);
+    FlowTraceReplay flowTraceReplay;
+    if (flowTrace != "")
+    {
+        NS_LOG_INFO ("Replay the flow trace: " << flowTrace);
+        if (!flowTraceReplay.Open (flowTrace))
+        {
+            NS_FATAL_ERROR ("Cannot open the flow trace " << flowTrace);
+        }
+        for (int i = 0; i < SERVER_COUNT * LEAF_COUNT; i++)
+        {
+            Ipv4Address address = servers.Get (i)->GetObject<Ipv4> ()->GetAddress (1, 0).GetLocal ();
+            flowTraceReplay.AddHost (generators[i], InetSocketAddress (address, PORT_START));
+        }
+        flowTraceReplay.Start (Seconds (START_TIME));
+    }
 
-    NS_LOG_INFO ("Enabling flow monitor");
+    // One sink per server receives all the flows sent to it
+    PacketSinkHelper sink ("ns3::TcpSocketFactory",
+            InetSocketAddress (Ipv4Address::GetAny (), PORT_START));
+    ApplicationContainer sinkApps = sink.Install (servers);
+    sinkApps.Start (Seconds (START_TIME));
+    sinkApps.Stop (Seconds (END_TIME));
 
     Ptr<FlowMonitor> flowMonitor;
     FlowMonitorHelper flowHelper;
-    flowMonitor = flowHelper.InstallAll();
+    if (enableFlowMonitor)
+    {
+        NS_LOG_INFO ("Enabling flow monitor");
+        flowHelper.SetMonitorAttribute ("LightMode", BooleanValue (flowMonitorLight));
+        flowMonitor = flowHelper.InstallAll();
+    }
+
+    NS_LOG_INFO ("Enabling flow completion time recorder");
+
+    // Server -> leaf -> spine -> leaf -> server and back
+    fctRecorder.SetLinkRate (DataRate (LEAF_SERVER_CAPACITY));
+    fctRecorder.SetBaseRtt (LINK_LATENCY * 8);
+    for (std::vector<Ptr<FlowWorkloadGenerator> >::iterator itr = generators.begin ();
+            itr != generators.end (); ++itr)
+    {
+        (*itr)->TraceConnectWithoutContext ("FlowComplete",
+                MakeCallback (&FctRecorder::FlowComplete, &fctRecorder));
+    }
 
     NS_LOG_INFO ("Enabling link monitor");
 
@@ -1280,7 +1596,10 @@ int main (int argc, char *argv[])
     linkMonitor->Start (Seconds (START_TIME));
     linkMonitor->Stop (Seconds (END_TIME));
 
-    flowMonitor->CheckForLostPackets ();
+    if (enableFlowMonitor)
+    {
+        flowMonitor->CheckForLostPackets ();
+    }
 
     std::stringstream flowMonitorFilename;
     std::stringstream linkMonitorFilename;
@@ -1288,7 +1607,6 @@ int main (int argc, char *argv[])
     flowMonitorFilename << id << "-1-large-load-" << LEAF_COUNT << "X" << SPINE_COUNT << "-" << load << "-"  << transportProt <<"-";
     linkMonitorFilename << id << "-1-large-load-" << LEAF_COUNT << "X" << SPINE_COUNT << "-" << load << "-"  << transportProt <<"-";
     tlbBibleFilename << id << "-1-large-load-" << LEAF_COUNT << "X" << SPINE_COUNT << "-" << load << "-"  << transportProt <<"-";
-    tlbBibleFilename2 << id << "-1-large-load-" << LEAF_COUNT << "X" << SPINE_COUNT << "-" << load << "-"  << transportProt <<"-";
     rbTraceFilename << id << "-1-large-load-" << LEAF_COUNT << "X" << SPINE_COUNT << "-" << load << "-"  << transportProt <<"-";
 
     if (runMode == CONGA)
@@ -1339,7 +1657,6 @@ int main (int argc, char *argv[])
         flowMonitorFilename << "tlb-" << TLBHighRTT << "-" << TLBMinRTT << "-" << TLBBetterPathRTT << "-" << TLBPoss << "-" << TLBS << "-" << TLBT1 << "-" << TLBProbingInterval << "-" << TLBSmooth << "-" << TLBRerouting << "-" << quantifyRTTBase << "-";
         linkMonitorFilename << "tlb-" << TLBHighRTT << "-" << TLBMinRTT << "-" << TLBBetterPathRTT << "-" << TLBPoss << "-" << TLBS << "-" << TLBT1 << "-" << TLBProbingInterval << "-" << TLBSmooth << "-" << TLBRerouting << "-" << quantifyRTTBase << "-";
         tlbBibleFilename << "tlb-" << TLBHighRTT << "-" << TLBMinRTT << "-" << TLBBetterPathRTT << "-" << TLBPoss << "-" << TLBS << "-" << TLBT1 << "-" << TLBProbingInterval << "-" << TLBSmooth << "-" << TLBRerouting << "-" << quantifyRTTBase << "-";
-        tlbBibleFilename2 << "tlb-" << TLBHighRTT << "-" << TLBMinRTT << "-" << TLBBetterPathRTT << "-" << TLBPoss << "-" << TLBS << "-" << TLBT1 << "-" << TLBProbingInterval << "-" << TLBSmooth << "-" << TLBRerouting << "-" << quantifyRTTBase << "-";
     }
     else if (runMode == Clove)
     {
@@ -1360,7 +1677,6 @@ int main (int argc, char *argv[])
     flowMonitorFilename << randomSeed << "-";
     linkMonitorFilename << randomSeed << "-";
     tlbBibleFilename << randomSeed << "-";
-    tlbBibleFilename2 << randomSeed << "-";
     rbTraceFilename << randomSeed << "-";
 
     if (asymCapacity)
@@ -1368,7 +1684,6 @@ int main (int argc, char *argv[])
         flowMonitorFilename << "capacity-asym-";
 	    linkMonitorFilename << "capacity-asym-";
         tlbBibleFilename << "capacity-asym-";
-        tlbBibleFilename2 << "capacity-asym-";
     }
 
     if (asymCapacity2)
@@ -1376,7 +1691,13 @@ int main (int argc, char *argv[])
         flowMonitorFilename << "capacity-asym2-";
 	    linkMonitorFilename << "capacity-asym2-";
         tlbBibleFilename << "capacity-asym2-";
-        tlbBibleFilename2 << "capacity-asym2-";
+    }
+
+    if (prestoFlowcell)
+    {
+        flowMonitorFilename << "flowcell-";
+        linkMonitorFilename << "flowcell-";
+        rbTraceFilename << "flowcell-";
     }
 
     if (resequenceBuffer)
@@ -1391,7 +1712,6 @@ int main (int argc, char *argv[])
         flowMonitorFilename << "p" << applicationPauseThresh << "-" << applicationPauseTime << "-";
         linkMonitorFilename << "p" << applicationPauseThresh << "-" << applicationPauseTime << "-";
         tlbBibleFilename << "p" << applicationPauseThresh << "-" << applicationPauseTime << "-";
-        tlbBibleFilename2 << "p" << applicationPauseThresh << "-" << applicationPauseTime << "-";
     }
 
     if (enableRandomDrop)
@@ -1399,7 +1719,6 @@ int main (int argc, char *argv[])
         flowMonitorFilename << "random-drop-" << randomDropRate << "-";
         linkMonitorFilename << "random-drop-" << randomDropRate << "-";
         tlbBibleFilename << "random-drop-" << randomDropRate << "-";
-        tlbBibleFilename2 << "random-drop-" << randomDropRate << "-";
         rbTraceFilename << "random-drop-" << randomDropRate << "-";
     }
 
@@ -1408,32 +1727,37 @@ int main (int argc, char *argv[])
         flowMonitorFilename << "black-hole-" << blackHoleMode << "-";
         linkMonitorFilename << "black-hole-" << blackHoleMode << "-";
         tlbBibleFilename << "black-hole-" << blackHoleMode << "-";
-        tlbBibleFilename2 << "black-hole-" << blackHoleMode << "-";
         rbTraceFilename << "black-hole-" << blackHoleMode << "-";
     }
 
 
     flowMonitorFilename << "b" << BUFFER_SIZE << ".xml";
-    linkMonitorFilename << "b" << BUFFER_SIZE << "-link-utility.out";
-    tlbBibleFilename << "b" << BUFFER_SIZE << "-bible.txt";
-    tlbBibleFilename2 << "b" << BUFFER_SIZE << "-piple.txt";
+    linkMonitorFilename << "b" << BUFFER_SIZE << (linkMonitorText ? "-link-utility.out" : "-link-utility.bin");
+    tlbBibleFilename << "b" << BUFFER_SIZE << "-bible.bin";
     rbTraceFilename << "b" << BUFFER_SIZE << "-RBTrace.txt";
 
+    // Same name as the flow monitor file, without its ".xml"
+    std::string fctFilename = flowMonitorFilename.str ();
+    fctFilename = fctFilename.substr (0, fctFilename.size () - 4) + (fctCsv ? "-fct.csv" : "-fct.bin");
+    fctRecorder.Open (fctFilename, fctCsv ? FctRecorder::CSV : FctRecorder::BINARY);
+
+    // The stream takes the samples of a port every FlushSize samples, so the
+    // memory of the link monitor stays bounded
+    if (!linkMonitorText && !linkMonitor->OpenStream (linkMonitorFilename.str ()))
+    {
+        NS_FATAL_ERROR ("Cannot open the link monitor stream " << linkMonitorFilename.str ());
+    }
+
     if (runMode == TLB)
     {
         NS_LOG_INFO ("Enabling TLB tracing");
-        remove (tlbBibleFilename.str ().c_str ());
-        remove (tlbBibleFilename2.str ().c_str ());
+        tlbBibleWriter.Open (tlbBibleFilename.str ());
 
         Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4TLB/SelectPath",
-                MakeCallback (&TLBPathSelectTrace));
+                MakeCallback (&TLBBibleWriter::PathSelect, &tlbBibleWriter));
 
         Config::ConnectWithoutContext ("/NodeList/*/$ns3::Ipv4TLB/ChangePath",
-                MakeCallback (&TLBPathChangeTrace));
-        std::ofstream out (tlbBibleFilename.str ().c_str (), std::ios::out|std::ios::app);
-        out << Ipv4TLB::GetLogo ();
-        std::ofstream out2 (tlbBibleFilename2.str ().c_str (), std::ios::out|std::ios::app);
-        out2 << Ipv4TLB::GetLogo ();
+                MakeCallback (&TLBBibleWriter::PathChange, &tlbBibleWriter));
     }
 
     if (resequenceBuffer && resequenceBufferLog)
@@ -1444,12 +1768,57 @@ int main (int argc, char *argv[])
 
     NS_LOG_INFO ("Start simulation");
     Simulator::Stop (Seconds (END_TIME));
+    SystemWallClockMs runClock;
+    runClock.Start ();
     Simulator::Run ();
+    int64_t runTime = runClock.End ();
+
+    if (enableFlowMonitor)
+    {
+        flowMonitor->SerializeToXmlFile(flowMonitorFilename.str (), true, true);
+    }
+    if (linkMonitorText)
+    {
+        linkMonitor->OutputToFile (linkMonitorFilename.str (), &LinkMonitor::DefaultFormat);
+    }
+    else
+    {
+        linkMonitor->CloseStream ();
+    }
+    tlbBibleWriter.Close ();
+    fctRecorder.Close ();
+
+    long flowCount = 0;
+    long totalFlowSize = 0;
+    for (std::vector<Ptr<FlowWorkloadGenerator> >::iterator itr = generators.begin ();
+            itr != generators.end (); ++itr)
+    {
+        flowCount += (*itr)->GetFlowCount ();
+        totalFlowSize += (*itr)->GetTotalFlowSize ();
+    }
+
+    NS_LOG_INFO ("Total flow: " << flowCount);
+
+    NS_LOG_INFO ("Actual average flow size: " << static_cast<double> (totalFlowSize) / flowCount);
+
+    NS_LOG_INFO ("Completed flow: " << fctRecorder.GetRecordCount ());
+    std::stringstream fctSummary;
+    fctRecorder.PrintSummary (fctSummary);
+    NS_LOG_INFO ("Flow completion time summary:\n" << fctSummary.str ());
 
-    flowMonitor->SerializeToXmlFile(flowMonitorFilename.str (), true, true);
-    linkMonitor->OutputToFile (linkMonitorFilename.str (), &LinkMonitor::DefaultFormat);
+    if (sweep)
+    {
+        std::stringstream row;
+        row << runModeStr << "," << transportProt << "," << cdfFileName << "," << load << "," << randomSeed
+            << "," << flowCount << "," << fctRecorder.GetRecordCount () << "," << runTime / 1000.0
+            << sweep_results_row (fctRecorder) << std::endl;
+        append_sweep_results (sweepResults, row.str ());
+    }
 
     Simulator::Destroy ();
-    free_cdf (cdfTable);
+    if (EventTraceScheduler::s_out.is_open ())
+    {
+        EventTraceScheduler::s_out.close ();
+    }
     NS_LOG_INFO ("Stop simulation");
 }
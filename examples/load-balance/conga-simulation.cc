@@ -36,9 +36,8 @@ extern "C"
 
 #define FLOW_LAUNCH_END_TIME 0.5
 
-// The flow port range, each flow will be assigned a random port number within this range
+// Every server receives all its flows on this port
 #define PORT_START 10000
-#define PORT_END 50000
 
 // Adopted from the simulation from WANG PENG
 // Acknowledged to https://williamcityu@bitbucket.org/williamcityu/2016-socc-simulation.git
@@ -58,59 +57,32 @@ enum RunMode {
     ECMP
 };
 
-// Port from Traffic Generator
-// Acknowledged to https://github.com/HKUST-SING/TrafficGenerator/blob/master/src/common/common.c
-double poission_gen_interval(double avg_rate)
-{
-    if (avg_rate > 0)
-       return -logf(1.0 - (double)rand() / RAND_MAX) / avg_rate;
-    else
-       return 0;
-}
-
-template<typename T>
-T rand_range (T min, T max)
-{
-    return min + ((double)max - min) * rand () / RAND_MAX;
-}
-
-void install_applications (NodeContainer fromServers, NodeContainer destServers, double requestRate,
-        struct cdf_table *cdfTable, std::vector<std::pair<Ipv4Address, uint32_t> > toAddresses, int &flowCount)
+void install_applications (NodeContainer fromServers, std::vector<std::pair<Ipv4Address, uint32_t> > toAddresses,
+        double requestRate, std::string cdfFileName, std::vector<Ptr<FlowWorkloadGenerator> > &generators)
 {
     NS_LOG_INFO ("Install applications:");
     for (int i = 0; i < LEAF_NODE_COUNT; i++)
     {
-        double startTime = START_TIME + poission_gen_interval (requestRate);
-        while (startTime < FLOW_LAUNCH_END_TIME)
+        Ptr<ExponentialRandomVariable> interArrival = CreateObject<ExponentialRandomVariable> ();
+        interArrival->SetAttribute ("Mean", DoubleValue (1 / requestRate));
+
+        Ptr<FlowSizeRandomVariable> flowSize = CreateObject<FlowSizeRandomVariable> ();
+        flowSize->SetAttribute ("CdfFile", StringValue (cdfFileName));
+
+        Ptr<FlowWorkloadGenerator> generator = CreateObject<FlowWorkloadGenerator> ();
+        generator->SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
+        generator->SetAttribute ("InterArrival", PointerValue (interArrival));
+        generator->SetAttribute ("FlowSize", PointerValue (flowSize));
+        generator->SetAttribute ("LaunchEnd", TimeValue (Seconds (FLOW_LAUNCH_END_TIME)));
+        for (int destIndex = 0; destIndex < LEAF_NODE_COUNT; destIndex++)
         {
-            flowCount ++;
-            uint16_t port = rand_range (PORT_START, PORT_END);
-            int destIndex = rand_range (0, LEAF_NODE_COUNT - 1);
-
-            BulkSendHelper source ("ns3::TcpSocketFactory",
-                    InetSocketAddress (toAddresses[destIndex].first, port));
-            uint32_t flowSize = gen_random_cdf (cdfTable);
- 	    source.SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
-            source.SetAttribute ("MaxBytes", UintegerValue(flowSize));
-
-            // Install apps
-            ApplicationContainer sourceApp = source.Install (fromServers.Get (i));
-            sourceApp.Start (Seconds (startTime));
-            sourceApp.Stop (Seconds (END_TIME));
-
-            // Install packet sinks
-            PacketSinkHelper sink ("ns3::TcpSocketFactory",
-                    InetSocketAddress (Ipv4Address::GetAny (), port));
-            ApplicationContainer sinkApp = sink.Install (destServers. Get (destIndex));
-            sinkApp.Start (Seconds (startTime));
-            sinkApp.Stop (Seconds (END_TIME));
-
-            NS_LOG_INFO ("\tFlow from server: " << i << " to server: "
-                    << destIndex << " on port: " << port << " with flow size: "
-                    << flowSize << " [start time: " << startTime <<"]");
-
-            startTime += poission_gen_interval (requestRate);
+            generator->AddDestination (InetSocketAddress (toAddresses[destIndex].first, PORT_START));
         }
+
+        fromServers.Get (i)->AddApplication (generator);
+        generator->SetStartTime (Seconds (START_TIME));
+        generator->SetStopTime (Seconds (END_TIME));
+        generators.push_back (generator);
     }
 }
 
@@ -190,6 +162,19 @@ int main (int argc, char *argv[])
     double requestRate = load * LEAF_SERVER_CAPACITY * LEAF_NODE_COUNT / oversubRatio / (8 * avg_cdf (cdfTable));
     NS_LOG_INFO ("Average request rate: " << requestRate << " per second");
 
+    // The load balancers draw their streams from the run as they are created
+    NS_LOG_INFO ("Initialize random seed: " << randomSeed);
+    if (randomSeed == 0)
+    {
+        srand ((unsigned)time (NULL));
+        RngSeedManager::SetRun ((unsigned)time (NULL));
+    }
+    else
+    {
+        srand (randomSeed);
+        RngSeedManager::SetRun (randomSeed);
+    }
+
     NS_LOG_INFO ("Create nodes");
 
     Ptr<Node> leaf0 = CreateObject<Node> ();
@@ -489,25 +474,19 @@ int main (int argc, char *argv[])
         }
     }
 
-    NS_LOG_INFO ("Initialize random seed: " << randomSeed);
-    if (randomSeed == 0)
-    {
-        srand ((unsigned)time (NULL));
-    }
-    else
-    {
-        srand (randomSeed);
-    }
-
     NS_LOG_INFO ("Create applications");
 
-    int flowCount = 0;
+    // The flows of each server are drawn as the simulation runs
+    std::vector<Ptr<FlowWorkloadGenerator> > generators;
+    install_applications(servers0, serversAddr1, requestRate, cdfFileName, generators);
+    install_applications(servers1, serversAddr0, requestRate, cdfFileName, generators);
 
-    // Install apps on servers under switch leaf0
-    install_applications(servers0, servers1, requestRate, cdfTable, serversAddr1, flowCount);
-    install_applications(servers1, servers0, requestRate, cdfTable, serversAddr0, flowCount);
-
-    NS_LOG_INFO ("Total flow: " << flowCount);
+    // One sink per server receives all the flows sent to it
+    PacketSinkHelper sink ("ns3::TcpSocketFactory",
+            InetSocketAddress (Ipv4Address::GetAny (), PORT_START));
+    ApplicationContainer sinkApps = sink.Install (NodeContainer (servers0, servers1));
+    sinkApps.Start (Seconds (START_TIME));
+    sinkApps.Stop (Seconds (END_TIME));
 
     NS_LOG_INFO ("Enabling flow monitor");
 
@@ -532,6 +511,14 @@ int main (int argc, char *argv[])
 
     flowMonitor->CheckForLostPackets ();
 
+    uint32_t flowCount = 0;
+    for (std::vector<Ptr<FlowWorkloadGenerator> >::iterator itr = generators.begin ();
+            itr != generators.end (); ++itr)
+    {
+        flowCount += (*itr)->GetFlowCount ();
+    }
+    NS_LOG_INFO ("Total flow: " << flowCount);
+
     std::stringstream fileName;
 
     fileName << "8-6-load-" << load <<"-";
@@ -11,6 +11,7 @@
 #include "ns3/ipv4-drb-routing-helper.h"
 
 #include <map>
+#include <vector>
 #include <utility>
 
 extern "C"
@@ -25,8 +26,8 @@ extern "C"
 
 #define RED_QUEUE_MARKING 65 		        	 // 65 Packets (available only in DcTcp)
 
+// Every server receives all its flows on this port
 #define PORT_START 10000
-#define PORT_END 50000
 
 
 using namespace ns3;
@@ -40,72 +41,43 @@ enum RunMode {
     PRESTO
 };
 
-double poission_gen_interval(double avg_rate)
-{
-    if (avg_rate > 0)
-       return -logf(1.0 - (double)rand() / RAND_MAX) / avg_rate;
-    else
-       return 0;
-}
-
-template<typename T>
-T rand_range (T min, T max)
-{
-    return min + ((double)max - min) * rand () / RAND_MAX;
-}
-
-void install_applications (uint32_t fromPodId, uint32_t serverCount, uint32_t k, NodeContainer servers, double requestRate, struct cdf_table *cdfTable,
-        long &flowCount, long &totalFlowSize, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME)
+void install_applications (uint32_t fromPodId, uint32_t serverCount, uint32_t k, NodeContainer servers, double requestRate, std::string cdfFileName,
+        std::vector<Ptr<FlowWorkloadGenerator> > &generators, double START_TIME, double END_TIME, double FLOW_LAUNCH_END_TIME)
 {
     NS_LOG_INFO ("Install applications:");
-    for (uint32_t i = 0; i < serverCount * (k / 2); i++)
+    uint32_t podServerCount = serverCount * (k / 2);
+    for (uint32_t i = 0; i < podServerCount; i++)
     {
-        uint32_t fromServerIndex = fromPodId * serverCount * (k / 2) + i;
+        uint32_t fromServerIndex = fromPodId * podServerCount + i;
 
-        double startTime = START_TIME + poission_gen_interval (requestRate);
-        while (startTime < FLOW_LAUNCH_END_TIME)
-        {
-            flowCount ++;
-            uint16_t port = rand_range (PORT_START, PORT_END);
+        Ptr<ExponentialRandomVariable> interArrival = CreateObject<ExponentialRandomVariable> ();
+        interArrival->SetAttribute ("Mean", DoubleValue (1 / requestRate));
+
+        Ptr<FlowSizeRandomVariable> flowSize = CreateObject<FlowSizeRandomVariable> ();
+        flowSize->SetAttribute ("CdfFile", StringValue (cdfFileName));
 
-            uint32_t destServerIndex = fromServerIndex;
-            while (destServerIndex >= fromPodId * serverCount * (k / 2)
-                    && destServerIndex < (fromPodId + 1) * serverCount * (k / 2))
+        Ptr<FlowWorkloadGenerator> generator = CreateObject<FlowWorkloadGenerator> ();
+        generator->SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
+        generator->SetAttribute ("InterArrival", PointerValue (interArrival));
+        generator->SetAttribute ("FlowSize", PointerValue (flowSize));
+        generator->SetAttribute ("LaunchEnd", TimeValue (Seconds (FLOW_LAUNCH_END_TIME)));
 
+        // The flows go to the servers of the other pods
+        for (uint32_t destServerIndex = 0; destServerIndex < podServerCount * k; destServerIndex++)
+        {
+            if (destServerIndex / podServerCount == fromPodId)
             {
-                destServerIndex = rand_range (0u, serverCount * (k / 2) * k);
+                continue;
             }
-
-	        Ptr<Node> destServer = servers.Get (destServerIndex);
-	        Ptr<Ipv4> ipv4 = destServer->GetObject<Ipv4> ();
-	        Ipv4InterfaceAddress destInterface = ipv4->GetAddress (1, 0);
-	        Ipv4Address destAddress = destInterface.GetLocal ();
-
-            BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (destAddress, port));
-            uint32_t flowSize = gen_random_cdf (cdfTable);
-
-            totalFlowSize += flowSize;
- 	        source.SetAttribute ("SendSize", UintegerValue (PACKET_SIZE));
-            source.SetAttribute ("MaxBytes", UintegerValue(flowSize));
-
-            // Install apps
-            ApplicationContainer sourceApp = source.Install (servers.Get (fromServerIndex));
-            sourceApp.Start (Seconds (startTime));
-            sourceApp.Stop (Seconds (END_TIME));
-
-            // Install packet sinks
-            PacketSinkHelper sink ("ns3::TcpSocketFactory",
-                    InetSocketAddress (Ipv4Address::GetAny (), port));
-            ApplicationContainer sinkApp = sink.Install (servers. Get (destServerIndex));
-            sinkApp.Start (Seconds (startTime));
-            sinkApp.Stop (Seconds (END_TIME));
-
-            //NS_LOG_INFO ("\tFlow from server: " << fromServerIndex << " to server: "
-                    //<< destServerIndex << " on port: " << port << " with flow size: "
-                    //<< flowSize << " [start time: " << startTime <<"]");
-
-            startTime += poission_gen_interval (requestRate);
+            Ptr<Ipv4> ipv4 = servers.Get (destServerIndex)->GetObject<Ipv4> ();
+            Ipv4Address destAddress = ipv4->GetAddress (1, 0).GetLocal ();
+            generator->AddDestination (InetSocketAddress (destAddress, PORT_START));
         }
+
+        servers.Get (fromServerIndex)->AddApplication (generator);
+        generator->SetStartTime (Seconds (START_TIME));
+        generator->SetStopTime (Seconds (END_TIME));
+        generators.push_back (generator);
     }
 }
 
@@ -281,6 +253,19 @@ int main (int argc, char *argv[])
     uint32_t aggregationCount = k * (k / 2);
     uint32_t coreCount = (k / 2) * (k / 2);
 
+    // The load balancers draw their streams from the run as they are created
+    NS_LOG_INFO ("Initialize random seed: " << randomSeed);
+    if (randomSeed == 0)
+    {
+        srand ((unsigned)time (NULL));
+        RngSeedManager::SetRun ((unsigned)time (NULL));
+    }
+    else
+    {
+        srand (randomSeed);
+        RngSeedManager::SetRun (randomSeed);
+    }
+
     NodeContainer servers;
     NodeContainer edges;
     NodeContainer aggregations;
@@ -612,29 +597,21 @@ int main (int argc, char *argv[])
     double requestRate = load * serverEdgeCapacity / oversubRatio / (8 * avg_cdf (cdfTable));
     NS_LOG_INFO ("Average request rate: " << requestRate << " per second");
 
-    NS_LOG_INFO ("Initialize random seed: " << randomSeed);
-    if (randomSeed == 0)
-    {
-        srand ((unsigned)time (NULL));
-    }
-    else
-    {
-        srand (randomSeed);
-    }
-
     NS_LOG_INFO ("Create applications");
 
-    long flowCount = 0;
-    long totalFlowSize = 0;
-
+    // The flows of each server are drawn as the simulation runs
+    std::vector<Ptr<FlowWorkloadGenerator> > generators;
     for (uint32_t fromPodId = 0; fromPodId < k; ++fromPodId)
     {
-        install_applications (fromPodId, serverCount, k, servers, requestRate, cdfTable, flowCount, totalFlowSize, START_TIME, END_TIME, FLOW_LAUNCH_END_TIME);
+        install_applications (fromPodId, serverCount, k, servers, requestRate, cdfFileName, generators, START_TIME, END_TIME, FLOW_LAUNCH_END_TIME);
     }
 
-    NS_LOG_INFO ("Total flow: " << flowCount);
-
-    NS_LOG_INFO ("Actual average flow size: " << static_cast<double> (totalFlowSize) / flowCount);
+    // One sink per server receives all the flows sent to it
+    PacketSinkHelper sink ("ns3::TcpSocketFactory",
+            InetSocketAddress (Ipv4Address::GetAny (), PORT_START));
+    ApplicationContainer sinkApps = sink.Install (servers);
+    sinkApps.Start (Seconds (START_TIME));
+    sinkApps.Stop (Seconds (END_TIME));
 
     NS_LOG_INFO ("Enabling flow monitor");
 
@@ -668,6 +645,17 @@ int main (int argc, char *argv[])
     Simulator::Stop (Seconds (END_TIME));
     Simulator::Run ();
 
+    long flowCount = 0;
+    long totalFlowSize = 0;
+    for (std::vector<Ptr<FlowWorkloadGenerator> >::iterator itr = generators.begin ();
+            itr != generators.end (); ++itr)
+    {
+        flowCount += (*itr)->GetFlowCount ();
+        totalFlowSize += (*itr)->GetTotalFlowSize ();
+    }
+    NS_LOG_INFO ("Total flow: " << flowCount);
+    NS_LOG_INFO ("Actual average flow size: " << static_cast<double> (totalFlowSize) / flowCount);
+
     flowMonitor->SerializeToXmlFile(flowMonitorFilename.str (), true, true);
 
     Simulator::Destroy ();
@@ -0,0 +1,255 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "fct-recorder.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/inet-socket-address.h"
+
+#include <cstring>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FctRecorder");
+
+const uint16_t FctRecorder::VERSION;
+const uint32_t FctRecorder::FILE_HEADER_SIZE;
+const uint32_t FctRecorder::RECORD_SIZE;
+
+FctRecorder::FctRecorder ()
+  : m_format (BINARY),
+    m_recordCount (0),
+    m_linkRate (0),
+    m_baseRtt (Time (0))
+{
+  // Small, medium and large flows
+  std::vector<uint32_t> bounds;
+  bounds.push_back (100000);
+  bounds.push_back (10000000);
+  SetSizeBuckets (bounds);
+}
+
+FctRecorder::~FctRecorder ()
+{
+  Close ();
+}
+
+bool
+FctRecorder::Open (std::string filename, Format format)
+{
+  Close ();
+  bool opened;
+  if (format == BINARY)
+    {
+      opened = m_binary.Open (filename, "FCTR", VERSION);
+    }
+  else
+    {
+      m_csv.open (filename.c_str (), std::ios::out | std::ios::trunc);
+      opened = m_csv.is_open ();
+    }
+  if (!opened)
+    {
+      NS_LOG_ERROR ("Cannot open the FCT file: " << filename);
+      return false;
+    }
+  m_format = format;
+  m_recordCount = 0;
+  if (m_format == CSV)
+    {
+      m_csv << "start_ns,fct_ns,size,src,sport,dst,dport,slowdown\n";
+    }
+  return true;
+}
+
+void
+FctRecorder::Close (void)
+{
+  m_binary.Close ();
+  if (m_csv.is_open ())
+    {
+      m_csv.close ();
+    }
+}
+
+void
+FctRecorder::Flush (void)
+{
+  m_binary.Flush ();
+  if (m_csv.is_open ())
+    {
+      m_csv.flush ();
+    }
+}
+
+void
+FctRecorder::SetSizeBuckets (const std::vector<uint32_t> &bounds)
+{
+  m_bounds = bounds;
+  m_fct.assign (m_bounds.size () + 1, QuantileSketch ());
+  m_slowdown.assign (m_bounds.size () + 1, QuantileSketch ());
+}
+
+void
+FctRecorder::SetLinkRate (DataRate rate)
+{
+  m_linkRate = rate;
+}
+
+void
+FctRecorder::SetBaseRtt (Time rtt)
+{
+  m_baseRtt = rtt;
+}
+
+void
+FctRecorder::FlowComplete (const Address &source, const Address &destination, uint32_t size, Time start)
+{
+  Time fct = Simulator::Now () - start;
+  double slowdown = 0;
+  if (m_linkRate.GetBitRate () != 0)
+    {
+      Time ideal = m_baseRtt + m_linkRate.CalculateBytesTxTime (size);
+      slowdown = fct.GetSeconds () / ideal.GetSeconds ();
+    }
+
+  uint32_t bucket = GetBucket (size);
+  m_fct[bucket].Update (fct.GetSeconds ());
+  if (m_linkRate.GetBitRate () != 0)
+    {
+      m_slowdown[bucket].Update (slowdown);
+    }
+  m_recordCount++;
+
+  if (!m_binary.IsOpen () && !m_csv.is_open ())
+    {
+      return;
+    }
+
+  Ipv4Address sourceAddress, destinationAddress;
+  uint16_t sourcePort = 0, destinationPort = 0;
+  if (InetSocketAddress::IsMatchingType (source))
+    {
+      InetSocketAddress address = InetSocketAddress::ConvertFrom (source);
+      sourceAddress = address.GetIpv4 ();
+      sourcePort = address.GetPort ();
+    }
+  if (InetSocketAddress::IsMatchingType (destination))
+    {
+      InetSocketAddress address = InetSocketAddress::ConvertFrom (destination);
+      destinationAddress = address.GetIpv4 ();
+      destinationPort = address.GetPort ();
+    }
+
+  if (m_format == BINARY)
+    {
+      m_binary.WriteU64 (start.GetNanoSeconds ());
+      m_binary.WriteU64 (fct.GetNanoSeconds ());
+      m_binary.WriteU32 (size);
+      m_binary.WriteU32 (sourceAddress.Get ());
+      m_binary.WriteU32 (destinationAddress.Get ());
+      m_binary.WriteU16 (sourcePort);
+      m_binary.WriteU16 (destinationPort);
+      uint64_t bits;
+      std::memcpy (&bits, &slowdown, sizeof (bits));
+      m_binary.WriteU64 (bits);
+    }
+  else
+    {
+      m_csv << start.GetNanoSeconds () << "," << fct.GetNanoSeconds () << "," << size << ","
+            << sourceAddress << "," << sourcePort << ","
+            << destinationAddress << "," << destinationPort << "," << slowdown << "\n";
+    }
+}
+
+uint64_t
+FctRecorder::GetRecordCount (void) const
+{
+  return m_recordCount;
+}
+
+uint32_t
+FctRecorder::GetBucketCount (void) const
+{
+  return m_fct.size ();
+}
+
+uint32_t
+FctRecorder::GetBucket (uint32_t size) const
+{
+  uint32_t bucket = 0;
+  while (bucket < m_bounds.size () && size > m_bounds[bucket])
+    {
+      bucket++;
+    }
+  return bucket;
+}
+
+const QuantileSketch &
+FctRecorder::GetFctSketch (uint32_t bucket) const
+{
+  return m_fct.at (bucket);
+}
+
+const QuantileSketch &
+FctRecorder::GetSlowdownSketch (uint32_t bucket) const
+{
+  return m_slowdown.at (bucket);
+}
+
+void
+FctRecorder::PrintSummary (std::ostream &os) const
+{
+  for (uint32_t bucket = 0; bucket < m_fct.size (); bucket++)
+    {
+      std::ostringstream name;
+      if (bucket < m_bounds.size ())
+        {
+          name << "size <= " << m_bounds[bucket];
+        }
+      else if (!m_bounds.empty ())
+        {
+          name << "size > " << m_bounds.back ();
+        }
+      else
+        {
+          name << "all sizes";
+        }
+
+      const QuantileSketch &fct = m_fct[bucket];
+      os << name.str () << ": " << fct.Count () << " flows";
+      if (fct.Count () != 0)
+        {
+          os << ", FCT (us) avg " << fct.Avg () * 1e6
+             << " p50 " << fct.GetQuantile (0.5) * 1e6
+             << " p99 " << fct.GetQuantile (0.99) * 1e6
+             << " p99.9 " << fct.GetQuantile (0.999) * 1e6;
+        }
+      const QuantileSketch &slowdown = m_slowdown[bucket];
+      if (slowdown.Count () != 0)
+        {
+          os << ", slowdown avg " << slowdown.Avg ()
+             << " p50 " << slowdown.GetQuantile (0.5)
+             << " p99 " << slowdown.GetQuantile (0.99)
+             << " p99.9 " << slowdown.GetQuantile (0.999);
+        }
+      os << std::endl;
+    }
+}
+
+} // namespace ns3
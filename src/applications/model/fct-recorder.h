@@ -0,0 +1,149 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FCT_RECORDER_H
+#define FCT_RECORDER_H
+
+#include "ns3/address.h"
+#include "ns3/binary-file-writer.h"
+#include "ns3/data-rate.h"
+#include "ns3/nstime.h"
+#include "ns3/quantile-sketch.h"
+
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup flowworkload
+ *
+ * \brief Flow completion time recorder for the FlowWorkloadGenerator
+ *
+ * FlowComplete matches the FlowComplete trace of the FlowWorkloadGenerator,
+ * so the flow completion times (FCT) are measured from the connection
+ * request to the acknowledgement of the last byte. Each flow is streamed to
+ * the file given to Open, and its FCT and slowdown are added to the quantile
+ * sketches of its flow size bucket.
+ *
+ * The slowdown is the FCT divided by the ideal FCT, which is the base RTT
+ * plus the transmission time of the flow at the link rate. It is only
+ * computed once the link rate is set.
+ *
+ * In the binary format, all the integers are little endian. The file starts
+ * with the magic "FCTR", a uint16_t version and a uint16_t reserved field,
+ * followed by RECORD_SIZE bytes per flow:
+ *
+ *   int64_t  start time in ns
+ *   int64_t  FCT in ns
+ *   uint32_t size in bytes
+ *   uint32_t source IPv4 address, uint32_t destination IPv4 address
+ *   uint16_t source port, uint16_t destination port
+ *   double   slowdown, an IEEE 754 binary64, 0 without link rate
+ *
+ * The CSV format has the same fields, with a header line.
+ */
+class FctRecorder
+{
+public:
+  static const uint16_t VERSION = 2;
+  static const uint32_t FILE_HEADER_SIZE = 8;
+  static const uint32_t RECORD_SIZE = 40;
+
+  enum Format
+  {
+    BINARY,
+    CSV
+  };
+
+  FctRecorder ();
+
+  ~FctRecorder ();
+
+  /**
+   * Truncate the file and write its header. Without an open file, the flows
+   * are only added to the summaries.
+   */
+  bool Open (std::string filename, Format format = BINARY);
+
+  void Close (void);
+
+  void Flush (void);
+
+  /**
+   * Set the upper bounds of the flow size buckets, in increasing order. The
+   * last bucket holds the flows larger than the last bound. This resets the
+   * summaries.
+   */
+  void SetSizeBuckets (const std::vector<uint32_t> &bounds);
+
+  void SetLinkRate (DataRate rate);
+
+  void SetBaseRtt (Time rtt);
+
+  /**
+   * Record a completed flow, the signature matches
+   * FlowWorkloadGenerator::FlowCompleteCallback
+   */
+  void FlowComplete (const Address &source, const Address &destination, uint32_t size, Time start);
+
+  uint64_t GetRecordCount (void) const;
+
+  uint32_t GetBucketCount (void) const;
+
+  /**
+   * \return the bucket of a flow size
+   */
+  uint32_t GetBucket (uint32_t size) const;
+
+  /**
+   * \return the FCT sketch of a bucket, in seconds
+   */
+  const QuantileSketch &GetFctSketch (uint32_t bucket) const;
+
+  /**
+   * \return the slowdown sketch of a bucket, empty without link rate
+   */
+  const QuantileSketch &GetSlowdownSketch (uint32_t bucket) const;
+
+  /**
+   * Print the count, average, p50, p99 and p99.9 of the FCT and of the
+   * slowdown of each bucket.
+   */
+  void PrintSummary (std::ostream &os) const;
+
+private:
+  FctRecorder (const FctRecorder &);
+  FctRecorder &operator = (const FctRecorder &);
+
+  BinaryFileWriter m_binary;
+  std::ofstream m_csv;
+  Format m_format;
+  uint64_t m_recordCount;
+
+  DataRate m_linkRate;
+  Time m_baseRtt;
+
+  std::vector<uint32_t> m_bounds;
+  std::vector<QuantileSketch> m_fct;
+  std::vector<QuantileSketch> m_slowdown;
+};
+
+} // namespace ns3
+
+#endif /* FCT_RECORDER_H */
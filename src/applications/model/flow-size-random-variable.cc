@@ -0,0 +1,225 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/assert.h"
+#include "ns3/string.h"
+#include "ns3/rng-stream.h"
+#include "flow-size-random-variable.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowSizeRandomVariable");
+
+NS_OBJECT_ENSURE_REGISTERED (FlowSizeRandomVariable);
+
+TypeId
+FlowSizeRandomVariable::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowSizeRandomVariable")
+    .SetParent<RandomVariableStream> ()
+    .SetGroupName ("Applications")
+    .AddConstructor<FlowSizeRandomVariable> ()
+    .AddAttribute ("CdfFile",
+                   "A workload file with a value and its cumulative probability per line",
+                   StringValue (""),
+                   MakeStringAccessor (&FlowSizeRandomVariable::SetCdfFile),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+FlowSizeRandomVariable::FlowSizeRandomVariable ()
+  : m_validated (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FlowSizeRandomVariable::CDF (double v, double c)
+{
+  NS_LOG_FUNCTION (this << v << c);
+  m_points.push_back (std::make_pair (v, c));
+  m_validated = false;
+}
+
+bool
+FlowSizeRandomVariable::LoadCdf (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  std::ifstream input (filename.c_str ());
+  if (!input.is_open ())
+    {
+      return false;
+    }
+  m_points.clear ();
+  m_validated = false;
+  std::string line;
+  while (std::getline (input, line))
+    {
+      std::istringstream fields (line);
+      double v, c;
+      if (fields >> v >> c)
+        {
+          CDF (v, c);
+        }
+    }
+  return true;
+}
+
+void
+FlowSizeRandomVariable::SetCdfFile (std::string filename)
+{
+  NS_LOG_FUNCTION (this << filename);
+  if (filename != "" && !LoadCdf (filename))
+    {
+      NS_FATAL_ERROR ("Cannot open the CDF file " << filename);
+    }
+}
+
+void
+FlowSizeRandomVariable::Validate (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_lower.clear ();
+  m_upper.clear ();
+  std::vector<double> weights;
+  double value = 0;
+  double cdf = 0;
+  for (std::vector<std::pair<double, double> >::const_iterator i = m_points.begin ();
+       i != m_points.end (); ++i)
+    {
+      if (i->second < cdf || i->first < value)
+        {
+          NS_FATAL_ERROR ("The CDF points are not increasing at " << i->first << " " << i->second);
+        }
+      if (i->second > cdf)
+        {
+          m_lower.push_back (value);
+          m_upper.push_back (i->first);
+          weights.push_back (i->second - cdf);
+        }
+      value = i->first;
+      cdf = i->second;
+    }
+  if (weights.empty ())
+    {
+      NS_FATAL_ERROR ("The CDF has no point of non zero probability");
+    }
+
+  // Vose's alias method: each entry keeps its segment with probability
+  // m_prob and otherwise takes the segment of m_alias, which is topped up
+  // with the probability in excess of the average
+  uint32_t n = weights.size ();
+  m_prob.assign (n, 1);
+  m_alias.resize (n);
+  std::vector<uint32_t> small;
+  std::vector<uint32_t> large;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      weights[i] *= n / cdf;
+      m_alias[i] = i;
+      if (weights[i] < 1)
+        {
+          small.push_back (i);
+        }
+      else
+        {
+          large.push_back (i);
+        }
+    }
+  while (!small.empty () && !large.empty ())
+    {
+      uint32_t s = small.back ();
+      small.pop_back ();
+      uint32_t l = large.back ();
+      m_prob[s] = weights[s];
+      m_alias[s] = l;
+      weights[l] -= 1 - weights[s];
+      if (weights[l] < 1)
+        {
+          large.pop_back ();
+          small.push_back (l);
+        }
+    }
+  // The entries left are full, up to rounding errors
+  m_validated = true;
+}
+
+double
+FlowSizeRandomVariable::GetMean (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_validated)
+    {
+      Validate ();
+    }
+  double mean = 0;
+  for (uint32_t i = 0; i < m_prob.size (); i++)
+    {
+      // Each entry holds 1 / n of the probability, split with its alias
+      mean += m_prob[i] * (m_lower[i] + m_upper[i]) / 2;
+      mean += (1 - m_prob[i]) * (m_lower[m_alias[i]] + m_upper[m_alias[i]]) / 2;
+    }
+  return mean / m_prob.size ();
+}
+
+double
+FlowSizeRandomVariable::GetValue (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (!m_validated)
+    {
+      Validate ();
+    }
+
+  double r = Peek ()->RandU01 ();
+  if (IsAntithetic ())
+    {
+      r = (1 - r);
+    }
+
+  // The integer part picks the entry, the fractional part picks between
+  // the entry and its alias, then the place within the segment
+  double x = r * m_prob.size ();
+  uint32_t entry = std::min (static_cast<uint32_t> (x), static_cast<uint32_t> (m_prob.size () - 1));
+  double f = x - entry;
+  uint32_t segment = entry;
+  double t;
+  if (f < m_prob[entry])
+    {
+      t = f / m_prob[entry];
+    }
+  else
+    {
+      segment = m_alias[entry];
+      t = (f - m_prob[entry]) / (1 - m_prob[entry]);
+    }
+  return m_lower[segment] + t * (m_upper[segment] - m_lower[segment]);
+}
+
+uint32_t
+FlowSizeRandomVariable::GetInteger (void)
+{
+  NS_LOG_FUNCTION (this);
+  return static_cast<uint32_t> (GetValue ());
+}
+
+} // namespace ns3
@@ -0,0 +1,95 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_SIZE_RANDOM_VARIABLE_H
+#define FLOW_SIZE_RANDOM_VARIABLE_H
+
+#include "ns3/random-variable-stream.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup flowworkload
+ *
+ * \brief Flow size distribution given by the points of its CDF
+ *
+ * The CDF is linear between two points, and between (0, 0) and the first
+ * point when its probability is not zero, like the CDF tables of the
+ * TrafficGenerator. Each segment between two points is an entry of a
+ * Walker alias table weighted by its probability, so a value takes a
+ * single uniform draw and no search whatever the number of points. The
+ * probabilities are relative to the one of the last point.
+ *
+ * The CdfFile attribute loads a workload file such as VL2_CDF.txt, with a
+ * value and its cumulative probability per line.
+ */
+class FlowSizeRandomVariable : public RandomVariableStream
+{
+public:
+  /**
+   * \brief Register this type.
+   * \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  FlowSizeRandomVariable ();
+
+  /**
+   * \brief Add a point of the CDF, in increasing order
+   * \param [in] v The value
+   * \param [in] c Probability that a value is less than or equal to v
+   */
+  void CDF (double v, double c);
+
+  /**
+   * \brief Replace the CDF with the points of a workload file
+   * \param [in] filename The file name
+   * \return false if the file cannot be read
+   */
+  bool LoadCdf (std::string filename);
+
+  /**
+   * \return The mean of the distribution
+   */
+  double GetMean (void);
+
+  virtual double GetValue (void);
+  virtual uint32_t GetInteger (void);
+
+private:
+  void SetCdfFile (std::string filename);
+
+  /** Build the alias table of the segments. */
+  void Validate (void);
+
+  /** The points of the CDF, value then probability. */
+  std::vector<std::pair<double, double> > m_points;
+  /** \c true once the alias table is built. */
+  bool m_validated;
+  /** Bounds of each segment. */
+  std::vector<double> m_lower;
+  std::vector<double> m_upper;
+  /** Probability to keep each entry instead of taking its alias. */
+  std::vector<double> m_prob;
+  std::vector<uint32_t> m_alias;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_SIZE_RANDOM_VARIABLE_H */
@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "flow-trace.h"
+#include "flow-workload-generator.h"
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/simulator.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowTrace");
+
+const uint16_t FlowTrace::VERSION;
+const uint32_t FlowTrace::FILE_HEADER_SIZE;
+const uint32_t FlowTrace::RECORD_SIZE;
+
+FlowTraceWriter::FlowTraceWriter ()
+  : m_lastStart (0)
+{
+}
+
+FlowTraceWriter::~FlowTraceWriter ()
+{
+  Close ();
+}
+
+bool
+FlowTraceWriter::Open (std::string filename)
+{
+  if (!m_out.Open (filename, "FLWT", FlowTrace::VERSION))
+    {
+      NS_LOG_ERROR ("Cannot open the flow trace: " << filename);
+      return false;
+    }
+  m_lastStart = 0;
+  return true;
+}
+
+void
+FlowTraceWriter::Close (void)
+{
+  m_out.Close ();
+}
+
+void
+FlowTraceWriter::Write (Time start, uint32_t source, uint32_t destination, uint32_t size)
+{
+  NS_ASSERT_MSG (start.GetNanoSeconds () >= m_lastStart, "The flows of a trace must be in start time order");
+  m_lastStart = start.GetNanoSeconds ();
+  m_out.WriteU64 (static_cast<uint64_t> (start.GetNanoSeconds ()));
+  m_out.WriteU32 (source);
+  m_out.WriteU32 (destination);
+  m_out.WriteU32 (size);
+  m_out.WriteU32 (0);
+}
+
+static uint32_t
+ReadU32 (const uint8_t *data)
+{
+  return data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t> (data[3]) << 24);
+}
+
+static uint64_t
+ReadU64 (const uint8_t *data)
+{
+  return ReadU32 (data) | (static_cast<uint64_t> (ReadU32 (data + 4)) << 32);
+}
+
+FlowTraceReplay::FlowTraceReplay ()
+  : m_data (0),
+    m_size (0),
+    m_flowCount (0),
+    m_next (0)
+{
+}
+
+FlowTraceReplay::~FlowTraceReplay ()
+{
+  Close ();
+}
+
+bool
+FlowTraceReplay::Open (std::string filename)
+{
+  Close ();
+  int fd = open (filename.c_str (), O_RDONLY);
+  if (fd < 0)
+    {
+      NS_LOG_ERROR ("Cannot open the flow trace: " << filename);
+      return false;
+    }
+  struct stat st;
+  if (fstat (fd, &st) != 0 || st.st_size < FlowTrace::FILE_HEADER_SIZE)
+    {
+      NS_LOG_ERROR ("Invalid flow trace: " << filename);
+      close (fd);
+      return false;
+    }
+  void *data = mmap (0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (data == MAP_FAILED)
+    {
+      NS_LOG_ERROR ("Cannot map the flow trace: " << filename);
+      return false;
+    }
+  m_data = static_cast<const uint8_t *> (data);
+  m_size = st.st_size;
+  if (m_data[0] != 'F' || m_data[1] != 'L' || m_data[2] != 'W' || m_data[3] != 'T'
+      || (m_data[4] | (m_data[5] << 8)) != FlowTrace::VERSION)
+    {
+      NS_LOG_ERROR ("Invalid flow trace: " << filename);
+      Close ();
+      return false;
+    }
+  // The records are read in order, and each page only once
+  madvise (const_cast<uint8_t *> (m_data), m_size, MADV_SEQUENTIAL);
+  m_flowCount = (m_size - FlowTrace::FILE_HEADER_SIZE) / FlowTrace::RECORD_SIZE;
+  m_next = 0;
+  return true;
+}
+
+void
+FlowTraceReplay::Close (void)
+{
+  if (m_data != 0)
+    {
+      munmap (const_cast<uint8_t *> (m_data), m_size);
+    }
+  m_data = 0;
+  m_size = 0;
+  m_flowCount = 0;
+  m_next = 0;
+}
+
+void
+FlowTraceReplay::AddHost (Ptr<FlowWorkloadGenerator> generator, const Address &address)
+{
+  m_generators.push_back (generator);
+  m_addresses.push_back (address);
+}
+
+void
+FlowTraceReplay::Start (Time start)
+{
+  m_start = start;
+  m_next = 0;
+  ScheduleNext ();
+}
+
+uint64_t
+FlowTraceReplay::GetFlowCount (void) const
+{
+  return m_flowCount;
+}
+
+uint64_t
+FlowTraceReplay::GetReplayedCount (void) const
+{
+  return m_next;
+}
+
+void
+FlowTraceReplay::ScheduleNext (void)
+{
+  if (m_next >= m_flowCount)
+    {
+      return;
+    }
+  const uint8_t *record = m_data + FlowTrace::FILE_HEADER_SIZE + m_next * FlowTrace::RECORD_SIZE;
+  uint32_t source = ReadU32 (record + 8);
+  if (source >= m_generators.size ())
+    {
+      NS_FATAL_ERROR ("Flow " << m_next << " of the trace comes from the unknown host " << source);
+    }
+  Time delay = m_start + NanoSeconds (static_cast<int64_t> (ReadU64 (record))) - Simulator::Now ();
+  if (delay.IsStrictlyNegative ())
+    {
+      NS_FATAL_ERROR ("Flow " << m_next << " of the trace starts before the previous one");
+    }
+  // In the context of the source node, as if its generator had scheduled it
+  Simulator::ScheduleWithContext (m_generators[source]->GetNode ()->GetId (), delay,
+                                  &FlowTraceReplay::Replay, this);
+}
+
+void
+FlowTraceReplay::Replay (void)
+{
+  const uint8_t *record = m_data + FlowTrace::FILE_HEADER_SIZE + m_next * FlowTrace::RECORD_SIZE;
+  uint32_t source = ReadU32 (record + 8);
+  uint32_t destination = ReadU32 (record + 12);
+  if (destination >= m_addresses.size ())
+    {
+      NS_FATAL_ERROR ("Flow " << m_next << " of the trace goes to the unknown host " << destination);
+    }
+  m_generators[source]->StartFlow (m_addresses[destination], ReadU32 (record + 16));
+  m_next++;
+  ScheduleNext ();
+}
+
+} // namespace ns3
@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_TRACE_H
+#define FLOW_TRACE_H
+
+#include "ns3/address.h"
+#include "ns3/binary-file-writer.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+class FlowWorkloadGenerator;
+
+/**
+ * \ingroup flowworkload
+ *
+ * \brief Binary trace of flow arrivals
+ *
+ * All the integers are little endian. The file starts with the magic
+ * "FLWT", a uint16_t version and a uint16_t reserved field, followed by
+ * RECORD_SIZE bytes per flow, in increasing start time:
+ *
+ *   int64_t  start time in ns
+ *   uint32_t source host, uint32_t destination host
+ *   uint32_t size in bytes, uint32_t reserved
+ *
+ * The hosts are indexes in the list given to FlowTraceReplay::AddHost.
+ */
+class FlowTrace
+{
+public:
+  static const uint16_t VERSION = 1;
+  static const uint32_t FILE_HEADER_SIZE = 8;
+  static const uint32_t RECORD_SIZE = 24;
+};
+
+/**
+ * \ingroup flowworkload
+ *
+ * \brief Write a FlowTrace
+ */
+class FlowTraceWriter
+{
+public:
+  FlowTraceWriter ();
+
+  ~FlowTraceWriter ();
+
+  /**
+   * Truncate the file and write its header
+   */
+  bool Open (std::string filename);
+
+  void Close (void);
+
+  /**
+   * Append a flow, which cannot start before the previous one
+   */
+  void Write (Time start, uint32_t source, uint32_t destination, uint32_t size);
+
+private:
+  FlowTraceWriter (const FlowTraceWriter &);
+  FlowTraceWriter &operator = (const FlowTraceWriter &);
+
+  BinaryFileWriter m_out;
+  int64_t m_lastStart;
+};
+
+/**
+ * \ingroup flowworkload
+ *
+ * \brief Replay a FlowTrace on the FlowWorkloadGenerator of each host
+ *
+ * The file is mapped in memory and read as the simulation advances: only
+ * the next arrival is scheduled, so a trace of millions of flows takes no
+ * memory besides the pages of the file in use. Each flow is started by
+ * the generator of its source host towards the address of its
+ * destination host, which keep their random arrivals unless their
+ * LaunchEnd is before their start time.
+ */
+class FlowTraceReplay
+{
+public:
+  FlowTraceReplay ();
+
+  ~FlowTraceReplay ();
+
+  /**
+   * Map the trace in memory
+   */
+  bool Open (std::string filename);
+
+  void Close (void);
+
+  /**
+   * Add the next host of the trace
+   * \param generator the generator starting the flows of the host
+   * \param address the address of the sink of the host
+   */
+  void AddHost (Ptr<FlowWorkloadGenerator> generator, const Address &address);
+
+  /**
+   * Schedule the flows, their start times being relative to this time
+   */
+  void Start (Time start);
+
+  /**
+   * \return the number of flows of the trace
+   */
+  uint64_t GetFlowCount (void) const;
+
+  /**
+   * \return the number of flows started so far
+   */
+  uint64_t GetReplayedCount (void) const;
+
+private:
+  FlowTraceReplay (const FlowTraceReplay &);
+  FlowTraceReplay &operator = (const FlowTraceReplay &);
+
+  /**
+   * Start the next flow and schedule the following one
+   */
+  void Replay (void);
+  void ScheduleNext (void);
+
+  const uint8_t *m_data;
+  uint64_t m_size;
+  uint64_t m_flowCount;
+  uint64_t m_next;
+  Time m_start;
+  std::vector<Ptr<FlowWorkloadGenerator> > m_generators;
+  std::vector<Address> m_addresses;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_TRACE_H */
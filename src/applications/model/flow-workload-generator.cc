@@ -0,0 +1,411 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/address.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/socket.h"
+#include "ns3/simulator.h"
+#include "ns3/socket-factory.h"
+#include "ns3/packet.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/inet6-socket-address.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/tcp-socket-factory.h"
+#include "flow-workload-generator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowWorkloadGenerator");
+
+NS_OBJECT_ENSURE_REGISTERED (FlowWorkloadGenerator);
+
+TypeId
+FlowWorkloadGenerator::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowWorkloadGenerator")
+    .SetParent<Application> ()
+    .SetGroupName("Applications")
+    .AddConstructor<FlowWorkloadGenerator> ()
+    .AddAttribute ("SendSize", "The amount of data to send each time.",
+                   UintegerValue (512),
+                   MakeUintegerAccessor (&FlowWorkloadGenerator::m_sendSize),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("InterArrival",
+                   "A RandomVariableStream giving the time between two flows in seconds",
+                   StringValue ("ns3::ExponentialRandomVariable[Mean=0.001]"),
+                   MakePointerAccessor (&FlowWorkloadGenerator::m_interArrival),
+                   MakePointerChecker <RandomVariableStream>())
+    .AddAttribute ("FlowSize",
+                   "A RandomVariableStream giving the size of a flow in bytes",
+                   StringValue ("ns3::ConstantRandomVariable[Constant=100000]"),
+                   MakePointerAccessor (&FlowWorkloadGenerator::m_flowSize),
+                   MakePointerChecker <RandomVariableStream>())
+    .AddAttribute ("LaunchEnd",
+                   "No flow starts after this time",
+                   TimeValue (Time::Max ()),
+                   MakeTimeAccessor (&FlowWorkloadGenerator::m_launchEnd),
+                   MakeTimeChecker ())
+    .AddAttribute ("DelayThresh",
+                   "How many packets can pass before we have delay, 0 for disable",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&FlowWorkloadGenerator::m_delayThresh),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("DelayTime",
+                   "The time for a delay",
+                   TimeValue (MicroSeconds (100)),
+                   MakeTimeAccessor (&FlowWorkloadGenerator::m_delayTime),
+                   MakeTimeChecker())
+    .AddAttribute ("Protocol", "The type of protocol to use.",
+                   TypeIdValue (TcpSocketFactory::GetTypeId ()),
+                   MakeTypeIdAccessor (&FlowWorkloadGenerator::m_tid),
+                   MakeTypeIdChecker ())
+    .AddTraceSource ("FlowStart", "A new flow starts",
+                     MakeTraceSourceAccessor (&FlowWorkloadGenerator::m_flowStartTrace),
+                     "ns3::FlowWorkloadGenerator::FlowStartCallback")
+    .AddTraceSource ("FlowComplete", "All the bytes of a flow are acknowledged",
+                     MakeTraceSourceAccessor (&FlowWorkloadGenerator::m_flowCompleteTrace),
+                     "ns3::FlowWorkloadGenerator::FlowCompleteCallback")
+    .AddTraceSource ("Tx", "A new packet is created and is sent",
+                     MakeTraceSourceAccessor (&FlowWorkloadGenerator::m_txTrace),
+                     "ns3::Packet::TracedCallback")
+  ;
+  return tid;
+}
+
+
+FlowWorkloadGenerator::FlowWorkloadGenerator ()
+  : m_flowCount (0),
+    m_totalFlowSize (0)
+{
+  NS_LOG_FUNCTION (this);
+  m_destination = CreateObject<UniformRandomVariable> ();
+}
+
+FlowWorkloadGenerator::~FlowWorkloadGenerator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FlowWorkloadGenerator::AddDestination (const Address &address)
+{
+  NS_LOG_FUNCTION (this << address);
+  m_destinations.push_back (address);
+}
+
+int64_t
+FlowWorkloadGenerator::AssignStreams (int64_t stream)
+{
+  NS_LOG_FUNCTION (this << stream);
+  m_interArrival->SetStream (stream);
+  m_flowSize->SetStream (stream + 1);
+  m_destination->SetStream (stream + 2);
+  return 3;
+}
+
+uint32_t
+FlowWorkloadGenerator::GetFlowCount (void) const
+{
+  return m_flowCount;
+}
+
+uint64_t
+FlowWorkloadGenerator::GetTotalFlowSize (void) const
+{
+  return m_totalFlowSize;
+}
+
+uint32_t
+FlowWorkloadGenerator::GetActiveFlowCount (void) const
+{
+  return m_flows.size ();
+}
+
+void
+FlowWorkloadGenerator::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  m_flows.clear ();
+  m_interArrival = 0;
+  m_flowSize = 0;
+  m_destination = 0;
+  // chain up
+  Application::DoDispose ();
+}
+
+// Application Methods
+void FlowWorkloadGenerator::StartApplication (void) // Called at time specified by Start
+{
+  NS_LOG_FUNCTION (this);
+
+  // Only the flows given to StartFlow
+  if (m_launchEnd <= Simulator::Now ())
+    {
+      return;
+    }
+
+  if (m_destinations.empty ())
+    {
+      NS_LOG_WARN ("FlowWorkloadGenerator has no destination");
+      return;
+    }
+
+  // Only the next arrival is scheduled, the following ones are drawn when it fires
+  Time next = Seconds (m_interArrival->GetValue ());
+  if (Simulator::Now () + next < m_launchEnd)
+    {
+      m_nextFlowEvent = Simulator::Schedule (next, &FlowWorkloadGenerator::NextFlow, this);
+    }
+}
+
+void FlowWorkloadGenerator::StopApplication (void) // Called at time specified by Stop
+{
+  NS_LOG_FUNCTION (this);
+
+  Simulator::Cancel (m_nextFlowEvent);
+  while (!m_flows.empty ())
+    {
+      FinishFlow (m_flows.begin ()->first);
+    }
+}
+
+
+// Private helpers
+
+void FlowWorkloadGenerator::NextFlow (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  uint32_t flowSize = static_cast<uint32_t> (m_flowSize->GetValue ());
+  const Address &peer = m_destinations[m_destination->GetInteger (0, m_destinations.size () - 1)];
+  StartFlow (peer, flowSize);
+
+  Time next = Seconds (m_interArrival->GetValue ());
+  if (Simulator::Now () + next < m_launchEnd)
+    {
+      m_nextFlowEvent = Simulator::Schedule (next, &FlowWorkloadGenerator::NextFlow, this);
+    }
+}
+
+void FlowWorkloadGenerator::StartFlow (const Address &peer, uint32_t flowSize)
+{
+  NS_LOG_FUNCTION (this << peer << flowSize);
+
+  if (flowSize == 0)
+    {
+      flowSize = 1;
+    }
+
+  Ptr<Socket> socket = Socket::CreateSocket (GetNode (), m_tid);
+
+  // Fatal error if socket type is not NS3_SOCK_STREAM or NS3_SOCK_SEQPACKET
+  if (socket->GetSocketType () != Socket::NS3_SOCK_STREAM &&
+      socket->GetSocketType () != Socket::NS3_SOCK_SEQPACKET)
+    {
+      NS_FATAL_ERROR ("Using FlowWorkloadGenerator with an incompatible socket type. "
+                      "FlowWorkloadGenerator requires SOCK_STREAM or SOCK_SEQPACKET. "
+                      "In other words, use TCP instead of UDP.");
+    }
+
+  if (Inet6SocketAddress::IsMatchingType (peer))
+    {
+      socket->Bind6 ();
+    }
+  else if (InetSocketAddress::IsMatchingType (peer))
+    {
+      socket->Bind ();
+    }
+
+  FlowState &state = m_flows[socket];
+  state.peer = peer;
+  state.start = Simulator::Now ();
+  state.maxBytes = flowSize;
+  state.totBytes = 0;
+  state.accumPackets = 0;
+  state.connected = false;
+  state.isDelay = false;
+  state.closed = false;
+  // The send buffer is empty once all the sent bytes are acknowledged
+  UintegerValue sndBufSize (0);
+  socket->GetAttributeFailSafe ("SndBufSize", sndBufSize);
+  state.sndBufSize = sndBufSize.Get ();
+
+  m_flowCount++;
+  m_totalFlowSize += flowSize;
+  m_flowStartTrace (peer, flowSize);
+
+  socket->Connect (peer);
+  socket->ShutdownRecv ();
+  socket->SetConnectCallback (
+    MakeCallback (&FlowWorkloadGenerator::ConnectionSucceeded, this),
+    MakeCallback (&FlowWorkloadGenerator::ConnectionFailed, this));
+  socket->SetSendCallback (
+    MakeCallback (&FlowWorkloadGenerator::DataSend, this));
+}
+
+void FlowWorkloadGenerator::SendData (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  FlowMap::iterator it = m_flows.find (socket);
+  if (it == m_flows.end ())
+    {
+      return;
+    }
+  FlowState &state = it->second;
+
+  while (state.totBytes < state.maxBytes)
+    {
+      if (state.isDelay)
+        {
+          break;
+        }
+
+      // Time to send more, make sure we don't send too many
+      uint32_t toSend = std::min (m_sendSize, state.maxBytes - state.totBytes);
+      NS_LOG_LOGIC ("sending packet at " << Simulator::Now ());
+      Ptr<Packet> packet = Create<Packet> (toSend);
+      m_txTrace (packet);
+      int actual = socket->Send (packet);
+      if (actual > 0)
+        {
+          state.totBytes += actual;
+          state.accumPackets ++;
+        }
+
+      // We exit this loop when actual < toSend as the send side
+      // buffer is full. The "DataSent" callback will pop when
+      // some buffer space has freed ip.
+      if ((unsigned)actual != toSend)
+        {
+          break;
+        }
+
+      if (m_delayThresh != 0 && state.accumPackets > m_delayThresh)
+        {
+          state.isDelay = true;
+          Simulator::Schedule (m_delayTime, &FlowWorkloadGenerator::ResumeSend, this, socket);
+        }
+    }
+  // Check if time to close (all sent)
+  if (state.totBytes == state.maxBytes && state.connected)
+    {
+      if (!state.closed)
+        {
+          socket->Close ();
+          state.closed = true;
+        }
+      CheckFlowComplete (socket);
+    }
+}
+
+void FlowWorkloadGenerator::CheckFlowComplete (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  FlowMap::iterator it = m_flows.find (socket);
+  if (it == m_flows.end () || !it->second.closed)
+    {
+      return;
+    }
+  FlowState &state = it->second;
+  if (state.sndBufSize != 0 && socket->GetTxAvailable () < state.sndBufSize)
+    {
+      return;
+    }
+
+  Address source;
+  socket->GetSockName (source);
+  m_flowCompleteTrace (source, state.peer, state.maxBytes, state.start);
+  FinishFlow (socket);
+}
+
+void FlowWorkloadGenerator::FinishFlow (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  // The TCP stack keeps the socket until the connection is closed
+  socket->SetConnectCallback (MakeNullCallback<void, Ptr<Socket> > (),
+                              MakeNullCallback<void, Ptr<Socket> > ());
+  socket->SetSendCallback (MakeNullCallback<void, Ptr<Socket>, uint32_t> ());
+  FlowMap::iterator it = m_flows.find (socket);
+  if (it == m_flows.end ())
+    {
+      return;
+    }
+  if (!it->second.closed)
+    {
+      socket->Close ();
+    }
+  m_flows.erase (it);
+}
+
+void FlowWorkloadGenerator::ConnectionSucceeded (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  NS_LOG_LOGIC ("FlowWorkloadGenerator Connection succeeded");
+  FlowMap::iterator it = m_flows.find (socket);
+  if (it != m_flows.end ())
+    {
+      it->second.connected = true;
+      SendData (socket);
+    }
+}
+
+void FlowWorkloadGenerator::ConnectionFailed (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+  NS_LOG_LOGIC ("FlowWorkloadGenerator, Connection Failed");
+  FinishFlow (socket);
+}
+
+void FlowWorkloadGenerator::DataSend (Ptr<Socket> socket, uint32_t)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  FlowMap::iterator it = m_flows.find (socket);
+  if (it != m_flows.end () && it->second.connected)
+    { // Only send new data if the connection has completed
+      // and complete the flow once its bytes are acknowledged
+      SendData (socket);
+    }
+}
+
+void FlowWorkloadGenerator::ResumeSend (Ptr<Socket> socket)
+{
+  NS_LOG_FUNCTION (this << socket);
+
+  FlowMap::iterator it = m_flows.find (socket);
+  if (it == m_flows.end ())
+    {
+      return;
+    }
+  it->second.isDelay = false;
+  it->second.accumPackets = 0;
+
+  if (it->second.connected)
+    {
+      SendData (socket);
+    }
+}
+
+} // Namespace ns3
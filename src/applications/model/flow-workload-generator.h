@@ -0,0 +1,211 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_WORKLOAD_GENERATOR_H
+#define FLOW_WORKLOAD_GENERATOR_H
+
+#include "ns3/address.h"
+#include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/ptr.h"
+#include "ns3/nstime.h"
+#include "ns3/traced-callback.h"
+#include "ns3/random-variable-stream.h"
+
+#include <map>
+#include <vector>
+
+namespace ns3 {
+
+class Socket;
+
+/**
+ * \ingroup applications
+ * \defgroup flowworkload FlowWorkloadGenerator
+ *
+ * This application replaces one BulkSendApplication per flow in the
+ * load balancing workloads.
+ */
+
+/**
+ * \ingroup flowworkload
+ *
+ * \brief Generate a stream of bulk transfer flows from one host
+ *
+ * The flow arrivals are drawn as the simulation advances: a flow starts
+ * after each InterArrival interval until LaunchEnd, towards a destination
+ * picked uniformly among the ones added with AddDestination, and sends
+ * FlowSize bytes like a BulkSendApplication before closing its socket.
+ * A flow completes when all its bytes have been acknowledged, which fires
+ * the FlowComplete trace with the time of its connection request.
+ * Only the sockets of the active flows are kept, so the memory used
+ * follows the number of concurrent flows instead of the total number of
+ * flows. A single PacketSink per destination is enough to receive all
+ * the flows.
+ */
+class FlowWorkloadGenerator : public Application
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  FlowWorkloadGenerator ();
+
+  virtual ~FlowWorkloadGenerator ();
+
+  /**
+   * \brief Add a possible destination for the flows
+   * \param address the address of the sink
+   */
+  void AddDestination (const Address &address);
+
+  /**
+   * \brief Start a flow now, besides the ones drawn by the generator
+   *
+   * A generator with a LaunchEnd before its start time only sends the
+   * flows given here, as a FlowTraceReplay does.
+   *
+   * \param destination the address of the sink
+   * \param size the number of bytes to send
+   */
+  void StartFlow (const Address &destination, uint32_t size);
+
+  /**
+   * \brief Assign a fixed random variable stream number to the random
+   * variables used by this application.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this application
+   */
+  int64_t AssignStreams (int64_t stream);
+
+  /**
+   * \return the number of flows started so far
+   */
+  uint32_t GetFlowCount (void) const;
+
+  /**
+   * \return the number of bytes of the flows started so far
+   */
+  uint64_t GetTotalFlowSize (void) const;
+
+  /**
+   * \return the number of flows which have not completed yet
+   */
+  uint32_t GetActiveFlowCount (void) const;
+
+  /**
+   * TracedCallback signature for the start of a flow
+   *
+   * \param [in] destination The address of the sink
+   * \param [in] size The number of bytes to send
+   */
+  typedef void (* FlowStartCallback) (const Address &destination, uint32_t size);
+
+  /**
+   * TracedCallback signature for the completion of a flow
+   *
+   * \param [in] source The address of the socket of the flow
+   * \param [in] destination The address of the sink
+   * \param [in] size The number of bytes sent
+   * \param [in] start The time of the connection request
+   */
+  typedef void (* FlowCompleteCallback) (const Address &source, const Address &destination,
+                                         uint32_t size, Time start);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  // inherited from Application base class.
+  virtual void StartApplication (void);
+  virtual void StopApplication (void);
+
+  /// The state of one active flow
+  struct FlowState
+  {
+    Address peer;           //!< Destination of the flow
+    Time start;             //!< Time of the connection request
+    uint32_t maxBytes;      //!< Size of the flow
+    uint32_t totBytes;      //!< Bytes sent so far
+    uint32_t accumPackets;  //!< Packets sent since the last pause
+    bool connected;         //!< True if connected
+    bool isDelay;           //!< True if paused
+    bool closed;            //!< True once all the bytes are given to the socket
+    uint32_t sndBufSize;    //!< Size of the send buffer, 0 if unknown
+  };
+
+  typedef std::map<Ptr<Socket>, FlowState> FlowMap;
+
+  /**
+   * \brief Start one flow drawn from the random variables and schedule
+   * the next arrival
+   */
+  void NextFlow (void);
+
+  /**
+   * \brief Send data until the L4 transmission buffer is full.
+   * \param socket the socket of the flow
+   */
+  void SendData (Ptr<Socket> socket);
+
+  void ConnectionSucceeded (Ptr<Socket> socket);
+  void ConnectionFailed (Ptr<Socket> socket);
+  void DataSend (Ptr<Socket> socket, uint32_t available);
+  void ResumeSend (Ptr<Socket> socket);
+
+  /**
+   * \brief Complete the flow once the send buffer of its closed socket is empty
+   * \param socket the socket of the flow
+   */
+  void CheckFlowComplete (Ptr<Socket> socket);
+
+  /**
+   * \brief Close the socket of a flow and forget it
+   * \param socket the socket of the flow
+   */
+  void FinishFlow (Ptr<Socket> socket);
+
+  uint32_t        m_sendSize;       //!< Size of data to send each time
+  TypeId          m_tid;            //!< The type of protocol to use.
+  Time            m_launchEnd;      //!< No flow starts after this time
+  uint32_t        m_delayThresh;    //!< Packets sent before a pause, 0 to disable
+  Time            m_delayTime;      //!< Duration of a pause
+
+  Ptr<RandomVariableStream> m_interArrival;   //!< Time between two flows in seconds
+  Ptr<RandomVariableStream> m_flowSize;       //!< Size of a flow in bytes
+  Ptr<UniformRandomVariable> m_destination;   //!< Picks the destination
+
+  std::vector<Address> m_destinations;        //!< Possible destinations
+  FlowMap         m_flows;          //!< Active flows
+  EventId         m_nextFlowEvent;  //!< Next flow arrival
+  uint32_t        m_flowCount;      //!< Flows started
+  uint64_t        m_totalFlowSize;  //!< Bytes of the flows started
+
+  /// Traced Callback: a new flow starts
+  TracedCallback<const Address &, uint32_t> m_flowStartTrace;
+  /// Traced Callback: a flow completes
+  TracedCallback<const Address &, const Address &, uint32_t, Time> m_flowCompleteTrace;
+  /// Traced Callback: sent packets
+  TracedCallback<Ptr<const Packet> > m_txTrace;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_WORKLOAD_GENERATOR_H */
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/flow-size-random-variable.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+
+#include <fstream>
+
+using namespace ns3;
+
+/**
+ * Test that the values of a FlowSizeRandomVariable follow its piecewise
+ * linear CDF
+ */
+
+class FlowSizeRandomVariableTestCase : public TestCase
+{
+public:
+  FlowSizeRandomVariableTestCase ();
+  virtual ~FlowSizeRandomVariableTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+};
+
+FlowSizeRandomVariableTestCase::FlowSizeRandomVariableTestCase ()
+  : TestCase ("Test that the values of a FlowSizeRandomVariable follow its CDF")
+{
+}
+
+FlowSizeRandomVariableTestCase::~FlowSizeRandomVariableTestCase ()
+{
+}
+
+void FlowSizeRandomVariableTestCase::DoRun (void)
+{
+  // Uniform on [0, 100] with probability 0.5, [100, 500] and [500, 1000]
+  // with 0.05 and [1000, 10000] with 0.4, with a repeated point
+  std::string cdfFilename = CreateTempDirFilename ("cdf.txt");
+  std::ofstream cdfFile (cdfFilename.c_str ());
+  cdfFile << "100 0.5\n500 0.55\n500 0.55\n1000 0.6\n10000 1\n";
+  cdfFile.close ();
+
+  Ptr<FlowSizeRandomVariable> x = CreateObject<FlowSizeRandomVariable> ();
+  x->SetAttribute ("CdfFile", StringValue (cdfFilename));
+  x->SetStream (1);
+  double mean = 0.5 * 50 + 0.05 * 300 + 0.05 * 750 + 0.4 * 5500;
+  NS_TEST_ASSERT_MSG_EQ_TOL (x->GetMean (), mean, 1e-9, "Wrong mean of the CDF");
+
+  uint32_t n = 100000;
+  uint32_t counts[3] = { 0, 0, 0 };
+  double sum = 0;
+  for (uint32_t i = 0; i < n; i++)
+    {
+      double value = x->GetValue ();
+      NS_TEST_ASSERT_MSG_EQ ((value >= 0 && value <= 10000), true, "Value out of the CDF: " << value);
+      counts[value < 100 ? 0 : value < 1000 ? 1 : 2]++;
+      sum += value;
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (counts[0] / static_cast<double> (n), 0.5, 0.01, "Wrong probability below 100");
+  NS_TEST_ASSERT_MSG_EQ_TOL (counts[1] / static_cast<double> (n), 0.1, 0.01, "Wrong probability below 1000");
+  NS_TEST_ASSERT_MSG_EQ_TOL (counts[2] / static_cast<double> (n), 0.4, 0.01, "Wrong probability above 1000");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sum / n, mean, mean * 0.02, "Wrong average value");
+
+  // The same stream gives the same values
+  Ptr<FlowSizeRandomVariable> y = CreateObject<FlowSizeRandomVariable> ();
+  Ptr<FlowSizeRandomVariable> z = CreateObject<FlowSizeRandomVariable> ();
+  y->CDF (1000, 1);
+  z->CDF (1000, 1);
+  y->SetStream (2);
+  z->SetStream (2);
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      NS_TEST_ASSERT_MSG_EQ (y->GetValue (), z->GetValue (), "The same stream should give the same values");
+    }
+}
+
+class FlowSizeRandomVariableTestSuite : public TestSuite
+{
+public:
+  FlowSizeRandomVariableTestSuite ();
+};
+
+FlowSizeRandomVariableTestSuite::FlowSizeRandomVariableTestSuite ()
+  : TestSuite ("flow-size-random-variable", UNIT)
+{
+  AddTestCase (new FlowSizeRandomVariableTestCase, TestCase::QUICK);
+}
+
+static FlowSizeRandomVariableTestSuite flowSizeRandomVariableTestSuite;
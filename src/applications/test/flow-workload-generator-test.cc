@@ -0,0 +1,261 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/log.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/pointer.h"
+#include "ns3/nstime.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/packet-sink.h"
+#include "ns3/packet-sink-helper.h"
+#include "ns3/flow-workload-generator.h"
+#include "ns3/fct-recorder.h"
+#include "ns3/flow-trace.h"
+#include "ns3/simple-net-device.h"
+#include "ns3/simple-channel.h"
+#include "ns3/mac48-address.h"
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+
+#include <cstring>
+#include <fstream>
+
+using namespace ns3;
+
+/**
+ * Test that the flows of a FlowWorkloadGenerator are all received by the
+ * single PacketSink of each destination, and recorded by a FctRecorder
+ */
+
+class FlowWorkloadGeneratorTestCase : public TestCase
+{
+public:
+  FlowWorkloadGeneratorTestCase ();
+  virtual ~FlowWorkloadGeneratorTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+};
+
+FlowWorkloadGeneratorTestCase::FlowWorkloadGeneratorTestCase ()
+  : TestCase ("Test that the flows of a FlowWorkloadGenerator are received by one sink per destination and recorded")
+{
+}
+
+FlowWorkloadGeneratorTestCase::~FlowWorkloadGeneratorTestCase ()
+{
+}
+
+void FlowWorkloadGeneratorTestCase::DoRun (void)
+{
+  NodeContainer n;
+  n.Create (3);
+
+  InternetStackHelper internet;
+  internet.Install (n);
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer d;
+  for (uint32_t i = 0; i < n.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::Allocate ());
+      n.Get (i)->AddDevice (dev);
+      dev->SetChannel (channel);
+      d.Add (dev);
+    }
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer i = ipv4.Assign (d);
+
+  uint16_t port = 4000;
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApps = sink.Install (NodeContainer (n.Get (1), n.Get (2)));
+  sinkApps.Start (Seconds (0.0));
+  sinkApps.Stop (Seconds (10.0));
+
+  // One flow of 10000 bytes every 10ms, the last one starting at 20ms
+  Ptr<FlowWorkloadGenerator> generator = CreateObject<FlowWorkloadGenerator> ();
+  generator->SetAttribute ("InterArrival", StringValue ("ns3::ConstantRandomVariable[Constant=0.01]"));
+  generator->SetAttribute ("FlowSize", StringValue ("ns3::ConstantRandomVariable[Constant=10000]"));
+  generator->SetAttribute ("LaunchEnd", TimeValue (MilliSeconds (25)));
+  generator->AddDestination (InetSocketAddress (i.GetAddress (1), port));
+  generator->AddDestination (InetSocketAddress (i.GetAddress (2), port));
+  generator->AssignStreams (0);
+  n.Get (0)->AddApplication (generator);
+  generator->SetStartTime (Seconds (0.0));
+  generator->SetStopTime (Seconds (10.0));
+
+  std::string fctFilename = CreateTempDirFilename ("fct.bin");
+  FctRecorder recorder;
+  recorder.SetLinkRate (DataRate ("1Gbps"));
+  NS_TEST_ASSERT_MSG_EQ (recorder.Open (fctFilename), true, "Cannot open the FCT file");
+  generator->TraceConnectWithoutContext ("FlowComplete", MakeCallback (&FctRecorder::FlowComplete, &recorder));
+
+  Simulator::Stop (Seconds (10.0));
+  Simulator::Run ();
+
+  Ptr<PacketSink> sink1 = DynamicCast<PacketSink> (sinkApps.Get (0));
+  Ptr<PacketSink> sink2 = DynamicCast<PacketSink> (sinkApps.Get (1));
+  NS_TEST_ASSERT_MSG_EQ (generator->GetFlowCount (), 2, "Did not start the expected number of flows");
+  NS_TEST_ASSERT_MSG_EQ (generator->GetTotalFlowSize (), 20000, "Did not draw the expected flow sizes");
+  NS_TEST_ASSERT_MSG_EQ (generator->GetActiveFlowCount (), 0, "Some flows did not finish");
+  NS_TEST_ASSERT_MSG_EQ (sink1->GetAcceptedSockets ().size () + sink2->GetAcceptedSockets ().size (), 2,
+                         "Each flow should be accepted by the sink of its destination");
+  NS_TEST_ASSERT_MSG_EQ (sink1->GetTotalRx () + sink2->GetTotalRx (), 20000, "Did not receive all the bytes of the flows");
+
+
+  recorder.Close ();
+  NS_TEST_ASSERT_MSG_EQ (recorder.GetRecordCount (), 2, "Every flow should be recorded once");
+  NS_TEST_ASSERT_MSG_EQ (recorder.GetFctSketch (0).Count (), 2, "The flows should be in the smallest bucket");
+  NS_TEST_ASSERT_MSG_EQ (recorder.GetSlowdownSketch (0).Count (), 2, "The slowdowns should be recorded");
+  NS_TEST_ASSERT_MSG_GT (recorder.GetFctSketch (0).Min (), 0, "The FCT should be positive");
+  std::ifstream fctFile (fctFilename.c_str (), std::ios::binary | std::ios::ate);
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (fctFile.tellg ()),
+                         FctRecorder::FILE_HEADER_SIZE + 2 * FctRecorder::RECORD_SIZE,
+                         "The FCT file should hold the header and one record per flow");
+
+  // The slowdown ends the record, as a little endian binary64
+  uint8_t bytes[8];
+  fctFile.seekg (FctRecorder::FILE_HEADER_SIZE + FctRecorder::RECORD_SIZE - 8);
+  fctFile.read (reinterpret_cast<char *> (bytes), 8);
+  uint64_t bits = 0;
+  for (int i = 7; i >= 0; i--)
+    {
+      bits = (bits << 8) | bytes[i];
+    }
+  double slowdown;
+  std::memcpy (&slowdown, &bits, sizeof (slowdown));
+  NS_TEST_ASSERT_MSG_EQ ((slowdown >= recorder.GetSlowdownSketch (0).Min ()
+                          && slowdown <= recorder.GetSlowdownSketch (0).Max ()), true,
+                         "The record should hold the slowdown of the flow");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * Test that a FlowTraceReplay starts the flows of a trace from the
+ * generators of their source hosts
+ */
+
+class FlowTraceReplayTestCase : public TestCase
+{
+public:
+  FlowTraceReplayTestCase ();
+  virtual ~FlowTraceReplayTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+};
+
+FlowTraceReplayTestCase::FlowTraceReplayTestCase ()
+  : TestCase ("Test that a FlowTraceReplay starts the flows of a trace from their source host")
+{
+}
+
+FlowTraceReplayTestCase::~FlowTraceReplayTestCase ()
+{
+}
+
+void FlowTraceReplayTestCase::DoRun (void)
+{
+  std::string traceFilename = CreateTempDirFilename ("flows.bin");
+  FlowTraceWriter writer;
+  NS_TEST_ASSERT_MSG_EQ (writer.Open (traceFilename), true, "Cannot open the flow trace");
+  writer.Write (MilliSeconds (1), 0, 1, 5000);
+  writer.Write (MilliSeconds (2), 0, 2, 7000);
+  writer.Write (MilliSeconds (2), 1, 2, 3000);
+  writer.Close ();
+
+  NodeContainer n;
+  n.Create (3);
+
+  InternetStackHelper internet;
+  internet.Install (n);
+
+  Ptr<SimpleChannel> channel = CreateObject<SimpleChannel> ();
+  NetDeviceContainer d;
+  for (uint32_t i = 0; i < n.GetN (); i++)
+    {
+      Ptr<SimpleNetDevice> dev = CreateObject<SimpleNetDevice> ();
+      dev->SetAddress (Mac48Address::Allocate ());
+      n.Get (i)->AddDevice (dev);
+      dev->SetChannel (channel);
+      d.Add (dev);
+    }
+
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.1.0", "255.255.255.0");
+  Ipv4InterfaceContainer i = ipv4.Assign (d);
+
+  uint16_t port = 4000;
+  PacketSinkHelper sink ("ns3::TcpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+  ApplicationContainer sinkApps = sink.Install (n);
+  sinkApps.Start (Seconds (0.0));
+  sinkApps.Stop (Seconds (10.0));
+
+  FlowTraceReplay replay;
+  NS_TEST_ASSERT_MSG_EQ (replay.Open (traceFilename), true, "Cannot map the flow trace");
+  NS_TEST_ASSERT_MSG_EQ (replay.GetFlowCount (), 3, "The trace should hold the flows written");
+  std::vector<Ptr<FlowWorkloadGenerator> > generators;
+  for (uint32_t j = 0; j < n.GetN (); j++)
+    {
+      // Only the flows of the trace
+      Ptr<FlowWorkloadGenerator> generator = CreateObject<FlowWorkloadGenerator> ();
+      generator->SetAttribute ("LaunchEnd", TimeValue (Seconds (0.0)));
+      n.Get (j)->AddApplication (generator);
+      generator->SetStartTime (Seconds (0.0));
+      generator->SetStopTime (Seconds (10.0));
+      generators.push_back (generator);
+      replay.AddHost (generator, InetSocketAddress (i.GetAddress (j), port));
+    }
+  replay.Start (Seconds (0.0));
+
+  Simulator::Stop (Seconds (10.0));
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_EQ (replay.GetReplayedCount (), 3, "Did not replay all the flows");
+  NS_TEST_ASSERT_MSG_EQ (generators[0]->GetFlowCount (), 2, "Host 0 should start two flows");
+  NS_TEST_ASSERT_MSG_EQ (generators[1]->GetTotalFlowSize (), 3000, "Host 1 should start the last flow");
+  NS_TEST_ASSERT_MSG_EQ (generators[2]->GetFlowCount (), 0, "Host 2 has no flow");
+  NS_TEST_ASSERT_MSG_EQ (DynamicCast<PacketSink> (sinkApps.Get (1))->GetTotalRx (), 5000,
+                         "Host 1 should receive the first flow");
+  NS_TEST_ASSERT_MSG_EQ (DynamicCast<PacketSink> (sinkApps.Get (2))->GetTotalRx (), 10000,
+                         "Host 2 should receive the two other flows");
+
+  Simulator::Destroy ();
+}
+
+class FlowWorkloadGeneratorTestSuite : public TestSuite
+{
+public:
+  FlowWorkloadGeneratorTestSuite ();
+};
+
+FlowWorkloadGeneratorTestSuite::FlowWorkloadGeneratorTestSuite ()
+  : TestSuite ("flow-workload-generator", UNIT)
+{
+  AddTestCase (new FlowWorkloadGeneratorTestCase, TestCase::QUICK);
+  AddTestCase (new FlowTraceReplayTestCase, TestCase::QUICK);
+}
+
+static FlowWorkloadGeneratorTestSuite flowWorkloadGeneratorTestSuite;
@@ -19,6 +19,8 @@ Ipv4Clove::Ipv4Clove () :
     m_disToUncongestedPath (false)
 {
     NS_LOG_FUNCTION (this);
+    m_flowletTable = CreateObject<FlowletTable> ();
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4Clove::Ipv4Clove (const Ipv4Clove &other) :
@@ -28,6 +30,8 @@ Ipv4Clove::Ipv4Clove (const Ipv4Clove &other) :
     m_disToUncongestedPath (other.m_disToUncongestedPath)
 {
     NS_LOG_FUNCTION (this);
+    m_flowletTable = CreateObject<FlowletTable> ();
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 TypeId
@@ -96,26 +100,27 @@ Ipv4Clove::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
         NS_LOG_ERROR ("Cannot find source tor id based on the given source address");
     }
 
-    struct CloveFlowlet flowlet;
-    std::map<uint32_t, CloveFlowlet>::iterator flowletItr = m_flowletMap.find (flowId);
-    if (flowletItr != m_flowletMap.end ())
+    FlowletEntry *flowlet = m_flowletTable->Lookup (flowId);
+    if (flowlet == NULL)
     {
-        flowlet = flowletItr->second;
-    }
-    else
-    {
-        flowlet.path = Ipv4Clove::CalPath (destTor);
+        flowlet = m_flowletTable->Insert (flowId, m_flowletTimeout);
+        if (flowlet == NULL)
+        {
+            // No entry left, the packets of the flow are routed one by one
+            return Ipv4Clove::CalPath (destTor);
+        }
+        flowlet->path = Ipv4Clove::CalPath (destTor);
+        flowlet->activeTime = Time (0);
     }
 
-    if (Simulator::Now () - flowlet.lastSeen >= m_flowletTimeout)
+    if (Simulator::Now () - flowlet->activeTime >= m_flowletTimeout)
     {
-        flowlet.path = Ipv4Clove::CalPath (destTor);
+        flowlet->path = Ipv4Clove::CalPath (destTor);
     }
 
-    flowlet.lastSeen = Simulator::Now ();
-    m_flowletMap[flowId] = flowlet;
+    flowlet->activeTime = Simulator::Now ();
 
-    return flowlet.path;
+    return flowlet->path;
 }
 
 
@@ -132,6 +137,13 @@ Ipv4Clove::FindTorId (Ipv4Address daddr, uint32_t &destTorId)
     return true;
 }
 
+int64_t
+Ipv4Clove::AssignStreams (int64_t stream)
+{
+    m_rand->SetStream (stream);
+    return 1;
+}
+
 uint32_t
 Ipv4Clove::CalPath (uint32_t destTor)
 {
@@ -143,11 +155,11 @@ Ipv4Clove::CalPath (uint32_t destTor)
     std::vector<uint32_t> paths = itr->second;
     if (m_runMode == CLOVE_RUNMODE_EDGE_FLOWLET)
     {
-        return paths[rand() % paths.size ()];
+        return paths[m_rand->GetInteger (0, paths.size () - 1)];
     }
     else if (m_runMode == CLOVE_RUNMODE_ECN)
     {
-        double r = ((double) rand () / RAND_MAX);
+        double r = m_rand->GetValue ();
         std::vector<uint32_t>::iterator itr = paths.begin ();
         double weightSum = 0.0;
         for ( ; itr != paths.end (); ++itr)
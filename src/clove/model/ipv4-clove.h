@@ -5,6 +5,8 @@
 #include "ns3/object.h"
 #include "ns3/nstime.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/flowlet-table.h"
+#include "ns3/random-variable-stream.h"
 
 #include <vector>
 #include <map>
@@ -16,11 +18,6 @@
 
 namespace ns3 {
 
-struct CloveFlowlet {
-    Time lastSeen;
-    uint32_t path;
-};
-
 class Ipv4Clove : public Object {
 
 public:
@@ -38,6 +35,15 @@ public:
 
     bool FindTorId (Ipv4Address daddr, uint32_t &torId);
 
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.
+     *
+     * \param stream first stream index to use
+     * \return the number of stream indices assigned by this model
+     */
+    int64_t AssignStreams (int64_t stream);
+
 private:
     uint32_t CalPath (uint32_t destTor);
 
@@ -46,7 +52,8 @@ private:
 
     std::map<uint32_t, std::vector<uint32_t> > m_availablePath;
     std::map<Ipv4Address, uint32_t> m_ipTorMap;
-    std::map<uint32_t, CloveFlowlet> m_flowletMap;
+    Ptr<FlowletTable> m_flowletTable;
+    Ptr<UniformRandomVariable> m_rand;
 
     // Clove ECN
     Time m_halfRTT;
@@ -1,5 +1,6 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 #include "ns3/tcp-clove-tag.h"
+#include "ns3/packet.h"
 
 namespace ns3 {
 
@@ -62,4 +63,33 @@ TcpCloveTag::Print (std::ostream &os) const
     os << " path: " << m_path;
 }
 
+bool
+TcpCloveTag::PeekFrom (Ptr<const Packet> packet)
+{
+    const LbMetadata &metadata = packet->GetLbMetadata ();
+    if (!metadata.Has (LbMetadata::CLOVE))
+    {
+        return false;
+    }
+    m_path = metadata.GetClovePath ();
+    return true;
+}
+
+void
+TcpCloveTag::AddTo (Ptr<const Packet> packet) const
+{
+    packet->GetLbMetadata ().SetClovePath (m_path);
+}
+
+bool
+TcpCloveTag::RemoveFrom (Ptr<const Packet> packet)
+{
+    if (!PeekFrom (packet))
+    {
+        return false;
+    }
+    packet->GetLbMetadata ().Remove (LbMetadata::CLOVE);
+    return true;
+}
+
 }
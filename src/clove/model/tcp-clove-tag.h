@@ -3,9 +3,12 @@
 #define TCP_CLOVE_TAG_H
 
 #include "ns3/tag.h"
+#include "ns3/ptr.h"
 
 namespace ns3 {
 
+class Packet;
+
 class TcpCloveTag : public Tag
 {
 public:
@@ -28,6 +31,13 @@ public:
 
     virtual void Print (std::ostream &os) const;
 
+    // Adapters on the LbMetadata of the packet, AddTo replaces an existing value
+    bool PeekFrom (Ptr<const Packet> packet);
+
+    void AddTo (Ptr<const Packet> packet) const;
+
+    bool RemoveFrom (Ptr<const Packet> packet);
+
 private:
 
     uint32_t m_path;
@@ -42,5 +42,20 @@ Ipv4CongaRoutingHelper::GetCongaRouting (Ptr<Ipv4> ipv4) const
   return 0;
 }
 
+int64_t
+Ipv4CongaRoutingHelper::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+  {
+    Ptr<Ipv4CongaRouting> congaRouting = GetCongaRouting ((*i)->GetObject<Ipv4> ());
+    if (congaRouting)
+    {
+      currentStream += congaRouting->AssignStreams (currentStream);
+    }
+  }
+  return currentStream - stream;
+}
+
 }
 
@@ -32,12 +32,16 @@ Ipv4CongaRouting::Ipv4CongaRouting ():
     m_flowletTimeout (MicroSeconds(50)), // The default value of flowlet timeout is small for experimental purpose
     m_ecmpMode (false),
     // Variables
-    m_feedbackIndex (0),
-    m_dreEvent (),
-    m_agingEvent (),
-    m_ipv4 (0)
+    m_dreTick (0),
+    m_ipv4 (0),
+    m_quantizingScale (0)
 {
   NS_LOG_FUNCTION (this);
+  m_flowletTable = CreateObject<FlowletTable> ();
+  m_rand = CreateObject<UniformRandomVariable> ();
+  m_dre.SetPeriod (m_tdre);
+  m_dre.SetAlpha (m_alpha);
+  Ipv4CongaRouting::UpdateQuantizing ();
 }
 
 Ipv4CongaRouting::~Ipv4CongaRouting ()
@@ -69,34 +73,47 @@ Ipv4CongaRouting::SetFlowletTimeout (Time timeout)
   m_flowletTimeout = timeout;
 }
 
+void
+Ipv4CongaRouting::SetExactDre (bool exact)
+{
+  m_dre.SetExact (exact);
+}
+
 void
 Ipv4CongaRouting::SetAlpha (double alpha)
 {
   m_alpha = alpha;
+  m_dre.SetAlpha (alpha);
+  Ipv4CongaRouting::UpdateQuantizing ();
 }
 
 void
 Ipv4CongaRouting::SetTDre (Time time)
 {
   m_tdre = time;
+  m_dre.SetPeriod (time);
+  Ipv4CongaRouting::UpdateQuantizing ();
 }
 
 void
 Ipv4CongaRouting::SetLinkCapacity (DataRate dataRate)
 {
   m_C = dataRate;
+  Ipv4CongaRouting::UpdateQuantizing ();
 }
 
 void
 Ipv4CongaRouting::SetLinkCapacity (uint32_t interface, DataRate dataRate)
 {
   m_Cs[interface] = dataRate;
+  Ipv4CongaRouting::UpdateQuantizing ();
 }
 
 void
 Ipv4CongaRouting::SetQ (uint32_t q)
 {
   m_Q = q;
+  Ipv4CongaRouting::UpdateQuantizing ();
 }
 
 void
@@ -111,64 +128,27 @@ Ipv4CongaRouting::EnableEcmpMode ()
   m_ecmpMode = true;
 }
 
+int64_t
+Ipv4CongaRouting::AssignStreams (int64_t stream)
+{
+  m_rand->SetStream (stream);
+  return 1;
+}
+
 void
 Ipv4CongaRouting::InitCongestion (uint32_t leafId, uint32_t port, uint32_t congestion)
 {
-  std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > >::iterator itr =
-      m_congaToLeafTable.find(leafId);
-  if (itr != m_congaToLeafTable.end ())
-  {
-    (itr->second)[port] = std::make_pair(Simulator::Now (), congestion);
-  }
-  else
-  {
-    std::map<uint32_t, std::pair<Time, uint32_t> > newMap;
-    newMap[port] = std::make_pair(Simulator::Now (), congestion);
-    m_congaToLeafTable[leafId] = newMap;
-  }
+  CongestionInfo &congestionInfo = Ipv4CongaRouting::GetCongaToLeafEntry (leafId, port);
+  congestionInfo.ce = congestion;
+  congestionInfo.updateTime = Simulator::Now ();
+  congestionInfo.valid = true;
 }
 
 void
 Ipv4CongaRouting::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port)
 {
   NS_LOG_LOGIC (this << " Add Conga routing entry: " << network << "/" << networkMask << " would go through port: " << port);
-  CongaRouteEntry congaRouteEntry;
-  congaRouteEntry.network = network;
-  congaRouteEntry.networkMask = networkMask;
-  congaRouteEntry.port = port;
-  m_routeEntryList.push_back (congaRouteEntry);
-}
-
-std::vector<CongaRouteEntry>
-Ipv4CongaRouting::LookupCongaRouteEntries (Ipv4Address dest)
-{
-  std::vector<CongaRouteEntry> congaRouteEntries;
-  std::vector<CongaRouteEntry>::iterator itr = m_routeEntryList.begin ();
-  for ( ; itr != m_routeEntryList.end (); ++itr)
-  {
-    if((*itr).networkMask.IsMatch(dest, (*itr).network))
-    {
-      congaRouteEntries.push_back (*itr);
-    }
-  }
-  return congaRouteEntries;
-}
-
-Ptr<Ipv4Route>
-Ipv4CongaRouting::ConstructIpv4Route (uint32_t port, Ipv4Address destAddress)
-{
-  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (port);
-  Ptr<Channel> channel = dev->GetChannel ();
-  uint32_t otherEnd = (channel->GetDevice (0) == dev) ? 1 : 0;
-  Ptr<Node> nextHop = channel->GetDevice (otherEnd)->GetNode ();
-  uint32_t nextIf = channel->GetDevice (otherEnd)->GetIfIndex ();
-  Ipv4Address nextHopAddr = nextHop->GetObject<Ipv4>()->GetAddress(nextIf,0).GetLocal();
-  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
-  route->SetOutputDevice (m_ipv4->GetNetDevice (port));
-  route->SetGateway (nextHopAddr);
-  route->SetSource (m_ipv4->GetAddress (port, 0).GetLocal ());
-  route->SetDestination (destAddress);
-  return route;
+  m_nextHopCache.AddRoute (network, networkMask, port);
 }
 
 Ptr<Ipv4Route>
@@ -212,7 +192,7 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
   // Extract the flow id
   uint32_t flowId = 0;
   FlowIdTag flowIdTag;
-  bool flowIdFound = packet->PeekPacketTag(flowIdTag);
+  bool flowIdFound = flowIdTag.PeekFrom (packet);
   if (!flowIdFound)
   {
     NS_LOG_ERROR (this << " Conga routing cannot extract the flow id");
@@ -221,9 +201,9 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
   }
   flowId = flowIdTag.GetFlowId ();
 
-  std::vector<CongaRouteEntry> routeEntries = Ipv4CongaRouting::LookupCongaRouteEntries (destAddress);
+  const std::vector<uint32_t> &routePorts = m_nextHopCache.LookupPorts (destAddress);
 
-  if (routeEntries.empty ())
+  if (routePorts.empty ())
   {
     NS_LOG_ERROR (this << " Conga routing cannot find routing entry");
     ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
@@ -233,24 +213,13 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
   // Dev use
   if (m_ecmpMode)
   {
-    uint32_t selectedPort = routeEntries[flowId % routeEntries.size ()].port;
-    Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+    uint32_t selectedPort = routePorts[flowId % routePorts.size ()];
+    Ptr<Ipv4Route> route = m_nextHopCache.GetRoute (selectedPort);
     ucb (route, packet, header);
   }
 
-  // Turn on DRE event scheduler if it is not running
-  if (!m_dreEvent.IsRunning ())
-  {
-    NS_LOG_LOGIC (this << " Conga routing restarts dre event scheduling");
-    m_dreEvent = Simulator::Schedule(m_tdre, &Ipv4CongaRouting::DreEvent, this);
-  }
-
-  // Turn on aging event scheduler if it is not running
-  if (!m_agingEvent.IsRunning ())
-  {
-    NS_LOG_LOGIC (this << "Conga routing restarts aging event scheduling");
-    m_agingEvent = Simulator::Schedule(m_agingTime / 4, &Ipv4CongaRouting::AgingEvent, this);
-  }
+  // Bring the local DREs up to date
+  Ipv4CongaRouting::AgeLocalDre ();
 
   // First, check if this switch if leaf switch
   if (m_isLeaf)
@@ -260,7 +229,7 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     // 2. The receiver is connected to this leaf switch
     // We can distinguish it by checking whether the packet has CongaTag
     Ipv4CongaTag ipv4CongaTag;
-    bool found = packet->PeekPacketTag(ipv4CongaTag);
+    bool found = ipv4CongaTag.PeekFrom (packet);
 
     if (!found)
     {
@@ -285,57 +254,29 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       uint32_t destLeafId = itr->second;
 
       // Check piggyback information
-      std::map<uint32_t, std::map<uint32_t, FeedbackInfo> >::iterator fbItr =
-          m_congaFromLeafTable.find (destLeafId);
-
       uint32_t fbLbTag = LOOPBACK_PORT;
       uint32_t fbMetric = 0;
 
       // Piggyback according to round robin and favoring those that has been changed
-      if (fbItr != m_congaFromLeafTable.end ())
-      {
-        std::map<uint32_t, FeedbackInfo>::iterator innerFbItr = (fbItr->second).begin ();
-        std::advance (innerFbItr, m_feedbackIndex++ % (fbItr->second).size ()); // round robin
-
-        if ((innerFbItr->second).change == false)  // prefer the changed ones
-        {
-          for (unsigned loopIndex = 0; loopIndex < (fbItr->second).size (); loopIndex ++) // prevent infinite looping
-          {
-            if (++innerFbItr == (fbItr->second).end ()) {
-              innerFbItr = (fbItr->second).begin (); // start from the beginning
-            }
-            if ((innerFbItr->second).change == true)
-            {
-              break;
-            }
-          }
-        }
-
-        fbLbTag = innerFbItr->first;
-        fbMetric = (innerFbItr->second).ce;
-        (innerFbItr->second).change = false;
-      }
+      Ipv4CongaRouting::SelectFeedback (destLeafId, fbLbTag, fbMetric);
 
       // Port determination logic:
       // Firstly, check the flowlet table to see whether there is existing flowlet
       // If not hit, determine the port based on the congestion degree of the link
 
       // Flowlet table look up
-      struct Flowlet *flowlet = NULL;
+      FlowletEntry *flowlet = m_flowletTable->Lookup (flowId);
 
       // If the flowlet table entry is valid, return the port
-      std::map<uint32_t, struct Flowlet *>::iterator flowletItr = m_flowletTable.find (flowId);
-      if (flowletItr != m_flowletTable.end ())
+      if (flowlet != NULL)
       {
-        flowlet = flowletItr->second;
-        if (flowlet != NULL && // Impossible in normal cases
-            now - flowlet->activeTime <= m_flowletTimeout)
+        if (now - flowlet->activeTime <= m_flowletTimeout)
         {
           // Do not forget to update the flowlet active time
           flowlet->activeTime = now;
 
           // Return the port information used for routing routine to select the port
-          selectedPort = flowlet->port;
+          selectedPort = flowlet->path;
 
           // Construct Conga Header for the packet
           ipv4CongaTag.SetLbTag (selectedPort);
@@ -344,12 +285,12 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
           // Piggyback the feedback information
           ipv4CongaTag.SetFbLbTag (fbLbTag);
           ipv4CongaTag.SetFbMetric (fbMetric);
-          packet->AddPacketTag(ipv4CongaTag);
+          ipv4CongaTag.AddTo (packet);
 
           // Update local dre
           Ipv4CongaRouting::UpdateLocalDre (header, packet, selectedPort);
 
-          Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+          Ptr<Ipv4Route> route = m_nextHopCache.GetRoute (selectedPort);
           ucb (route, packet, header);
 
           NS_LOG_LOGIC (this << " Sending Conga on leaf switch (flowlet hit): " << m_leafId << " - LbTag: " << selectedPort << ", CE: " << 0 << ", FbLbTag: " << fbLbTag << ", FbMetric: " << fbMetric);
@@ -361,93 +302,72 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       NS_LOG_LOGIC (this << " Flowlet expires, calculate the new port");
       // Not hit. Determine the port
 
-      // 1. Select port congestion information based on dest leaf switch id
-      std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > >::iterator
-          congaToLeafItr = m_congaToLeafTable.find (destLeafId);
-
-      // 2. Prepare the candidate port
+      // 1. Evaluate the candidate ports
       // For a new flowlet, we pick the uplink port that minimizes the maximum of the local metric (from the local DREs)
       // and the remote metric (from the Congestion-To-Leaf Table).
-      uint32_t minPortCongestion = (std::numeric_limits<uint32_t>::max)();
-
-      std::vector<uint32_t> portCandidates;
-      std::vector<CongaRouteEntry>::iterator routeEntryItr = routeEntries.begin ();
+      uint32_t minCount = 0;
+      uint32_t minPortCongestion = Ipv4CongaRouting::EvaluatePorts (routePorts, destLeafId, minCount);
 
-      for ( ; routeEntryItr != routeEntries.end (); ++routeEntryItr)
+      // 2. Select one port from all those candidate ports
+      bool flowletCandidate = false;
+      if (flowlet != NULL)
       {
-        uint32_t port = (*routeEntryItr).port;
-        uint32_t localCongestion = 0;
-        uint32_t remoteCongestion = 0;
-
-        std::map<uint32_t, uint32_t>::iterator localCongestionItr = m_XMap.find (port);
-        if (localCongestionItr != m_XMap.end ())
-        {
-          localCongestion = Ipv4CongaRouting::QuantizingX (port, localCongestionItr->second);
-        }
-
-        std::map<uint32_t, std::pair<Time, uint32_t> >::iterator remoteCongestionItr =
-            (congaToLeafItr->second).find (port);
-        if (remoteCongestionItr != (congaToLeafItr->second).end ())
-        {
-          remoteCongestion = (remoteCongestionItr->second).second;
-        }
-
-        uint32_t congestionDegree = std::max (localCongestion, remoteCongestion);
-
-        if (congestionDegree < minPortCongestion)
-        {
-          // Strictly better port
-          minPortCongestion = congestionDegree;
-          portCandidates.clear();
-          portCandidates.push_back(port);
-        }
-        if (congestionDegree == minPortCongestion)
+        for (uint32_t i = 0; i < routePorts.size (); ++i)
         {
-          // Equally good port
-          portCandidates.push_back(port);
+          flowletCandidate |= routePorts[i] == flowlet->path && m_portMetrics[i] == minPortCongestion;
         }
       }
-
-      // 3. Select one port from all those candidate ports
-      if (flowlet != NULL &&
-            std::find(portCandidates.begin (), portCandidates.end (), flowlet->port) != portCandidates.end ())
+      if (flowletCandidate)
       {
         // Prefer the port cached in flowlet table
-        selectedPort = flowlet->port;
+        selectedPort = flowlet->path;
         // Activate the flowlet entry again
         flowlet->activeTime = now;
       }
       else
       {
         // If there are no cached ports, we randomly choose a good port
-        selectedPort = portCandidates[rand() % portCandidates.size ()];
+        // The first good port weighs twice the others, as in the candidate list it used to be pushed twice
+        uint32_t rank = m_rand->GetInteger (0, minCount);
+        rank = rank == 0 ? 0 : rank - 1;
+        selectedPort = routePorts[0];
+        for (uint32_t i = 0; i < routePorts.size (); ++i)
+        {
+          if (m_portMetrics[i] == minPortCongestion)
+          {
+            if (rank == 0)
+            {
+              selectedPort = routePorts[i];
+              break;
+            }
+            rank--;
+          }
+        }
         if (flowlet == NULL)
         {
-          struct Flowlet *newFlowlet = new Flowlet;
-          newFlowlet->port = selectedPort;
-          newFlowlet->activeTime = now;
-          m_flowletTable[flowId] = newFlowlet;
+          flowlet = m_flowletTable->Insert (flowId, m_flowletTimeout);
         }
-        else
+        // Without an entry, the packets of the flow are routed one by one
+        if (flowlet != NULL)
         {
-          flowlet->port = selectedPort;
+          flowlet->path = selectedPort;
           flowlet->activeTime = now;
         }
       }
 
-      // 4. Construct Conga Header for the packet
+      // 3. Construct Conga Header for the packet
       ipv4CongaTag.SetLbTag (selectedPort);
       ipv4CongaTag.SetCe (0);
 
       // Piggyback the feedback information
       ipv4CongaTag.SetFbLbTag (fbLbTag);
       ipv4CongaTag.SetFbMetric (fbMetric);
-      packet->AddPacketTag(ipv4CongaTag);
+      ipv4CongaTag.AddTo (packet);
 
       // Update local dre
       Ipv4CongaRouting::UpdateLocalDre (header, packet, selectedPort);
 
-      Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+      Ptr<Ipv4Route> route = m_nextHopCache.GetRoute (selectedPort);
       ucb (route, packet, header);
 
       NS_LOG_LOGIC (this << " Sending Conga on leaf switch: " << m_leafId << " - LbTag: " << selectedPort << ", CE: " << 0 << ", FbLbTag: " << fbLbTag << ", FbMetric: " << fbMetric);
@@ -474,66 +394,31 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
       uint32_t sourceLeafId = itr->second;
 
       // 1. Update the CongaFromLeafTable
-      std::map<uint32_t, std::map<uint32_t, FeedbackInfo> >::iterator fromLeafItr = m_congaFromLeafTable.find (sourceLeafId);
-
-      if (fromLeafItr == m_congaFromLeafTable.end ())
-      {
-        std::map<uint32_t, FeedbackInfo> newMap;
-        FeedbackInfo feedbackInfo;
-        feedbackInfo.ce = ipv4CongaTag.GetCe ();
-        feedbackInfo.change = true;
-        feedbackInfo.updateTime = Simulator::Now ();
-        newMap[ipv4CongaTag.GetLbTag ()] = feedbackInfo;
-        m_congaFromLeafTable[sourceLeafId] = newMap;
-      }
-      else
-      {
-        std::map<uint32_t, FeedbackInfo>::iterator innerItr = (fromLeafItr->second).find (ipv4CongaTag.GetLbTag ());
-        if (innerItr == (fromLeafItr->second).end ())
-        {
-          FeedbackInfo feedbackInfo;
-          feedbackInfo.ce = ipv4CongaTag.GetCe ();
-          feedbackInfo.change = true;
-          feedbackInfo.updateTime = Simulator::Now ();
-          (fromLeafItr->second)[ipv4CongaTag.GetLbTag ()] = feedbackInfo;
-        }
-        else
-        {
-          (innerItr->second).ce = ipv4CongaTag.GetCe ();
-          (innerItr->second).change = true;
-          (innerItr->second).updateTime = Simulator::Now ();
-        }
-      }
+      FeedbackInfo &feedbackInfo = Ipv4CongaRouting::GetCongaFromLeafEntry (sourceLeafId, ipv4CongaTag.GetLbTag ());
+      feedbackInfo.ce = ipv4CongaTag.GetCe ();
+      feedbackInfo.change = true;
+      feedbackInfo.updateTime = Simulator::Now ();
+      feedbackInfo.valid = true;
 
       // 2. Update the CongaToLeafTable
       if (ipv4CongaTag.GetFbLbTag () != LOOPBACK_PORT)
       {
-        std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > >::iterator toLeafItr =
-            m_congaToLeafTable.find(sourceLeafId);
-        if (toLeafItr != m_congaToLeafTable.end ())
-        {
-          (toLeafItr->second)[ipv4CongaTag.GetFbLbTag ()] =
-              std::make_pair(Simulator::Now (), ipv4CongaTag.GetFbMetric ());
-        }
-        else
-        {
-          std::map<uint32_t, std::pair<Time, uint32_t> > newMap;
-          newMap[ipv4CongaTag.GetFbLbTag ()] =
-              std::make_pair(Simulator::Now (), ipv4CongaTag.GetFbMetric ());
-          m_congaToLeafTable[sourceLeafId] = newMap;
-        }
+        CongestionInfo &congestionInfo = Ipv4CongaRouting::GetCongaToLeafEntry (sourceLeafId, ipv4CongaTag.GetFbLbTag ());
+        congestionInfo.ce = ipv4CongaTag.GetFbMetric ();
+        congestionInfo.updateTime = Simulator::Now ();
+        congestionInfo.valid = true;
       }
 
       // Not necessary
       // Remove the Conga Header
-      packet->RemovePacketTag (ipv4CongaTag);
+      ipv4CongaTag.RemoveFrom (packet);
 
       // Pick port using standard ECMP
-      uint32_t selectedPort = routeEntries[flowId % routeEntries.size ()].port;
+      uint32_t selectedPort = routePorts[flowId % routePorts.size ()];
 
       Ipv4CongaRouting::UpdateLocalDre (header, packet, selectedPort);
 
-      Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+      Ptr<Ipv4Route> route = m_nextHopCache.GetRoute (selectedPort);
       ucb (route, packet, header);
 
       Ipv4CongaRouting::PrintDreTable ();
@@ -548,7 +433,7 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     // If the switch is spine switch
     // Extract Conga Header
     Ipv4CongaTag ipv4CongaTag;
-    bool found = packet->PeekPacketTag(ipv4CongaTag);
+    bool found = ipv4CongaTag.PeekFrom (packet);
     if (!found)
     {
       NS_LOG_ERROR (this<< "Conga routing cannot extract Conga Header in spine switch");
@@ -557,7 +442,7 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     }
 
     // Determine the port using standard ECMP
-    uint32_t selectedPort = routeEntries[flowId % routeEntries.size ()].port;
+    uint32_t selectedPort = routePorts[flowId % routePorts.size ()];
 
     // Update local dre
     uint32_t X = Ipv4CongaRouting::UpdateLocalDre (header, packet, selectedPort);
@@ -573,10 +458,10 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     // Compare the X with that in the Conga Header
     if (quantizingX > ipv4CongaTag.GetCe()) {
       ipv4CongaTag.SetCe(quantizingX);
-      packet->ReplacePacketTag(ipv4CongaTag);
+      ipv4CongaTag.AddTo (packet);
     }
 
-    Ptr<Ipv4Route> route = Ipv4CongaRouting::ConstructIpv4Route (selectedPort, destAddress);
+    Ptr<Ipv4Route> route = m_nextHopCache.GetRoute (selectedPort);
     ucb (route, packet, header);
 
     return true;
@@ -586,21 +471,25 @@ Ipv4CongaRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
 void
 Ipv4CongaRouting::NotifyInterfaceUp (uint32_t interface)
 {
+  m_nextHopCache.Invalidate ();
 }
 
 void
 Ipv4CongaRouting::NotifyInterfaceDown (uint32_t interface)
 {
+  m_nextHopCache.Invalidate ();
 }
 
 void
 Ipv4CongaRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_nextHopCache.Invalidate ();
 }
 
 void
 Ipv4CongaRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_nextHopCache.Invalidate ();
 }
 
 void
@@ -609,6 +498,7 @@ Ipv4CongaRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_LOGIC (this << "Setting up Ipv4: " << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  m_nextHopCache.SetIpv4 (ipv4);
 }
 
 void
@@ -620,13 +510,10 @@ Ipv4CongaRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 void
 Ipv4CongaRouting::DoDispose (void)
 {
-  std::map<uint32_t, Flowlet *>::iterator itr = m_flowletTable.begin ();
-  for ( ; itr != m_flowletTable.end (); ++itr )
-  {
-    delete (itr->second);
-  }
-  m_dreEvent.Cancel ();
-  m_agingEvent.Cancel ();
+  m_flowletTable->Dispose ();
+  m_flowletTable = 0;
+  m_rand = 0;
+  m_nextHopCache.Clear ();
   m_ipv4=0;
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -634,115 +521,247 @@ Ipv4CongaRouting::DoDispose (void)
 uint32_t
 Ipv4CongaRouting::UpdateLocalDre (const Ipv4Header &header, Ptr<Packet> packet, uint32_t port)
 {
-  uint32_t X = 0;
-  std::map<uint32_t, uint32_t>::iterator XItr = m_XMap.find(port);
-  if (XItr != m_XMap.end ())
+  if (port >= m_X.size ())
   {
-    X = XItr->second;
+    Ipv4CongaRouting::EnsurePorts (port + 1);
   }
-  uint32_t newX = X + packet->GetSize () + header.GetSerializedSize ();
+  uint32_t newX = m_X[port] + packet->GetSize () + header.GetSerializedSize ();
   NS_LOG_LOGIC (this << " Update local dre, new X: " << newX);
-  m_XMap[port] = newX;
+  m_X[port] = newX;
   return newX;
 }
 
 void
-Ipv4CongaRouting::DreEvent ()
+Ipv4CongaRouting::AgeLocalDre ()
 {
+  Time now = Simulator::Now ();
+
+  if (!m_dre.IsRunning ())
+  {
+    NS_LOG_LOGIC (this << " Conga routing restarts dre");
+    m_dre.Start (now);
+    m_dreTick = 0;
+    return;
+  }
+
+  uint64_t tick = m_dre.GetTick (now);
+  if (tick == m_dreTick)
+  {
+    return;
+  }
+
   bool moveToIdleStatus = true;
 
-  std::map<uint32_t, uint32_t>::iterator itr = m_XMap.begin ();
-  for ( ; itr != m_XMap.end (); ++itr )
+  for (uint32_t port = 0; port < m_X.size (); ++port)
   {
-    uint32_t newX = itr->second * (1 - m_alpha);
-    itr->second = newX;
+    uint32_t newX = m_dre.Decay (m_X[port], tick - m_dreTick);
+    m_X[port] = newX;
     if (newX != 0)
     {
       moveToIdleStatus = false;
     }
   }
+  m_dreTick = tick;
 
-  NS_LOG_LOGIC (this << " Dre event finished, the dre table is now: ");
+  NS_LOG_LOGIC (this << " Dre aged, the dre table is now: ");
   Ipv4CongaRouting::PrintDreTable ();
 
-  if (!moveToIdleStatus)
+  if (moveToIdleStatus)
   {
-    m_dreEvent = Simulator::Schedule(m_tdre, &Ipv4CongaRouting::DreEvent, this);
+    // All the DREs reached zero at one of the ticks, restart the tick grid from now
+    NS_LOG_LOGIC (this << " Dre goes into idle status, restarts dre");
+    m_dre.Start (now);
+    m_dreTick = 0;
   }
-  else
+}
+
+double
+Ipv4CongaRouting::QuantizingDivisor (uint32_t interface)
+{
+  DataRate c = m_C;
+  std::map<uint32_t, DataRate>::iterator itr = m_Cs.find (interface);
+  if (itr != m_Cs.end ())
+  {
+    c = itr->second;
+  }
+  return c.GetBitRate () * m_tdre.GetSeconds () / m_alpha;
+}
+
+void
+Ipv4CongaRouting::EnsurePorts (uint32_t size)
+{
+  uint32_t oldSize = m_X.size ();
+  if (size <= oldSize)
+  {
+    return;
+  }
+  m_X.resize (size, 0);
+  m_quantizingDivisor.resize (size);
+  for (uint32_t port = oldSize; port < size; ++port)
   {
-    NS_LOG_LOGIC (this << " Dre event goes into idle status");
+    m_quantizingDivisor[port] = Ipv4CongaRouting::QuantizingDivisor (port);
   }
 }
 
 void
-Ipv4CongaRouting::AgingEvent ()
+Ipv4CongaRouting::UpdateQuantizing ()
 {
-    bool moveToIdleStatus = true;
-    std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > >::iterator itr =
-        m_congaToLeafTable.begin ();
-    for ( ; itr != m_congaToLeafTable.end (); ++itr)
+  m_quantizingScale = std::pow (2, m_Q);
+  for (uint32_t port = 0; port < m_quantizingDivisor.size (); ++port)
+  {
+    m_quantizingDivisor[port] = Ipv4CongaRouting::QuantizingDivisor (port);
+  }
+}
+
+uint32_t
+Ipv4CongaRouting::EvaluatePorts (const std::vector<uint32_t> &ports, uint32_t leafId, uint32_t &count)
+{
+  uint32_t size = ports.size ();
+  m_portMetrics.resize (size);
+
+  const std::vector<CongestionInfo> *remotes = NULL;
+  if (leafId < m_congaToLeafTable.size ())
+  {
+    remotes = &m_congaToLeafTable[leafId];
+  }
+  Time now = Simulator::Now ();
+
+  // Gather the metrics in a contiguous array
+  for (uint32_t i = 0; i < size; ++i)
+  {
+    uint32_t port = ports[i];
+    if (port >= m_X.size ())
     {
-      std::map<uint32_t, std::pair<Time, uint32_t> >::iterator innerItr =
-        (itr->second).begin ();
-      for (; innerItr != (itr->second).end (); ++innerItr)
-      {
-        if (Simulator::Now () - (innerItr->second).first > m_agingTime)
-        {
-          (innerItr->second).second = 0;
-        }
-        else
-        {
-          moveToIdleStatus = false;
-        }
-      }
+      Ipv4CongaRouting::EnsurePorts (port + 1);
     }
-    std::map<uint32_t, std::map<uint32_t, FeedbackInfo> >::iterator itr2 =
-        m_congaFromLeafTable.begin ();
-    for ( ; itr2 != m_congaFromLeafTable.end (); ++itr2 )
+    uint32_t localCongestion = Ipv4CongaRouting::QuantizingX (port, m_X[port]);
+    uint32_t remoteCongestion = 0;
+    if (remotes != NULL && port < remotes->size ())
     {
-        std::map<uint32_t, FeedbackInfo>::iterator innerItr2 =
-          (itr2->second).begin ();
-        for ( ; innerItr2 != (itr2->second).end (); ++innerItr2)
-        {
-          if (Simulator::Now () - (innerItr2->second).updateTime > m_agingTime)
-          {
-            (itr2->second).erase (innerItr2);
-            if ((itr2->second).empty ())
-            {
-                m_congaFromLeafTable.erase (itr2);
-            }
-          }
-          else
-          {
-            moveToIdleStatus = false;
-          }
-        }
+      const CongestionInfo &congestionInfo = (*remotes)[port];
+      // Aged metrics are ignored
+      if (congestionInfo.valid && now - congestionInfo.updateTime <= m_agingTime)
+      {
+        remoteCongestion = congestionInfo.ce;
+      }
     }
+    m_portMetrics[i] = std::max (localCongestion, remoteCongestion);
+  }
+
+  // Branch free reductions, which the compiler can vectorize
+  uint32_t minMetric = (std::numeric_limits<uint32_t>::max) ();
+  for (uint32_t i = 0; i < size; ++i)
+  {
+    minMetric = std::min (minMetric, m_portMetrics[i]);
+  }
+  count = 0;
+  for (uint32_t i = 0; i < size; ++i)
+  {
+    count += m_portMetrics[i] == minMetric;
+  }
+  return minMetric;
+}
 
+CongestionInfo &
+Ipv4CongaRouting::GetCongaToLeafEntry (uint32_t leafId, uint32_t port)
+{
+  if (leafId >= m_congaToLeafTable.size ())
+  {
+    m_congaToLeafTable.resize (leafId + 1);
+  }
+  std::vector<CongestionInfo> &ports = m_congaToLeafTable[leafId];
+  if (port >= ports.size ())
+  {
+    CongestionInfo emptyInfo;
+    emptyInfo.ce = 0;
+    emptyInfo.updateTime = Time (0);
+    emptyInfo.valid = false;
+    ports.resize (port + 1, emptyInfo);
+  }
+  return ports[port];
+}
 
-    if (!moveToIdleStatus)
+FeedbackInfo &
+Ipv4CongaRouting::GetCongaFromLeafEntry (uint32_t leafId, uint32_t port)
+{
+  if (leafId >= m_congaFromLeafTable.size ())
+  {
+    m_congaFromLeafTable.resize (leafId + 1);
+    m_feedbackCursor.resize (leafId + 1, 0);
+  }
+  std::vector<FeedbackInfo> &ports = m_congaFromLeafTable[leafId];
+  if (port >= ports.size ())
+  {
+    FeedbackInfo emptyInfo;
+    emptyInfo.ce = 0;
+    emptyInfo.change = false;
+    emptyInfo.updateTime = Time (0);
+    emptyInfo.valid = false;
+    ports.resize (port + 1, emptyInfo);
+  }
+  return ports[port];
+}
+
+bool
+Ipv4CongaRouting::SelectFeedback (uint32_t leafId, uint32_t &fbLbTag, uint32_t &fbMetric)
+{
+  if (leafId >= m_congaFromLeafTable.size ())
+  {
+    return false;
+  }
+
+  std::vector<FeedbackInfo> &ports = m_congaFromLeafTable[leafId];
+  uint32_t size = ports.size ();
+  uint32_t cursor = m_feedbackCursor[leafId];
+  Time now = Simulator::Now ();
+
+  // Starting from the cursor, pick the first changed entry, or the first one if none has changed
+  bool found = false;
+  uint32_t selectedPort = 0;
+  for (uint32_t index = 0; index < size; index++)
+  {
+    uint32_t port = (cursor + index) % size;
+    FeedbackInfo &feedbackInfo = ports[port];
+    if (!feedbackInfo.valid)
     {
-      m_agingEvent = Simulator::Schedule(m_agingTime / 4, &Ipv4CongaRouting::AgingEvent, this);
+      continue;
     }
-    else
+    if (now - feedbackInfo.updateTime > m_agingTime)
     {
-      NS_LOG_LOGIC (this << " Aging event goes into idle status");
+      // Aged entry
+      feedbackInfo.valid = false;
+      continue;
     }
+    if (!found || feedbackInfo.change)
+    {
+      found = true;
+      selectedPort = port;
+    }
+    if (feedbackInfo.change)
+    {
+      break;
+    }
+  }
+
+  if (!found)
+  {
+    return false;
+  }
+
+  m_feedbackCursor[leafId] = (selectedPort + 1) % size;
+  fbLbTag = selectedPort;
+  fbMetric = ports[selectedPort].ce;
+  ports[selectedPort].change = false;
+  return true;
 }
 
 uint32_t
 Ipv4CongaRouting::QuantizingX (uint32_t interface, uint32_t X)
 {
-  DataRate c = m_C;
-  std::map<uint32_t, DataRate>::iterator itr = m_Cs.find (interface);
-  if (itr != m_Cs.end ())
-  {
-    c = itr->second;
-  }
-  double ratio = static_cast<double> (X * 8) / (c.GetBitRate () * m_tdre.GetSeconds () / m_alpha);
+  NS_ASSERT (interface < m_quantizingDivisor.size ());
+  double ratio = static_cast<double> (X * 8) / m_quantizingDivisor[interface];
   NS_LOG_LOGIC ("ratio: " << ratio);
-  return static_cast<uint32_t>(ratio * std::pow(2, m_Q));
+  return static_cast<uint32_t>(ratio * m_quantizingScale);
 }
 
 void
@@ -751,15 +770,17 @@ Ipv4CongaRouting::PrintCongaToLeafTable ()
 /*
   std::ostringstream oss;
   oss << "===== CongaToLeafTable For Leaf: " << m_leafId <<"=====" << std::endl;
-  std::map<uint32_t, std::map<uint32_t, uint32_t> >::iterator itr = m_congaToLeafTable.begin ();
-  for ( ; itr != m_congaToLeafTable.end (); ++itr )
+  for (uint32_t leafId = 0; leafId < m_congaToLeafTable.size (); ++leafId)
   {
-    oss << "Leaf ID: " << itr->first << std::endl<<"\t";
-    std::map<uint32_t, uint32_t>::iterator innerItr = (itr->second).begin ();
-    for ( ; innerItr != (itr->second).end (); ++innerItr)
+    oss << "Leaf ID: " << leafId << std::endl<<"\t";
+    for (uint32_t port = 0; port < m_congaToLeafTable[leafId].size (); ++port)
     {
+      if (!m_congaToLeafTable[leafId][port].valid)
+      {
+        continue;
+      }
       oss << "{ port: "
-          << innerItr->first << ", ce: "  << (innerItr->second)
+          << port << ", ce: "  << m_congaToLeafTable[leafId][port].ce
           << " } ";
     }
     oss << std::endl;
@@ -775,16 +796,18 @@ Ipv4CongaRouting::PrintCongaFromLeafTable ()
 /*
   std::ostringstream oss;
   oss << "===== CongaFromLeafTable For Leaf: " << m_leafId << "=====" <<std::endl;
-  std::map<uint32_t, std::map<uint32_t, FeedbackInfo> >::iterator itr = m_congaFromLeafTable.begin ();
-  for ( ; itr != m_congaFromLeafTable.end (); ++itr )
+  for (uint32_t leafId = 0; leafId < m_congaFromLeafTable.size (); ++leafId)
   {
-    oss << "Leaf ID: " << itr->first << std::endl << "\t";
-    std::map<uint32_t, FeedbackInfo>::iterator innerItr = (itr->second).begin ();
-    for ( ; innerItr != (itr->second).end (); ++innerItr)
+    oss << "Leaf ID: " << leafId << std::endl << "\t";
+    for (uint32_t port = 0; port < m_congaFromLeafTable[leafId].size (); ++port)
     {
+      if (!m_congaFromLeafTable[leafId][port].valid)
+      {
+        continue;
+      }
       oss << "{ port: "
-          << innerItr->first << ", ce: "  << (innerItr->second).ce
-          << ", change: " << (innerItr->second).change
+          << port << ", ce: "  << m_congaFromLeafTable[leafId][port].ce
+          << ", change: " << m_congaFromLeafTable[leafId][port].change
           << " } ";
     }
     oss << std::endl;
@@ -800,13 +823,7 @@ Ipv4CongaRouting::PrintFlowletTable ()
 /*
   std::ostringstream oss;
   oss << "===== Flowlet For Leaf: " << m_leafId << "=====" << std::endl;
-  std::map<uint32_t, Flowlet*>::iterator itr = m_flowletTable.begin ();
-  for ( ; itr != m_flowletTable.end(); ++itr )
-  {
-    oss << "flowId: " << itr->first << std::endl << "\t"
-        << "port: " << (itr->second)->port << "\t"
-        << "activeTime" << (itr->second)->activeTime << std::endl;
-  }
+  oss << "capacity: " << m_flowletTable->GetCapacity () << std::endl;
   oss << "===================";
   NS_LOG_LOGIC (oss.str ());
 */
@@ -819,12 +836,11 @@ Ipv4CongaRouting::PrintDreTable ()
   std::ostringstream oss;
   std::string switchType = m_isLeaf == true ? "leaf switch" : "spine switch";
   oss << "==== Local Dre for " << switchType << " ====" <<std::endl;
-  std::map<uint32_t, uint32_t>::iterator itr = m_XMap.begin ();
-  for ( ; itr != m_XMap.end (); ++itr)
+  for (uint32_t port = 0; port < m_X.size (); ++port)
   {
-    oss << "port: " << itr->first <<
-      ", X: " << itr->second <<
-      ", Quantized X: " << Ipv4CongaRouting::QuantizingX (itr->second) <<std::endl;
+    oss << "port: " << port <<
+      ", X: " << m_X[port] <<
+      ", Quantized X: " << Ipv4CongaRouting::QuantizingX (port, m_X[port]) <<std::endl;
   }
   oss << "=================================";
   NS_LOG_LOGIC (oss.str ());
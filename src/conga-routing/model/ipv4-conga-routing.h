@@ -10,27 +10,27 @@
 #include "ns3/data-rate.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-next-hop-cache.h"
+#include "ns3/flowlet-table.h"
+#include "ns3/lazy-dre.h"
 
 #include <map>
 #include <vector>
 
 namespace ns3 {
 
-struct Flowlet {
-  uint32_t port;
-  Time activeTime;
+struct CongestionInfo {
+  uint32_t ce;
+  Time updateTime;
+  bool valid;
 };
 
 struct FeedbackInfo {
   uint32_t ce;
   bool change;
   Time updateTime;
-};
-
-struct CongaRouteEntry {
-  Ipv4Address network;
-  Ipv4Mask networkMask;
-  uint32_t port;
+  bool valid;
 };
 
 class Ipv4CongaRouting : public Ipv4RoutingProtocol
@@ -55,6 +55,9 @@ public:
 
   void SetFlowletTimeout (Time timeout);
 
+  // Set to false to decay the DREs in closed form instead of reproducing the periodic truncation
+  void SetExactDre (bool exact);
+
   void AddAddressToLeafIdMap (Ipv4Address addr, uint32_t leafId);
 
   void AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port);
@@ -63,6 +66,15 @@ public:
 
   void EnableEcmpMode ();
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
   /* Inherit From Ipv4RoutingProtocol */
   virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
   virtual bool RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
@@ -107,54 +119,78 @@ private:
   bool m_ecmpMode;
 
   // ------ Variables ------
-  // Used to maintain the round robin
-  unsigned long m_feedbackIndex;
-
-  // Dre Event ID
-  EventId m_dreEvent;
-
-  // Metric aging event
-  EventId m_agingEvent;
+  // Local DREs are decayed on access, all the ports are aged up to m_dreTick
+  LazyDre m_dre;
+  uint64_t m_dreTick;
 
   // Ipv4 associated with this router
   Ptr<Ipv4> m_ipv4;
 
-  // Route table
-  std::vector<CongaRouteEntry> m_routeEntryList;
+  // Route table and per port routes
+  Ipv4NextHopCache m_nextHopCache;
 
   // Ip and leaf switch map,
   // used to determine the which leaf switch the packet would go through
   std::map<Ipv4Address, uint32_t> m_ipLeafIdMap;
 
-  // Congestion To Leaf Table
-  std::map<uint32_t, std::map<uint32_t, std::pair<Time, uint32_t> > > m_congaToLeafTable;
+  // Congestion To Leaf Table, indexed by [leaf][port]
+  // The entries older than m_agingTime are ignored when they are read
+  std::vector<std::vector<CongestionInfo> > m_congaToLeafTable;
+
+  // Congestion From Leaf Table, indexed by [leaf][port]
+  std::vector<std::vector<FeedbackInfo> > m_congaFromLeafTable;
+
+  // Round robin feedback cursor of each leaf, the next port to piggyback
+  std::vector<uint32_t> m_feedbackCursor;
 
-  // Congestion From Leaf Table
-  std::map<uint32_t, std::map<uint32_t, FeedbackInfo> > m_congaFromLeafTable;
+  // Flowlet Table, the path of the entries is the port
+  Ptr<FlowletTable> m_flowletTable;
 
-  // Flowlet Table
-  std::map<uint32_t, Flowlet *> m_flowletTable;
+  // Local DRE of each port, indexed by port
+  std::vector<uint32_t> m_X;
 
-  // Parameters
-  // DRE
-  std::map<uint32_t, uint32_t> m_XMap;
+  // Quantizing X of each port is X * 8 / divisor * scale, the divisor being
+  // the bits of a saturated DRE, C * Tdre / alpha, and the scale 2^Q
+  std::vector<double> m_quantizingDivisor;
+  double m_quantizingScale;
+
+  // Congestion metric of each candidate port of a new flowlet, reused
+  std::vector<uint32_t> m_portMetrics;
+
+  // Picks a port among the least congested ones
+  Ptr<UniformRandomVariable> m_rand;
 
   // ------ Functions ------
   // DRE algorithm
   uint32_t UpdateLocalDre (const Ipv4Header &header, Ptr<Packet> packet, uint32_t path);
 
-  void DreEvent();
+  void AgeLocalDre ();
+
+  // Grow the per port arrays up to the given number of ports
+  void EnsurePorts (uint32_t size);
+
+  // Bits of a saturated DRE of the port
+  double QuantizingDivisor (uint32_t interface);
+
+  // Compute the quantizing divisors and scale again after a parameter change
+  void UpdateQuantizing ();
 
-  void AgingEvent ();
+  // Fill m_portMetrics with max (local, remote) of each port towards the leaf,
+  // return the lowest metric and the number of ports reaching it
+  uint32_t EvaluatePorts (const std::vector<uint32_t> &ports, uint32_t leafId, uint32_t &count);
+
+  // Congestion tables
+  CongestionInfo & GetCongaToLeafEntry (uint32_t leafId, uint32_t port);
+  FeedbackInfo & GetCongaFromLeafEntry (uint32_t leafId, uint32_t port);
+
+  // Pick the feedback to piggyback to the given leaf, return false if there is none
+  bool SelectFeedback (uint32_t leafId, uint32_t &fbLbTag, uint32_t &fbMetric);
 
   // Quantizing X to metrics degree
   // X is bytes here and we quantizing it to 0 - 2^Q
+  // The interface should be covered by the per port arrays
   uint32_t QuantizingX (uint32_t interface, uint32_t X);
 
-  std::vector<CongaRouteEntry> LookupCongaRouteEntries (Ipv4Address dest);
-
-  Ptr<Ipv4Route> ConstructIpv4Route (uint32_t port, Ipv4Address destAddress);
-
   // Debug use
   void PrintCongaToLeafTable ();
   void PrintCongaFromLeafTable ();
@@ -1,4 +1,5 @@
 #include "ipv4-conga-tag.h"
+#include "ns3/packet.h"
 
 namespace ns3
 {
@@ -106,4 +107,36 @@ Ipv4CongaTag::Print (std::ostream &os) const
   os << "Feedback Metric = " << m_fbMetric;
 }
 
+bool
+Ipv4CongaTag::PeekFrom (Ptr<const Packet> packet)
+{
+  const LbMetadata &metadata = packet->GetLbMetadata ();
+  if (!metadata.Has (LbMetadata::CONGA))
+    {
+      return false;
+    }
+  m_lbTag = metadata.GetCongaLbTag ();
+  m_ce = metadata.GetCongaCe ();
+  m_fbLbTag = metadata.GetCongaFbLbTag ();
+  m_fbMetric = metadata.GetCongaFbMetric ();
+  return true;
+}
+
+void
+Ipv4CongaTag::AddTo (Ptr<const Packet> packet) const
+{
+  packet->GetLbMetadata ().SetConga (m_lbTag, m_ce, m_fbLbTag, m_fbMetric);
+}
+
+bool
+Ipv4CongaTag::RemoveFrom (Ptr<const Packet> packet)
+{
+  if (!PeekFrom (packet))
+    {
+      return false;
+    }
+  packet->GetLbMetadata ().Remove (LbMetadata::CONGA);
+  return true;
+}
+
 }
@@ -2,9 +2,12 @@
 #define NS3_IPV4_CONGA_TAG
 
 #include "ns3/tag.h"
+#include "ns3/ptr.h"
 
 namespace ns3 {
 
+class Packet;
+
 class Ipv4CongaTag: public Tag
 {
 public:
@@ -38,6 +41,13 @@ public:
 
     virtual void Print (std::ostream &os) const;
 
+    // Adapters on the LbMetadata of the packet, AddTo replaces an existing value
+    bool PeekFrom (Ptr<const Packet> packet);
+
+    void AddTo (Ptr<const Packet> packet) const;
+
+    bool RemoveFrom (Ptr<const Packet> packet);
+
 private:
     uint32_t m_lbTag;
     uint32_t m_ce;
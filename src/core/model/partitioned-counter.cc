@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "partitioned-counter.h"
+#include "assert.h"
+#ifdef NS3_MTP
+#include "system-mutex.h"
+#endif
+
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup thread
+ * ns3::PartitionedCounter implementation.
+ */
+
+namespace ns3 {
+
+uint32_t PartitionedCounter::g_partitions = 0;
+#ifdef NS3_MTP
+thread_local uint32_t PartitionedCounter::g_current = 0;
+#else
+uint32_t PartitionedCounter::g_current = 0;
+#endif
+
+std::vector<PartitionedCounter *> *
+PartitionedCounter::GetCounters (void)
+{
+  // Built on first use, the counters are static objects of several modules
+  static std::vector<PartitionedCounter *> counters;
+  return &counters;
+}
+
+#ifdef NS3_MTP
+/**
+ * \returns the mutex of the list of the counters, which the partitions
+ * may build while they run
+ */
+static SystemMutex &
+GetCountersMutex (void)
+{
+  static SystemMutex mutex;
+  return mutex;
+}
+#endif
+
+PartitionedCounter::PartitionedCounter (uint64_t first)
+  : m_next (first)
+{
+#ifdef NS3_MTP
+  CriticalSection cs (GetCountersMutex ());
+#endif
+  if (g_partitions > 0)
+    {
+      m_drawn.assign (g_partitions + 1, 0);
+    }
+  GetCounters ()->push_back (this);
+}
+
+PartitionedCounter::~PartitionedCounter ()
+{
+#ifdef NS3_MTP
+  CriticalSection cs (GetCountersMutex ());
+#endif
+  std::vector<PartitionedCounter *> *counters = GetCounters ();
+  counters->erase (std::remove (counters->begin (), counters->end (), this), counters->end ());
+}
+
+uint64_t
+PartitionedCounter::Next (void)
+{
+  if (g_partitions == 0)
+    {
+      return m_next++;
+    }
+  // Partition p draws m_next + p, m_next + p + stride, ...
+  uint32_t slot = g_current;
+  NS_ASSERT (slot < m_drawn.size ());
+  return m_next + slot + (m_drawn[slot]++) * m_drawn.size ();
+}
+
+void
+PartitionedCounter::Reset (uint64_t first)
+{
+  NS_ASSERT (g_partitions == 0);
+  m_next = first;
+}
+
+void
+PartitionedCounter::BeginPartitions (uint32_t partitions)
+{
+  NS_ASSERT (g_partitions == 0 && partitions > 0);
+  g_partitions = partitions;
+  g_current = partitions;
+  std::vector<PartitionedCounter *> *counters = GetCounters ();
+  for (std::vector<PartitionedCounter *>::iterator i = counters->begin (); i != counters->end (); ++i)
+    {
+      (*i)->m_drawn.assign (partitions + 1, 0);
+    }
+}
+
+void
+PartitionedCounter::EndPartitions (void)
+{
+  if (g_partitions == 0)
+    {
+      return;
+    }
+  std::vector<PartitionedCounter *> *counters = GetCounters ();
+  for (std::vector<PartitionedCounter *>::iterator i = counters->begin (); i != counters->end (); ++i)
+    {
+      PartitionedCounter *counter = *i;
+      uint64_t stride = counter->m_drawn.size ();
+      uint64_t next = counter->m_next;
+      for (uint32_t slot = 0; slot < stride; ++slot)
+        {
+          if (counter->m_drawn[slot] > 0)
+            {
+              next = std::max (next, counter->m_next + slot + (counter->m_drawn[slot] - 1) * stride + 1);
+            }
+        }
+      counter->m_next = next;
+      counter->m_drawn.clear ();
+    }
+  g_partitions = 0;
+  g_current = 0;
+}
+
+void
+PartitionedCounter::SetCurrentPartition (uint32_t partition)
+{
+  NS_ASSERT (partition <= g_partitions);
+  g_current = partition;
+}
+
+} // namespace ns3
@@ -0,0 +1,106 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PARTITIONED_COUNTER_H
+#define PARTITIONED_COUNTER_H
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup thread
+ * ns3::PartitionedCounter declaration.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup thread
+ * \brief A process wide counter, such as the packet uids or the random
+ * stream indexes, whose values do not depend on the threads running the
+ * partitions of a parallel simulator
+ *
+ * Outside of the partitions, Next returns consecutive values. Between
+ * BeginPartitions and EndPartitions, each partition, and the events
+ * running outside of them, draw from their own interleaved sequence
+ * starting at the value of the counter at BeginPartitions. The values a
+ * partition gets then only depend on its own events, whatever the
+ * thread running it and the progress of the other partitions.
+ *
+ * The counters are meant to be static objects: they register
+ * themselves so that BeginPartitions and EndPartitions reach all of them.
+ */
+class PartitionedCounter
+{
+public:
+  /**
+   * \param first the first value handed out
+   */
+  PartitionedCounter (uint64_t first);
+  ~PartitionedCounter ();
+
+  /**
+   * \returns the next value of the sequence of the calling partition
+   */
+  uint64_t Next (void);
+
+  /**
+   * Restart the counter from a value, outside of the partitions.
+   * \param first the next value handed out
+   */
+  void Reset (uint64_t first);
+
+  /**
+   * Give each partition its own sequence in all the counters, until
+   * EndPartitions. Must be called while no partition is running.
+   *
+   * \param partitions the number of partitions
+   */
+  static void BeginPartitions (uint32_t partitions);
+
+  /**
+   * Go back to consecutive values in all the counters, after the
+   * largest value handed out to the partitions.
+   */
+  static void EndPartitions (void);
+
+  /**
+   * Set the partition the calling thread runs the events of.
+   *
+   * \param partition the partition, or the number of partitions for
+   * the events running outside of them
+   */
+  static void SetCurrentPartition (uint32_t partition);
+
+private:
+  /** \returns the list of the existing counters */
+  static std::vector<PartitionedCounter *> *GetCounters (void);
+
+  uint64_t m_next;                 //!< Next value outside of the partitions
+  std::vector<uint64_t> m_drawn;   //!< Values drawn by each partition, the global one last
+
+  static uint32_t g_partitions;    //!< Number of partitions, 0 outside of them
+#ifdef NS3_MTP
+  static thread_local uint32_t g_current; //!< Partition of the calling thread
+#else
+  static uint32_t g_current;       //!< Partition running
+#endif
+};
+
+} // namespace ns3
+
+#endif /* PARTITIONED_COUNTER_H */
@@ -23,6 +23,7 @@
 #include "integer.h"
 #include "config.h"
 #include "log.h"
+#include "partitioned-counter.h"
 
 /**
  * \file
@@ -38,8 +39,15 @@ NS_LOG_COMPONENT_DEFINE ("RngSeedManager");
  * \relates RngSeedManager
  * The next random number generator stream number to use
  * for automatic assignment.
+ *
+ * \returns the counter, built on first use
  */
-static uint64_t g_nextStreamIndex = 0;
+static PartitionedCounter &
+GetStreamIndexCounter (void)
+{
+  static PartitionedCounter counter (0);
+  return counter;
+}
 /**
  * \relates RngSeedManager
  * The random number generator seed number global value.
@@ -94,9 +102,13 @@ uint64_t RngSeedManager::GetRun ()
 uint64_t RngSeedManager::GetNextStreamIndex (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  uint64_t next = g_nextStreamIndex;
-  g_nextStreamIndex++;
-  return next;
+  return GetStreamIndexCounter ().Next ();
+}
+
+void RngSeedManager::ResetNextStreamIndex (void)
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  GetStreamIndexCounter ().Reset (0);
 }
 
 } // namespace ns3
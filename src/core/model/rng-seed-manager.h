@@ -105,6 +105,12 @@ public:
    */
   static uint64_t GetNextStreamIndex(void);
 
+  /**
+   * Start the automatic stream assignment over, to run a scenario
+   * again in the same process with the same streams.
+   */
+  static void ResetNextStreamIndex (void);
+
 };
 
 /** Alias for compatibility. */
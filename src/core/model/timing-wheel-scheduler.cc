@@ -0,0 +1,354 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "timing-wheel-scheduler.h"
+#include "event-impl.h"
+#include "assert.h"
+#include "log.h"
+#include "uinteger.h"
+#include "boolean.h"
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Implementation of ns3::TimingWheelScheduler class.
+ */
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TimingWheelScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED (TimingWheelScheduler);
+
+/** Number of events removed between two checks of the bucket width. */
+static const uint32_t RESIZE_INTERVAL = 4096;
+/** Largest log2 of the bucket width. */
+static const uint32_t MAX_SHIFT = 40;
+
+TypeId
+TimingWheelScheduler::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TimingWheelScheduler")
+    .SetParent<Scheduler> ()
+    .SetGroupName ("Core")
+    .AddConstructor<TimingWheelScheduler> ()
+    .AddAttribute ("Buckets",
+                   "The number of buckets of the wheel, rounded up to a power of two.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&TimingWheelScheduler::SetBuckets),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Width",
+                   "The initial bucket width in time steps, rounded down to a power of two.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&TimingWheelScheduler::SetWidth),
+                   MakeUintegerChecker<uint64_t> (1))
+    .AddAttribute ("AutoResize",
+                   "Whether the bucket width follows the event intervals.",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&TimingWheelScheduler::m_autoResize),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+TimingWheelScheduler::TimingWheelScheduler ()
+  : m_buckets (1024),
+    m_sorted (1024, 0),
+    m_mask (1023),
+    m_shift (10),
+    m_current (0),
+    m_lastTs (0),
+    m_wheelSize (0),
+    m_autoResize (true),
+    m_removed (0),
+    m_scanned (0),
+    m_sortedBuckets (0),
+    m_sortedEvents (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+TimingWheelScheduler::~TimingWheelScheduler ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TimingWheelScheduler::SetBuckets (uint32_t nBuckets)
+{
+  NS_LOG_FUNCTION (this << nBuckets);
+  uint32_t size = 1;
+  while (size < nBuckets && size < (1u << 31))
+    {
+      size <<= 1;
+    }
+  m_mask = size - 1;
+  Resize (m_shift);
+}
+
+void
+TimingWheelScheduler::SetWidth (uint64_t width)
+{
+  NS_LOG_FUNCTION (this << width);
+  uint32_t shift = 0;
+  while ((width >> (shift + 1)) != 0 && shift < MAX_SHIFT)
+    {
+      shift++;
+    }
+  Resize (shift);
+}
+
+bool
+TimingWheelScheduler::IsLater (const Scheduler::Event &a, const Scheduler::Event &b)
+{
+  return b.key < a.key;
+}
+
+void
+TimingWheelScheduler::DoInsert (const Event &ev)
+{
+  uint64_t slot = ev.key.m_ts >> m_shift;
+  // An event cannot run before the last one removed, keep it in the
+  // current bucket where it is the earliest anyway
+  if (slot < m_current)
+    {
+      slot = m_current;
+    }
+  if (slot - m_current > m_mask)
+    {
+      m_overflow.push_back (ev);
+      std::push_heap (m_overflow.begin (), m_overflow.end (), &TimingWheelScheduler::IsLater);
+      return;
+    }
+
+  uint32_t index = slot & m_mask;
+  Bucket &bucket = m_buckets[index];
+  if (m_sorted[index])
+    {
+      bucket.insert (std::upper_bound (bucket.begin (), bucket.end (), ev,
+                                       &TimingWheelScheduler::IsLater),
+                     ev);
+      m_sortedEvents++;
+    }
+  else
+    {
+      bucket.push_back (ev);
+    }
+  m_wheelSize++;
+}
+
+void
+TimingWheelScheduler::Migrate (void)
+{
+  while (!m_overflow.empty ()
+         && (m_overflow.front ().key.m_ts >> m_shift) - m_current <= m_mask)
+    {
+      std::pop_heap (m_overflow.begin (), m_overflow.end (), &TimingWheelScheduler::IsLater);
+      Event ev = m_overflow.back ();
+      m_overflow.pop_back ();
+      DoInsert (ev);
+    }
+}
+
+uint32_t
+TimingWheelScheduler::FindNext (void) const
+{
+  NS_ASSERT (m_wheelSize != 0);
+  uint32_t steps = 0;
+  while (m_buckets[(m_current + steps) & m_mask].empty ())
+    {
+      steps++;
+    }
+  m_scanned += steps;
+  return steps;
+}
+
+void
+TimingWheelScheduler::SortBucket (uint32_t index) const
+{
+  Bucket &bucket = m_buckets[index];
+  std::sort (bucket.begin (), bucket.end (), &TimingWheelScheduler::IsLater);
+  m_sorted[index] = 1;
+  m_sortedBuckets++;
+  m_sortedEvents += bucket.size ();
+}
+
+void
+TimingWheelScheduler::Insert (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  DoInsert (ev);
+}
+
+bool
+TimingWheelScheduler::IsEmpty (void) const
+{
+  NS_LOG_FUNCTION (this);
+  return m_wheelSize == 0 && m_overflow.empty ();
+}
+
+Scheduler::Event
+TimingWheelScheduler::PeekNext (void) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  // The heap only holds events beyond the wheel
+  if (m_wheelSize == 0)
+    {
+      return m_overflow.front ();
+    }
+  uint32_t index = (m_current + FindNext ()) & m_mask;
+  if (!m_sorted[index])
+    {
+      SortBucket (index);
+    }
+  return m_buckets[index].back ();
+}
+
+Scheduler::Event
+TimingWheelScheduler::RemoveNext (void)
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (!IsEmpty ());
+  if (m_wheelSize == 0)
+    {
+      // Jump to the earliest event of the heap
+      m_current = m_overflow.front ().key.m_ts >> m_shift;
+      Migrate ();
+    }
+  else
+    {
+      uint32_t steps = FindNext ();
+      if (steps != 0)
+        {
+          m_current += steps;
+          Migrate ();
+        }
+    }
+
+  uint32_t index = m_current & m_mask;
+  Bucket &bucket = m_buckets[index];
+  if (!m_sorted[index])
+    {
+      SortBucket (index);
+    }
+  Event ev = bucket.back ();
+  bucket.pop_back ();
+  if (bucket.empty ())
+    {
+      m_sorted[index] = 0;
+    }
+  m_wheelSize--;
+  m_lastTs = ev.key.m_ts;
+
+  if (m_autoResize && ++m_removed >= RESIZE_INTERVAL)
+    {
+      CheckResize ();
+    }
+  NS_LOG_DEBUG (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  return ev;
+}
+
+void
+TimingWheelScheduler::Remove (const Event &ev)
+{
+  NS_LOG_FUNCTION (this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+  uint64_t slot = ev.key.m_ts >> m_shift;
+  if (slot < m_current)
+    {
+      slot = m_current;
+    }
+  if (slot - m_current <= m_mask)
+    {
+      uint32_t index = slot & m_mask;
+      Bucket &bucket = m_buckets[index];
+      for (Bucket::iterator i = bucket.begin (); i != bucket.end (); ++i)
+        {
+          if (i->key.m_uid == ev.key.m_uid)
+            {
+              NS_ASSERT (i->impl == ev.impl);
+              bucket.erase (i);
+              if (bucket.empty ())
+                {
+                  m_sorted[index] = 0;
+                }
+              m_wheelSize--;
+              return;
+            }
+        }
+    }
+  else
+    {
+      for (Bucket::iterator i = m_overflow.begin (); i != m_overflow.end (); ++i)
+        {
+          if (i->key.m_uid == ev.key.m_uid)
+            {
+              NS_ASSERT (i->impl == ev.impl);
+              m_overflow.erase (i);
+              std::make_heap (m_overflow.begin (), m_overflow.end (), &TimingWheelScheduler::IsLater);
+              return;
+            }
+        }
+    }
+  NS_ASSERT_MSG (false, "Event " << ev.key.m_uid << " not found");
+}
+
+void
+TimingWheelScheduler::CheckResize (void)
+{
+  NS_LOG_FUNCTION (this << m_removed << m_scanned << m_sortedBuckets << m_sortedEvents);
+  // Both conditions leave a margin, so that the width settles instead of
+  // swinging between two values
+  if (m_sortedEvents > 16 * m_sortedBuckets && m_scanned < m_removed && m_shift > 0)
+    {
+      Resize (m_shift - 1);
+    }
+  else if (m_scanned > 4 * m_removed && m_sortedEvents < 4 * m_sortedBuckets
+           && m_shift < MAX_SHIFT)
+    {
+      Resize (m_shift + 1);
+    }
+  m_removed = 0;
+  m_scanned = 0;
+  m_sortedBuckets = 0;
+  m_sortedEvents = 0;
+}
+
+void
+TimingWheelScheduler::Resize (uint32_t shift)
+{
+  NS_LOG_FUNCTION (this << shift);
+  Bucket events;
+  events.reserve (m_wheelSize);
+  for (std::vector<Bucket>::iterator i = m_buckets.begin (); i != m_buckets.end (); ++i)
+    {
+      events.insert (events.end (), i->begin (), i->end ());
+      i->clear ();
+    }
+  m_buckets.resize (m_mask + 1);
+  m_sorted.assign (m_mask + 1, 0);
+  m_wheelSize = 0;
+
+  m_shift = shift;
+  m_current = m_lastTs >> m_shift;
+  for (Bucket::const_iterator i = events.begin (); i != events.end (); ++i)
+    {
+      DoInsert (*i);
+    }
+  Migrate ();
+}
+
+} // namespace ns3
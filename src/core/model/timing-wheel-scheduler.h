@@ -0,0 +1,156 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TIMING_WHEEL_SCHEDULER_H
+#define TIMING_WHEEL_SCHEDULER_H
+
+#include "scheduler.h"
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * Declaration of ns3::TimingWheelScheduler class.
+ */
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief a two level timing wheel event scheduler
+ *
+ * The near future is a wheel of buckets, each one covering a power of
+ * two number of time steps. A bucket is an unsorted vector until it
+ * becomes the next one to run: it is then sorted once and drained
+ * from its back. The events beyond the wheel wait in a binary heap and
+ * move into the wheel as it turns.
+ *
+ * The buckets keep their capacity, so in steady state inserting and
+ * removing events does not allocate. The bucket width follows the
+ * workload: it is halved when the drained buckets get crowded and
+ * doubled when most of the buckets scanned are empty.
+ *
+ * This scheduler fits workloads with many events a few microseconds
+ * ahead, such as the packet transmissions of a datacenter network.
+ */
+class TimingWheelScheduler : public Scheduler
+{
+public:
+  /**
+   *  Register this type.
+   *  \return The object TypeId.
+   */
+  static TypeId GetTypeId (void);
+
+  /** Constructor. */
+  TimingWheelScheduler ();
+  /** Destructor. */
+  virtual ~TimingWheelScheduler ();
+
+  // Inherited
+  virtual void Insert (const Scheduler::Event &ev);
+  virtual bool IsEmpty (void) const;
+  virtual Scheduler::Event PeekNext (void) const;
+  virtual Scheduler::Event RemoveNext (void);
+  virtual void Remove (const Scheduler::Event &ev);
+
+private:
+  /** Bucket type: a vector of Events, sorted latest first once it is the next one to run. */
+  typedef std::vector<Scheduler::Event> Bucket;
+
+  /**
+   * Set the number of buckets, rounded up to a power of two.
+   *
+   * \param [in] nBuckets The number of buckets.
+   */
+  void SetBuckets (uint32_t nBuckets);
+  /**
+   * Set the initial bucket width, rounded down to a power of two.
+   *
+   * \param [in] width The bucket width, in time steps.
+   */
+  void SetWidth (uint64_t width);
+  /**
+   * Heap order of the events beyond the wheel, the earliest on top.
+   *
+   * \param [in] a The first Event.
+   * \param [in] b The second Event.
+   * \returns \c true if \p a runs after \p b.
+   */
+  static bool IsLater (const Scheduler::Event &a, const Scheduler::Event &b);
+  /**
+   * Insert an event in its bucket, or in the heap if it is beyond the wheel.
+   *
+   * \param [in] ev The new Event.
+   */
+  void DoInsert (const Scheduler::Event &ev);
+  /** Move the events the wheel covers now from the heap to their buckets. */
+  void Migrate (void);
+  /**
+   * Find the first non empty bucket from the current one.
+   *
+   * The wheel must not be empty.
+   *
+   * \returns The number of buckets from the current one to it.
+   */
+  uint32_t FindNext (void) const;
+  /**
+   * Sort a bucket, latest event first, and count it for the resizing.
+   *
+   * \param [in] index The bucket index.
+   */
+  void SortBucket (uint32_t index) const;
+  /** Adapt the bucket width to the events drained since the last check. */
+  void CheckResize (void);
+  /**
+   * Rebuild the wheel with a new bucket width.
+   *
+   * \param [in] shift The log2 of the new bucket width.
+   */
+  void Resize (uint32_t shift);
+
+  /** The wheel of buckets. */
+  mutable std::vector<Bucket> m_buckets;
+  /** Whether each bucket is sorted. */
+  mutable std::vector<uint8_t> m_sorted;
+  /** The events beyond the wheel, a heap ordered by IsLater. */
+  std::vector<Scheduler::Event> m_overflow;
+  /** Number of buckets minus one, the number of buckets is a power of two. */
+  uint32_t m_mask;
+  /** Log2 of the bucket width, in time steps. */
+  uint32_t m_shift;
+  /** Absolute index of the current bucket, the one of the last event removed. */
+  uint64_t m_current;
+  /** Time stamp of the last event removed. */
+  uint64_t m_lastTs;
+  /** Number of events in the wheel, not counting the heap. */
+  uint32_t m_wheelSize;
+  /** Whether the bucket width follows the workload. */
+  bool m_autoResize;
+  /** Events removed since the last resize check. */
+  uint32_t m_removed;
+  /** Empty buckets skipped since the last resize check. */
+  mutable uint32_t m_scanned;
+  /** Buckets sorted since the last resize check. */
+  mutable uint32_t m_sortedBuckets;
+  /** Events in the buckets sorted since the last resize check. */
+  mutable uint32_t m_sortedEvents;
+};
+
+} // namespace ns3
+
+#endif /* TIMING_WHEEL_SCHEDULER_H */
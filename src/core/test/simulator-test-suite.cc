@@ -23,6 +23,10 @@
 #include "ns3/heap-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/calendar-scheduler.h"
+#include "ns3/timing-wheel-scheduler.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/uinteger.h"
+#include <set>
 
 using namespace ns3;
 
@@ -168,6 +172,86 @@ SimulatorEventsTestCase::DoRun (void)
   NS_TEST_EXPECT_MSG_EQ (m_destroy, true, "Event should have run");
 }
 
+class SchedulerOrderTestCase : public TestCase
+{
+public:
+  SchedulerOrderTestCase (ObjectFactory schedulerFactory, std::string description);
+  virtual void DoRun (void);
+  ObjectFactory m_schedulerFactory;
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase (ObjectFactory schedulerFactory, std::string description)
+  : TestCase ("Check the event order of " + schedulerFactory.GetTypeId ().GetName () + description
+              + " against a std::set under random inserts and removes"),
+    m_schedulerFactory (schedulerFactory)
+{
+}
+void
+SchedulerOrderTestCase::DoRun (void)
+{
+  Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler> ();
+  Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable> ();
+  std::set<Scheduler::EventKey> reference;
+  uint64_t now = 0;
+  uint32_t uid = 0;
+
+  for (uint32_t i = 0; i < 20000; ++i)
+    {
+      double op = rng->GetValue ();
+      if (reference.empty () || op < 0.55)
+        {
+          // Events at the same time, a few steps ahead and far ahead
+          double range = rng->GetValue ();
+          uint64_t delay = range < 0.1 ? 0 : (range < 0.8 ? rng->GetInteger (0, 100)
+                                                          : rng->GetInteger (0, 1000000));
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key.m_ts = now + delay;
+          ev.key.m_uid = uid++;
+          ev.key.m_context = 0;
+          scheduler->Insert (ev);
+          reference.insert (ev.key);
+        }
+      else if (op < 0.9)
+        {
+          Scheduler::EventKey expected = *reference.begin ();
+          uint64_t next = scheduler->PeekNext ().key.m_uid;
+          NS_TEST_ASSERT_MSG_EQ (next, expected.m_uid, "Wrong next event");
+          Scheduler::Event ev = scheduler->RemoveNext ();
+          NS_TEST_ASSERT_MSG_EQ (ev.key.m_uid, expected.m_uid, "Wrong event removed");
+          reference.erase (reference.begin ());
+          now = ev.key.m_ts;
+        }
+      else
+        {
+          Scheduler::EventKey key;
+          key.m_ts = now + rng->GetInteger (0, 1000000);
+          key.m_uid = 0;
+          std::set<Scheduler::EventKey>::iterator it = reference.lower_bound (key);
+          if (it == reference.end ())
+            {
+              --it;
+            }
+          Scheduler::Event ev;
+          ev.impl = 0;
+          ev.key = *it;
+          scheduler->Remove (ev);
+          reference.erase (it);
+        }
+      bool empty = scheduler->IsEmpty ();
+      NS_TEST_ASSERT_MSG_EQ (empty, reference.empty (), "Wrong emptiness");
+    }
+
+  while (!reference.empty ())
+    {
+      uint64_t next = scheduler->RemoveNext ().key.m_uid;
+      NS_TEST_ASSERT_MSG_EQ (next, reference.begin ()->m_uid, "Wrong event removed");
+      reference.erase (reference.begin ());
+    }
+  bool empty = scheduler->IsEmpty ();
+  NS_TEST_ASSERT_MSG_EQ (empty, true, "Events left");
+}
+
 class SimulatorTemplateTestCase : public TestCase
 {
 public:
@@ -475,5 +559,18 @@ public:
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
     factory.SetTypeId (CalendarScheduler::GetTypeId ());
     AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+    factory.SetTypeId (TimingWheelScheduler::GetTypeId ());
+    AddTestCase (new SimulatorEventsTestCase (factory), TestCase::QUICK);
+
+    factory.SetTypeId (MapScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, ""), TestCase::QUICK);
+    factory.SetTypeId (CalendarScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, ""), TestCase::QUICK);
+    factory.SetTypeId (TimingWheelScheduler::GetTypeId ());
+    AddTestCase (new SchedulerOrderTestCase (factory, ""), TestCase::QUICK);
+    // A small wheel of narrow buckets sends most events to the heap and resizes
+    factory.Set ("Buckets", UintegerValue (8));
+    factory.Set ("Width", UintegerValue (1));
+    AddTestCase (new SchedulerOrderTestCase (factory, " with 8 buckets"), TestCase::QUICK);
   }
 } g_simulatorTestSuite;
@@ -7,8 +7,11 @@
 #include "ns3/node.h"
 #include "ns3/flow-id-tag.h"
 #include "ns3/ipv4-xpath-tag.h"
+#include "ns3/ipv4-flowcell-tag.h"
 #include "ns3/uinteger.h"
 
+#include <algorithm>
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4DrbRouting");
@@ -22,19 +25,25 @@ Ipv4DrbRouting::GetTypeId (void)
       .SetParent<Object> ()
       .SetGroupName ("DRBRouting")
       .AddConstructor<Ipv4DrbRouting> ()
-      .AddAttribute ("Mode", "DRB Mode, 0 for PER DEST and 1 for PER FLOW",
+      .AddAttribute ("Mode", "DRB Mode, 0 for PER DEST, 1 for PER FLOW and 2 for PER FLOWCELL",
                     UintegerValue (1),
                     MakeUintegerAccessor (&Ipv4DrbRouting::m_mode),
                     MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("FlowcellSize", "Max bytes of a flowcell in the PER FLOWCELL mode",
+                    UintegerValue (65536),
+                    MakeUintegerAccessor (&Ipv4DrbRouting::m_flowcellSize),
+                    MakeUintegerChecker<uint32_t> ())
   ;
 
   return tid;
 }
 
 Ipv4DrbRouting::Ipv4DrbRouting () :
-    m_mode (PER_FLOW)
+    m_mode (PER_FLOW),
+    m_flowcellSize (65536)
 {
   NS_LOG_FUNCTION (this);
+  m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4DrbRouting::~Ipv4DrbRouting ()
@@ -42,6 +51,13 @@ Ipv4DrbRouting::~Ipv4DrbRouting ()
   NS_LOG_FUNCTION (this);
 }
 
+int64_t
+Ipv4DrbRouting::AssignStreams (int64_t stream)
+{
+  m_rand->SetStream (stream);
+  return 1;
+}
+
 bool
 Ipv4DrbRouting::AddPath (uint32_t path)
 {
@@ -51,15 +67,16 @@ Ipv4DrbRouting::AddPath (uint32_t path)
 bool
 Ipv4DrbRouting::AddPath (uint32_t weight, uint32_t path)
 {
-  if (weight != 1 && m_mode != PER_FLOW)
+  if (weight != 1 && m_mode != PER_FLOW && m_mode != PER_FLOWCELL)
   {
-    NS_LOG_ERROR ("You have to use the PER_FLOW mode when the weight != 1");
+    NS_LOG_ERROR ("You have to use the PER_FLOW or PER_FLOWCELL mode when the weight != 1");
     return false;
   }
   for (uint32_t i = 0; i < weight; i++)
   {
     m_paths.push_back (path);
   }
+  m_flowcellPaths.clear ();
   return true;
 }
 
@@ -87,6 +104,7 @@ Ipv4DrbRouting::AddWeightedPath (uint32_t weight, uint32_t path,
     }
     m_extraPaths[key] = paths;
   }
+  m_extraFlowcellPaths.clear ();
   return true;
 }
 
@@ -110,6 +128,7 @@ Ipv4DrbRouting::AddWeightedPath (Ipv4Address destAddr, uint32_t weight, uint32_t
   }
 
   m_extraPaths[destAddr] = paths;
+  m_extraFlowcellPaths.erase (destAddr);
   return true;
 }
 
@@ -125,10 +144,10 @@ Ipv4DrbRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDev
   }
 
   uint32_t flowIndentify = 0;
-  if (m_mode == PER_FLOW)
+  if (m_mode == PER_FLOW || m_mode == PER_FLOWCELL)
   {
     FlowIdTag flowIdTag;
-    bool found = p->PeekPacketTag (flowIdTag);
+    bool found = flowIdTag.PeekFrom (p);
     if (!found)
     {
       sockerr = Socket::ERROR_NOROUTETOHOST;
@@ -148,32 +167,62 @@ Ipv4DrbRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDev
     return 0;
   }
 
-  /* Ugly code, patch to support Weighted Presto */
-  std::vector<uint32_t> paths;
-  std::map<Ipv4Address, std::vector<uint32_t> >::iterator extraItr = m_extraPaths.find (header.GetDestination ());
-  if (extraItr == m_extraPaths.end ())
+  uint32_t path = 0;
+  if (m_mode == PER_FLOWCELL)
   {
-    paths = m_paths;
+    // Presto: keep the path for FlowcellSize bytes of the flow, then move the
+    // flow to the next path of the interleaved weighted schedule
+    const std::vector<uint32_t> &paths = Ipv4DrbRouting::GetFlowcellPaths (header.GetDestination ());
+    if (paths.empty ())
+    {
+      sockerr = Socket::ERROR_NOROUTETOHOST;
+      return 0;
+    }
+
+    std::map<uint32_t, Flowcell>::iterator cellItr = m_flowcells.find (flowIndentify);
+    if (cellItr == m_flowcells.end ())
+    {
+      Flowcell flowcell;
+      flowcell.id = 1;
+      flowcell.bytes = 0;
+      flowcell.index = m_rand->GetInteger (0, paths.size () - 1);
+      cellItr = m_flowcells.insert (std::make_pair (flowIndentify, flowcell)).first;
+    }
+
+    Flowcell &flowcell = cellItr->second;
+    if (flowcell.bytes > 0 && flowcell.bytes + p->GetSize () > m_flowcellSize)
+    {
+      flowcell.id++;
+      flowcell.bytes = 0;
+      flowcell.index = (flowcell.index + 1) % paths.size ();
+    }
+    flowcell.bytes += p->GetSize ();
+    path = paths[flowcell.index % paths.size ()];
+
+    Ipv4FlowcellTag flowcellTag;
+    flowcellTag.SetFlowcellId (flowcell.id);
+    flowcellTag.AddTo (p);
+
+    NS_LOG_LOGIC ("\tFlowcell: " << flowcell.id << " of flow: " << flowIndentify);
   }
   else
   {
-    paths = extraItr->second;
-  }
-  /* Breathe a fresh air to celebrate the end of ugly code */
+    const std::vector<uint32_t> &paths = Ipv4DrbRouting::GetPaths (header.GetDestination ());
 
-  uint32_t index = rand () % paths.size ();
-  std::map<uint32_t, uint32_t>::iterator itr = m_indexMap.find (flowIndentify);
-  if (itr != m_indexMap.end ())
-  {
-    index = itr->second;
-  }
+    uint32_t index = m_rand->GetInteger (0, paths.size () - 1);
+    std::map<uint32_t, uint32_t>::iterator itr = m_indexMap.find (flowIndentify);
+    if (itr != m_indexMap.end ())
+    {
+      index = itr->second;
+    }
 
-  uint32_t path = paths[index];
-  m_indexMap[flowIndentify] = (index + 1) % paths.size ();
+    path = paths[index];
+    m_indexMap[flowIndentify] = (index + 1) % paths.size ();
+  }
 
   Ipv4XPathTag ipv4XPathTag;
   ipv4XPathTag.SetPathId (path);
-  p->AddPacketTag (ipv4XPathTag);
+  ipv4XPathTag.AddTo (p);
 
   NS_LOG_LOGIC ("\tDRB Routing has assigned path: " << path);
 
@@ -182,6 +231,80 @@ Ipv4DrbRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDev
   return 0;
 }
 
+/* Ugly code, patch to support Weighted Presto */
+const std::vector<uint32_t> &
+Ipv4DrbRouting::GetPaths (Ipv4Address destAddr) const
+{
+  std::map<Ipv4Address, std::vector<uint32_t> >::const_iterator extraItr = m_extraPaths.find (destAddr);
+  if (extraItr == m_extraPaths.end ())
+  {
+    return m_paths;
+  }
+  return extraItr->second;
+}
+
+const std::vector<uint32_t> &
+Ipv4DrbRouting::GetFlowcellPaths (Ipv4Address destAddr)
+{
+  std::map<Ipv4Address, std::vector<uint32_t> >::const_iterator extraItr = m_extraPaths.find (destAddr);
+  if (extraItr == m_extraPaths.end ())
+  {
+    if (m_flowcellPaths.empty ())
+    {
+      m_flowcellPaths = Ipv4DrbRouting::InterleavePaths (m_paths);
+    }
+    return m_flowcellPaths;
+  }
+
+  std::vector<uint32_t> &flowcellPaths = m_extraFlowcellPaths[destAddr];
+  if (flowcellPaths.empty ())
+  {
+    flowcellPaths = Ipv4DrbRouting::InterleavePaths (extraItr->second);
+  }
+  return flowcellPaths;
+}
+
+std::vector<uint32_t>
+Ipv4DrbRouting::InterleavePaths (const std::vector<uint32_t> &paths)
+{
+  // The weight of a path is the number of times it is repeated
+  std::vector<uint32_t> pathIds;
+  std::vector<int32_t> weights;
+  std::vector<uint32_t>::const_iterator pathItr = paths.begin ();
+  for ( ; pathItr != paths.end (); ++pathItr)
+  {
+    std::vector<uint32_t>::iterator idItr = std::find (pathIds.begin (), pathIds.end (), *pathItr);
+    if (idItr == pathIds.end ())
+    {
+      pathIds.push_back (*pathItr);
+      weights.push_back (1);
+    }
+    else
+    {
+      weights[idItr - pathIds.begin ()]++;
+    }
+  }
+
+  std::vector<uint32_t> schedule;
+  std::vector<int32_t> current (pathIds.size (), 0);
+  int32_t total = paths.size ();
+  for (int32_t n = 0; n < total; n++)
+  {
+    uint32_t best = 0;
+    for (uint32_t i = 0; i < pathIds.size (); i++)
+    {
+      current[i] += weights[i];
+      if (current[i] > current[best])
+      {
+        best = i;
+      }
+    }
+    current[best] -= total;
+    schedule.push_back (pathIds[best]);
+  }
+  return schedule;
+}
+
 bool
 Ipv4DrbRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
                             UnicastForwardCallback ucb, MulticastForwardCallback mcb,
@@ -228,6 +351,7 @@ Ipv4DrbRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 void
 Ipv4DrbRouting::DoDispose (void)
 {
+  m_rand = 0;
 }
 
 }
@@ -8,6 +8,7 @@
 #include "ns3/packet.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/random-variable-stream.h"
 
 #include <set>
 
@@ -16,7 +17,8 @@ namespace ns3 {
 enum DrbRoutingMode
 {
     PER_DEST = 0,
-    PER_FLOW
+    PER_FLOW,
+    PER_FLOWCELL  // Presto, one path per flowcell of FlowcellSize bytes
 };
 
 class Ipv4DrbRouting : public Ipv4RoutingProtocol
@@ -36,6 +38,15 @@ public:
           const std::set<Ipv4Address>& exclusiveIPs = std::set<Ipv4Address> ());
   bool AddWeightedPath (Ipv4Address destAddr, uint32_t weight, uint32_t path);
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
   /* Inherit From Ipv4RoutingProtocol */
   virtual Ptr<Ipv4Route> RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr);
   virtual bool RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<const NetDevice> idev,
@@ -51,11 +62,35 @@ public:
   virtual void DoDispose (void);
 
 private:
+  // Per flow state of the PER_FLOWCELL mode
+  struct Flowcell
+  {
+    uint32_t id;     // Flowcell id, starts from 1
+    uint32_t bytes;  // Bytes sent in the current flowcell
+    uint32_t index;  // Index in the flowcell path schedule
+  };
+
+  const std::vector<uint32_t> &GetPaths (Ipv4Address destAddr) const;
+  const std::vector<uint32_t> &GetFlowcellPaths (Ipv4Address destAddr);
+
+  // Interleave the repeated path ids of a weighted path list with a smooth
+  // weighted round robin, so that consecutive flowcells use different paths
+  static std::vector<uint32_t> InterleavePaths (const std::vector<uint32_t> &paths);
+
   std::vector<uint32_t> m_paths;
   std::map<Ipv4Address, std::vector<uint32_t> > m_extraPaths;
   std::map<uint32_t, uint32_t> m_indexMap;
   enum DrbRoutingMode m_mode;
 
+  uint32_t m_flowcellSize;
+  std::map<uint32_t, Flowcell> m_flowcells;
+  // Interleaved m_paths and m_extraPaths, built on demand
+  std::vector<uint32_t> m_flowcellPaths;
+  std::map<Ipv4Address, std::vector<uint32_t> > m_extraFlowcellPaths;
+
+  // Picks the first path of a flow
+  Ptr<UniformRandomVariable> m_rand;
+
   Ptr<Ipv4> m_ipv4;
 };
 
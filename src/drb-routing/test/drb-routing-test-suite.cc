@@ -2,6 +2,10 @@
 
 // Include a header file from your module to test.
 #include "ns3/ipv4-drb-routing.h"
+#include "ns3/ipv4-flowcell-tag.h"
+#include "ns3/ipv4-xpath-tag.h"
+#include "ns3/flow-id-tag.h"
+#include "ns3/uinteger.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
@@ -46,6 +50,68 @@ DrbRoutingTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Presto mode: each flowcell of FlowcellSize bytes stays on one path and the
+// flowcells round robin over the weighted paths
+class DrbRoutingFlowcellTestCase : public TestCase
+{
+public:
+  DrbRoutingFlowcellTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+DrbRoutingFlowcellTestCase::DrbRoutingFlowcellTestCase ()
+  : TestCase ("DrbRouting splits flows into weighted flowcells")
+{
+}
+
+void
+DrbRoutingFlowcellTestCase::DoRun (void)
+{
+  Ptr<Ipv4DrbRouting> drb = CreateObject<Ipv4DrbRouting> ();
+  drb->SetAttribute ("Mode", UintegerValue (PER_FLOWCELL));
+  drb->SetAttribute ("FlowcellSize", UintegerValue (3000));
+  NS_TEST_ASSERT_MSG_EQ (drb->AddPath (2, 100), true, "Weighted paths are allowed with flowcells");
+  NS_TEST_ASSERT_MSG_EQ (drb->AddPath (1, 200), true, "Weighted paths are allowed with flowcells");
+
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address ("10.0.0.1"));
+
+  std::map<uint32_t, uint32_t> cellsPerPath;
+  uint32_t previousPath = 0;
+  for (uint32_t i = 0; i < 18; i++)
+    {
+      Ptr<Packet> packet = Create<Packet> (1000);
+      FlowIdTag flowIdTag;
+      flowIdTag.SetFlowId (1);
+      flowIdTag.AddTo (packet);
+
+      Socket::SocketErrno sockerr;
+      drb->RouteOutput (packet, header, 0, sockerr);
+      NS_TEST_ASSERT_MSG_EQ (sockerr, Socket::ERROR_NOTERROR, "A path should be assigned");
+
+      Ipv4XPathTag pathTag;
+      Ipv4FlowcellTag flowcellTag;
+      NS_TEST_ASSERT_MSG_EQ (pathTag.PeekFrom (packet), true, "Missing path");
+      NS_TEST_ASSERT_MSG_EQ (flowcellTag.PeekFrom (packet), true, "Missing flowcell id");
+      NS_TEST_ASSERT_MSG_EQ (flowcellTag.GetFlowcellId (), i / 3 + 1, "Three packets per flowcell");
+
+      if (i % 3 == 0)
+        {
+          cellsPerPath[pathTag.GetPathId ()]++;
+        }
+      else
+        {
+          NS_TEST_ASSERT_MSG_EQ (pathTag.GetPathId (), previousPath, "A flowcell changed its path");
+        }
+      previousPath = pathTag.GetPathId ();
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (cellsPerPath[100], 4, "Path 100 should carry two thirds of the flowcells");
+  NS_TEST_ASSERT_MSG_EQ (cellsPerPath[200], 2, "Path 200 should carry one third of the flowcells");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +127,7 @@ DrbRoutingTestSuite::DrbRoutingTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new DrbRoutingTestCase1, TestCase::QUICK);
+  AddTestCase (new DrbRoutingFlowcellTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
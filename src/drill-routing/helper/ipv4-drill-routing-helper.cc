@@ -55,5 +55,20 @@ Ipv4DrillRoutingHelper::GetDrillRouting (Ptr<Ipv4> ipv4) const
   return 0;
 }
 
+int64_t
+Ipv4DrillRoutingHelper::AssignStreams (NodeContainer c, int64_t stream)
+{
+  int64_t currentStream = stream;
+  for (NodeContainer::Iterator i = c.Begin (); i != c.End (); ++i)
+  {
+    Ptr<Ipv4DrillRouting> drillRouting = GetDrillRouting ((*i)->GetObject<Ipv4> ());
+    if (drillRouting)
+    {
+      currentStream += drillRouting->AssignStreams (currentStream);
+    }
+  }
+  return currentStream - stream;
+}
+
 }
 
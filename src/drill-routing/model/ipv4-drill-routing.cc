@@ -29,15 +29,21 @@ Ipv4DrillRouting::GetTypeId (void)
                      UintegerValue (2),
                      MakeUintegerAccessor (&Ipv4DrillRouting::m_d),
                      MakeUintegerChecker<uint32_t> ())
+      .AddAttribute ("m", "Remember the m least loaded outputs queue",
+                     UintegerValue (1),
+                     MakeUintegerAccessor (&Ipv4DrillRouting::m_m),
+                     MakeUintegerChecker<uint32_t> ())
   ;
 
   return tid;
 }
 
 Ipv4DrillRouting::Ipv4DrillRouting ()
-    : m_d (2)
+    : m_d (2),
+      m_m (1)
 {
   NS_LOG_FUNCTION (this);
+  m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4DrillRouting::~Ipv4DrillRouting ()
@@ -49,85 +55,122 @@ void
 Ipv4DrillRouting::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port)
 {
   NS_LOG_LOGIC (this << " Add Drill routing entry: " << network << "/" << networkMask << " would go through port: " << port);
-  DrillRouteEntry drillRouteEntry;
-  drillRouteEntry.network = network;
-  drillRouteEntry.networkMask = networkMask;
-  drillRouteEntry.port = port;
-  m_routeEntryList.push_back (drillRouteEntry);
+  m_nextHopCache.AddRoute (network, networkMask, port);
+  m_memory.clear ();
 }
 
-std::vector<DrillRouteEntry>
-Ipv4DrillRouting::LookupDrillRouteEntries (Ipv4Address dest)
+int64_t
+Ipv4DrillRouting::AssignStreams (int64_t stream)
 {
-  std::vector<DrillRouteEntry> drillRouteEntries;
-  std::vector<DrillRouteEntry>::iterator itr = m_routeEntryList.begin ();
-  for ( ; itr != m_routeEntryList.end (); ++itr)
-  {
-    if((*itr).networkMask.IsMatch(dest, (*itr).network))
-    {
-      drillRouteEntries.push_back (*itr);
-    }
-  }
-  return drillRouteEntries;
+  m_rand->SetStream (stream);
+  return 1;
 }
 
 uint32_t
 Ipv4DrillRouting::CalculateQueueLength (uint32_t interface)
 {
-  Ptr<Ipv4L3Protocol> ipv4L3Protocol = DynamicCast<Ipv4L3Protocol> (m_ipv4);
-  if (!ipv4L3Protocol)
+  if (interface >= m_portLoads.size ())
   {
-    NS_LOG_ERROR (this << " Drill routing cannot work other than Ipv4L3Protocol");
-    return 0;
+    BindPortLoads (interface);
   }
+  const PortLoad &load = m_portLoads[interface];
+  return load.deviceBytes + load.queueDiscBytes;
+}
 
-  uint32_t totalLength = 0;
+void
+Ipv4DrillRouting::UpdateBytes (uint32_t *bytes, uint32_t oldValue, uint32_t newValue)
+{
+  *bytes = newValue;
+}
 
-  const Ptr<NetDevice> netDevice = this->m_ipv4->GetNetDevice (interface);
+void
+Ipv4DrillRouting::BindPortLoads (uint32_t port)
+{
+  Ptr<TrafficControlLayer> tc = m_ipv4->GetObject<Node> ()->GetObject<TrafficControlLayer> ();
 
-  if (netDevice->IsPointToPoint ())
+  while (m_portLoads.size () <= port)
   {
+    uint32_t interface = m_portLoads.size ();
+    m_portLoads.push_back (PortLoad ());
+    PortLoad &load = m_portLoads.back ();
+    load.deviceBytes = 0;
+    load.queueDiscBytes = 0;
+
+    const Ptr<NetDevice> netDevice = m_ipv4->GetNetDevice (interface);
+
     Ptr<PointToPointNetDevice> p2pNetDevice = DynamicCast<PointToPointNetDevice> (netDevice);
-    if (p2pNetDevice)
+    if (p2pNetDevice && p2pNetDevice->GetQueue ())
     {
-      totalLength += p2pNetDevice->GetQueue ()->GetNBytes ();
+      load.queue = p2pNetDevice->GetQueue ();
+      load.deviceBytes = load.queue->GetNBytes ();
+      load.queue->TraceConnectWithoutContext ("BytesInQueue",
+                                              MakeBoundCallback (&Ipv4DrillRouting::UpdateBytes, &load.deviceBytes));
     }
-  }
 
-  Ptr<TrafficControlLayer> tc = ipv4L3Protocol->GetNode ()->GetObject<TrafficControlLayer> ();
+    if (tc)
+    {
+      load.queueDisc = tc->GetRootQueueDiscOnDevice (netDevice);
+    }
+    if (load.queueDisc)
+    {
+      load.queueDiscBytes = load.queueDisc->GetNBytes ();
+      load.queueDisc->TraceConnectWithoutContext ("BytesInQueue",
+                                                  MakeBoundCallback (&Ipv4DrillRouting::UpdateBytes, &load.queueDiscBytes));
+    }
+  }
+}
 
-  if (!tc)
+void
+Ipv4DrillRouting::UnbindPortLoads (void)
+{
+  for (std::deque<PortLoad>::iterator itr = m_portLoads.begin (); itr != m_portLoads.end (); ++itr)
   {
-    return totalLength;
+    if (itr->queue)
+    {
+      itr->queue->TraceDisconnectWithoutContext ("BytesInQueue",
+                                                 MakeBoundCallback (&Ipv4DrillRouting::UpdateBytes, &itr->deviceBytes));
+    }
+    if (itr->queueDisc)
+    {
+      itr->queueDisc->TraceDisconnectWithoutContext ("BytesInQueue",
+                                                     MakeBoundCallback (&Ipv4DrillRouting::UpdateBytes, &itr->queueDiscBytes));
+    }
   }
+  m_portLoads.clear ();
+}
 
-  Ptr<QueueDisc> queueDisc = tc->GetRootQueueDiscOnDevice (netDevice);
-  if (queueDisc)
+void
+Ipv4DrillRouting::SamplePorts (uint32_t n)
+{
+  // Floyd's algorithm: d distinct indices without shuffling the group
+  m_samples.clear ();
+  uint32_t sampleNum = m_d < n ? m_d : n;
+  for (uint32_t j = n - sampleNum; j < n; j++)
   {
-    totalLength += queueDisc->GetNBytes ();
+    uint32_t t = m_rand->GetInteger (0, j);
+    if (std::find (m_samples.begin (), m_samples.end (), t) != m_samples.end ())
+    {
+      t = j;
+    }
+    m_samples.push_back (t);
   }
-
-  return totalLength;
 }
 
-Ptr<Ipv4Route>
-Ipv4DrillRouting::ConstructIpv4Route (uint32_t port, Ipv4Address destAddress)
+uint32_t *
+Ipv4DrillRouting::GetMemory (uint32_t iif, uint32_t group)
 {
-  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (port);
-  Ptr<Channel> channel = dev->GetChannel ();
-  uint32_t otherEnd = (channel->GetDevice (0) == dev) ? 1 : 0;
-  Ptr<Node> nextHop = channel->GetDevice (otherEnd)->GetNode ();
-  uint32_t nextIf = channel->GetDevice (otherEnd)->GetIfIndex ();
-  Ipv4Address nextHopAddr = nextHop->GetObject<Ipv4>()->GetAddress(nextIf,0).GetLocal();
-  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
-  route->SetOutputDevice (m_ipv4->GetNetDevice (port));
-  route->SetGateway (nextHopAddr);
-  route->SetSource (m_ipv4->GetAddress (port, 0).GetLocal ());
-  route->SetDestination (destAddress);
-  return route;
+  if (iif >= m_memory.size ())
+  {
+    m_memory.resize (iif + 1);
+  }
+  std::vector<uint32_t> &memory = m_memory[iif];
+  if (memory.size () < (group + 1) * m_m)
+  {
+    memory.resize ((group + 1) * m_m, std::numeric_limits<uint32_t>::max ());
+  }
+  return &memory[group * m_m];
 }
 
-
 /* Inherit From Ipv4RoutingProtocol */
 Ptr<Ipv4Route>
 Ipv4DrillRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
@@ -164,7 +207,8 @@ Ipv4DrillRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     return false;
   }
 
-  std::vector<DrillRouteEntry> allPorts = Ipv4DrillRouting::LookupDrillRouteEntries (destAddress);
+  uint32_t group = m_nextHopCache.LookupGroup (destAddress);
+  const std::vector<uint32_t> &allPorts = m_nextHopCache.GetGroupPorts (group);
 
   if (allPorts.empty ())
   {
@@ -173,36 +217,60 @@ Ipv4DrillRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
     return false;
   }
 
-  uint32_t leastLoadInterface = 0;
-  uint32_t leastLoad = std::numeric_limits<uint32_t>::max ();
-
-  std::random_shuffle (allPorts.begin (), allPorts.end ());
-
-  std::map<Ipv4Address, uint32_t>::iterator itr = m_previousBestQueueMap.find (destAddress);
+  if (allPorts.size () == 1)
+  {
+    ucb (m_nextHopCache.GetRoute (allPorts[0]), packet, header);
+    return true;
+  }
 
-  if (itr != m_previousBestQueueMap.end ())
+  // The remembered ports go first, so they win the ties
+  m_candidates.clear ();
+  uint32_t *memory = GetMemory (iif, group);
+  for (uint32_t unit = 0; unit < m_m; unit++)
   {
-    leastLoadInterface = itr->second;
-    leastLoad = CalculateQueueLength (itr->second);
+    if (memory[unit] != std::numeric_limits<uint32_t>::max ())
+    {
+      m_candidates.push_back (std::make_pair (CalculateQueueLength (memory[unit]), memory[unit]));
+    }
   }
 
-  uint32_t sampleNum = m_d < allPorts.size () ? m_d : allPorts.size ();
+  SamplePorts (allPorts.size ());
+  for (std::vector<uint32_t>::const_iterator itr = m_samples.begin (); itr != m_samples.end (); ++itr)
+  {
+    uint32_t samplePort = allPorts[*itr];
+    bool remembered = false;
+    for (uint32_t unit = 0; unit < m_m; unit++)
+    {
+      remembered = remembered || memory[unit] == samplePort;
+    }
+    if (!remembered)
+    {
+      m_candidates.push_back (std::make_pair (CalculateQueueLength (samplePort), samplePort));
+    }
+  }
 
-  for (uint32_t samplePort = 0; samplePort < sampleNum; samplePort ++)
+  // Keep the m least loaded candidates, the first one is the choice
+  uint32_t rememberNum = m_m < m_candidates.size () ? m_m : m_candidates.size ();
+  for (uint32_t unit = 0; unit < rememberNum; unit++)
   {
-    uint32_t sampleLoad = Ipv4DrillRouting::CalculateQueueLength (allPorts[samplePort].port);
-    if (sampleLoad < leastLoad)
+    uint32_t best = unit;
+    for (uint32_t i = unit + 1; i < m_candidates.size (); i++)
     {
-      leastLoad = sampleLoad;
-      leastLoadInterface = allPorts[samplePort].port;
+      if (m_candidates[i].first < m_candidates[best].first)
+      {
+        best = i;
+      }
     }
+    std::swap (m_candidates[unit], m_candidates[best]);
+    memory[unit] = m_candidates[unit].second;
   }
 
-  NS_LOG_INFO (this << " Drill routing chooses interface: " << leastLoadInterface << ", since its load is: " << leastLoad);
+  uint32_t leastLoadInterface = m_candidates[0].second;
+  uint32_t leastLoad = m_candidates[0].first;
 
-  m_previousBestQueueMap[destAddress] = leastLoadInterface;
+  NS_LOG_INFO (this << " Drill routing chooses interface: " << leastLoadInterface << ", since its load is: " << leastLoad);
 
-  Ptr<Ipv4Route> route = Ipv4DrillRouting::ConstructIpv4Route (leastLoadInterface, destAddress);
+  Ptr<Ipv4Route> route = m_nextHopCache.GetRoute (leastLoadInterface);
   ucb (route, packet, header);
 
   return true;
@@ -211,21 +279,29 @@ Ipv4DrillRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr
 void
 Ipv4DrillRouting::NotifyInterfaceUp (uint32_t interface)
 {
+  m_nextHopCache.Invalidate ();
+  m_memory.clear ();
 }
 
 void
 Ipv4DrillRouting::NotifyInterfaceDown (uint32_t interface)
 {
+  m_nextHopCache.Invalidate ();
+  m_memory.clear ();
 }
 
 void
 Ipv4DrillRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_nextHopCache.Invalidate ();
+  m_memory.clear ();
 }
 
 void
 Ipv4DrillRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_nextHopCache.Invalidate ();
+  m_memory.clear ();
 }
 
 void
@@ -234,6 +310,7 @@ Ipv4DrillRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_LOGIC (this << "Setting up Ipv4: " << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  m_nextHopCache.SetIpv4 (ipv4);
 }
 
 void
@@ -244,6 +321,10 @@ Ipv4DrillRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 void
 Ipv4DrillRouting::DoDispose (void)
 {
+  UnbindPortLoads ();
+  m_memory.clear ();
+  m_rand = 0;
+  m_nextHopCache.Clear ();
 }
 }
 
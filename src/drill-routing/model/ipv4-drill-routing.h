@@ -8,19 +8,28 @@
 #include "ns3/packet.h"
 #include "ns3/ipv4-header.h"
 #include "ns3/ipv4-address.h"
+#include "ns3/queue.h"
+#include "ns3/queue-disc.h"
+#include "ns3/ipv4-next-hop-cache.h"
+#include "ns3/random-variable-stream.h"
 
 #include <vector>
-#include <map>
+#include <deque>
 
 namespace ns3 {
 
-struct DrillRouteEntry {
-  Ipv4Address network;
-  Ipv4Mask networkMask;
-  uint32_t port;
-};
-
-
+/**
+ * DRILL samples the queue length of d random ports of the ECMP group and of
+ * the m least loaded ports it remembers from the previous packets, and picks
+ * the least loaded one. As in the DRILL paper, the memory is per input port
+ * (one forwarding engine per input port), and per ECMP group since the ports
+ * remembered for one group are not valid for the others.
+ *
+ * The queue length of a port is the number of bytes in the queue of its
+ * point to point device and in its root queue disc. They are bound the first
+ * time the port is sampled, and kept up to date by their BytesInQueue traces,
+ * so sampling a port reads two counters.
+ */
 class Ipv4DrillRouting : public Ipv4RoutingProtocol {
 
 public:
@@ -30,10 +39,17 @@ public:
   static TypeId GetTypeId (void);
 
   void AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port);
-  std::vector<DrillRouteEntry> LookupDrillRouteEntries (Ipv4Address dest);
 
   uint32_t CalculateQueueLength (uint32_t interface);
-  Ptr<Ipv4Route> ConstructIpv4Route (uint32_t port, Ipv4Address destAddress);
+
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
 
 
   /* Inherit From Ipv4RoutingProtocol */
@@ -51,11 +67,43 @@ public:
   virtual void DoDispose (void);
 
 private:
+  // Bytes queued on one port, pushed by the BytesInQueue traces
+  struct PortLoad
+  {
+    uint32_t deviceBytes;
+    uint32_t queueDiscBytes;
+    Ptr<Queue> queue;
+    Ptr<QueueDisc> queueDisc;
+  };
+
+  static void UpdateBytes (uint32_t *bytes, uint32_t oldValue, uint32_t newValue);
+
+  // Bind the queues of all the ports up to this one
+  void BindPortLoads (uint32_t port);
+
+  void UnbindPortLoads (void);
+
+  // Draw m_d distinct indices in [0, n) into m_samples
+  void SamplePorts (uint32_t n);
+
+  // The m_m remembered ports of an ECMP group seen from an input port
+  uint32_t *GetMemory (uint32_t iif, uint32_t group);
+
   uint32_t m_d;
-  std::map<Ipv4Address, uint32_t> m_previousBestQueueMap;
+  uint32_t m_m;
+
+  // Deque: the traces keep pointers to the counters
+  std::deque<PortLoad> m_portLoads;
+
+  // Input port -> (group * m_m + unit) -> remembered port
+  std::vector<std::vector<uint32_t> > m_memory;
+
+  Ptr<UniformRandomVariable> m_rand;
+  std::vector<uint32_t> m_samples;
+  std::vector<std::pair<uint32_t, uint32_t> > m_candidates;
 
   Ptr<Ipv4> m_ipv4;
-  std::vector<DrillRouteEntry> m_routeEntryList;
+  Ipv4NextHopCache m_nextHopCache;
 };
 
 }
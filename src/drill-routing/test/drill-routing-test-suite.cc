@@ -1,55 +1,130 @@
 /* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
 
-// Include a header file from your module to test.
 #include "ns3/ipv4-drill-routing.h"
-
-// An essential include is test.h
 #include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node-container.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/queue.h"
 
-// Do not put your test classes in namespace ns3.  You may find it useful
-// to use the using directive to access the ns3 namespace directly
 using namespace ns3;
 
-// This is an example TestCase.
-class DrillRoutingTestCase1 : public TestCase
+class DrillRoutingQueueTestCase : public TestCase
 {
 public:
-  DrillRoutingTestCase1 ();
-  virtual ~DrillRoutingTestCase1 ();
+  DrillRoutingQueueTestCase ();
+  virtual ~DrillRoutingQueueTestCase ();
 
 private:
   virtual void DoRun (void);
+
+  void Forward (Ptr<Ipv4Route> route, Ptr<const Packet> packet, const Ipv4Header &header);
+  void Error (Ptr<const Packet> packet, const Ipv4Header &header, Socket::SocketErrno sockerr);
+
+  Ptr<NetDevice> m_outputDevice;
 };
 
-// Add some help text to this case to describe what it is intended to test
-DrillRoutingTestCase1::DrillRoutingTestCase1 ()
-  : TestCase ("DrillRouting test case (does nothing)")
+DrillRoutingQueueTestCase::DrillRoutingQueueTestCase ()
+  : TestCase ("Drill routing picks the output with the shortest queue")
 {
 }
 
-// This destructor does nothing but we include it as a reminder that
-// the test case should clean up after itself
-DrillRoutingTestCase1::~DrillRoutingTestCase1 ()
+DrillRoutingQueueTestCase::~DrillRoutingQueueTestCase ()
+{
+}
+
+void
+DrillRoutingQueueTestCase::Forward (Ptr<Ipv4Route> route, Ptr<const Packet> packet, const Ipv4Header &header)
 {
+  m_outputDevice = route->GetOutputDevice ();
 }
 
-//
-// This method is the pure virtual method from class TestCase that every
-// TestCase must implement
-//
 void
-DrillRoutingTestCase1::DoRun (void)
+DrillRoutingQueueTestCase::Error (Ptr<const Packet> packet, const Ipv4Header &header, Socket::SocketErrno sockerr)
 {
-  // A wide variety of test macros are available in src/core/test.h
-  NS_TEST_ASSERT_MSG_EQ (true, true, "true doesn't equal true for some reason");
-  // Use this one for floating point comparisons
-  NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
+  m_outputDevice = 0;
+}
+
+void
+DrillRoutingQueueTestCase::DoRun (void)
+{
+  // The router forwards from the source to two next hops
+  NodeContainer nodes;
+  nodes.Create (4);
+  InternetStackHelper internet;
+  internet.Install (nodes);
+
+  PointToPointHelper p2p;
+  Ipv4AddressHelper address;
+  NetDeviceContainer input = p2p.Install (nodes.Get (0), nodes.Get (1));
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  address.Assign (input);
+  NetDeviceContainer output1 = p2p.Install (nodes.Get (0), nodes.Get (2));
+  address.SetBase ("10.1.2.0", "255.255.255.0");
+  address.Assign (output1);
+  NetDeviceContainer output2 = p2p.Install (nodes.Get (0), nodes.Get (3));
+  address.SetBase ("10.1.3.0", "255.255.255.0");
+  address.Assign (output2);
+
+  Ptr<Ipv4> ipv4 = nodes.Get (0)->GetObject<Ipv4> ();
+  uint32_t port1 = ipv4->GetInterfaceForDevice (output1.Get (0));
+  uint32_t port2 = ipv4->GetInterfaceForDevice (output2.Get (0));
+
+  Ptr<Ipv4DrillRouting> drill = CreateObject<Ipv4DrillRouting> ();
+  drill->SetIpv4 (ipv4);
+  drill->AssignStreams (1);
+  drill->AddRoute (Ipv4Address ("10.2.0.0"), Ipv4Mask ("255.255.0.0"), port1);
+  drill->AddRoute (Ipv4Address ("10.2.0.0"), Ipv4Mask ("255.255.0.0"), port2);
+
+  Ptr<Queue> queue1 = DynamicCast<PointToPointNetDevice> (output1.Get (0))->GetQueue ();
+  Ptr<Queue> queue2 = DynamicCast<PointToPointNetDevice> (output2.Get (0))->GetQueue ();
+
+  NS_TEST_ASSERT_MSG_EQ (drill->CalculateQueueLength (port1), 0, "The queue should be empty");
+
+  // The counters follow the queues once they are bound
+  queue1->Enqueue (Create<QueueItem> (Create<Packet> (1000)));
+  queue1->Enqueue (Create<QueueItem> (Create<Packet> (1000)));
+  NS_TEST_ASSERT_MSG_EQ (drill->CalculateQueueLength (port1), 2000, "The queue length is not pushed");
+
+  Ipv4Header header;
+  header.SetSource (Ipv4Address ("10.1.1.2"));
+  header.SetDestination (Ipv4Address ("10.2.0.1"));
+  Ptr<Packet> packet = Create<Packet> (100);
+
+  Ipv4RoutingProtocol::UnicastForwardCallback ucb = MakeCallback (&DrillRoutingQueueTestCase::Forward, this);
+  Ipv4RoutingProtocol::ErrorCallback ecb = MakeCallback (&DrillRoutingQueueTestCase::Error, this);
+
+  // With d = 2, both outputs are sampled for every packet
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      drill->RouteInput (packet, header, input.Get (0), ucb, Ipv4RoutingProtocol::MulticastForwardCallback (),
+                         Ipv4RoutingProtocol::LocalDeliverCallback (), ecb);
+      NS_TEST_ASSERT_MSG_EQ (m_outputDevice, output2.Get (0), "Drill should avoid the longer queue");
+    }
+
+  queue2->Enqueue (Create<QueueItem> (Create<Packet> (1000)));
+  queue2->Enqueue (Create<QueueItem> (Create<Packet> (1000)));
+  queue2->Enqueue (Create<QueueItem> (Create<Packet> (1000)));
+  drill->RouteInput (packet, header, input.Get (0), ucb, Ipv4RoutingProtocol::MulticastForwardCallback (),
+                     Ipv4RoutingProtocol::LocalDeliverCallback (), ecb);
+  NS_TEST_ASSERT_MSG_EQ (m_outputDevice, output1.Get (0), "Drill should move to the shorter queue");
+
+  queue1->Dequeue ();
+  queue1->Dequeue ();
+  NS_TEST_ASSERT_MSG_EQ (drill->CalculateQueueLength (port1), 0, "The dequeues are not pushed");
+
+  header.SetDestination (Ipv4Address ("10.3.0.1"));
+  drill->RouteInput (packet, header, input.Get (0), ucb, Ipv4RoutingProtocol::MulticastForwardCallback (),
+                     Ipv4RoutingProtocol::LocalDeliverCallback (), ecb);
+  NS_TEST_ASSERT_MSG_EQ (m_outputDevice, 0, "There is no route to this destination");
+
+  drill->Dispose ();
+  Simulator::Destroy ();
 }
 
-// The TestSuite class names the TestSuite, identifies what type of TestSuite,
-// and enables the TestCases to be run.  Typically, only the constructor for
-// this class must be defined
-//
 class DrillRoutingTestSuite : public TestSuite
 {
 public:
@@ -59,10 +134,7 @@ public:
 DrillRoutingTestSuite::DrillRoutingTestSuite ()
   : TestSuite ("drill-routing", UNIT)
 {
-  // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
-  AddTestCase (new DrillRoutingTestCase1, TestCase::QUICK);
+  AddTestCase (new DrillRoutingQueueTestCase, TestCase::QUICK);
 }
 
-// Do not forget to allocate an instance of this TestSuite
 static DrillRoutingTestSuite drillRoutingTestSuite;
-
@@ -22,6 +22,8 @@
 #include "ns3/simulator.h"
 #include "ns3/log.h"
 #include "ns3/double.h"
+#include "ns3/boolean.h"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
@@ -29,12 +31,26 @@
 
 #define PERIODIC_CHECK_INTERVAL (Seconds (1))
 
+#define TRACKED_PACKETS_INITIAL_SLOTS 1024
+
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("FlowMonitor");
 
 NS_OBJECT_ENSURE_REGISTERED (FlowMonitor);
 
+static inline uint64_t
+TrackedPacketKey (FlowId flowId, FlowPacketId packetId)
+{
+  return (static_cast<uint64_t> (flowId) << 32) | packetId;
+}
+
+static inline uint32_t
+TrackedPacketHash (uint64_t key)
+{
+  return (key * 0x9e3779b97f4a7c15ULL) >> 32;
+}
+
 
 TypeId
 FlowMonitor::GetTypeId (void)
@@ -72,6 +88,12 @@ FlowMonitor::GetTypeId (void)
                    TimeValue (Seconds (0.5)),
                    MakeTimeAccessor (&FlowMonitor::m_flowInterruptionsMinTime),
                    MakeTimeChecker ())
+    .AddAttribute ("LightMode", ("Only record the counters, times and paths of the flows, "
+                                 "without tracking each packet for delays, jitters, histograms and losses. "
+                                 "The forward count of a flow then includes the packets which are not received."),
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&FlowMonitor::m_lightMode),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -83,7 +105,9 @@ FlowMonitor::GetInstanceTypeId (void) const
 }
 
 FlowMonitor::FlowMonitor ()
-  : m_enabled (false)
+  : m_trackedPacketCount (0),
+    m_lightMode (false),
+    m_enabled (false)
 {
   // m_histogramBinWidth=DEFAULT_BIN_WIDTH;
 }
@@ -108,29 +132,93 @@ FlowMonitor::DoDispose (void)
 inline FlowMonitor::FlowStats&
 FlowMonitor::GetStatsForFlow (FlowId flowId)
 {
-  FlowStatsContainerI iter;
-  iter = m_flowStats.find (flowId);
-  if (iter == m_flowStats.end ())
-    {
-      FlowMonitor::FlowStats &ref = m_flowStats[flowId];
-      ref.delaySum = Seconds (0);
-      ref.jitterSum = Seconds (0);
-      ref.lastDelay = Seconds (0);
-      ref.txBytes = 0;
-      ref.rxBytes = 0;
-      ref.txPackets = 0;
-      ref.rxPackets = 0;
-      ref.lostPackets = 0;
-      ref.timesForwarded = 0;
-      ref.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
-      ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
-      ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
-      ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
-      return ref;
+  if (flowId < m_flowStatsById.size () && m_flowStatsById[flowId] != 0)
+    {
+      return *m_flowStatsById[flowId];
     }
-  else
+  FlowMonitor::FlowStats &ref = m_flowStats[flowId];
+  ref.delaySum = Seconds (0);
+  ref.jitterSum = Seconds (0);
+  ref.lastDelay = Seconds (0);
+  ref.txBytes = 0;
+  ref.rxBytes = 0;
+  ref.txPackets = 0;
+  ref.rxPackets = 0;
+  ref.lostPackets = 0;
+  ref.timesForwarded = 0;
+  ref.delayHistogram.SetDefaultBinWidth (m_delayBinWidth);
+  ref.jitterHistogram.SetDefaultBinWidth (m_jitterBinWidth);
+  ref.packetSizeHistogram.SetDefaultBinWidth (m_packetSizeBinWidth);
+  ref.flowInterruptionsHistogram.SetDefaultBinWidth (m_flowInterruptionsBinWidth);
+  if (flowId >= m_flowStatsById.size ())
     {
-      return iter->second;
+      m_flowStatsById.resize (flowId + 1, 0);
+    }
+  m_flowStatsById[flowId] = &ref;
+  return ref;
+}
+
+uint32_t
+FlowMonitor::FindTrackedPacketSlot (uint64_t key) const
+{
+  uint32_t mask = m_trackedPackets.size () - 1;
+  uint32_t slot = TrackedPacketHash (key) & mask;
+  while (m_trackedPackets[slot].key != 0 && m_trackedPackets[slot].key != key)
+    {
+      slot = (slot + 1) & mask;
+    }
+  return slot;
+}
+
+FlowMonitor::TrackedPacket&
+FlowMonitor::InsertTrackedPacket (uint64_t key)
+{
+  NS_ASSERT_MSG (key != 0, "Flow 0 cannot be tracked");
+  if ((m_trackedPacketCount + 1) * 4 > m_trackedPackets.size () * 3)
+    {
+      // keep the load under 3/4, so that the probe sequences stay short
+      std::vector<TrackedPacketSlot> slots (std::max<uint32_t> (TRACKED_PACKETS_INITIAL_SLOTS,
+                                                                m_trackedPackets.size () * 2));
+      slots.swap (m_trackedPackets);
+      for (uint32_t i = 0; i < m_trackedPackets.size (); i++)
+        {
+          m_trackedPackets[i].key = 0;
+        }
+      for (uint32_t i = 0; i < slots.size (); i++)
+        {
+          if (slots[i].key != 0)
+            {
+              m_trackedPackets[FindTrackedPacketSlot (slots[i].key)] = slots[i];
+            }
+        }
+    }
+  TrackedPacketSlot &slot = m_trackedPackets[FindTrackedPacketSlot (key)];
+  if (slot.key == 0)
+    {
+      slot.key = key;
+      m_trackedPacketCount++;
+    }
+  return slot.packet;
+}
+
+void
+FlowMonitor::EraseTrackedPacketSlot (uint32_t slot)
+{
+  // shift back the next packets of the probe sequence which are allowed to
+  // be in the freed slot, so that no tombstone is needed
+  uint32_t mask = m_trackedPackets.size () - 1;
+  uint32_t hole = slot;
+  m_trackedPackets[hole].key = 0;
+  m_trackedPacketCount--;
+  for (uint32_t next = (hole + 1) & mask; m_trackedPackets[next].key != 0; next = (next + 1) & mask)
+    {
+      uint32_t home = TrackedPacketHash (m_trackedPackets[next].key) & mask;
+      if (((next - home) & mask) >= ((next - hole) & mask))
+        {
+          m_trackedPackets[hole] = m_trackedPackets[next];
+          m_trackedPackets[next].key = 0;
+          hole = next;
+        }
     }
 }
 
@@ -143,14 +231,17 @@ FlowMonitor::ReportFirstTx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t pack
       return;
     }
   Time now = Simulator::Now ();
-  TrackedPacket &tracked = m_trackedPackets[std::make_pair (flowId, packetId)];
-  tracked.firstSeenTime = now;
-  tracked.lastSeenTime = tracked.firstSeenTime;
-  tracked.timesForwarded = 0;
-  NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
-                                                                << ").");
-
-  probe->AddPacketStats (flowId, packetSize, Seconds (0));
+  if (!m_lightMode)
+    {
+      TrackedPacket &tracked = InsertTrackedPacket (TrackedPacketKey (flowId, packetId));
+      tracked.firstSeenTime = now;
+      tracked.lastSeenTime = tracked.firstSeenTime;
+      tracked.timesForwarded = 0;
+      NS_LOG_DEBUG ("ReportFirstTx: adding tracked packet (flowId=" << flowId << ", packetId=" << packetId
+                                                                    << ").");
+
+      probe->AddPacketStats (flowId, packetSize, Seconds (0));
+    }
 
   FlowStats &stats = GetStatsForFlow (flowId);
   stats.txBytes += packetSize;
@@ -172,19 +263,31 @@ FlowMonitor::ReportForwarding (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t p
     {
       return;
     }
-  std::pair<FlowId, FlowPacketId> key (flowId, packetId);
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (key);
-  if (tracked == m_trackedPackets.end ())
+  if (m_lightMode)
+    {
+      FlowStats &stats = GetStatsForFlow (flowId);
+      stats.timesForwarded++;
+      if (stats.firstPacketId == packetId)
+        {
+          stats.ports.push_back (interface);
+        }
+      return;
+    }
+
+  uint64_t key = TrackedPacketKey (flowId, packetId);
+  uint32_t slot = m_trackedPacketCount == 0 ? 0 : FindTrackedPacketSlot (key);
+  if (m_trackedPacketCount == 0 || m_trackedPackets[slot].key != key)
     {
       NS_LOG_WARN ("Received packet forward report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
+  TrackedPacket &tracked = m_trackedPackets[slot].packet;
 
-  tracked->second.timesForwarded++;
-  tracked->second.lastSeenTime = Simulator::Now ();
+  tracked.timesForwarded++;
+  tracked.lastSeenTime = Simulator::Now ();
 
-  Time delay = (Simulator::Now () - tracked->second.firstSeenTime);
+  Time delay = (Simulator::Now () - tracked.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
@@ -202,16 +305,31 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
     {
       return;
     }
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked == m_trackedPackets.end ())
+  Time now = Simulator::Now ();
+  if (m_lightMode)
+    {
+      FlowStats &stats = GetStatsForFlow (flowId);
+      stats.rxBytes += packetSize;
+      stats.rxPackets++;
+      if (stats.rxPackets == 1)
+        {
+          stats.timeFirstRxPacket = now;
+        }
+      stats.timeLastRxPacket = now;
+      return;
+    }
+
+  uint64_t key = TrackedPacketKey (flowId, packetId);
+  uint32_t slot = m_trackedPacketCount == 0 ? 0 : FindTrackedPacketSlot (key);
+  if (m_trackedPacketCount == 0 || m_trackedPackets[slot].key != key)
     {
       NS_LOG_WARN ("Received packet last-tx report (flowId=" << flowId << ", packetId=" << packetId
                                                              << ") but not known to be transmitted.");
       return;
     }
+  const TrackedPacket &tracked = m_trackedPackets[slot].packet;
 
-  Time now = Simulator::Now ();
-  Time delay = (now - tracked->second.firstSeenTime);
+  Time delay = (now - tracked.firstSeenTime);
   probe->AddPacketStats (flowId, packetSize, delay);
 
   FlowStats &stats = GetStatsForFlow (flowId);
@@ -250,12 +368,12 @@ FlowMonitor::ReportLastRx (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packe
         }
     }
   stats.timeLastRxPacket = now;
-  stats.timesForwarded += tracked->second.timesForwarded;
+  stats.timesForwarded += tracked.timesForwarded;
 
   NS_LOG_DEBUG ("ReportLastTx: removing tracked packet (flowId="
                 << flowId << ", packetId=" << packetId << ").");
 
-  m_trackedPackets.erase (tracked); // we don't need to track this packet anymore
+  EraseTrackedPacketSlot (slot); // we don't need to track this packet anymore
 }
 
 void
@@ -282,14 +400,15 @@ FlowMonitor::ReportDrop (Ptr<FlowProbe> probe, uint32_t flowId, uint32_t packetI
 
   // XXX It is event not true with QueueDisc Requeue
   /*
-  TrackedPacketMap::iterator tracked = m_trackedPackets.find (std::make_pair (flowId, packetId));
-  if (tracked != m_trackedPackets.end ())
+  uint64_t key = TrackedPacketKey (flowId, packetId);
+  uint32_t slot = m_trackedPacketCount == 0 ? 0 : FindTrackedPacketSlot (key);
+  if (m_trackedPacketCount != 0 && m_trackedPackets[slot].key == key)
     {
       // we don't need to track this packet anymore
       // FIXME: this will not necessarily be true with broadcast/multicast
       NS_LOG_DEBUG ("ReportDrop: removing tracked packet (flowId="
                     << flowId << ", packetId=" << packetId << ").");
-      m_trackedPackets.erase (tracked);
+      EraseTrackedPacketSlot (slot);
     }
     */
 }
@@ -306,24 +425,25 @@ FlowMonitor::CheckForLostPackets (Time maxDelay)
 {
   Time now = Simulator::Now ();
 
-  for (TrackedPacketMap::iterator iter = m_trackedPackets.begin ();
-       iter != m_trackedPackets.end (); )
+  // erasing may move the next packets back, so they are erased afterwards
+  std::vector<uint64_t> lost;
+  for (uint32_t i = 0; i < m_trackedPackets.size (); i++)
     {
-      if (now - iter->second.lastSeenTime >= maxDelay)
+      if (m_trackedPackets[i].key != 0 && now - m_trackedPackets[i].packet.lastSeenTime >= maxDelay)
         {
-          // packet is considered lost, add it to the loss statistics
-          FlowStatsContainerI flow = m_flowStats.find (iter->first.first);
-          NS_ASSERT (flow != m_flowStats.end ());
-          flow->second.lostPackets++;
-
-          // we won't track it anymore
-          m_trackedPackets.erase (iter++);
-        }
-      else
-        {
-          iter++;
+          lost.push_back (m_trackedPackets[i].key);
         }
     }
+  for (std::vector<uint64_t>::const_iterator iter = lost.begin (); iter != lost.end (); iter++)
+    {
+      // packet is considered lost, add it to the loss statistics
+      FlowId flowId = *iter >> 32;
+      NS_ASSERT (flowId < m_flowStatsById.size () && m_flowStatsById[flowId] != 0);
+      m_flowStatsById[flowId]->lostPackets++;
+
+      // we won't track it anymore
+      EraseTrackedPacketSlot (FindTrackedPacketSlot (*iter));
+    }
 }
 
 void
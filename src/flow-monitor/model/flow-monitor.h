@@ -46,6 +46,13 @@ namespace ns3 {
  * The FlowMonitor class is responsible for coordinating efforts
  * regarding probes, and collects end-to-end flow statistics.
  *
+ * With the LightMode attribute, the packets are not tracked from probe to
+ * probe: only the counters, the first and last times and the path of the
+ * flows are recorded, and neither the delays, the jitters, the histograms,
+ * the per-probe statistics nor the lost packets other than the drops are.
+ * As the packets are not tracked, timesForwarded then counts the hops of
+ * all the packets, and not only of the received ones.
+ *
  */
 class FlowMonitor : public Object
 {
@@ -107,7 +114,8 @@ public:
     uint32_t lostPackets;
 
     /// Contains the number of times a packet has been reportedly
-    /// forwarded, summed for all received packets in the flow
+    /// forwarded, summed for all received packets in the flow.  In
+    /// light mode, the packets which are not received are counted too.
     uint32_t timesForwarded;
 
     /// Histogram of the packet delays
@@ -276,12 +284,23 @@ private:
     uint32_t timesForwarded; //!< number of times the packet was reportedly forwarded
   };
 
+  /// Slot of the open addressing table of the tracked packets
+  struct TrackedPacketSlot
+  {
+    uint64_t key; //!< FlowId in the high bits and FlowPacketId in the low bits, 0 if the slot is empty
+    TrackedPacket packet; //!< the tracked packet
+  };
+
   /// FlowId --> FlowStats
   FlowStatsContainer m_flowStats;
-
-  /// (FlowId,PacketId) --> TrackedPacket
-  typedef std::map< std::pair<FlowId, FlowPacketId>, TrackedPacket> TrackedPacketMap;
-  TrackedPacketMap m_trackedPackets; //!< Tracked packets
+  /// FlowId --> FlowStats in m_flowStats, 0 for unknown flows
+  std::vector<FlowStats *> m_flowStatsById;
+
+  /// (FlowId,PacketId) --> TrackedPacket, with linear probing in a power
+  /// of two number of slots, so that tracking a packet does not allocate
+  std::vector<TrackedPacketSlot> m_trackedPackets;
+  uint32_t m_trackedPacketCount; //!< Number of tracked packets
+  bool m_lightMode; //!< Only per flow counters and times, without tracked packets
   Time m_maxPerHopDelay; //!< Minimum per-hop delay
   FlowProbeContainer m_flowProbes; //!< all the FlowProbes
 
@@ -304,6 +323,18 @@ private:
 
   /// Periodic function to check for lost packets and prune statistics
   void PeriodicCheckForLostPackets ();
+
+  /// Get the slot of a tracked packet, when some packets are tracked
+  /// \param key the key of the packet
+  /// \returns the slot of the packet, or the empty slot where it would be added
+  uint32_t FindTrackedPacketSlot (uint64_t key) const;
+  /// Start tracking a packet, or get it if already tracked
+  /// \param key the key of the packet
+  /// \returns the tracked packet
+  TrackedPacket& InsertTrackedPacket (uint64_t key);
+  /// Stop tracking a packet
+  /// \param slot the slot of the packet
+  void EraseTrackedPacketSlot (uint32_t slot);
 };
 
 
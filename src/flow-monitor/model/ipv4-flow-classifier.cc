@@ -23,6 +23,9 @@
 #include "ipv4-flow-classifier.h"
 #include "ns3/udp-header.h"
 #include "ns3/tcp-header.h"
+#include "ns3/flow-hash.h"
+
+#include <algorithm>
 
 namespace ns3 {
 
@@ -95,6 +98,15 @@ bool operator == (const Ipv4FlowClassifier::FiveTuple &t1,
 
 
 
+size_t
+Ipv4FlowClassifier::FiveTupleHash::operator() (const FiveTuple &tuple) const
+{
+  uint32_t hash = FlowHash::Mix (tuple.sourceAddress.Get ());
+  hash = FlowHash::Mix (hash ^ tuple.destinationAddress.Get ());
+  hash = FlowHash::Mix (hash ^ ((static_cast<uint32_t> (tuple.sourcePort) << 16) | tuple.destinationPort));
+  return FlowHash::Mix (hash ^ tuple.protocol);
+}
+
 Ipv4FlowClassifier::Ipv4FlowClassifier ()
 {
 }
@@ -147,7 +159,7 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
   tuple.destinationPort = dstPort;
 
   // try to insert the tuple, but check if it already exists
-  std::pair<std::map<FiveTuple, FlowId>::iterator, bool> insert
+  std::pair<sgi::hash_map<FiveTuple, FlowId, FiveTupleHash>::iterator, bool> insert
     = m_flowMap.insert (std::pair<FiveTuple, FlowId> (tuple, 0));
 
   // if the insertion succeeded, we need to assign this tuple a new flow identifier
@@ -155,7 +167,13 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
     {
       FlowId newFlowId = GetNewFlowId ();
       insert.first->second = newFlowId;
+      if (newFlowId >= m_flowPktIdMap.size ())
+        {
+          m_flowPktIdMap.resize (newFlowId + 1, 0);
+          m_flows.resize (newFlowId + 1);
+        }
       m_flowPktIdMap[newFlowId] = 0;
+      m_flows[newFlowId] = tuple;
     }
   else
     {
@@ -172,13 +190,9 @@ Ipv4FlowClassifier::Classify (const Ipv4Header &ipHeader, Ptr<const Packet> ipPa
 Ipv4FlowClassifier::FiveTuple
 Ipv4FlowClassifier::FindFlow (FlowId flowId) const
 {
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  if (flowId != 0 && flowId < m_flows.size ())
     {
-      if (iter->second == flowId)
-        {
-          return iter->first;
-        }
+      return m_flows[flowId];
     }
   NS_FATAL_ERROR ("Could not find the flow with ID " << flowId);
   FiveTuple retval = { Ipv4Address::GetZero (), Ipv4Address::GetZero (), 0, 0, 0 };
@@ -192,9 +206,13 @@ Ipv4FlowClassifier::SerializeToXmlStream (std::ostream &os, int indent) const
 
   INDENT (indent); os << "<Ipv4FlowClassifier>\n";
 
+  // in the order of the FiveTuples
+  std::vector<std::pair<FiveTuple, FlowId> > flows (m_flowMap.begin (), m_flowMap.end ());
+  std::sort (flows.begin (), flows.end ());
+
   indent += 2;
-  for (std::map<FiveTuple, FlowId>::const_iterator
-       iter = m_flowMap.begin (); iter != m_flowMap.end (); iter++)
+  for (std::vector<std::pair<FiveTuple, FlowId> >::const_iterator
+       iter = flows.begin (); iter != flows.end (); iter++)
     {
       INDENT (indent);
       os << "<Flow flowId=\"" << iter->second << "\""
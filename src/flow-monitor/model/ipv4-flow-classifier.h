@@ -22,9 +22,10 @@
 #define IPV4_FLOW_CLASSIFIER_H
 
 #include <stdint.h>
-#include <map>
+#include <vector>
 
 #include "ns3/ipv4-header.h"
+#include "ns3/sgi-hashmap.h"
 #include "ns3/flow-classifier.h"
 
 namespace ns3 {
@@ -73,10 +74,20 @@ public:
 
 private:
 
+  /// Hash of a FiveTuple
+  struct FiveTupleHash
+  {
+    /// \param tuple the FiveTuple
+    /// \returns the hash of the FiveTuple
+    size_t operator() (const FiveTuple &tuple) const;
+  };
+
   /// Map to Flows Identifiers to FlowIds
-  std::map<FiveTuple, FlowId> m_flowMap;
-  /// Map to FlowIds to FlowPacketId
-  std::map<FlowId, FlowPacketId> m_flowPktIdMap;
+  sgi::hash_map<FiveTuple, FlowId, FiveTupleHash> m_flowMap;
+  /// FlowIds to their last FlowPacketId
+  std::vector<FlowPacketId> m_flowPktIdMap;
+  /// FlowIds to their Flows Identifiers
+  std::vector<FiveTuple> m_flows;
 
 };
 
@@ -0,0 +1,197 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License version 2 as
+// published by the Free Software Foundation;
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+
+#include "ns3/flow-monitor.h"
+#include "ns3/flow-probe.h"
+#include "ns3/simulator.h"
+#include "ns3/boolean.h"
+#include "ns3/test.h"
+
+using namespace ns3;
+
+// A probe whose reports are made by the test
+class TestFlowProbe : public FlowProbe
+{
+public:
+  TestFlowProbe (Ptr<FlowMonitor> monitor)
+    : FlowProbe (monitor)
+  {
+  }
+
+  void Send (FlowId flowId, uint32_t count)
+  {
+    for (uint32_t i = 0; i < count; i++)
+      {
+        m_flowMonitor->ReportFirstTx (this, flowId, i, 100, 1);
+      }
+  }
+
+  void Forward (FlowId flowId, uint32_t count, uint32_t interface)
+  {
+    for (uint32_t i = 0; i < count; i++)
+      {
+        m_flowMonitor->ReportForwarding (this, flowId, i, 100, interface);
+      }
+  }
+
+  void Receive (FlowId flowId, uint32_t first, uint32_t count, uint32_t step)
+  {
+    for (uint32_t i = first; i < count; i += step)
+      {
+        m_flowMonitor->ReportLastRx (this, flowId, i, 100);
+      }
+  }
+};
+
+// Thousands of packets in flight grow the table of the tracked packets
+// several times, and receiving every other packet erases slots in the
+// middle of the probe sequences of the others
+class FlowMonitorTrackedPacketsTestCase : public TestCase
+{
+public:
+  FlowMonitorTrackedPacketsTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+FlowMonitorTrackedPacketsTestCase::FlowMonitorTrackedPacketsTestCase ()
+  : TestCase ("FlowMonitor tracked packets table and lost packets")
+{
+}
+
+void
+FlowMonitorTrackedPacketsTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  Ptr<TestFlowProbe> probe = CreateObject<TestFlowProbe> (monitor);
+
+  for (FlowId flowId = 1; flowId <= 3; flowId++)
+    {
+      Simulator::Schedule (Seconds (0.1), &TestFlowProbe::Send, probe, flowId, 2000);
+      Simulator::Schedule (Seconds (0.3), &TestFlowProbe::Receive, probe, flowId, 0, 2000, 2);
+      Simulator::Schedule (Seconds (0.4), &TestFlowProbe::Receive, probe, flowId, 1, 2000, 2);
+    }
+  Simulator::Schedule (Seconds (0.2), &TestFlowProbe::Forward, probe, 1, 2000, 2);
+  Simulator::Schedule (Seconds (0.5), &TestFlowProbe::Send, probe, 4, 10);
+  Simulator::Schedule (Seconds (0.6), &TestFlowProbe::Receive, probe, 4, 0, 5, 1);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  const FlowMonitor::FlowStatsContainer &stats = monitor->GetFlowStats ();
+  NS_TEST_ASSERT_MSG_EQ (stats.size (), 4, "Wrong number of flows");
+  for (FlowId flowId = 1; flowId <= 3; flowId++)
+    {
+      const FlowMonitor::FlowStats &flow = stats.find (flowId)->second;
+      NS_TEST_ASSERT_MSG_EQ (flow.txPackets, 2000, "Wrong number of packets sent");
+      NS_TEST_ASSERT_MSG_EQ (flow.rxPackets, 2000, "A tracked packet was lost by the table");
+      NS_TEST_ASSERT_MSG_EQ (flow.rxBytes, 200000, "Wrong number of bytes received");
+      NS_TEST_ASSERT_MSG_EQ_TOL (flow.delaySum.GetSeconds (), 500, 1e-6, "Wrong delays");
+    }
+  const FlowMonitor::FlowStats &forwarded = stats.find (1)->second;
+  NS_TEST_ASSERT_MSG_EQ (forwarded.timesForwarded, 2000, "Every packet was forwarded once");
+  NS_TEST_ASSERT_MSG_EQ (forwarded.ports.size (), 2, "The path is the sender and the forwarding port");
+  NS_TEST_ASSERT_MSG_EQ (forwarded.ports[1], 2, "Wrong forwarding port");
+  NS_TEST_ASSERT_MSG_EQ (stats.find (2)->second.timesForwarded, 0, "The packets were not forwarded");
+
+  // The packets of flow 4 not received for 0.4s are lost, and only once
+  monitor->CheckForLostPackets (Seconds (0.3));
+  NS_TEST_ASSERT_MSG_EQ (stats.find (4)->second.lostPackets, 5, "The packets not received should be lost");
+  NS_TEST_ASSERT_MSG_EQ (stats.find (1)->second.lostPackets, 0, "The packets received should not be lost");
+  monitor->CheckForLostPackets (Seconds (0));
+  NS_TEST_ASSERT_MSG_EQ (stats.find (4)->second.lostPackets, 5, "The lost packets should not be tracked anymore");
+  probe->Receive (4, 5, 10, 1);
+  NS_TEST_ASSERT_MSG_EQ (stats.find (4)->second.rxPackets, 5, "The lost packets should not be received");
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+// The same flow in light and in full mode: the counters match, except the
+// forward count of the packets which are not received
+class FlowMonitorLightModeTestCase : public TestCase
+{
+public:
+  FlowMonitorLightModeTestCase (bool lightMode);
+
+private:
+  virtual void DoRun (void);
+
+  bool m_lightMode;
+};
+
+FlowMonitorLightModeTestCase::FlowMonitorLightModeTestCase (bool lightMode)
+  : TestCase (lightMode ? "FlowMonitor counters in light mode" : "FlowMonitor counters in full mode"),
+    m_lightMode (lightMode)
+{
+}
+
+void
+FlowMonitorLightModeTestCase::DoRun (void)
+{
+  Ptr<FlowMonitor> monitor = CreateObject<FlowMonitor> ();
+  monitor->SetAttribute ("LightMode", BooleanValue (m_lightMode));
+  Ptr<TestFlowProbe> probe = CreateObject<TestFlowProbe> (monitor);
+
+  Simulator::Schedule (Seconds (0.1), &TestFlowProbe::Send, probe, 1, 10);
+  Simulator::Schedule (Seconds (0.2), &TestFlowProbe::Forward, probe, 1, 10, 2);
+  Simulator::Schedule (Seconds (0.3), &TestFlowProbe::Forward, probe, 1, 10, 3);
+  Simulator::Schedule (Seconds (0.4), &TestFlowProbe::Receive, probe, 1, 0, 8, 1);
+  Simulator::Stop (Seconds (1));
+  Simulator::Run ();
+
+  monitor->CheckForLostPackets (Seconds (0.5));
+  const FlowMonitor::FlowStats &flow = monitor->GetFlowStats ().find (1)->second;
+  NS_TEST_ASSERT_MSG_EQ (flow.txPackets, 10, "Wrong number of packets sent");
+  NS_TEST_ASSERT_MSG_EQ (flow.txBytes, 1000, "Wrong number of bytes sent");
+  NS_TEST_ASSERT_MSG_EQ (flow.rxPackets, 8, "Wrong number of packets received");
+  NS_TEST_ASSERT_MSG_EQ (flow.rxBytes, 800, "Wrong number of bytes received");
+  NS_TEST_ASSERT_MSG_EQ (flow.timeFirstTxPacket, Seconds (0.1), "Wrong first transmission");
+  NS_TEST_ASSERT_MSG_EQ (flow.timeFirstRxPacket, Seconds (0.4), "Wrong first reception");
+  NS_TEST_ASSERT_MSG_EQ (flow.timeLastRxPacket, Seconds (0.4), "Wrong last reception");
+  NS_TEST_ASSERT_MSG_EQ (flow.ports.size (), 3, "The path is the sender and the two forwarding ports");
+  if (m_lightMode)
+    {
+      NS_TEST_ASSERT_MSG_EQ (flow.timesForwarded, 20, "Light mode counts the hops of all the packets");
+      NS_TEST_ASSERT_MSG_EQ (flow.delaySum, Seconds (0), "Light mode does not measure the delays");
+      NS_TEST_ASSERT_MSG_EQ (flow.lostPackets, 0, "Light mode does not track the lost packets");
+    }
+  else
+    {
+      NS_TEST_ASSERT_MSG_EQ (flow.timesForwarded, 16, "Full mode counts the hops of the received packets");
+      NS_TEST_ASSERT_MSG_EQ_TOL (flow.delaySum.GetSeconds (), 2.4, 1e-6, "Wrong delays");
+      NS_TEST_ASSERT_MSG_EQ (flow.lostPackets, 2, "The packets not received should be lost");
+    }
+
+  monitor->Dispose ();
+  Simulator::Destroy ();
+}
+
+class FlowMonitorTestSuite : public TestSuite
+{
+public:
+  FlowMonitorTestSuite ();
+};
+
+FlowMonitorTestSuite::FlowMonitorTestSuite ()
+  : TestSuite ("flow-monitor", UNIT)
+{
+  AddTestCase (new FlowMonitorTrackedPacketsTestCase, TestCase::QUICK);
+  AddTestCase (new FlowMonitorLightModeTestCase (false), TestCase::QUICK);
+  AddTestCase (new FlowMonitorLightModeTestCase (true), TestCase::QUICK);
+}
+
+static FlowMonitorTestSuite g_flowMonitorTestSuite;
@@ -166,10 +166,13 @@
 #include "ns3/arp-l3-protocol.h"
 #include "internet-stack-helper.h"
 #include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-list-routing.h"
 #include "ns3/ipv4-list-routing-helper.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
 #include "ns3/ipv4-drb-helper.h"
+#include "ns3/ipv4-tlb.h"
+#include "ns3/ipv4-clove.h"
 #include "ns3/ipv6-static-routing-helper.h"
 #include "ns3/ipv6-extension.h"
 #include "ns3/ipv6-extension-demux.h"
@@ -389,6 +392,21 @@ InternetStackHelper::AssignStreams (NodeContainer c, int64_t stream)
             {
               currentStream += arpL3Protocol->AssignStreams (currentStream);
             }
+          Ptr<Ipv4ListRouting> listRouting = DynamicCast<Ipv4ListRouting> (ipv4->GetRoutingProtocol ());
+          if (listRouting != 0 && listRouting->GetDrb () != 0)
+            {
+              currentStream += listRouting->GetDrb ()->AssignStreams (currentStream);
+            }
+        }
+      Ptr<Ipv4TLB> tlb = node->GetObject<Ipv4TLB> ();
+      if (tlb != 0)
+        {
+          currentStream += tlb->AssignStreams (currentStream);
+        }
+      Ptr<Ipv4Clove> clove = node->GetObject<Ipv4Clove> ();
+      if (clove != 0)
+        {
+          currentStream += clove->AssignStreams (currentStream);
         }
       Ptr<Ipv6> ipv6 = node->GetObject<Ipv6> ();
       if (ipv6 != 0)
@@ -210,7 +210,8 @@ public:
   * Assign a fixed random variable stream number to the random variables
   * used by this model.  Return the number of streams (possibly zero) that
   * have been assigned.  The Install() method should have previously been
-  * called by the user.
+  * called by the user.  The TLB, Clove and DRB load balancers it installs
+  * are included.
   *
   * \param stream first stream index to use
   * \param c NodeContainer of the set of nodes for which the internet models
@@ -82,6 +82,16 @@ public:
    *
    */
   static void RecomputeRoutingTables (void);
+  /**
+   * \brief Update the routes installed by a prior call to either
+   * PopulateRoutingTables(), RecomputeRoutingTables() or
+   * UpdateRoutingTables() after a change of the topology.
+   *
+   * This gives the same routes as RecomputeRoutingTables(), but when links
+   * were only taken down, only the nodes for which a removed link was on a
+   * shortest path run the SPF calculation again.
+   */
+  static void UpdateRoutingTables (void);
 private:
   /**
    * \brief Assignment operator declared private and not implemented to disallow
@@ -27,6 +27,7 @@
 #include <queue>
 #include <algorithm>
 #include <iostream>
+#include <set>
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
@@ -35,6 +36,14 @@
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/ipv4-list-routing.h"
 #include "ns3/mpi-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/uinteger.h"
+#include "ns3/core-config.h"
+#ifdef HAVE_PTHREAD_H
+#include <unistd.h>
+#include "ns3/system-thread.h"
+#include "ns3/system-mutex.h"
+#endif /* HAVE_PTHREAD_H */
 #include "global-router-interface.h"
 #include "global-route-manager-impl.h"
 #include "candidate-queue.h"
@@ -44,6 +53,12 @@ namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("GlobalRouteManagerImpl");
 
+static GlobalValue g_globalRoutingThreads ("GlobalRoutingThreads",
+                                           "The number of threads computing the global routes, "
+                                           "0 for one per processor",
+                                           UintegerValue (0),
+                                           MakeUintegerChecker<uint32_t> ());
+
 /**
  * \brief Stream insertion operator.
  *
@@ -169,7 +184,7 @@ SPFVertex::~SPFVertex ()
   // delete parents
   m_parents.clear ();
   // delete root exit direction
-  m_ecmpRootExits.clear ();
+  m_ecmpRootExits = 0;
 
   NS_LOG_LOGIC ("Vertex-" << m_vertexId << " completed deleted");
 }
@@ -280,8 +295,8 @@ SPFVertex::SetRootExitDirection (Ipv4Address nextHop, int32_t id)
   NS_LOG_FUNCTION (this << nextHop << id);
 
   // always maintain only one root's exit
-  m_ecmpRootExits.clear ();
-  m_ecmpRootExits.push_back (NodeExit_t (nextHop, id));
+  m_ecmpRootExits = Create<RootExitGroup> ();
+  m_ecmpRootExits->exits.push_back (NodeExit_t (nextHop, id));
   // update the following in order to be backward compatitable with
   // GetNextHop and GetOutgoingInterface methods
   m_nextHop = nextHop;
@@ -299,13 +314,8 @@ SPFVertex::NodeExit_t
 SPFVertex::GetRootExitDirection (uint32_t i) const
 {
   NS_LOG_FUNCTION (this << i);
-  typedef ListOfNodeExit_t::const_iterator CIter_t;
-
-  NS_ASSERT_MSG (i < m_ecmpRootExits.size (), "Index out-of-range when accessing SPFVertex::m_ecmpRootExits!");
-  CIter_t iter = m_ecmpRootExits.begin ();
-  while (i-- > 0) { iter++; }
-
-  return *iter;
+  NS_ASSERT_MSG (i < GetNRootExitDirections (), "Index out-of-range when accessing SPFVertex::m_ecmpRootExits!");
+  return m_ecmpRootExits->exits[i];
 }
 
 SPFVertex::NodeExit_t 
@@ -313,7 +323,7 @@ SPFVertex::GetRootExitDirection () const
 {
   NS_LOG_FUNCTION (this);
 
-  NS_ASSERT_MSG (m_ecmpRootExits.size () <= 1, "Assumed there is at most one exit from the root to this vertex");
+  NS_ASSERT_MSG (GetNRootExitDirections () <= 1, "Assumed there is at most one exit from the root to this vertex");
   return GetRootExitDirection (0);
 }
 
@@ -322,14 +332,27 @@ SPFVertex::MergeRootExitDirections (const SPFVertex* vertex)
 {
   NS_LOG_FUNCTION (this << vertex);
 
+  if (vertex->GetNRootExitDirections () == 0 || vertex->m_ecmpRootExits == m_ecmpRootExits)
+    {
+      return;
+    }
+  if (GetNRootExitDirections () == 0)
+    {
+      m_ecmpRootExits = vertex->m_ecmpRootExits;
+      return;
+    }
   // obtain the external list of exit directions
   //
-  // Append the external list into 'this' and remove duplication afterward
-  const ListOfNodeExit_t& extList = vertex->m_ecmpRootExits;
-  m_ecmpRootExits.insert (m_ecmpRootExits.end (), 
-                          extList.begin (), extList.end ());
-  m_ecmpRootExits.sort ();
-  m_ecmpRootExits.unique ();
+  // Merge both lists into a new group, since the current one may be shared
+  const std::vector<NodeExit_t>& extList = vertex->m_ecmpRootExits->exits;
+  Ptr<RootExitGroup> group = Create<RootExitGroup> ();
+  group->exits.reserve (m_ecmpRootExits->exits.size () + extList.size ());
+  group->exits.insert (group->exits.end (),
+                       m_ecmpRootExits->exits.begin (), m_ecmpRootExits->exits.end ());
+  group->exits.insert (group->exits.end (), extList.begin (), extList.end ());
+  std::sort (group->exits.begin (), group->exits.end ());
+  group->exits.erase (std::unique (group->exits.begin (), group->exits.end ()), group->exits.end ());
+  m_ecmpRootExits = group;
 }
 
 void 
@@ -338,21 +361,19 @@ SPFVertex::InheritAllRootExitDirections (const SPFVertex* vertex)
   NS_LOG_FUNCTION (this << vertex);
 
   // discard all exit direction currently associated with this vertex,
-  // and copy all the exit directions from the given vertex
-  if (m_ecmpRootExits.size () > 0)
+  // and share all the exit directions of the given vertex
+  if (GetNRootExitDirections () > 0)
     {
       NS_LOG_WARN ("x root exit directions in this vertex are going to be discarded");
     }
-  m_ecmpRootExits.clear ();
-  m_ecmpRootExits.insert (m_ecmpRootExits.end (), 
-                          vertex->m_ecmpRootExits.begin (), vertex->m_ecmpRootExits.end ());
+  m_ecmpRootExits = vertex->m_ecmpRootExits;
 }
 
 uint32_t 
 SPFVertex::GetNRootExitDirections () const
 {
   NS_LOG_FUNCTION (this);
-  return m_ecmpRootExits.size ();
+  return m_ecmpRootExits ? m_ecmpRootExits->exits.size () : 0;
 }
 
 uint32_t 
@@ -495,13 +516,10 @@ GlobalRouteManagerLSDB::GetLSA (Ipv4Address addr) const
 //
 // Look up an LSA by its address.
 //
-  LSDBMap_t::const_iterator i;
-  for (i= m_database.begin (); i!= m_database.end (); i++)
+  LSDBMap_t::const_iterator i = m_database.find (addr);
+  if (i != m_database.end ())
     {
-      if (i->first == addr)
-        {
-          return i->second;
-        }
+      return i->second;
     }
   return 0;
 }
@@ -531,15 +549,65 @@ GlobalRouteManagerLSDB::GetLSAByLinkData (Ipv4Address addr) const
   return 0;
 }
 
+void
+GlobalRouteManagerLSDB::GetLSAs (std::vector<GlobalRoutingLSA*>& lsas) const
+{
+  NS_LOG_FUNCTION (this);
+  lsas.clear ();
+  lsas.reserve (m_database.size ());
+  LSDBMap_t::const_iterator i;
+  for (i= m_database.begin (); i!= m_database.end (); i++)
+    {
+      lsas.push_back (i->second);
+    }
+}
+
+GlobalRouteManagerLSDB*
+GlobalRouteManagerLSDB::Copy (void) const
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB* lsdb = new GlobalRouteManagerLSDB ();
+  LSDBMap_t::const_iterator i;
+  for (i= m_database.begin (); i!= m_database.end (); i++)
+    {
+      GlobalRoutingLSA* lsa = new GlobalRoutingLSA ();
+      *lsa = *i->second;
+// The assignment operator does not copy the attached routers of a network LSA
+      for (uint32_t j = 0; j < i->second->GetNAttachedRouters (); j++)
+        {
+          lsa->AddAttachedRouter (i->second->GetAttachedRouter (j));
+        }
+      lsdb->m_database.insert (LSDBPair_t (i->first, lsa));
+    }
+  for (uint32_t j = 0; j < m_extdatabase.size (); j++)
+    {
+      GlobalRoutingLSA* lsa = new GlobalRoutingLSA ();
+      *lsa = *m_extdatabase.at (j);
+      lsdb->m_extdatabase.push_back (lsa);
+    }
+  return lsdb;
+}
+
 // ---------------------------------------------------------------------------
 //
 // GlobalRouteManagerImpl Implementation
 //
 // ---------------------------------------------------------------------------
 
+// The roots left to compute, shared by the workers of CalculateRoutes
+struct GlobalRouteManagerImpl::SpfJob
+{
+  std::vector<Ipv4Address> roots;
+  uint32_t next;
+#ifdef HAVE_PTHREAD_H
+  SystemMutex mutex;
+#endif /* HAVE_PTHREAD_H */
+};
+
 GlobalRouteManagerImpl::GlobalRouteManagerImpl () 
   :
-    m_spfroot (0)
+    m_spfroot (0),
+    m_job (0)
 {
   NS_LOG_FUNCTION (this);
   m_lsdb = new GlobalRouteManagerLSDB ();
@@ -572,26 +640,9 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
-      Ptr<Node> node = *i;
-      Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
-      if (router == 0)
-        {
-          continue;
-        }
-      Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
-      uint32_t j = 0;
-      uint32_t nRoutes = gr->GetNRoutes ();
-      NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
-      // Each time we delete route 0, the route index shifts downward
-      // We can delete all routes if we delete the route numbered 0
-      // nRoutes times
-      for (j = 0; j < nRoutes; j++)
-        {
-          NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
-          gr->RemoveRoute (0);
-        }
-      NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+      DeleteNodeRoutes (*i);
     }
+  m_spfDistances.clear ();
   if (m_lsdb)
     {
       NS_LOG_LOGIC ("Deleting LSDB, creating new one");
@@ -600,6 +651,30 @@ GlobalRouteManagerImpl::DeleteGlobalRoutes ()
     }
 }
 
+void
+GlobalRouteManagerImpl::DeleteNodeRoutes (Ptr<Node> node)
+{
+  NS_LOG_FUNCTION (this << node);
+  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
+  if (router == 0)
+    {
+      return;
+    }
+  Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
+  uint32_t j = 0;
+  uint32_t nRoutes = gr->GetNRoutes ();
+  NS_LOG_LOGIC ("Deleting " << gr->GetNRoutes ()<< " routes from node " << node->GetId ());
+  // Each time we delete route 0, the route index shifts downward
+  // We can delete all routes if we delete the route numbered 0
+  // nRoutes times
+  for (j = 0; j < nRoutes; j++)
+    {
+      NS_LOG_LOGIC ("Deleting global route " << j << " from node " << node->GetId ());
+      gr->RemoveRoute (0);
+    }
+  NS_LOG_LOGIC ("Deleted " << j << " global routes from node "<< node->GetId ());
+}
+
 //
 // In order to build the routing database, we need to walk the list of nodes
 // in the system and look for those that support the GlobalRouter interface.
@@ -696,10 +771,23 @@ void
 GlobalRouteManagerImpl::InitializeRoutes ()
 {
   NS_LOG_FUNCTION (this);
+  std::vector<Ipv4Address> roots;
+  FindRoots (roots);
+  NS_LOG_INFO ("About to start SPF calculation");
+  CalculateRoutes (roots);
+  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+void
+GlobalRouteManagerImpl::FindRoots (std::vector<Ipv4Address>& roots)
+{
+  NS_LOG_FUNCTION (this);
+  roots.clear ();
+  m_routerNodes.clear ();
 //
 // Walk the list of nodes in the system.
 //
-  NS_LOG_INFO ("About to start SPF calculation");
+  uint32_t systemId = MpiInterface::GetSystemId ();
   NodeList::Iterator listEnd = NodeList::End ();
   for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
     {
@@ -710,24 +798,350 @@ GlobalRouteManagerImpl::InitializeRoutes ()
 //
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
+      if (rtr == 0)
+        {
+          continue;
+        }
+      m_routerNodes[rtr->GetRouterId ()] = node;
 
-      uint32_t systemId = MpiInterface::GetSystemId ();
       // Ignore nodes that are not assigned to our systemId (distributed sim)
       if (node->GetSystemId () != systemId) 
         {
           continue;
         }
-
 //
 // if the node has a global router interface, then run the global routing
 // algorithms.
 //
-      if (rtr && rtr->GetNumLSAs () )
+      if (rtr->GetNumLSAs ())
         {
-          SPFCalculate (rtr->GetRouterId ());
+          roots.push_back (rtr->GetRouterId ());
         }
     }
-  NS_LOG_INFO ("Finished SPF calculation");
+}
+
+Ptr<Node>
+GlobalRouteManagerImpl::GetRouterNode (Ipv4Address routerId) const
+{
+  NS_LOG_FUNCTION (this << routerId);
+  RouterNodeMap_t::const_iterator it = m_routerNodes.find (routerId);
+  if (it != m_routerNodes.end ())
+    {
+      return it->second;
+    }
+//
+// The map is built by FindRoots (); the unit tests call SPFCalculate ()
+// directly, so fall back to walking the list of nodes.
+//
+  NodeList::Iterator listEnd = NodeList::End ();
+  for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+    {
+      Ptr<GlobalRouter> rtr = (*i)->GetObject<GlobalRouter> ();
+      if (rtr && rtr->GetRouterId () == routerId)
+        {
+          return *i;
+        }
+    }
+  return 0;
+}
+
+void
+GlobalRouteManagerImpl::CalculateRoutes (const std::vector<Ipv4Address>& roots)
+{
+  NS_LOG_FUNCTION (this << roots.size ());
+  for (std::vector<Ipv4Address>::const_iterator i = roots.begin (); i != roots.end (); i++)
+    {
+      m_spfDistances.erase (*i);
+    }
+
+  UintegerValue threadsValue;
+  g_globalRoutingThreads.GetValue (threadsValue);
+  uint32_t nThreads = threadsValue.Get ();
+#ifdef HAVE_PTHREAD_H
+  if (nThreads == 0)
+    {
+      long nProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+      nThreads = nProcessors > 0 ? nProcessors : 1;
+    }
+#else
+  nThreads = 1;
+#endif /* HAVE_PTHREAD_H */
+  if (nThreads > roots.size ())
+    {
+      nThreads = roots.size ();
+    }
+
+  if (nThreads <= 1)
+    {
+      for (std::vector<Ipv4Address>::const_iterator i = roots.begin (); i != roots.end (); i++)
+        {
+          SPFCalculate (*i);
+        }
+      return;
+    }
+
+#ifdef HAVE_PTHREAD_H
+//
+// Each worker runs SPFCalculate on its own copy of the LSDB, since the SPF
+// calculation marks the LSAs, and writes only to the routing table of the
+// root it works on.  The nodes are looked up in a copy of m_routerNodes
+// because the NodeList (and the reference counts of its nodes) cannot be
+// used from several threads.
+//
+  NS_LOG_LOGIC ("Computing the routes of " << roots.size () << " roots with " << nThreads << " threads");
+  SpfJob job;
+  job.roots = roots;
+  job.next = 0;
+  std::vector<GlobalRouteManagerImpl*> workers;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      GlobalRouteManagerImpl* worker = new GlobalRouteManagerImpl ();
+      worker->DebugUseLsdb (m_lsdb->Copy ());
+      worker->m_routerNodes = m_routerNodes;
+      worker->m_job = &job;
+      workers.push_back (worker);
+      threads.push_back (Create<SystemThread> (MakeCallback (&GlobalRouteManagerImpl::RunSpfJob, worker)));
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      threads[i]->Start ();
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      threads[i]->Join ();
+    }
+  for (uint32_t i = 0; i < nThreads; i++)
+    {
+      m_spfDistances.insert (workers[i]->m_spfDistances.begin (), workers[i]->m_spfDistances.end ());
+      delete workers[i];
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+void
+GlobalRouteManagerImpl::RunSpfJob (void)
+{
+  NS_LOG_FUNCTION (this);
+#ifdef HAVE_PTHREAD_H
+  NS_ASSERT (m_job);
+  for (;;)
+    {
+      Ipv4Address root;
+      {
+        CriticalSection cs (m_job->mutex);
+        if (m_job->next == m_job->roots.size ())
+          {
+            return;
+          }
+        root = m_job->roots[m_job->next++];
+      }
+      SPFCalculate (root);
+    }
+#endif /* HAVE_PTHREAD_H */
+}
+
+//
+// Used by UpdateRoutes () to compare the link records of two versions of an
+// LSA.
+//
+static bool
+HasLinkRecord (GlobalRoutingLSA* lsa, GlobalRoutingLinkRecord* l)
+{
+  for (uint32_t i = 0; i < lsa->GetNLinkRecords (); i++)
+    {
+      GlobalRoutingLinkRecord* lr = lsa->GetLinkRecord (i);
+      if (lr->GetLinkType () == l->GetLinkType ()
+          && lr->GetLinkId () == l->GetLinkId ()
+          && lr->GetLinkData () == l->GetLinkData ()
+          && lr->GetMetric () == l->GetMetric ())
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+//
+// Used by UpdateRoutes () to look up the distance of a vertex from a root.
+//
+static bool
+FindDistance (const std::vector<std::pair<uint32_t, uint32_t> >& distances,
+              Ipv4Address vertexId, uint32_t& distance)
+{
+  std::vector<std::pair<uint32_t, uint32_t> >::const_iterator it =
+    std::lower_bound (distances.begin (), distances.end (), std::make_pair (vertexId.Get (), 0u));
+  if (it == distances.end () || it->first != vertexId.Get ())
+    {
+      return false;
+    }
+  distance = it->second;
+  return true;
+}
+
+void
+GlobalRouteManagerImpl::UpdateRoutes ()
+{
+  NS_LOG_FUNCTION (this);
+  GlobalRouteManagerLSDB* oldLsdb = m_lsdb;
+  m_lsdb = new GlobalRouteManagerLSDB ();
+  BuildGlobalRoutingDatabase ();
+  std::vector<Ipv4Address> roots;
+  FindRoots (roots);
+
+  std::vector<GlobalRoutingLSA*> oldLsas;
+  std::vector<GlobalRoutingLSA*> newLsas;
+  oldLsdb->GetLSAs (oldLsas);
+  m_lsdb->GetLSAs (newLsas);
+//
+// Find the link records that were removed since the last computation.  The
+// LSAs are sorted by link state ID, so walk both lists together.
+//
+  typedef std::pair<Ipv4Address, GlobalRoutingLinkRecord*> RemovedLink_t;
+  std::vector<RemovedLink_t> removedLinks;
+  std::set<Ipv4Address> changedRouters;
+  bool full = oldLsas.empty () || oldLsdb->GetNumExtLSAs () > 0 || m_lsdb->GetNumExtLSAs () > 0;
+  std::vector<GlobalRoutingLSA*>::const_iterator o = oldLsas.begin ();
+  std::vector<GlobalRoutingLSA*>::const_iterator n = newLsas.begin ();
+  while (!full && (o != oldLsas.end () || n != newLsas.end ()))
+    {
+      if (o == oldLsas.end () || n == newLsas.end ()
+          || (*o)->GetLinkStateId () != (*n)->GetLinkStateId ()
+          || (*o)->GetLSType () != GlobalRoutingLSA::RouterLSA
+          || (*n)->GetLSType () != GlobalRoutingLSA::RouterLSA)
+        {
+          NS_LOG_LOGIC ("A router or a network was added or removed");
+          full = true;
+          break;
+        }
+      for (uint32_t i = 0; i < (*n)->GetNLinkRecords () && !full; i++)
+        {
+          if (!HasLinkRecord (*o, (*n)->GetLinkRecord (i)))
+            {
+              NS_LOG_LOGIC ("Router " << (*n)->GetLinkStateId () << " has a new link");
+              full = true;
+            }
+        }
+      for (uint32_t i = 0; i < (*o)->GetNLinkRecords () && !full; i++)
+        {
+          GlobalRoutingLinkRecord* l = (*o)->GetLinkRecord (i);
+          if (HasLinkRecord (*n, l))
+            {
+              continue;
+            }
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+// The root at the other end takes its next hop to this router from l
+              changedRouters.insert (l->GetLinkId ());
+            }
+          else if (l->GetLinkType () != GlobalRoutingLinkRecord::StubNetwork)
+            {
+              full = true;
+            }
+          changedRouters.insert ((*o)->GetLinkStateId ());
+          removedLinks.push_back (RemovedLink_t ((*o)->GetLinkStateId (), l));
+        }
+      o++;
+      n++;
+    }
+//
+// The routes to a removed address can only be dropped if no other router
+// still advertises it.
+//
+  if (!full && !removedLinks.empty ())
+    {
+      std::set<Ipv4Address> hosts;
+      std::set<std::pair<Ipv4Address, Ipv4Address> > stubs;
+      for (n = newLsas.begin (); n != newLsas.end (); n++)
+        {
+          for (uint32_t i = 0; i < (*n)->GetNLinkRecords (); i++)
+            {
+              GlobalRoutingLinkRecord* l = (*n)->GetLinkRecord (i);
+              if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+                {
+                  hosts.insert (l->GetLinkData ());
+                }
+              else if (l->GetLinkType () == GlobalRoutingLinkRecord::StubNetwork)
+                {
+                  stubs.insert (std::make_pair (l->GetLinkId (), l->GetLinkData ()));
+                }
+            }
+        }
+      for (std::vector<RemovedLink_t>::const_iterator r = removedLinks.begin (); r != removedLinks.end () && !full; r++)
+        {
+          GlobalRoutingLinkRecord* l = r->second;
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+              full = hosts.count (l->GetLinkData ()) > 0;
+            }
+          else
+            {
+              full = stubs.count (std::make_pair (l->GetLinkId (), l->GetLinkData ())) > 0;
+            }
+        }
+    }
+
+  if (full)
+    {
+      NS_LOG_INFO ("Recomputing all the routes");
+      NodeList::Iterator listEnd = NodeList::End ();
+      for (NodeList::Iterator i = NodeList::Begin (); i != listEnd; i++)
+        {
+          DeleteNodeRoutes (*i);
+        }
+      m_spfDistances.clear ();
+      CalculateRoutes (roots);
+      delete oldLsdb;
+      return;
+    }
+//
+// A root has to run SPF again if it lost a link, or if a removed link from
+// X to Y was on one of its shortest paths, i.e. d(X) + metric == d(Y).  The
+// other roots keep their shortest path trees, minus the removed addresses.
+//
+  std::vector<Ipv4Address> recompute;
+  for (std::vector<Ipv4Address>::const_iterator root = roots.begin (); root != roots.end (); root++)
+    {
+      bool affected = changedRouters.count (*root) > 0;
+      DistanceMap_t::const_iterator d = m_spfDistances.find (*root);
+      for (std::vector<RemovedLink_t>::const_iterator r = removedLinks.begin ();
+           r != removedLinks.end () && !affected && d != m_spfDistances.end (); r++)
+        {
+          GlobalRoutingLinkRecord* l = r->second;
+          uint32_t dx, dy;
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint
+              && FindDistance (d->second, r->first, dx)
+              && FindDistance (d->second, l->GetLinkId (), dy)
+              && dx + l->GetMetric () == dy)
+            {
+              affected = true;
+            }
+        }
+      Ptr<Node> node = GetRouterNode (*root);
+      if (affected)
+        {
+          DeleteNodeRoutes (node);
+          recompute.push_back (*root);
+          continue;
+        }
+      Ptr<Ipv4GlobalRouting> gr = node->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      for (std::vector<RemovedLink_t>::const_iterator r = removedLinks.begin (); r != removedLinks.end (); r++)
+        {
+          GlobalRoutingLinkRecord* l = r->second;
+          if (l->GetLinkType () == GlobalRoutingLinkRecord::PointToPoint)
+            {
+              gr->RemoveHostRoutesTo (l->GetLinkData ());
+            }
+          else
+            {
+              Ipv4Mask mask (l->GetLinkData ().Get ());
+              gr->RemoveNetworkRoutesTo (l->GetLinkId ().CombineMask (mask), mask);
+            }
+        }
+    }
+  NS_LOG_INFO ("Recomputing the routes of " << recompute.size () << " of " << roots.size () << " roots");
+  CalculateRoutes (recompute);
+  delete oldLsdb;
 }
 
 //
@@ -1320,7 +1734,8 @@ GlobalRouteManagerImpl::CheckForStubNode (Ipv4Address root)
               if (lr->GetLinkId () == myRouterId)
                 {
                   // Next hop is stored in the LinkID field of lr
-                  Ptr<GlobalRouter> router = rlsa->GetNode ()->GetObject<GlobalRouter> ();
+                  Ptr<Node> node = m_spfrootNode ? m_spfrootNode : rlsa->GetNode ();
+                  Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
                   NS_ASSERT (router);
                   Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
                   NS_ASSERT (gr);
@@ -1366,9 +1781,16 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // We also mark this vertex as being in the SPF tree.
 //
   m_spfroot= v;
+  m_spfrootNode = GetRouterNode (root);
   v->SetDistanceFromRoot (0);
   v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
   NS_LOG_LOGIC ("Starting SPFCalculate for node " << root);
+//
+// Remember the distance of every vertex of the tree, so that UpdateRoutes ()
+// can tell whether a removed link was on a shortest path from this root.
+//
+  Distances_t distances;
+  distances.push_back (std::make_pair (root.Get (), 0));
 
 //
 // Optimize SPF calculation, for ns-3.
@@ -1377,10 +1799,13 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // reached.  Instead, short-circuit this computation and just install
 // a default route in the CheckForStubNode() method.
 //
-  if (NodeList::GetNNodes () > 0 && CheckForStubNode (root))
+  if ((m_spfrootNode || NodeList::GetNNodes () > 0) && CheckForStubNode (root))
     {
       NS_LOG_LOGIC ("SPFCalculate truncated for stub node " << root);
       delete m_spfroot;
+      m_spfroot = 0;
+      m_spfrootNode = 0;
+      m_spfDistances.erase (root);
       return;
     }
 
@@ -1429,6 +1854,7 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 // tree.
 //
       v->GetLSA ()->SetStatus (GlobalRoutingLSA::LSA_SPF_IN_SPFTREE);
+      distances.push_back (std::make_pair (v->GetVertexId ().Get (), v->GetDistanceFromRoot ()));
 //
 // The current vertex has a parent pointer.  By calling this rather oddly 
 // named method (blame quagga) we add the current vertex to the list of 
@@ -1502,6 +1928,9 @@ GlobalRouteManagerImpl::SPFCalculate (Ipv4Address root)
 //
   delete m_spfroot;
   m_spfroot = 0;
+  m_spfrootNode = 0;
+  std::sort (distances.begin (), distances.end ());
+  m_spfDistances[root].swap (distances);
 }
 
 void
@@ -1560,26 +1989,24 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was found
+// once by SPFCalculate.  This is the one we're going to write the routing
+// information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
 //
 // The router ID is accessible through the GlobalRouter interface, so we need
 // to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
+// in question cannot be the router we want, so we return.
 // 
       Ptr<GlobalRouter> rtr = node->GetObject<GlobalRouter> ();
 
       if (rtr == 0)
         {
           NS_LOG_LOGIC ("No GlobalRouter interface on node " << node->GetId ());
-          continue;
+          return;
         }
 //
 // If the router ID of the current node is equal to the router ID of the 
@@ -1629,7 +2056,7 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
           Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
           if (router == 0)
             {
-              continue;
+              return;
             }
           Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
           NS_ASSERT (gr);
@@ -1658,7 +2085,7 @@ GlobalRouteManagerImpl::SPFAddASExternal (GlobalRoutingLSA *extlsa, SPFVertex *v
             }
           return;
         } // if
-    } // for
+    } // if
 }
 
 
@@ -1729,19 +2156,17 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was found
+// once by SPFCalculate.  This is the one we're going to write the routing
+// information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
 //
 // The router ID is accessible through the GlobalRouter interface, so we need
 // to QI for that interface.  If there's no GlobalRouter interface, the node
-// in question cannot be the router we want, so we continue.
+// in question cannot be the router we want, so we return.
 // 
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
@@ -1750,7 +2175,7 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
         {
           NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
                         node->GetId ());
-          continue;
+          return;
         }
 //
 // If the router ID of the current node is equal to the router ID of the 
@@ -1800,7 +2225,7 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
           Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
           if (router == 0)
             {
-              continue;
+              return;
             }
           Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
           NS_ASSERT (gr);
@@ -1829,7 +2254,7 @@ GlobalRouteManagerImpl::SPFIntraAddStub (GlobalRoutingLinkRecord *l, SPFVertex*
             }
           return;
         } // if
-    } // for
+    } // if
 }
 
 //
@@ -1853,15 +2278,12 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
   Ipv4Address routerId = m_spfroot->GetVertexId ();
 //
-// Walk the list of nodes in the system looking for the one corresponding to
-// the node at the root of the SPF tree.  This is the node for which we are
-// building the routing table.
+// SPFCalculate found the node corresponding to the node at the root of the
+// SPF tree.  This is the node for which we are building the routing table.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
 
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
@@ -1871,7 +2293,7 @@ GlobalRouteManagerImpl::FindOutgoingInterfaceId (Ipv4Address a, Ipv4Mask amask)
 //
       if (rtr == 0)
         {
-          continue;
+          return -1;
         }
 
       if (rtr->GetRouterId () == routerId)
@@ -1944,19 +2366,17 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was found
+// once by SPFCalculate.  This is the one we're going to write the routing
+// information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
 //
 // The router ID is accessible through the GlobalRouter interface, so we need
 // to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
+// the node in question cannot be the router we want, so we return.
 // 
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
@@ -1965,7 +2385,7 @@ GlobalRouteManagerImpl::SPFIntraAddRouter (SPFVertex* v)
         {
           NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
                         node->GetId ());
-          continue;
+          return;
         }
 //
 // If the router ID of the current node is equal to the router ID of the 
@@ -2089,19 +2509,17 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
 
   NS_LOG_LOGIC ("Vertex ID = " << routerId);
 //
-// We need to walk the list of nodes looking for the one that has the router
-// ID corresponding to the root vertex.  This is the one we're going to write
-// the routing information to.
+// The node that has the router ID corresponding to the root vertex was found
+// once by SPFCalculate.  This is the one we're going to write the routing
+// information to.
 //
-  NodeList::Iterator i = NodeList::Begin (); 
-  NodeList::Iterator listEnd = NodeList::End ();
-  for (; i != listEnd; i++)
+  Ptr<Node> node = m_spfrootNode;
+  if (node != 0)
     {
-      Ptr<Node> node = *i;
 //
 // The router ID is accessible through the GlobalRouter interface, so we need
 // to GetObject for that interface.  If there's no GlobalRouter interface, 
-// the node in question cannot be the router we want, so we continue.
+// the node in question cannot be the router we want, so we return.
 // 
       Ptr<GlobalRouter> rtr = 
         node->GetObject<GlobalRouter> ();
@@ -2110,7 +2528,7 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
         {
           NS_LOG_LOGIC ("No GlobalRouter interface on node " << 
                         node->GetId ());
-          continue;
+          return;
         }
 //
 // If the router ID of the current node is equal to the router ID of the 
@@ -2147,7 +2565,7 @@ GlobalRouteManagerImpl::SPFIntraAddTransit (SPFVertex* v)
           Ptr<GlobalRouter> router = node->GetObject<GlobalRouter> ();
           if (router == 0)
             {
-              continue;
+              return;
             }
           Ptr<Ipv4GlobalRouting> gr = router->GetRoutingProtocol ();
           NS_ASSERT (gr);
@@ -29,6 +29,7 @@
 #include <vector>
 #include "ns3/object.h"
 #include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
 #include "ns3/ipv4-address.h"
 #include "global-router-interface.h"
 
@@ -530,8 +531,20 @@ private:
   uint32_t m_distanceFromRoot; //!< Distance from root node
   int32_t m_rootOif; //!< root Output Interface
   Ipv4Address m_nextHop; //!< next hop
-  typedef std::list< NodeExit_t > ListOfNodeExit_t; //!< container of Exit nodes
-  ListOfNodeExit_t m_ecmpRootExits; //!< store the multiple root's exits for supporting ECMP
+  /**
+   * \brief A sorted set of root exits, shared by the vertices that inherit it
+   *
+   * In a Clos fabric most vertices inherit the exits of their parent
+   * unchanged, so the vertices point to one group instead of copying it.
+   * A group is never changed once it is shared: SetRootExitDirection and
+   * MergeRootExitDirections build a new one.
+   */
+  class RootExitGroup : public SimpleRefCount<RootExitGroup>
+  {
+  public:
+    std::vector<NodeExit_t> exits; //!< the exits, sorted and unique
+  };
+  Ptr<RootExitGroup> m_ecmpRootExits; //!< store the multiple root's exits for supporting ECMP
   typedef std::list<SPFVertex*> ListOfSPFVertex_t; //!< container of SPFVertexes
   ListOfSPFVertex_t m_parents; //!< parent list
   ListOfSPFVertex_t m_children; //!< Children list
@@ -672,6 +685,23 @@ public:
    */
   uint32_t GetNumExtLSAs () const;
 
+  /**
+   * @brief Make a deep copy of the database.
+   *
+   * The copy owns its own Link State Advertisements, so that it can be
+   * initialized and walked by an SPF calculation running in another thread.
+   *
+   * @returns a new database holding copies of all the LSAs
+   */
+  GlobalRouteManagerLSDB* Copy (void) const;
+
+  /**
+   * @brief Get the (non external) Link State Advertisements.
+   *
+   * @param lsas filled with the router and network LSAs, in the order of
+   * their link state IDs
+   */
+  void GetLSAs (std::vector<GlobalRoutingLSA*>& lsas) const;
 
 private:
   typedef std::map<Ipv4Address, GlobalRoutingLSA*> LSDBMap_t; //!< container of IPv4 addresses / Link State Advertisements
@@ -733,6 +763,22 @@ public:
  */
   virtual void InitializeRoutes ();
 
+/**
+ * @brief Rebuild the routing database and update the routes of the nodes
+ * whose shortest paths changed since the last computation.
+ *
+ * When the only differences from the previous database are removed
+ * point-to-point or stub link records (e.g., after interfaces went down),
+ * only the roots for which a removed link was on a shortest path, and the
+ * routers that lost the records, run SPF again; the other roots just drop
+ * their routes to the addresses that are no longer advertised.  Any other
+ * change (a new link, a new or removed router, a transit network or an
+ * external LSA) triggers a full recomputation.  The resulting routes are
+ * the same as the ones of DeleteGlobalRoutes (), BuildGlobalRoutingDatabase ()
+ * and InitializeRoutes ().
+ */
+  virtual void UpdateRoutes ();
+
 /**
  * @brief Debugging routine; allow client code to supply a pre-built LSDB
  */
@@ -765,8 +811,60 @@ private:
   GlobalRouteManagerImpl& operator= (GlobalRouteManagerImpl& srmi);
 
   SPFVertex* m_spfroot; //!< the root node
+  Ptr<Node> m_spfrootNode; //!< the node of the root of the current SPF calculation
   GlobalRouteManagerLSDB* m_lsdb; //!< the Link State DataBase (LSDB) of the Global Route Manager
 
+  typedef std::map<Ipv4Address, Ptr<Node> > RouterNodeMap_t; //!< container of router IDs / nodes
+  RouterNodeMap_t m_routerNodes; //!< the nodes of the routers, by router ID
+
+  typedef std::vector<std::pair<uint32_t, uint32_t> > Distances_t; //!< vertex IDs / distances, sorted by vertex ID
+  typedef std::map<Ipv4Address, Distances_t> DistanceMap_t; //!< container of roots / SPF distances
+  DistanceMap_t m_spfDistances; //!< the SPF distances of the last calculation of each (non stub) root
+
+  struct SpfJob;
+  SpfJob* m_job; //!< the shared queue of roots, for a worker of CalculateRoutes
+
+  /**
+   * \brief Find the routers whose routes this system computes
+   *
+   * Also rebuilds the router ID to node map used by GetRouterNode ().
+   *
+   * \param roots filled with the router IDs
+   */
+  void FindRoots (std::vector<Ipv4Address>& roots);
+
+  /**
+   * \brief Get the node of a router
+   *
+   * \param routerId the router ID
+   * \returns the node, or 0 if there is no such router
+   */
+  Ptr<Node> GetRouterNode (Ipv4Address routerId) const;
+
+  /**
+   * \brief Run SPFCalculate for each root
+   *
+   * The roots are spread across the threads given by the
+   * "GlobalRoutingThreads" global value.  Each thread works on its own copy
+   * of the LSDB, and only writes the routing table of the root it is
+   * working on.
+   *
+   * \param roots the router IDs of the roots
+   */
+  void CalculateRoutes (const std::vector<Ipv4Address>& roots);
+
+  /**
+   * \brief Run SPFCalculate for the roots of m_job until there are none left
+   */
+  void RunSpfJob (void);
+
+  /**
+   * \brief Delete the global routes of a node
+   *
+   * \param node the node
+   */
+  void DeleteNodeRoutes (Ptr<Node> node);
+
   /**
    * \brief Test if a node is a stub, from an OSPF sense.
    *
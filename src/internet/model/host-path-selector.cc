@@ -0,0 +1,423 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "host-path-selector.h"
+#include "tcp-header.h"
+#include "tcp-flow-bender.h"
+#include "ipv4-xpath-tag.h"
+
+#include "ns3/log.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/boolean.h"
+#include "ns3/simulator.h"
+#include "ns3/ipv4-tlb.h"
+#include "ns3/tcp-tlb-tag.h"
+#include "ns3/ipv4-clove.h"
+#include "ns3/tcp-clove-tag.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("HostPathSelector");
+
+NS_OBJECT_ENSURE_REGISTERED (HostPathSelector);
+
+TypeId
+HostPathSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::HostPathSelector")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<HostPathSelector> ()
+  ;
+  return tid;
+}
+
+HostPathSelector::HostPathSelector ()
+  : m_flowId (0),
+    m_sendSide (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+HostPathSelector::~HostPathSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+HostPathSelector::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_node = 0;
+  m_pathCallback = MakeNullCallback<void, Ptr<HostPathSelector>, uint32_t> ();
+  Object::DoDispose ();
+}
+
+void
+HostPathSelector::SetPathCallback (PathCallback callback)
+{
+  m_pathCallback = callback;
+}
+
+void
+HostPathSelector::Bind (Ptr<Node> node, uint32_t flowId,
+                        Ipv4Address local, Ipv4Address peer, bool sendSide)
+{
+  NS_LOG_FUNCTION (this << node << flowId << local << peer << sendSide);
+  m_node = node;
+  m_flowId = flowId;
+  m_local = local;
+  m_peer = peer;
+  m_sendSide = sendSide;
+}
+
+void
+HostPathSelector::OnSend (Ptr<Packet> packet, uint8_t flags, bool hasData, bool isRetransmission)
+{
+}
+
+void
+HostPathSelector::OnAck (Ptr<Packet> packet, uint32_t bytesAcked, bool withECE)
+{
+}
+
+void
+HostPathSelector::OnAckProcessed (SequenceNumber32 highTxMark, SequenceNumber32 ackNumber,
+                                  uint32_t bytesAcked, bool withECE)
+{
+}
+
+void
+HostPathSelector::OnReceive (Ptr<Packet> packet)
+{
+}
+
+void
+HostPathSelector::OnTimeout (void)
+{
+}
+
+void
+HostPathSelector::OnRetransmit (SequenceNumber32 seq)
+{
+}
+
+uint32_t
+HostPathSelector::MapFlowId (uint32_t flowId)
+{
+  return flowId;
+}
+
+Time
+HostPathSelector::GetPauseTime (void)
+{
+  return Seconds (0);
+}
+
+void
+HostPathSelector::NotifyPath (uint32_t path)
+{
+  if (!m_pathCallback.IsNull ())
+    {
+      m_pathCallback (this, path);
+    }
+}
+
+NS_OBJECT_ENSURE_REGISTERED (TlbPathSelector);
+
+TypeId
+TlbPathSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TlbPathSelector")
+    .SetParent<HostPathSelector> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TlbPathSelector> ()
+    .AddAttribute ("ReverseAck", "Whether the receiver picks the path of its ACKs",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TlbPathSelector::m_reverseAck),
+                   MakeBooleanChecker ())
+  ;
+  return tid;
+}
+
+TlbPathSelector::TlbPathSelector ()
+  : m_reverseAck (false),
+    m_pathAcked (0),
+    m_piggyback (false),
+    m_path (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TlbPathSelector::~TlbPathSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TlbPathSelector::DoDispose (void)
+{
+  m_tlb = 0;
+  HostPathSelector::DoDispose ();
+}
+
+void
+TlbPathSelector::Bind (Ptr<Node> node, uint32_t flowId,
+                       Ipv4Address local, Ipv4Address peer, bool sendSide)
+{
+  HostPathSelector::Bind (node, flowId, local, peer, sendSide);
+  m_tlb = node->GetObject<Ipv4TLB> ();
+  NS_ASSERT_MSG (m_tlb != 0, "TLB is enabled on a node without Ipv4TLB");
+}
+
+void
+TlbPathSelector::OnSend (Ptr<Packet> packet, uint8_t flags, bool hasData, bool isRetransmission)
+{
+  if (m_sendSide)
+    {
+      uint32_t path = m_tlb->GetPath (m_flowId, m_local, m_peer);
+
+      Ipv4XPathTag ipv4XPathTag;
+      ipv4XPathTag.SetPathId (path);
+      ipv4XPathTag.AddTo (packet);
+
+      TcpTLBTag tcpTLBTag;
+      tcpTLBTag.SetPath (path);
+      tcpTLBTag.SetTime (Simulator::Now ());
+      tcpTLBTag.AddTo (packet);
+
+      m_tlb->FlowSend (m_flowId, m_peer, path, packet->GetSize (), isRetransmission);
+      if ((flags & TcpHeader::SYN) && isRetransmission)
+        {
+          m_tlb->FlowTimeout (m_flowId, m_peer, path);
+        }
+      NotifyPath (path);
+      return;
+    }
+
+  // The receiver only echoes on its empty segments
+  if (hasData)
+    {
+      return;
+    }
+
+  if (m_piggyback)
+    {
+      TcpTLBTag tcpTLBTag;
+      tcpTLBTag.SetPath (m_path);
+      tcpTLBTag.SetTime (m_onewayRtt);
+      tcpTLBTag.AddTo (packet);
+    }
+
+  bool isAck = (flags & ~(TcpHeader::ECE | TcpHeader::CWR)) == TcpHeader::ACK;
+  if (m_reverseAck && ((flags & TcpHeader::SYN) || isAck))
+    {
+      Ipv4XPathTag ipv4XPathTag;
+      ipv4XPathTag.SetPathId (m_tlb->GetAckPath (m_flowId, m_local, m_peer));
+      ipv4XPathTag.AddTo (packet);
+    }
+}
+
+void
+TlbPathSelector::OnAck (Ptr<Packet> packet, uint32_t bytesAcked, bool withECE)
+{
+  if (!m_sendSide)
+    {
+      return;
+    }
+  TcpTLBTag tcpTLBTag;
+  if (tcpTLBTag.RemoveFrom (packet))
+    {
+      m_pathAcked = tcpTLBTag.GetPath ();
+      m_tlb->FlowRecv (m_flowId, m_pathAcked, m_peer, bytesAcked, withECE, tcpTLBTag.GetTime ());
+    }
+}
+
+void
+TlbPathSelector::OnReceive (Ptr<Packet> packet)
+{
+  if (m_sendSide)
+    {
+      return;
+    }
+  TcpTLBTag tcpTLBTag;
+  if (tcpTLBTag.RemoveFrom (packet))
+    {
+      m_piggyback = true;
+      m_onewayRtt = Simulator::Now () - tcpTLBTag.GetTime ();
+      m_path = tcpTLBTag.GetPath ();
+    }
+}
+
+void
+TlbPathSelector::OnTimeout (void)
+{
+  m_tlb->FlowTimeout (m_flowId, m_peer, m_pathAcked);
+}
+
+Time
+TlbPathSelector::GetPauseTime (void)
+{
+  return m_tlb->GetPauseTime (m_flowId);
+}
+
+NS_OBJECT_ENSURE_REGISTERED (ClovePathSelector);
+
+TypeId
+ClovePathSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::ClovePathSelector")
+    .SetParent<HostPathSelector> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<ClovePathSelector> ()
+  ;
+  return tid;
+}
+
+ClovePathSelector::ClovePathSelector ()
+  : m_piggyback (false),
+    m_path (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+ClovePathSelector::~ClovePathSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+ClovePathSelector::DoDispose (void)
+{
+  m_clove = 0;
+  HostPathSelector::DoDispose ();
+}
+
+void
+ClovePathSelector::Bind (Ptr<Node> node, uint32_t flowId,
+                         Ipv4Address local, Ipv4Address peer, bool sendSide)
+{
+  HostPathSelector::Bind (node, flowId, local, peer, sendSide);
+  m_clove = node->GetObject<Ipv4Clove> ();
+  NS_ASSERT_MSG (m_clove != 0, "Clove is enabled on a node without Ipv4Clove");
+}
+
+void
+ClovePathSelector::OnSend (Ptr<Packet> packet, uint8_t flags, bool hasData, bool isRetransmission)
+{
+  if (m_sendSide)
+    {
+      uint32_t path = m_clove->GetPath (m_flowId, m_local, m_peer);
+
+      Ipv4XPathTag ipv4XPathTag;
+      ipv4XPathTag.SetPathId (path);
+      ipv4XPathTag.AddTo (packet);
+
+      TcpCloveTag tcpCloveTag;
+      tcpCloveTag.SetPath (path);
+      tcpCloveTag.AddTo (packet);
+    }
+  else if (!hasData && m_piggyback)
+    {
+      TcpCloveTag tcpCloveTag;
+      tcpCloveTag.SetPath (m_path);
+      tcpCloveTag.AddTo (packet);
+    }
+}
+
+void
+ClovePathSelector::OnAck (Ptr<Packet> packet, uint32_t bytesAcked, bool withECE)
+{
+  if (!m_sendSide)
+    {
+      return;
+    }
+  TcpCloveTag tcpCloveTag;
+  if (tcpCloveTag.RemoveFrom (packet))
+    {
+      m_clove->FlowRecv (tcpCloveTag.GetPath (), m_peer, withECE);
+    }
+}
+
+void
+ClovePathSelector::OnReceive (Ptr<Packet> packet)
+{
+  if (m_sendSide)
+    {
+      return;
+    }
+  TcpCloveTag tcpCloveTag;
+  if (tcpCloveTag.RemoveFrom (packet))
+    {
+      m_piggyback = true;
+      m_path = tcpCloveTag.GetPath ();
+    }
+}
+
+NS_OBJECT_ENSURE_REGISTERED (FlowBenderPathSelector);
+
+TypeId
+FlowBenderPathSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowBenderPathSelector")
+    .SetParent<HostPathSelector> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<FlowBenderPathSelector> ()
+  ;
+  return tid;
+}
+
+FlowBenderPathSelector::FlowBenderPathSelector ()
+{
+  NS_LOG_FUNCTION (this);
+  m_flowBender = CreateObject<TcpFlowBender> ();
+}
+
+FlowBenderPathSelector::~FlowBenderPathSelector ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FlowBenderPathSelector::DoDispose (void)
+{
+  m_flowBender = 0;
+  HostPathSelector::DoDispose ();
+}
+
+void
+FlowBenderPathSelector::OnAckProcessed (SequenceNumber32 highTxMark, SequenceNumber32 ackNumber,
+                                        uint32_t bytesAcked, bool withECE)
+{
+  m_flowBender->ReceivedPacket (highTxMark, ackNumber, bytesAcked, withECE);
+}
+
+uint32_t
+FlowBenderPathSelector::MapFlowId (uint32_t flowId)
+{
+  uint32_t path = m_flowBender->GetV ();
+  NotifyPath (path);
+  return flowId + path;
+}
+
+Time
+FlowBenderPathSelector::GetPauseTime (void)
+{
+  return m_flowBender->GetPauseTime ();
+}
+
+} // namespace ns3
@@ -0,0 +1,252 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef HOST_PATH_SELECTOR_H
+#define HOST_PATH_SELECTOR_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+#include "ns3/callback.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/sequence-number.h"
+
+namespace ns3 {
+
+class Node;
+class Packet;
+class Ipv4TLB;
+class Ipv4Clove;
+class TcpFlowBender;
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Host side path selection of a TCP connection
+ *
+ * The edge load balancing schemes are pluggable components of the socket,
+ * the way the congestion control is. A selector is bound once to an IPv4
+ * connection, when it is set up, and then follows its segments through the
+ * hooks below. It may tag the outgoing segments with their path, change
+ * their flow id, or learn from the tags of the incoming ones.
+ *
+ * This base class selects nothing, each hook is a no-op.
+ */
+class HostPathSelector : public Object
+{
+public:
+  /**
+   * \brief Get the type ID.
+   * \return the object TypeId
+   */
+  static TypeId GetTypeId (void);
+
+  HostPathSelector ();
+  virtual ~HostPathSelector ();
+
+  /**
+   * \brief Callback invoked with the path of each segment the selector routes,
+   * so that the socket can pause on a path change
+   */
+  typedef Callback<void, Ptr<HostPathSelector>, uint32_t> PathCallback;
+
+  void SetPathCallback (PathCallback callback);
+
+  /**
+   * \brief Bind the selector to a connection
+   *
+   * \param node the node of the socket
+   * \param flowId the flow id of the connection
+   * \param local the local address
+   * \param peer the peer address
+   * \param sendSide whether the socket opened the connection
+   */
+  virtual void Bind (Ptr<Node> node, uint32_t flowId,
+                     Ipv4Address local, Ipv4Address peer, bool sendSide);
+
+  /**
+   * \brief A segment is about to be sent
+   *
+   * \param packet the segment, without its TCP header
+   * \param flags the TCP flags of the segment
+   * \param hasData whether the segment carries data
+   * \param isRetransmission whether the segment is sent again
+   */
+  virtual void OnSend (Ptr<Packet> packet, uint8_t flags, bool hasData, bool isRetransmission);
+
+  /**
+   * \brief An ACK arrived, before the socket processes it
+   *
+   * \param packet the ACK, without its TCP header
+   * \param bytesAcked the bytes newly acknowledged
+   * \param withECE whether the ACK echoes a congestion mark
+   */
+  virtual void OnAck (Ptr<Packet> packet, uint32_t bytesAcked, bool withECE);
+
+  /**
+   * \brief The congestion control accounted for acknowledged bytes
+   *
+   * \param highTxMark the highest sequence number sent
+   * \param ackNumber the acknowledgement number
+   * \param bytesAcked the bytes accounted for
+   * \param withECE whether the ACK echoes a congestion mark
+   */
+  virtual void OnAckProcessed (SequenceNumber32 highTxMark, SequenceNumber32 ackNumber,
+                               uint32_t bytesAcked, bool withECE);
+
+  /**
+   * \brief A data segment arrived, before it enters the receive buffer
+   *
+   * \param packet the segment, without its TCP header
+   */
+  virtual void OnReceive (Ptr<Packet> packet);
+
+  /**
+   * \brief The retransmission timer expired out of the loss state
+   */
+  virtual void OnTimeout (void);
+
+  /**
+   * \brief A segment is retransmitted, after a timeout or a fast retransmit
+   *
+   * \param seq the sequence number of the segment
+   */
+  virtual void OnRetransmit (SequenceNumber32 seq);
+
+  /**
+   * \brief Map the flow id of an outgoing segment, used by the ECMP hash
+   *
+   * \param flowId the flow id of the connection or of the previous selector
+   * \return the flow id to tag the segment with
+   */
+  virtual uint32_t MapFlowId (uint32_t flowId);
+
+  /**
+   * \return how long the socket should pause after a path change
+   */
+  virtual Time GetPauseTime (void);
+
+protected:
+  virtual void DoDispose (void);
+
+  /**
+   * \brief Report the path of a segment to the socket
+   * \param path the path
+   */
+  void NotifyPath (uint32_t path);
+
+  Ptr<Node> m_node;      //!< The node of the socket
+  uint32_t m_flowId;     //!< The flow id of the connection
+  Ipv4Address m_local;   //!< The local address
+  Ipv4Address m_peer;    //!< The peer address
+  bool m_sendSide;       //!< Whether the socket opened the connection
+
+private:
+  PathCallback m_pathCallback;
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief TLB: the sender picks the path of each segment from the Ipv4TLB
+ * of the node, and the receiver echoes the path and the one way delay
+ */
+class TlbPathSelector : public HostPathSelector
+{
+public:
+  static TypeId GetTypeId (void);
+
+  TlbPathSelector ();
+  virtual ~TlbPathSelector ();
+
+  virtual void Bind (Ptr<Node> node, uint32_t flowId,
+                     Ipv4Address local, Ipv4Address peer, bool sendSide);
+  virtual void OnSend (Ptr<Packet> packet, uint8_t flags, bool hasData, bool isRetransmission);
+  virtual void OnAck (Ptr<Packet> packet, uint32_t bytesAcked, bool withECE);
+  virtual void OnReceive (Ptr<Packet> packet);
+  virtual void OnTimeout (void);
+  virtual Time GetPauseTime (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  Ptr<Ipv4TLB> m_tlb;
+  bool m_reverseAck;    //!< Whether the receiver picks the path of its ACKs
+
+  uint32_t m_pathAcked; //!< The path of the last echoed segment
+  bool m_piggyback;     //!< Whether the receiver has something to echo
+  uint32_t m_path;      //!< The path to echo
+  Time m_onewayRtt;     //!< The one way delay to echo
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief Clove: the sender picks the path of each segment from the Ipv4Clove
+ * of the node, and the receiver echoes the path
+ */
+class ClovePathSelector : public HostPathSelector
+{
+public:
+  static TypeId GetTypeId (void);
+
+  ClovePathSelector ();
+  virtual ~ClovePathSelector ();
+
+  virtual void Bind (Ptr<Node> node, uint32_t flowId,
+                     Ipv4Address local, Ipv4Address peer, bool sendSide);
+  virtual void OnSend (Ptr<Packet> packet, uint8_t flags, bool hasData, bool isRetransmission);
+  virtual void OnAck (Ptr<Packet> packet, uint32_t bytesAcked, bool withECE);
+  virtual void OnReceive (Ptr<Packet> packet);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  Ptr<Ipv4Clove> m_clove;
+
+  bool m_piggyback;     //!< Whether the receiver has something to echo
+  uint32_t m_path;      //!< The path to echo
+};
+
+/**
+ * \ingroup tcp
+ *
+ * \brief FlowBender: the flow id of the segments changes once the ECN marks
+ * stay high for several RTTs, so that the switches hash them to another path
+ */
+class FlowBenderPathSelector : public HostPathSelector
+{
+public:
+  static TypeId GetTypeId (void);
+
+  FlowBenderPathSelector ();
+  virtual ~FlowBenderPathSelector ();
+
+  virtual void OnAckProcessed (SequenceNumber32 highTxMark, SequenceNumber32 ackNumber,
+                               uint32_t bytesAcked, bool withECE);
+  virtual uint32_t MapFlowId (uint32_t flowId);
+  virtual Time GetPauseTime (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  Ptr<TcpFlowBender> m_flowBender;
+};
+
+} // namespace ns3
+
+#endif /* HOST_PATH_SELECTOR_H */
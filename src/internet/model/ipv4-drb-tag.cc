@@ -1,4 +1,5 @@
 #include "ipv4-drb-tag.h"
+#include "ns3/packet.h"
 
 namespace ns3
 {
@@ -56,4 +57,34 @@ Ipv4DrbTag::Print (std::ostream &os) const
 {
   os << "IP_Drb_original_dest_addr = " << m_addr;
 }
+
+bool
+Ipv4DrbTag::PeekFrom (Ptr<const Packet> packet)
+{
+  const LbMetadata &metadata = packet->GetLbMetadata ();
+  if (!metadata.Has (LbMetadata::OVERLAY))
+    {
+      return false;
+    }
+  m_addr = metadata.GetOverlayDestination ();
+  return true;
+}
+
+void
+Ipv4DrbTag::AddTo (Ptr<const Packet> packet) const
+{
+  packet->GetLbMetadata ().SetOverlayDestination (m_addr);
+}
+
+bool
+Ipv4DrbTag::RemoveFrom (Ptr<const Packet> packet)
+{
+  if (!PeekFrom (packet))
+    {
+      return false;
+    }
+  packet->GetLbMetadata ().Remove (LbMetadata::OVERLAY);
+  return true;
+}
+
 }
@@ -2,10 +2,13 @@
 #define NS3_IPV4_DRB_TAG
 
 #include "ns3/tag.h"
+#include "ns3/ptr.h"
 #include "ns3/ipv4-address.h"
 
 namespace ns3 {
 
+class Packet;
+
 class Ipv4DrbTag : public Tag
 {
 public:
@@ -27,6 +30,13 @@ public:
 
   virtual void Print (std::ostream &os) const;
 
+  // Adapters on the LbMetadata of the packet, AddTo replaces an existing value
+  bool PeekFrom (Ptr<const Packet> packet);
+
+  void AddTo (Ptr<const Packet> packet) const;
+
+  bool RemoveFrom (Ptr<const Packet> packet);
+
 private:
   Ipv4Address m_addr;
 };
@@ -1,4 +1,5 @@
 #include "ipv4-ecn-tag.h"
+#include "ns3/packet.h"
 
 namespace ns3
 {
@@ -55,4 +56,34 @@ Ipv4EcnTag::Print (std::ostream &os) const
 {
   os << "IP_ECN = " << m_ipv4Ecn;
 }
+
+bool
+Ipv4EcnTag::PeekFrom (Ptr<const Packet> packet)
+{
+  const LbMetadata &metadata = packet->GetLbMetadata ();
+  if (!metadata.Has (LbMetadata::ECN))
+    {
+      return false;
+    }
+  m_ipv4Ecn = metadata.GetEcn ();
+  return true;
+}
+
+void
+Ipv4EcnTag::AddTo (Ptr<const Packet> packet) const
+{
+  packet->GetLbMetadata ().SetEcn (m_ipv4Ecn);
+}
+
+bool
+Ipv4EcnTag::RemoveFrom (Ptr<const Packet> packet)
+{
+  if (!PeekFrom (packet))
+    {
+      return false;
+    }
+  packet->GetLbMetadata ().Remove (LbMetadata::ECN);
+  return true;
+}
+
 }
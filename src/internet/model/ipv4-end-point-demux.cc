@@ -17,15 +17,32 @@
  *
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
-
 #include "ipv4-end-point-demux.h"
 #include "ipv4-end-point.h"
 #include "ns3/log.h"
+#include "ns3/flow-hash.h"
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("Ipv4EndPointDemux");
 
+bool
+Ipv4EndPointDemux::FourTuple::operator== (const FourTuple &other) const
+{
+  return localPort == other.localPort
+         && peerPort == other.peerPort
+         && localAddress == other.localAddress
+         && peerAddress == other.peerAddress;
+}
+
+size_t
+Ipv4EndPointDemux::FourTupleHash::operator() (const FourTuple &x) const
+{
+  uint32_t hash = FlowHash::Mix (x.localAddress.Get ());
+  hash = FlowHash::Mix (hash ^ x.peerAddress.Get ());
+  return FlowHash::Mix (hash ^ ((static_cast<uint32_t> (x.localPort) << 16) | x.peerPort));
+}
+
 Ipv4EndPointDemux::Ipv4EndPointDemux ()
   : m_ephemeral (49152), m_portLast (65535), m_portFirst (49152)
 {
@@ -35,36 +52,39 @@ Ipv4EndPointDemux::Ipv4EndPointDemux ()
 Ipv4EndPointDemux::~Ipv4EndPointDemux ()
 {
   NS_LOG_FUNCTION (this);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (PortEndPoints::iterator port = m_endPoints.begin (); port != m_endPoints.end (); port++)
     {
-      Ipv4EndPoint *endPoint = *i;
-      delete endPoint;
+      for (EndPointsI i = port->second.begin (); i != port->second.end (); i++)
+        {
+          Ipv4EndPoint *endPoint = *i;
+          endPoint->m_demux = 0;
+          delete endPoint;
+        }
     }
   m_endPoints.clear ();
+  m_listening.clear ();
+  m_connected.clear ();
 }
 
 bool
 Ipv4EndPointDemux::LookupPortLocal (uint16_t port)
 {
   NS_LOG_FUNCTION (this << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      if ((*i)->GetLocalPort  () == port) 
-        {
-          return true;
-        }
-    }
-  return false;
+  return m_endPoints.find (port) != m_endPoints.end ();
 }
 
 bool
 Ipv4EndPointDemux::LookupLocal (Ipv4Address addr, uint16_t port)
 {
   NS_LOG_FUNCTION (this << addr << port);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  PortEndPoints::iterator endPoints = m_endPoints.find (port);
+  if (endPoints == m_endPoints.end ())
     {
-      if ((*i)->GetLocalPort () == port &&
-          (*i)->GetLocalAddress () == addr) 
+      return false;
+    }
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
+    {
+      if ((*i)->GetLocalAddress () == addr) 
         {
           return true;
         }
@@ -83,8 +103,7 @@ Ipv4EndPointDemux::Allocate (void)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (Ipv4Address::GetAny (), port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -99,8 +118,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -122,8 +140,7 @@ Ipv4EndPointDemux::Allocate (Ipv4Address address, uint16_t port)
       return 0;
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (address, port);
-  m_endPoints.push_back (endPoint);
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -132,24 +149,24 @@ Ipv4EndPointDemux::Allocate (Ipv4Address localAddress, uint16_t localPort,
                              Ipv4Address peerAddress, uint16_t peerPort)
 {
   NS_LOG_FUNCTION (this << localAddress << localPort << peerAddress << peerPort);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  PortEndPoints::iterator endPoints = m_endPoints.find (localPort);
+  if (endPoints != m_endPoints.end ())
     {
-      if ((*i)->GetLocalPort () == localPort &&
-          (*i)->GetLocalAddress () == localAddress &&
-          (*i)->GetPeerPort () == peerPort &&
-          (*i)->GetPeerAddress () == peerAddress) 
+      for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
         {
-          NS_LOG_WARN ("No way we can allocate this end-point.");
-          /* no way we can allocate this end-point. */
-          return 0;
+          if ((*i)->GetLocalAddress () == localAddress &&
+              (*i)->GetPeerPort () == peerPort &&
+              (*i)->GetPeerAddress () == peerAddress) 
+            {
+              NS_LOG_WARN ("No way we can allocate this end-point.");
+              /* no way we can allocate this end-point. */
+              return 0;
+            }
         }
     }
   Ipv4EndPoint *endPoint = new Ipv4EndPoint (localAddress, localPort);
   endPoint->SetPeer (peerAddress, peerPort);
-  m_endPoints.push_back (endPoint);
-
-  NS_LOG_DEBUG ("Now have >>" << m_endPoints.size () << "<< endpoints.");
-
+  Insert (endPoint);
   return endPoint;
 }
 
@@ -157,12 +174,23 @@ void
 Ipv4EndPointDemux::DeAllocate (Ipv4EndPoint *endPoint)
 {
   NS_LOG_FUNCTION (this << endPoint);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  PortEndPoints::iterator endPoints = m_endPoints.find (endPoint->GetLocalPort ());
+  if (endPoints == m_endPoints.end ())
+    {
+      return;
+    }
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
     {
       if (*i == endPoint)
         {
+          Unindex (endPoint);
+          endPoints->second.erase (i);
+          if (endPoints->second.empty ())
+            {
+              m_endPoints.erase (endPoints);
+            }
+          endPoint->m_demux = 0;
           delete endPoint;
-          m_endPoints.erase (i);
           break;
         }
     }
@@ -177,143 +205,242 @@ Ipv4EndPointDemux::GetAllEndPoints (void)
   NS_LOG_FUNCTION (this);
   EndPoints ret;
 
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++)
+  for (PortEndPoints::iterator port = m_endPoints.begin (); port != m_endPoints.end (); port++)
     {
-      Ipv4EndPoint* endP = *i;
-      ret.push_back (endP);
+      ret.insert (ret.end (), port->second.begin (), port->second.end ());
     }
   return ret;
 }
 
+void
+Ipv4EndPointDemux::Insert (Ipv4EndPoint *endPoint)
+{
+  NS_LOG_FUNCTION (this << endPoint);
+  m_endPoints[endPoint->GetLocalPort ()].push_back (endPoint);
+  endPoint->m_demux = this;
+  Index (endPoint);
+  NS_LOG_DEBUG ("Now have >>" << m_endPoints[endPoint->GetLocalPort ()].size ()
+                              << "<< endpoints on port " << endPoint->GetLocalPort ());
+}
+
+void
+Ipv4EndPointDemux::Index (Ipv4EndPoint *endPoint)
+{
+  // The endpoints with only one of the peer address and port set never
+  // match a packet, they are only indexed by local port
+  if (endPoint->GetPeerPort () == 0 && endPoint->GetPeerAddress () == Ipv4Address::GetAny ())
+    {
+      m_listening[endPoint->GetLocalPort ()].push_back (endPoint);
+    }
+  else if (endPoint->GetPeerPort () != 0 && endPoint->GetPeerAddress () != Ipv4Address::GetAny ())
+    {
+      FourTuple tuple;
+      tuple.localAddress = endPoint->GetLocalAddress ();
+      tuple.localPort = endPoint->GetLocalPort ();
+      tuple.peerAddress = endPoint->GetPeerAddress ();
+      tuple.peerPort = endPoint->GetPeerPort ();
+      m_connected[tuple].push_back (endPoint);
+    }
+}
+
+void
+Ipv4EndPointDemux::Unindex (Ipv4EndPoint *endPoint)
+{
+  if (endPoint->GetPeerPort () == 0 && endPoint->GetPeerAddress () == Ipv4Address::GetAny ())
+    {
+      PortEndPoints::iterator endPoints = m_listening.find (endPoint->GetLocalPort ());
+      NS_ASSERT (endPoints != m_listening.end ());
+      endPoints->second.remove (endPoint);
+      if (endPoints->second.empty ())
+        {
+          m_listening.erase (endPoints);
+        }
+    }
+  else if (endPoint->GetPeerPort () != 0 && endPoint->GetPeerAddress () != Ipv4Address::GetAny ())
+    {
+      FourTuple tuple;
+      tuple.localAddress = endPoint->GetLocalAddress ();
+      tuple.localPort = endPoint->GetLocalPort ();
+      tuple.peerAddress = endPoint->GetPeerAddress ();
+      tuple.peerPort = endPoint->GetPeerPort ();
+      ConnectedEndPoints::iterator endPoints = m_connected.find (tuple);
+      NS_ASSERT (endPoints != m_connected.end ());
+      endPoints->second.remove (endPoint);
+      if (endPoints->second.empty ())
+        {
+          m_connected.erase (endPoints);
+        }
+    }
+}
+
+bool
+Ipv4EndPointDemux::CanReceive (Ipv4EndPoint *endPoint, Ptr<Ipv4Interface> incomingInterface)
+{
+  if (!endPoint->IsRxEnabled ())
+    {
+      NS_LOG_LOGIC ("Skipping endpoint " << endPoint
+                    << " because endpoint can not receive packets");
+      return false;
+    }
+  if (endPoint->GetBoundNetDevice ())
+    {
+      if (endPoint->GetBoundNetDevice () != incomingInterface->GetDevice ())
+        {
+          NS_LOG_LOGIC ("Skipping endpoint " << endPoint
+                                             << " because endpoint is bound to specific device and"
+                                             << endPoint->GetBoundNetDevice ()
+                                             << " does not match packet device " << incomingInterface->GetDevice ());
+          return false;
+        }
+    }
+  return true;
+}
 
-/*
- * If we have an exact match, we return it.
- * Otherwise, if we find a generic match, we return it.
- * Otherwise, we return 0.
- */
 Ipv4EndPointDemux::EndPoints
 Ipv4EndPointDemux::Lookup (Ipv4Address daddr, uint16_t dport, 
                            Ipv4Address saddr, uint16_t sport,
                            Ptr<Ipv4Interface> incomingInterface)
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
-  
-  EndPoints retval1; // Matches exact on local port, wildcards on others
-  EndPoints retval2; // Matches exact on local port/adder, wildcards on others
-  EndPoints retval3; // Matches all but local address
-  EndPoints retval4; // Exact match on all 4
+  EndPoints retval;
+  DoLookup (daddr, dport, saddr, sport, incomingInterface, &retval);
+  return retval;
+}
 
-  NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
-    {
-      Ipv4EndPoint* endP = *i;
+Ipv4EndPoint *
+Ipv4EndPointDemux::LookupBest (Ipv4Address daddr, uint16_t dport,
+                               Ipv4Address saddr, uint16_t sport,
+                               Ptr<Ipv4Interface> incomingInterface)
+{
+  NS_LOG_FUNCTION (this << daddr << dport << saddr << sport << incomingInterface);
+  return DoLookup (daddr, dport, saddr, sport, incomingInterface, 0);
+}
 
-      NS_LOG_DEBUG ("Looking at endpoint dport=" << endP->GetLocalPort ()
-                                                 << " daddr=" << endP->GetLocalAddress ()
-                                                 << " sport=" << endP->GetPeerPort ()
-                                                 << " saddr=" << endP->GetPeerAddress ());
+/*
+ * If we have an exact match, we return it.
+ * Otherwise, if we find a generic match, we return it.
+ * Otherwise, we return 0.
+ *
+ * The matches are, from the most exact one:
+ *   4. Exact match on all 4, from the connected endpoints
+ *   3. Matches all but local address, from the connected endpoints
+ *   2. Matches exact on local port/adder, wildcards on others, from the
+ *      listening endpoints
+ *   1. Matches exact on local port, wildcards on others, from the listening
+ *      endpoints
+ */
+Ipv4EndPoint *
+Ipv4EndPointDemux::DoLookup (Ipv4Address daddr, uint16_t dport,
+                             Ipv4Address saddr, uint16_t sport,
+                             Ptr<Ipv4Interface> incomingInterface,
+                             EndPoints *retval)
+{
+  NS_LOG_DEBUG ("Looking up endpoint for destination address " << daddr);
 
-      if (!endP->IsRxEnabled ())
+  bool subnetDirected = false;
+  Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
+  for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
+    {
+      Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
+      if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
+          daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                        << " because endpoint can not receive packets");
-          continue;
+          subnetDirected = true;
+          incomingInterfaceAddr = addr.GetLocal ();
         }
+    }
+  bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
+  NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
 
-      if (endP->GetLocalPort () != dport) 
+  // The connected endpoints with the local address of the packet, or of
+  // the interface for a broadcast, then with a wildcard local address
+  Ipv4Address localAddresses[2] = { isBroadcast ? incomingInterfaceAddr : daddr, Ipv4Address::GetAny () };
+  for (uint32_t j = 0; j < 2; j++)
+    {
+      if (j == 1 && localAddresses[1] == localAddresses[0])
+        {
+          break;
+        }
+      FourTuple tuple;
+      tuple.localAddress = localAddresses[j];
+      tuple.localPort = dport;
+      tuple.peerAddress = saddr;
+      tuple.peerPort = sport;
+      ConnectedEndPoints::iterator endPoints = m_connected.find (tuple);
+      if (endPoints == m_connected.end ())
         {
-          NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                             << " because endpoint dport "
-                                             << endP->GetLocalPort ()
-                                             << " does not match packet dport " << dport);
           continue;
         }
-      if (endP->GetBoundNetDevice ())
+      for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++)
         {
-          if (endP->GetBoundNetDevice () != incomingInterface->GetDevice ())
+          if (!CanReceive (*i, incomingInterface))
             {
-              NS_LOG_LOGIC ("Skipping endpoint " << &endP
-                                                 << " because endpoint is bound to specific device and"
-                                                 << endP->GetBoundNetDevice ()
-                                                 << " does not match packet device " << incomingInterface->GetDevice ());
               continue;
             }
-        }
-      bool subnetDirected = false;
-      Ipv4Address incomingInterfaceAddr = daddr;  // may be a broadcast
-      for (uint32_t i = 0; i < incomingInterface->GetNAddresses (); i++)
-        {
-          Ipv4InterfaceAddress addr = incomingInterface->GetAddress (i);
-          if (addr.GetLocal ().CombineMask (addr.GetMask ()) == daddr.CombineMask (addr.GetMask ()) &&
-              daddr.IsSubnetDirectedBroadcast (addr.GetMask ()))
+          if (retval == 0)
             {
-              subnetDirected = true;
-              incomingInterfaceAddr = addr.GetLocal ();
+              return *i;
             }
+          retval->push_back (*i);
         }
-      bool isBroadcast = (daddr.IsBroadcast () || subnetDirected == true);
-      NS_LOG_DEBUG ("dest addr " << daddr << " broadcast? " << isBroadcast);
-      bool localAddressMatchesWildCard = 
-        endP->GetLocalAddress () == Ipv4Address::GetAny ();
-      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
-
-      if (isBroadcast)
+      if (retval != 0 && !retval->empty ())
         {
-          NS_LOG_DEBUG ("Found bcast, localaddr " << endP->GetLocalAddress ());
+          return retval->front ();
         }
+    }
 
-      if (isBroadcast && (endP->GetLocalAddress () != Ipv4Address::GetAny ()))
+  PortEndPoints::iterator endPoints = m_listening.find (dport);
+  if (endPoints == m_listening.end ())
+    {
+      return 0;
+    }
+  Ipv4EndPoint *wildcard = 0;
+  EndPoints wildcards;
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
+    {
+      Ipv4EndPoint* endP = *i;
+      if (!CanReceive (endP, incomingInterface))
+        {
+          continue;
+        }
+      bool localAddressMatchesWildCard = 
+        endP->GetLocalAddress () == Ipv4Address::GetAny ();
+      bool localAddressMatchesExact = endP->GetLocalAddress () == daddr;
+      if (isBroadcast && !localAddressMatchesWildCard)
         {
           localAddressMatchesExact = (endP->GetLocalAddress () ==
                                       incomingInterfaceAddr);
         }
-      // if no match here, keep looking
-      if (!(localAddressMatchesExact || localAddressMatchesWildCard))
-        continue; 
-      bool remotePeerMatchesExact = endP->GetPeerPort () == sport;
-      bool remotePeerMatchesWildCard = endP->GetPeerPort () == 0;
-      bool remoteAddressMatchesExact = endP->GetPeerAddress () == saddr;
-      bool remoteAddressMatchesWildCard = endP->GetPeerAddress () ==
-        Ipv4Address::GetAny ();
-      // If remote does not match either with exact or wildcard,
-      // skip this one
-      if (!(remotePeerMatchesExact || remotePeerMatchesWildCard))
-        continue;
-      if (!(remoteAddressMatchesExact || remoteAddressMatchesWildCard))
-        continue;
-
-      // Now figure out which return list to add this one to
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
-        { // Only local port matches exactly
-          retval1.push_back (endP);
-        }
-      if ((localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))&&
-          remotePeerMatchesWildCard &&
-          remoteAddressMatchesWildCard)
+
+      if (localAddressMatchesExact || (isBroadcast && localAddressMatchesWildCard))
         { // Only local port and local address matches exactly
-          retval2.push_back (endP);
-        }
-      if (localAddressMatchesWildCard &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All but local address
-          retval3.push_back (endP);
+          if (retval == 0)
+            {
+              return endP;
+            }
+          retval->push_back (endP);
         }
-      if (localAddressMatchesExact &&
-          remotePeerMatchesExact &&
-          remoteAddressMatchesExact)
-        { // All 4 match
-          retval4.push_back (endP);
+      else if (localAddressMatchesWildCard)
+        { // Only local port matches exactly
+          if (wildcard == 0)
+            {
+              wildcard = endP;
+            }
+          if (retval != 0)
+            {
+              wildcards.push_back (endP);
+            }
         }
     }
-
-  // Here we find the most exact match
-  if (!retval4.empty ()) return retval4;
-  if (!retval3.empty ()) return retval3;
-  if (!retval2.empty ()) return retval2;
-  return retval1;  // might be empty if no matches
+  if (retval == 0)
+    {
+      return wildcard;
+    }
+  if (retval->empty ())
+    {
+      retval->swap (wildcards);
+    }
+  return retval->empty () ? 0 : retval->front ();
 }
 
 Ipv4EndPoint *
@@ -324,16 +451,17 @@ Ipv4EndPointDemux::SimpleLookup (Ipv4Address daddr,
 {
   NS_LOG_FUNCTION (this << daddr << dport << saddr << sport);
 
+  PortEndPoints::iterator endPoints = m_endPoints.find (dport);
+  if (endPoints == m_endPoints.end ())
+    {
+      return 0;
+    }
   // this code is a copy/paste version of an old BSD ip stack lookup
   // function.
   uint32_t genericity = 3;
   Ipv4EndPoint *generic = 0;
-  for (EndPointsI i = m_endPoints.begin (); i != m_endPoints.end (); i++) 
+  for (EndPointsI i = endPoints->second.begin (); i != endPoints->second.end (); i++) 
     {
-      if ((*i)->GetLocalPort () != dport) 
-        {
-          continue;
-        }
       if ((*i)->GetLocalAddress () == daddr &&
           (*i)->GetPeerPort () == sport &&
           (*i)->GetPeerAddress () == saddr) 
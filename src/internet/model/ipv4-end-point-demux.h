@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include <list>
 #include "ns3/ipv4-address.h"
+#include "ns3/sgi-hashmap.h"
 #include "ipv4-interface.h"
 
 namespace ns3 {
@@ -34,10 +35,11 @@ class Ipv4EndPoint;
  * \brief Demultiplexes packets to various transport layer endpoints
  *
  * This class serves as a lookup table to match partial or full information
- * about a four-tuple to an ns3::Ipv4EndPoint.  It internally contains a list
- * of endpoints, and has APIs to add and find endpoints in this demux.  This
- * code is shared in common to TCP and UDP protocols in ns3.  This demux
- * sits between ns3's layer four and the socket layer
+ * about a four-tuple to an ns3::Ipv4EndPoint.  It internally indexes the
+ * endpoints by local port, the connected ones by four-tuple and the
+ * listening ones by local port, and has APIs to add and find endpoints in
+ * this demux.  This code is shared in common to TCP and UDP protocols in
+ * ns3.  This demux sits between ns3's layer four and the socket layer
  */
 
 class Ipv4EndPointDemux {
@@ -100,6 +102,24 @@ public:
                     uint16_t sport,
                     Ptr<Ipv4Interface> incomingInterface);
 
+  /**
+   * \brief lookup for the best match with all the parameters.
+   *
+   * Same as Lookup, without building the list of the matches.
+   *
+   * \param daddr destination address to test
+   * \param dport destination port to test
+   * \param saddr source address to test
+   * \param sport source port to test
+   * \param incomingInterface the incoming interface
+   * \return the first IPv4EndPoint Lookup would return (0 if not found)
+   */
+  Ipv4EndPoint *LookupBest (Ipv4Address daddr,
+                            uint16_t dport,
+                            Ipv4Address saddr,
+                            uint16_t sport,
+                            Ptr<Ipv4Interface> incomingInterface);
+
   /**
    * \brief simple lookup for a match with all the parameters.
    * \param daddr destination address to test
@@ -161,6 +181,93 @@ public:
   void DeAllocate (Ipv4EndPoint *endPoint);
 
 private:
+  friend class Ipv4EndPoint;
+
+  /**
+   * \brief Four-tuple of a connected endpoint.
+   */
+  struct FourTuple
+  {
+    Ipv4Address localAddress; //!< Local address
+    uint16_t localPort;       //!< Local port
+    Ipv4Address peerAddress;  //!< Peer address
+    uint16_t peerPort;        //!< Peer port
+
+    /**
+     * \brief Equal to operator.
+     * \param other the four-tuple to compare to
+     * \return true if the four-tuples are equal
+     */
+    bool operator== (const FourTuple &other) const;
+  };
+
+  /**
+   * \brief Hash of a four-tuple.
+   */
+  struct FourTupleHash
+  {
+    /**
+     * \param x the four-tuple
+     * \return the hash
+     */
+    size_t operator() (const FourTuple &x) const;
+  };
+
+  /**
+   * \brief Endpoints by local port.
+   */
+  typedef sgi::hash_map<uint16_t, EndPoints> PortEndPoints;
+
+  /**
+   * \brief Endpoints by four-tuple.
+   */
+  typedef sgi::hash_map<FourTuple, EndPoints, FourTupleHash> ConnectedEndPoints;
+
+  /**
+   * \brief Add an endpoint to the indexes.
+   * \param endPoint the end point to add
+   */
+  void Insert (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Add an endpoint to the listening or connected index, from its
+   * current addresses and ports.
+   * \param endPoint the end point to add
+   */
+  void Index (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Remove an endpoint from the listening or connected index, before
+   * its addresses or ports change.
+   * \param endPoint the end point to remove
+   */
+  void Unindex (Ipv4EndPoint *endPoint);
+
+  /**
+   * \brief Lookup for the matches of the best kind.
+   *
+   * \param daddr destination address to test
+   * \param dport destination port to test
+   * \param saddr source address to test
+   * \param sport source port to test
+   * \param incomingInterface the incoming interface
+   * \param retval list to fill with the matches, or 0 to stop at the first one
+   * \return the first match (0 if not found)
+   */
+  Ipv4EndPoint *DoLookup (Ipv4Address daddr,
+                          uint16_t dport,
+                          Ipv4Address saddr,
+                          uint16_t sport,
+                          Ptr<Ipv4Interface> incomingInterface,
+                          EndPoints *retval);
+
+  /**
+   * \brief Check that an endpoint can receive from an interface.
+   * \param endPoint the end point to test
+   * \param incomingInterface the incoming interface
+   * \return true if the endpoint has Rx enabled and is not bound to another device
+   */
+  bool CanReceive (Ipv4EndPoint *endPoint, Ptr<Ipv4Interface> incomingInterface);
 
   /**
    * \brief Allocate an ephemeral port.
@@ -184,9 +291,20 @@ private:
   uint16_t m_portFirst;
 
   /**
-   * \brief A list of IPv4 end points.
+   * \brief All the IPv4 end points, by local port.
+   */
+  PortEndPoints m_endPoints;
+
+  /**
+   * \brief The IPv4 end points with wildcard peer address and port, by local
+   * port.
+   */
+  PortEndPoints m_listening;
+
+  /**
+   * \brief The IPv4 end points with peer address and port, by four-tuple.
    */
-  EndPoints m_endPoints;
+  ConnectedEndPoints m_connected;
 };
 
 } // namespace ns3
@@ -31,6 +31,7 @@
 namespace ns3 {
 
 class Header;
+class Ipv4EndPointDemux;
 class Packet;
 
 /**
@@ -181,6 +182,13 @@ public:
   bool IsRxEnabled (void);
 
 private:
+  friend class Ipv4EndPointDemux;
+
+  /**
+   * \brief The demux indexing the endpoint (if any).
+   */
+  Ipv4EndPointDemux *m_demux;
+
   /**
    * \brief The local address.
    */
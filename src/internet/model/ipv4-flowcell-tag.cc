@@ -0,0 +1,93 @@
+#include "ipv4-flowcell-tag.h"
+#include "ns3/packet.h"
+
+namespace ns3
+{
+
+Ipv4FlowcellTag::Ipv4FlowcellTag ()
+  : m_flowcellId (0)
+{
+}
+
+void
+Ipv4FlowcellTag::SetFlowcellId (uint32_t flowcellId)
+{
+  m_flowcellId = flowcellId;
+}
+
+uint32_t
+Ipv4FlowcellTag::GetFlowcellId (void) const
+{
+  return m_flowcellId;
+}
+
+TypeId
+Ipv4FlowcellTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::Ipv4FlowcellTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<Ipv4FlowcellTag> ();
+  return tid;
+}
+
+TypeId
+Ipv4FlowcellTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+uint32_t
+Ipv4FlowcellTag::GetSerializedSize (void) const
+{
+  return sizeof (uint32_t);
+}
+
+void
+Ipv4FlowcellTag::Serialize (TagBuffer i) const
+{
+  i.WriteU32 (m_flowcellId);
+}
+
+void
+Ipv4FlowcellTag::Deserialize (TagBuffer i)
+{
+  m_flowcellId = i.ReadU32 ();
+}
+
+void
+Ipv4FlowcellTag::Print (std::ostream &os) const
+{
+  os << "IP_Flowcell_id = " << m_flowcellId;
+}
+
+bool
+Ipv4FlowcellTag::PeekFrom (Ptr<const Packet> packet)
+{
+  const LbMetadata &metadata = packet->GetLbMetadata ();
+  if (!metadata.Has (LbMetadata::FLOWCELL))
+    {
+      return false;
+    }
+  m_flowcellId = metadata.GetFlowcellId ();
+  return true;
+}
+
+void
+Ipv4FlowcellTag::AddTo (Ptr<const Packet> packet) const
+{
+  packet->GetLbMetadata ().SetFlowcellId (m_flowcellId);
+}
+
+bool
+Ipv4FlowcellTag::RemoveFrom (Ptr<const Packet> packet)
+{
+  if (!PeekFrom (packet))
+    {
+      return false;
+    }
+  packet->GetLbMetadata ().Remove (LbMetadata::FLOWCELL);
+  return true;
+}
+
+}
@@ -0,0 +1,52 @@
+#ifndef NS3_IPV4_FLOWCELL_TAG
+#define NS3_IPV4_FLOWCELL_TAG
+
+#include "ns3/tag.h"
+#include "ns3/ptr.h"
+
+namespace ns3 {
+
+class Packet;
+
+/**
+ * \brief Presto flowcell id, set by Ipv4DrbRouting in the PER_FLOWCELL mode
+ *
+ * A flowcell is a run of at most FlowcellSize bytes of one flow sent on the
+ * same path. The receiver uses the id to find the boundaries of the runs it
+ * may merge.
+ */
+class Ipv4FlowcellTag : public Tag
+{
+public:
+  Ipv4FlowcellTag ();
+
+  void SetFlowcellId (uint32_t flowcellId);
+
+  uint32_t GetFlowcellId (void) const;
+
+  static TypeId GetTypeId (void);
+
+  virtual TypeId GetInstanceTypeId (void) const;
+
+  virtual uint32_t GetSerializedSize (void) const;
+
+  virtual void Serialize (TagBuffer i) const;
+
+  virtual void Deserialize (TagBuffer i);
+
+  virtual void Print (std::ostream &os) const;
+
+  // Adapters on the LbMetadata of the packet, AddTo replaces an existing value
+  bool PeekFrom (Ptr<const Packet> packet);
+
+  void AddTo (Ptr<const Packet> packet) const;
+
+  bool RemoveFrom (Ptr<const Packet> packet);
+
+private:
+  uint32_t m_flowcellId;
+};
+
+}
+
+#endif
@@ -27,11 +27,12 @@
 #include "ns3/ipv4-route.h"
 #include "ns3/ipv4-routing-table-entry.h"
 #include "ns3/boolean.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
 #include "ns3/node.h"
 #include "ipv4-global-routing.h"
 #include "global-route-manager.h"
 #include "ns3/flow-id-tag.h"
-#include "ns3/hash.h"
 
 namespace ns3 {
 
@@ -55,6 +56,24 @@ Ipv4GlobalRouting::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&Ipv4GlobalRouting::m_perFlowEcmpRouting),
                    MakeBooleanChecker ())
+    .AddAttribute ("EcmpHashAlgorithm",
+                   "The hash function used by per flow ECMP",
+                   EnumValue (FlowHash::MURMUR3),
+                   MakeEnumAccessor (&Ipv4GlobalRouting::m_ecmpHashAlgorithm),
+                   MakeEnumChecker (FlowHash::MURMUR3, "Murmur3",
+                                    FlowHash::CRC16, "Crc16",
+                                    FlowHash::CRC32, "Crc32",
+                                    FlowHash::TOEPLITZ, "Toeplitz"))
+    .AddAttribute ("EcmpHashSeed",
+                   "The seed of the per flow ECMP hash, set a different seed on each switch to avoid polarization",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&Ipv4GlobalRouting::m_ecmpHashSeed),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("EcmpHashTtl",
+                   "Set to true if the TTL is hashed together with the flow id by per flow ECMP",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&Ipv4GlobalRouting::m_ecmpHashTtl),
+                   MakeBooleanChecker ())
     .AddAttribute ("RespondToInterfaceEvents",
                    "Set to true if you want to dynamically recompute the global routes upon Interface notification events (up/down, or add/remove address)",
                    BooleanValue (false),
@@ -67,7 +86,11 @@ Ipv4GlobalRouting::GetTypeId (void)
 Ipv4GlobalRouting::Ipv4GlobalRouting ()
   : m_randomEcmpRouting (false),
     m_perFlowEcmpRouting (false),
-    m_respondToInterfaceEvents (false)
+    m_ecmpHashAlgorithm (FlowHash::MURMUR3),
+    m_ecmpHashSeed (0),
+    m_ecmpHashTtl (true),
+    m_respondToInterfaceEvents (false),
+    m_fibCompiled (false)
 {
   NS_LOG_FUNCTION (this);
 
@@ -88,6 +111,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, nextHop, interface);
   m_hostRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 void
@@ -98,6 +122,7 @@ Ipv4GlobalRouting::AddHostRouteTo (Ipv4Address dest,
   Ipv4RoutingTableEntry *route = new Ipv4RoutingTableEntry ();
   *route = Ipv4RoutingTableEntry::CreateHostRouteTo (dest, interface);
   m_hostRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 void
@@ -113,6 +138,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_networkRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 void
@@ -126,6 +152,7 @@ Ipv4GlobalRouting::AddNetworkRouteTo (Ipv4Address network,
                                                         networkMask,
                                                         interface);
   m_networkRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 void
@@ -141,6 +168,7 @@ Ipv4GlobalRouting::AddASExternalRouteTo (Ipv4Address network,
                                                         nextHop,
                                                         interface);
   m_ASexternalRoutes.push_back (route);
+  InvalidateFib ();
 }
 
 
@@ -149,117 +177,247 @@ Ipv4GlobalRouting::LookupGlobal (Ipv4Address dest, Ptr<Packet> packet, const Ipv
 {
   NS_LOG_FUNCTION (this << dest << oif);
   NS_LOG_LOGIC ("Looking for route for destination " << dest);
-  Ptr<Ipv4Route> rtentry = 0;
-  // store all available routes that bring packets to their destination
-  typedef std::vector<Ipv4RoutingTableEntry*> RouteVec_t;
-  RouteVec_t allRoutes;
+  if (!m_fibCompiled)
+    {
+      CompileFib ();
+    }
 
-  NS_LOG_LOGIC ("Number of m_hostRoutes = " << m_hostRoutes.size ());
-  for (HostRoutesCI i = m_hostRoutes.begin ();
-       i != m_hostRoutes.end ();
-       i++)
+  if (oif == 0)
     {
-      NS_ASSERT ((*i)->IsHost ());
-      if ((*i)->GetDest ().IsEqual (dest))
+      uint32_t groupIndex = m_fib.Lookup (dest);
+      if (groupIndex != 0)
         {
-          if (oif != 0)
-            {
-              if (oif != m_ipv4->GetNetDevice ((*i)->GetInterface ()))
-                {
-                  NS_LOG_LOGIC ("Not on requested interface, skipping");
-                  continue;
-                }
-            }
-          allRoutes.push_back (*i);
-          NS_LOG_LOGIC (allRoutes.size () << "Found global host route" << *i);
+          EcmpGroup &group = m_groups[groupIndex];
+          uint32_t member = SelectMember (group.members.size (), packet, header, flowId);
+          NS_LOG_LOGIC ("Found global route to " << group.network << "/" << group.prefixLength <<
+                        ", member " << member << " of " << group.members.size ());
+          return GetGroupRoute (group, group.members[member]);
         }
     }
-  if (allRoutes.size () == 0) // if no host route is found
+  else
     {
-      NS_LOG_LOGIC ("Number of m_networkRoutes" << m_networkRoutes.size ());
-      for (NetworkRoutesI j = m_networkRoutes.begin ();
-           j != m_networkRoutes.end ();
-           j++)
+      // The lookup is restricted to the routes through oif, so it cannot stop
+      // at the longest prefix: take the longest prefix with such a route.
+      uint32_t bestGroup = 0;
+      std::vector<uint32_t> bestMembers;
+      for (uint32_t i = 1; i < m_groups.size (); i++)
         {
-          Ipv4Mask mask = (*j)->GetDestNetworkMask ();
-          Ipv4Address entry = (*j)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          EcmpGroup &group = m_groups[i];
+          if (bestGroup != 0
+              && (group.prefixLength < m_groups[bestGroup].prefixLength
+                  || (group.prefixLength == m_groups[bestGroup].prefixLength && !group.host)))
             {
-              if (oif != 0)
+              continue;
+            }
+          if (!Ipv4Mask (group.prefixLength == 0 ? 0 : 0xffffffff << (32 - group.prefixLength)).IsMatch (dest, group.network))
+            {
+              continue;
+            }
+          std::vector<uint32_t> members;
+          for (std::vector<uint32_t>::const_iterator m = group.members.begin (); m != group.members.end (); m++)
+            {
+              if (oif == m_ipv4->GetNetDevice (group.entries[*m]->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*j)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  members.push_back (*m);
                 }
-              allRoutes.push_back (*j);
-              NS_LOG_LOGIC (allRoutes.size () << "Found global network route" << *j);
+            }
+          if (!members.empty ())
+            {
+              bestGroup = i;
+              bestMembers.swap (members);
+            }
+          else
+            {
+              NS_LOG_LOGIC ("Not on requested interface, skipping");
             }
         }
+      if (bestGroup != 0)
+        {
+          uint32_t member = SelectMember (bestMembers.size (), packet, header, flowId);
+          return GetGroupRoute (m_groups[bestGroup], bestMembers[member]);
+        }
     }
-  if (allRoutes.size () == 0)  // consider external if no host/network found
+
+  // consider external if no host/network found
+  for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
+       k != m_ASexternalRoutes.end ();
+       k++)
     {
-      for (ASExternalRoutesI k = m_ASexternalRoutes.begin ();
-           k != m_ASexternalRoutes.end ();
-           k++)
+      Ipv4Mask mask = (*k)->GetDestNetworkMask ();
+      Ipv4Address entry = (*k)->GetDestNetwork ();
+      if (mask.IsMatch (dest, entry))
         {
-          Ipv4Mask mask = (*k)->GetDestNetworkMask ();
-          Ipv4Address entry = (*k)->GetDestNetwork ();
-          if (mask.IsMatch (dest, entry))
+          NS_LOG_LOGIC ("Found external route" << *k);
+          if (oif != 0)
             {
-              NS_LOG_LOGIC ("Found external route" << *k);
-              if (oif != 0)
+              if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
                 {
-                  if (oif != m_ipv4->GetNetDevice ((*k)->GetInterface ()))
-                    {
-                      NS_LOG_LOGIC ("Not on requested interface, skipping");
-                      continue;
-                    }
+                  NS_LOG_LOGIC ("Not on requested interface, skipping");
+                  continue;
                 }
-              allRoutes.push_back (*k);
-              break;
             }
+          Ipv4RoutingTableEntry* route = *k;
+          // create a Ipv4Route object from the selected routing table entry
+          Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
+          rtentry->SetDestination (route->GetDest ());
+          /// \todo handle multi-address case
+          rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
+          rtentry->SetGateway (route->GetGateway ());
+          rtentry->SetOutputDevice (m_ipv4->GetNetDevice (route->GetInterface ()));
+          return rtentry;
         }
     }
-  if (allRoutes.size () > 0 ) // if route(s) is found
+  return 0;
+}
+
+uint32_t
+Ipv4GlobalRouting::SelectMember (uint32_t n, Ptr<const Packet> packet, const Ipv4Header &header, uint32_t flowId)
+{
+  NS_ASSERT (n > 0);
+  if (!m_ecmpSelect.IsNull ())
     {
-      // pick up one of the routes uniformly at random if random
-      // ECMP routing is enabled, or always select the first route
-      // consistently if random ECMP routing is disabled
-      uint32_t selectIndex;
-      if (m_randomEcmpRouting)
-        {
-          selectIndex = m_rand->GetInteger (0, allRoutes.size ()-1);
-        }
-      else if (m_perFlowEcmpRouting && flowId != 0) // If the flow id is 0, it may be the socket setup endpoint request, we simply return the first
-        {                                           // available route to indicate the address is not local
-          std::stringstream hash_string;
-          hash_string << flowId;
-          hash_string << header.GetTtl ();
-          uint32_t hashPerturbe = Hash32 (hash_string.str ()); // Hash Perturbe
-          selectIndex = hashPerturbe % allRoutes.size();
-          NS_LOG_LOGIC ("Per flow ECMP is enabled, select index: " << selectIndex << " for flow: " << flowId);
-        }
-      else
-        {
-          selectIndex = 0;
-        }
-      Ipv4RoutingTableEntry* route = allRoutes.at (selectIndex);
+      uint32_t selectIndex = m_ecmpSelect (packet, header, flowId, n);
+      NS_ASSERT_MSG (selectIndex < n, "The ECMP select callback returned " << selectIndex << " for " << n << " members");
+      return selectIndex;
+    }
+  // pick up one of the routes uniformly at random if random
+  // ECMP routing is enabled, or always select the first route
+  // consistently if random ECMP routing is disabled
+  if (m_randomEcmpRouting)
+    {
+      return m_rand->GetInteger (0, n - 1);
+    }
+  else if (m_perFlowEcmpRouting && flowId != 0) // If the flow id is 0, it may be the socket setup endpoint request, we simply return the first
+    {                                           // available route to indicate the address is not local
+      FlowHash flowHash (m_ecmpHashAlgorithm, m_ecmpHashSeed);
+      uint32_t hashPerturbe = flowHash.Hash (flowId, m_ecmpHashTtl ? header.GetTtl () : 0); // Hash Perturbe
+      uint32_t selectIndex = hashPerturbe % n;
+      NS_LOG_LOGIC ("Per flow ECMP is enabled, select index: " << selectIndex << " for flow: " << flowId);
+      return selectIndex;
+    }
+  return 0;
+}
+
+Ptr<Ipv4Route>
+Ipv4GlobalRouting::GetGroupRoute (EcmpGroup &group, uint32_t entry)
+{
+  if (group.routes[entry] == 0)
+    {
+      Ipv4RoutingTableEntry* route = group.entries[entry];
       // create a Ipv4Route object from the selected routing table entry
-      rtentry = Create<Ipv4Route> ();
+      Ptr<Ipv4Route> rtentry = Create<Ipv4Route> ();
       rtentry->SetDestination (route->GetDest ());
       /// \todo handle multi-address case
       rtentry->SetSource (m_ipv4->GetAddress (route->GetInterface (), 0).GetLocal ());
       rtentry->SetGateway (route->GetGateway ());
       uint32_t interfaceIdx = route->GetInterface ();
       rtentry->SetOutputDevice (m_ipv4->GetNetDevice (interfaceIdx));
-      return rtentry;
+      group.routes[entry] = rtentry;
     }
-  else
+  return group.routes[entry];
+}
+
+void
+Ipv4GlobalRouting::CompileFib (void)
+{
+  NS_LOG_FUNCTION (this);
+  InvalidateFib ();
+
+  // Group 0 is reserved for destinations without route
+  m_groups.push_back (EcmpGroup ());
+
+  // (network, prefix length) -> group index
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> networkGroups;
+  for (NetworkRoutesCI j = m_networkRoutes.begin (); j != m_networkRoutes.end (); j++)
+    {
+      Ipv4Mask mask = (*j)->GetDestNetworkMask ();
+      Ipv4Address network = (*j)->GetDestNetwork ().CombineMask (mask);
+      std::pair<uint32_t, uint32_t> prefix (network.Get (), mask.GetPrefixLength ());
+      std::map<std::pair<uint32_t, uint32_t>, uint32_t>::iterator it = networkGroups.find (prefix);
+      if (it == networkGroups.end ())
+        {
+          it = networkGroups.insert (std::make_pair (prefix, m_groups.size ())).first;
+          m_groups.push_back (EcmpGroup ());
+          m_groups.back ().network = network;
+          m_groups.back ().prefixLength = prefix.second;
+          m_groups.back ().host = false;
+        }
+      m_groups[it->second].entries.push_back (*j);
+    }
+
+  // Host routes are inserted last, so that they replace the network routes
+  // to the same /32 in the trie
+  std::map<uint32_t, uint32_t> hostGroups;
+  for (HostRoutesCI i = m_hostRoutes.begin (); i != m_hostRoutes.end (); i++)
     {
-      return 0;
+      NS_ASSERT ((*i)->IsHost ());
+      std::map<uint32_t, uint32_t>::iterator it = hostGroups.find ((*i)->GetDest ().Get ());
+      if (it == hostGroups.end ())
+        {
+          it = hostGroups.insert (std::make_pair ((*i)->GetDest ().Get (), m_groups.size ())).first;
+          m_groups.push_back (EcmpGroup ());
+          m_groups.back ().network = (*i)->GetDest ();
+          m_groups.back ().prefixLength = 32;
+          m_groups.back ().host = true;
+        }
+      m_groups[it->second].entries.push_back (*i);
     }
+
+  for (uint32_t g = 1; g < m_groups.size (); g++)
+    {
+      EcmpGroup &group = m_groups[g];
+      group.routes.resize (group.entries.size ());
+      for (uint32_t e = 0; e < group.entries.size (); e++)
+        {
+          uint32_t weight = GetEcmpWeight (group.entries[e]->GetInterface ());
+          group.members.insert (group.members.end (), weight, e);
+        }
+      if (group.members.empty ())
+        {
+          for (uint32_t e = 0; e < group.entries.size (); e++)
+            {
+              group.members.push_back (e);
+            }
+        }
+      m_fib.Insert (group.network, group.prefixLength, g);
+    }
+
+  NS_LOG_LOGIC ("Compiled " << GetNRoutes () << " routes into " << m_groups.size () - 1 << " groups");
+  m_fibCompiled = true;
+}
+
+void
+Ipv4GlobalRouting::InvalidateFib (void)
+{
+  if (!m_fibCompiled && m_groups.empty ())
+    {
+      return;
+    }
+  m_fibCompiled = false;
+  m_fib.Clear ();
+  m_groups.clear ();
+}
+
+void
+Ipv4GlobalRouting::SetEcmpWeight (uint32_t interface, uint32_t weight)
+{
+  NS_LOG_FUNCTION (this << interface << weight);
+  m_ecmpWeights[interface] = weight;
+  InvalidateFib ();
+}
+
+uint32_t
+Ipv4GlobalRouting::GetEcmpWeight (uint32_t interface) const
+{
+  std::map<uint32_t, uint32_t>::const_iterator it = m_ecmpWeights.find (interface);
+  return it == m_ecmpWeights.end () ? 1 : it->second;
+}
+
+void
+Ipv4GlobalRouting::SetEcmpSelectCallback (EcmpSelectCallback cb)
+{
+  NS_LOG_FUNCTION (this);
+  m_ecmpSelect = cb;
 }
 
 uint32_t
@@ -326,6 +484,7 @@ void
 Ipv4GlobalRouting::RemoveRoute (uint32_t index)
 {
   NS_LOG_FUNCTION (this << index);
+  InvalidateFib ();
   if (index < m_hostRoutes.size ())
     {
       uint32_t tmp = 0;
@@ -379,6 +538,53 @@ Ipv4GlobalRouting::RemoveRoute (uint32_t index)
   NS_ASSERT (false);
 }
 
+uint32_t
+Ipv4GlobalRouting::RemoveHostRoutesTo (Ipv4Address dest)
+{
+  NS_LOG_FUNCTION (this << dest);
+  InvalidateFib ();
+  uint32_t removed = 0;
+  HostRoutesI i = m_hostRoutes.begin ();
+  while (i != m_hostRoutes.end ())
+    {
+      if ((*i)->GetDest () == dest)
+        {
+          delete *i;
+          i = m_hostRoutes.erase (i);
+          removed++;
+        }
+      else
+        {
+          i++;
+        }
+    }
+  return removed;
+}
+
+uint32_t
+Ipv4GlobalRouting::RemoveNetworkRoutesTo (Ipv4Address network, Ipv4Mask networkMask)
+{
+  NS_LOG_FUNCTION (this << network << networkMask);
+  InvalidateFib ();
+  uint32_t removed = 0;
+  NetworkRoutesI j = m_networkRoutes.begin ();
+  while (j != m_networkRoutes.end ())
+    {
+      if ((*j)->GetDestNetwork () == network
+          && (*j)->GetDestNetworkMask () == networkMask)
+        {
+          delete *j;
+          j = m_networkRoutes.erase (j);
+          removed++;
+        }
+      else
+        {
+          j++;
+        }
+    }
+  return removed;
+}
+
 int64_t
 Ipv4GlobalRouting::AssignStreams (int64_t stream)
 {
@@ -391,6 +597,8 @@ void
 Ipv4GlobalRouting::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
+  InvalidateFib ();
+  m_ecmpSelect = EcmpSelectCallback ();
   for (HostRoutesI i = m_hostRoutes.begin ();
        i != m_hostRoutes.end ();
        i = m_hostRoutes.erase (i))
@@ -477,7 +685,7 @@ Ipv4GlobalRouting::RouteOutput (Ptr<Packet> p, const Ipv4Header &header, Ptr<Net
   if (m_perFlowEcmpRouting && p != NULL) {
     NS_ASSERT(m_randomEcmpRouting == false);
     FlowIdTag flowIdTag;
-    bool found = p->PeekPacketTag(flowIdTag);
+    bool found = flowIdTag.PeekFrom (p);
     if (found)
     {
       flowId = flowIdTag.GetFlowId();
@@ -525,7 +733,7 @@ Ipv4GlobalRouting::RouteInput  (Ptr<const Packet> packet, const Ipv4Header &head
     if (m_perFlowEcmpRouting && p != NULL) {
       NS_ASSERT(m_randomEcmpRouting == false);
       FlowIdTag flowIdTag;
-      bool found = p->PeekPacketTag(flowIdTag);
+      bool found = flowIdTag.PeekFrom (p);
       if (found)
       {
         flowId = flowIdTag.GetFlowId();
@@ -578,6 +786,7 @@ void
 Ipv4GlobalRouting::NotifyInterfaceUp (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  InvalidateFib ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -590,6 +799,7 @@ void
 Ipv4GlobalRouting::NotifyInterfaceDown (uint32_t i)
 {
   NS_LOG_FUNCTION (this << i);
+  InvalidateFib ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -602,6 +812,7 @@ void
 Ipv4GlobalRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  InvalidateFib ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -614,6 +825,7 @@ void
 Ipv4GlobalRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
   NS_LOG_FUNCTION (this << interface << address);
+  InvalidateFib ();
   if (m_respondToInterfaceEvents && Simulator::Now ().GetSeconds () > 0)  // avoid startup events
     {
       GlobalRouteManager::DeleteGlobalRoutes ();
@@ -628,6 +840,7 @@ Ipv4GlobalRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_FUNCTION (this << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  InvalidateFib ();
 }
 
 } // namespace ns3
@@ -21,6 +21,8 @@
 #define IPV4_GLOBAL_ROUTING_H
 
 #include <list>
+#include <map>
+#include <vector>
 #include <stdint.h>
 #include "ns3/ipv4-address.h"
 #include "ns3/ipv4-header.h"
@@ -28,6 +30,9 @@
 #include "ns3/ipv4.h"
 #include "ns3/ipv4-routing-protocol.h"
 #include "ns3/random-variable-stream.h"
+#include "ns3/flow-hash.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-lpm-trie.h"
 
 namespace ns3 {
 
@@ -63,6 +68,15 @@ class Node;
  *
  * This class deals with Ipv4 unicast routes only.
  *
+ * The host and network routes are compiled, on the first lookup after a
+ * change, into a longest prefix match trie whose leaves are ECMP groups:
+ * the routes to one prefix, in table order, with one Ipv4Route per route
+ * built once and shared by all the packets.  A host route takes precedence
+ * over a network route to the same /32.  The member of a group is picked
+ * at random, by a per flow hash, or by the callback given to
+ * SetEcmpSelectCallback (); SetEcmpWeight () turns the groups into weighted
+ * (WCMP) groups.
+ *
  * \see Ipv4RoutingProtocol
  * \see GlobalRouteManager
  */
@@ -216,6 +230,23 @@ public:
    */
   void RemoveRoute (uint32_t i);
 
+  /**
+   * \brief Remove all the host routes to a destination.
+   *
+   * \param dest The Ipv4Address destination of the routes.
+   * \returns the number of routes removed
+   */
+  uint32_t RemoveHostRoutesTo (Ipv4Address dest);
+
+  /**
+   * \brief Remove all the network routes to a network.
+   *
+   * \param network The Ipv4Address network of the routes.
+   * \param networkMask The Ipv4Mask of the network.
+   * \returns the number of routes removed
+   */
+  uint32_t RemoveNetworkRoutesTo (Ipv4Address network, Ipv4Mask networkMask);
+
   /**
    * Assign a fixed random variable stream number to the random variables
    * used by this model.  Return the number of streams (possibly zero) that
@@ -226,6 +257,42 @@ public:
    */
   int64_t AssignStreams (int64_t stream);
 
+  /**
+   * \brief Set the weight of an interface in the ECMP groups (WCMP).
+   *
+   * The routes of a group are picked with a probability, or for a share of
+   * the flows, proportional to the weight of their output interface.  The
+   * weights default to 1.  A weight of 0 removes the interface from the
+   * groups that have another member with a non zero weight.
+   *
+   * \param interface The interface index.
+   * \param weight The weight.
+   */
+  void SetEcmpWeight (uint32_t interface, uint32_t weight);
+
+  /**
+   * \param interface The interface index.
+   * \returns the weight of the interface in the ECMP groups
+   */
+  uint32_t GetEcmpWeight (uint32_t interface) const;
+
+  /**
+   * \brief Callback choosing a member of an ECMP group
+   *
+   * The arguments are the packet (possibly 0), its header, its flow id (0
+   * if unknown) and the number of members n; the callback returns an index
+   * in [0, n).  With weights, a route appears as many times as its weight.
+   */
+  typedef Callback<uint32_t, Ptr<const Packet>, const Ipv4Header &, uint32_t, uint32_t> EcmpSelectCallback;
+
+  /**
+   * \brief Replace the random / per flow / first route selection.
+   *
+   * \param cb The selection callback, a null callback restores the built in
+   * selection.
+   */
+  void SetEcmpSelectCallback (EcmpSelectCallback cb);
+
 protected:
   void DoDispose (void);
 
@@ -235,6 +302,12 @@ private:
 
   bool m_perFlowEcmpRouting;
 
+  /// The hash function and seed used by per flow ECMP
+  FlowHash::Algorithm m_ecmpHashAlgorithm;
+  uint32_t m_ecmpHashSeed;
+  /// Set to true if the TTL is hashed with the flow id, i.e. every hop makes a different choice
+  bool m_ecmpHashTtl;
+
   /// Set to true if this interface should respond to interface events by globallly recomputing routes
   bool m_respondToInterfaceEvents;
   /// A uniform random number generator for randomly routing packets among ECMP
@@ -263,10 +336,51 @@ private:
 
   Ptr<Ipv4Route> LookupGlobal (Ipv4Address dest, Ptr<Packet> packet, const Ipv4Header &header, uint32_t flowId, Ptr<NetDevice> oif = 0);
 
+  /// The routes to one prefix
+  struct EcmpGroup
+  {
+    Ipv4Address network;                          //!< the prefix
+    uint32_t prefixLength;                        //!< the prefix length
+    bool host;                                    //!< true for host routes
+    std::vector<Ipv4RoutingTableEntry *> entries; //!< the routes, in table order
+    std::vector<Ptr<Ipv4Route> > routes;          //!< the Ipv4Route of each entry, built on first use
+    std::vector<uint32_t> members;                //!< entry indices, each one repeated by its weight
+  };
+
+  /// Build the trie and the ECMP groups from the route lists
+  void CompileFib (void);
+
+  /// Drop the compiled trie and groups after a change of the routes or interfaces
+  void InvalidateFib (void);
+
+  /**
+   * \brief Pick a member of an ECMP group
+   * \param n the number of members
+   * \param packet the packet
+   * \param header the IPv4 header
+   * \param flowId the flow id, 0 if unknown
+   * \returns an index in [0, n)
+   */
+  uint32_t SelectMember (uint32_t n, Ptr<const Packet> packet, const Ipv4Header &header, uint32_t flowId);
+
+  /**
+   * \brief Get the (cached) Ipv4Route of a route of a group
+   * \param group the group
+   * \param entry the index of the route in the group
+   * \returns the route
+   */
+  Ptr<Ipv4Route> GetGroupRoute (EcmpGroup &group, uint32_t entry);
+
   HostRoutes m_hostRoutes;             //!< Routes to hosts
   NetworkRoutes m_networkRoutes;       //!< Routes to networks
   ASExternalRoutes m_ASexternalRoutes; //!< External routes imported
 
+  bool m_fibCompiled;                  //!< True if m_fib and m_groups reflect the routes
+  Ipv4LpmTrie m_fib;                   //!< Prefix -> index in m_groups
+  std::vector<EcmpGroup> m_groups;     //!< ECMP groups, group 0 is the empty group (no route)
+  std::map<uint32_t, uint32_t> m_ecmpWeights; //!< Interface -> WCMP weight, 1 if absent
+  EcmpSelectCallback m_ecmpSelect;     //!< Selection callback, the built in selection if null
+
   Ptr<Ipv4> m_ipv4; //!< associated IPv4 instance
 };
 
@@ -729,7 +729,7 @@ Ipv4L3Protocol::Send (Ptr<Packet> packet,
 
   Ipv4Header::EcnType ecnType = Ipv4Header::ECN_NotECT;
   Ipv4EcnTag ipv4EcnTag;
-  found = packet->RemovePacketTag (ipv4EcnTag);
+  found = ipv4EcnTag.RemoveFrom (packet);
   if (found)
   {
     ecnType = ipv4EcnTag.GetEcn();
@@ -149,10 +149,10 @@ Ipv4ListRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<
   // We need to query the DRB index here to simulate the IP-in-IP encapsulation
 
   Ipv4DrbTag ipv4DrbTag;
-  bool found = packet->PeekPacketTag(ipv4DrbTag);
+  bool found = ipv4DrbTag.PeekFrom (packet);
 
   FlowIdTag flowIdTag;
-  bool foundFlowId = packet->PeekPacketTag(flowIdTag);
+  bool foundFlowId = flowIdTag.PeekFrom (packet);
 
   if (m_drb != 0 && !found)
   {
@@ -172,7 +172,7 @@ Ipv4ListRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, Ptr<
       Ipv4DrbTag ipv4DrbTag;
       ipv4DrbTag.SetOriginalDestAddr(header.GetDestination ());
       ipHeader.SetDestination(address);
-      packet->AddPacketTag(ipv4DrbTag);
+      ipv4DrbTag.AddTo (packet);
       NS_LOG_DEBUG ("Forwarding the packet to core switch: " << address);
     }
     else
@@ -0,0 +1,101 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ipv4-lpm-trie.h"
+
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+const uint32_t Ipv4LpmTrie::STRIDE;
+const uint32_t Ipv4LpmTrie::FANOUT;
+
+Ipv4LpmTrie::Ipv4LpmTrie ()
+{
+}
+
+void
+Ipv4LpmTrie::Insert (Ipv4Address network, Ipv4Mask networkMask, uint32_t value)
+{
+  Insert (network, networkMask.GetPrefixLength (), value);
+}
+
+void
+Ipv4LpmTrie::Insert (Ipv4Address network, uint32_t prefixLength, uint32_t value)
+{
+  NS_ASSERT (prefixLength <= 32 && value != 0);
+
+  if (m_slots.empty ())
+    {
+      m_slots.resize (FANOUT);
+    }
+
+  uint32_t addr = prefixLength == 0 ? 0 : network.Get () & (0xffffffff << (32 - prefixLength));
+  uint32_t level = prefixLength == 0 ? 0 : (prefixLength - 1) / STRIDE;
+
+  uint32_t node = 0;
+  for (uint32_t l = 0; l < level; l++)
+    {
+      uint32_t slot = node * FANOUT + ((addr >> (32 - STRIDE * (l + 1))) & (FANOUT - 1));
+      if (m_slots[slot].child == 0)
+        {
+          uint32_t child = m_slots.size () / FANOUT;
+          m_slots.resize (m_slots.size () + FANOUT);
+          m_slots[slot].child = child;
+        }
+      node = m_slots[slot].child;
+    }
+
+  uint32_t first = (addr >> (32 - STRIDE * (level + 1))) & (FANOUT - 1);
+  uint32_t count = 1 << (STRIDE * (level + 1) - prefixLength);
+  for (uint32_t i = 0; i < count; i++)
+    {
+      Slot &slot = m_slots[node * FANOUT + first + i];
+      if (slot.value == 0 || slot.prefixLength <= prefixLength)
+        {
+          slot.value = value;
+          slot.prefixLength = prefixLength;
+        }
+    }
+}
+
+uint32_t
+Ipv4LpmTrie::Lookup (Ipv4Address dest) const
+{
+  if (m_slots.empty ())
+    {
+      return 0;
+    }
+
+  uint32_t addr = dest.Get ();
+  uint32_t value = 0;
+  uint32_t node = 0;
+  for (uint32_t shift = 32 - STRIDE; ; shift -= STRIDE)
+    {
+      const Slot &slot = m_slots[node * FANOUT + ((addr >> shift) & (FANOUT - 1))];
+      // A match in a deeper node is always longer
+      if (slot.value != 0)
+        {
+          value = slot.value;
+        }
+      if (slot.child == 0 || shift == 0)
+        {
+          break;
+        }
+      node = slot.child;
+    }
+  return value;
+}
+
+void
+Ipv4LpmTrie::Clear (void)
+{
+  m_slots.clear ();
+}
+
+bool
+Ipv4LpmTrie::IsEmpty (void) const
+{
+  return m_slots.empty ();
+}
+
+}
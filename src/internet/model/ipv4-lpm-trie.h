@@ -0,0 +1,80 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_LPM_TRIE_H
+#define IPV4_LPM_TRIE_H
+
+#include "ns3/ipv4-address.h"
+
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Longest prefix match table mapping IPv4 prefixes to integers
+ *
+ * A multibit trie with 8 bit strides: a lookup reads at most 4 slots, one
+ * per byte of the address, whatever the number of prefixes. The prefixes
+ * whose length is not a multiple of the stride are expanded over the slots
+ * they cover in their node, a longer prefix taking precedence over a shorter
+ * one in the same slot.
+ *
+ * The nodes are stored in one vector and refer to their children by index,
+ * so the table can be copied and cleared cheaply.
+ */
+class Ipv4LpmTrie
+{
+public:
+  Ipv4LpmTrie ();
+
+  /**
+   * Map a prefix to a value. Inserting a prefix again replaces its value.
+   *
+   * \param network the network address, the host bits are ignored
+   * \param networkMask the mask of the network
+   * \param value the value, 0 is reserved for "no route"
+   */
+  void Insert (Ipv4Address network, Ipv4Mask networkMask, uint32_t value);
+
+  /**
+   * \param network the network address, the host bits are ignored
+   * \param prefixLength the length of the prefix, in [0, 32]
+   * \param value the value, 0 is reserved for "no route"
+   */
+  void Insert (Ipv4Address network, uint32_t prefixLength, uint32_t value);
+
+  /**
+   * \param dest the destination address
+   * \return the value of the longest prefix matching dest, 0 if none
+   */
+  uint32_t Lookup (Ipv4Address dest) const;
+
+  void Clear (void);
+
+  bool IsEmpty (void) const;
+
+private:
+  static const uint32_t STRIDE = 8;
+  static const uint32_t FANOUT = 1 << STRIDE;
+
+  struct Slot
+  {
+    Slot ()
+      : child (0),
+        value (0),
+        prefixLength (0)
+    {
+    }
+    uint32_t child;         //!< Index of the child node, 0 if none (the root is never a child)
+    uint32_t value;         //!< Value of the longest prefix ending in this node and covering this slot
+    uint32_t prefixLength;  //!< Length of that prefix
+  };
+
+  // Node i occupies the slots [i * FANOUT, (i + 1) * FANOUT), node 0 is the root
+  std::vector<Slot> m_slots;
+};
+
+}
+
+#endif /* IPV4_LPM_TRIE_H */
@@ -0,0 +1,155 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ipv4-next-hop-cache.h"
+
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/channel.h"
+#include "ns3/node.h"
+
+#include <map>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("Ipv4NextHopCache");
+
+Ipv4NextHopCache::Ipv4NextHopCache ()
+  : m_ipv4 (0),
+    m_compiled (false)
+{
+}
+
+void
+Ipv4NextHopCache::SetIpv4 (Ptr<Ipv4> ipv4)
+{
+  m_ipv4 = ipv4;
+  Invalidate ();
+}
+
+void
+Ipv4NextHopCache::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port)
+{
+  RouteEntry routeEntry;
+  routeEntry.network = network.CombineMask (networkMask);
+  routeEntry.networkMask = networkMask;
+  routeEntry.port = port;
+  m_routeEntryList.push_back (routeEntry);
+  Invalidate ();
+}
+
+void
+Ipv4NextHopCache::Invalidate (void)
+{
+  m_compiled = false;
+  m_prefixTable.Clear ();
+  m_groups.clear ();
+  m_routes.clear ();
+}
+
+void
+Ipv4NextHopCache::Clear (void)
+{
+  Invalidate ();
+  m_routeEntryList.clear ();
+  m_ipv4 = 0;
+}
+
+void
+Ipv4NextHopCache::Compile (void)
+{
+  NS_LOG_FUNCTION (this);
+
+  Invalidate ();
+
+  // Group 0 is reserved for destinations without route
+  m_groups.push_back (std::vector<uint32_t> ());
+
+  // (network, prefix length) -> group index
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> prefixGroups;
+  std::vector<RouteEntry>::const_iterator itr = m_routeEntryList.begin ();
+  for ( ; itr != m_routeEntryList.end (); ++itr)
+    {
+      uint32_t prefixLength = itr->networkMask.GetPrefixLength ();
+      std::pair<uint32_t, uint32_t> prefix (itr->network.Get (), prefixLength);
+      std::map<std::pair<uint32_t, uint32_t>, uint32_t>::iterator groupItr = prefixGroups.find (prefix);
+      if (groupItr == prefixGroups.end ())
+        {
+          groupItr = prefixGroups.insert (std::make_pair (prefix, m_groups.size ())).first;
+          m_prefixTable.Insert (itr->network, prefixLength, m_groups.size ());
+          m_groups.push_back (std::vector<uint32_t> ());
+        }
+      m_groups[groupItr->second].push_back (itr->port);
+    }
+
+  if (m_ipv4 != 0)
+    {
+      m_routes.resize (m_ipv4->GetNInterfaces ());
+    }
+
+  m_compiled = true;
+}
+
+const std::vector<uint32_t> &
+Ipv4NextHopCache::LookupPorts (Ipv4Address dest)
+{
+  return GetGroupPorts (LookupGroup (dest));
+}
+
+uint32_t
+Ipv4NextHopCache::LookupGroup (Ipv4Address dest)
+{
+  if (!m_compiled)
+    {
+      Compile ();
+    }
+
+  return m_prefixTable.Lookup (dest);
+}
+
+const std::vector<uint32_t> &
+Ipv4NextHopCache::GetGroupPorts (uint32_t group) const
+{
+  NS_ASSERT (m_compiled && group < m_groups.size ());
+  return m_groups[group];
+}
+
+Ptr<Ipv4Route>
+Ipv4NextHopCache::GetRoute (uint32_t port)
+{
+  if (!m_compiled)
+    {
+      Compile ();
+    }
+
+  if (port >= m_routes.size ())
+    {
+      m_routes.resize (port + 1);
+    }
+
+  if (m_routes[port] == 0)
+    {
+      m_routes[port] = BuildRoute (port);
+    }
+  return m_routes[port];
+}
+
+Ptr<Ipv4Route>
+Ipv4NextHopCache::BuildRoute (uint32_t port) const
+{
+  NS_LOG_FUNCTION (this << port);
+  NS_ASSERT (m_ipv4 != 0);
+
+  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (port);
+  Ptr<Channel> channel = dev->GetChannel ();
+  uint32_t otherEnd = (channel->GetDevice (0) == dev) ? 1 : 0;
+  Ptr<Node> nextHop = channel->GetDevice (otherEnd)->GetNode ();
+  uint32_t nextIf = channel->GetDevice (otherEnd)->GetIfIndex ();
+  Ipv4Address nextHopAddr = nextHop->GetObject<Ipv4>()->GetAddress (nextIf, 0).GetLocal ();
+  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
+  route->SetOutputDevice (dev);
+  route->SetGateway (nextHopAddr);
+  route->SetSource (m_ipv4->GetAddress (port, 0).GetLocal ());
+  return route;
+}
+
+}
@@ -0,0 +1,105 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef IPV4_NEXT_HOP_CACHE_H
+#define IPV4_NEXT_HOP_CACHE_H
+
+#include "ns3/ipv4.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ptr.h"
+#include "ns3/ipv4-lpm-trie.h"
+
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ipv4Routing
+ *
+ * \brief Compiled forwarding state shared by the port based load balancing
+ * routing protocols (Conga, Drill, LetFlow and XPath).
+ *
+ * Routes are added as (network, mask, port) triples. On the first lookup
+ * after a change, the entries are compiled into an Ipv4LpmTrie whose leaves
+ * are port groups (the ECMP set of the longest matching prefix, kept in
+ * insertion order), so the per packet cost is at most 4 array accesses.
+ *
+ * For every port, one immutable Ipv4Route pointing to the peer on the other
+ * end of the point to point channel is built once and shared by all packets.
+ * The destination field of these routes is left unset since the forwarding
+ * path only relies on the output device and the gateway.
+ *
+ * The owner should call Invalidate () whenever an interface or an address
+ * changes, the compiled state is then rebuilt lazily.
+ */
+class Ipv4NextHopCache
+{
+public:
+  Ipv4NextHopCache ();
+
+  void SetIpv4 (Ptr<Ipv4> ipv4);
+
+  void AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port);
+
+  /**
+   * \param dest the destination address
+   * \return the ports of the longest matching prefix, empty if there is no route
+   */
+  const std::vector<uint32_t> & LookupPorts (Ipv4Address dest);
+
+  /**
+   * \param dest the destination address
+   * \return the index of the port group of the longest matching prefix, 0
+   * if there is no route. The indices are stable until the next Invalidate ().
+   */
+  uint32_t LookupGroup (Ipv4Address dest);
+
+  /**
+   * \param group a group index returned by LookupGroup
+   * \return the ports of the group
+   */
+  const std::vector<uint32_t> & GetGroupPorts (uint32_t group) const;
+
+  /**
+   * \param port the output interface
+   * \return the shared route going through this interface
+   */
+  Ptr<Ipv4Route> GetRoute (uint32_t port);
+
+  // Drop the compiled state, the route entries are kept
+  void Invalidate (void);
+
+  // Drop everything, including the route entries and the Ipv4
+  void Clear (void);
+
+private:
+  struct RouteEntry
+  {
+    Ipv4Address network;
+    Ipv4Mask networkMask;
+    uint32_t port;
+  };
+
+  void Compile (void);
+
+  Ptr<Ipv4Route> BuildRoute (uint32_t port) const;
+
+  Ptr<Ipv4> m_ipv4;
+
+  // Route entries in insertion order
+  std::vector<RouteEntry> m_routeEntryList;
+
+  bool m_compiled;
+
+  // Prefix -> group index
+  Ipv4LpmTrie m_prefixTable;
+
+  // Port groups, group 0 is the empty group (no route)
+  std::vector<std::vector<uint32_t> > m_groups;
+
+  // Port -> route
+  std::vector<Ptr<Ipv4Route> > m_routes;
+};
+
+}
+
+#endif /* IPV4_NEXT_HOP_CACHE_H */
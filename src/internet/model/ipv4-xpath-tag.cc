@@ -1,4 +1,5 @@
 #include "ipv4-xpath-tag.h"
+#include "ns3/packet.h"
 
 namespace ns3 {
 
@@ -57,4 +58,33 @@ Ipv4XPathTag::Print (std::ostream &os) const
   os << "Path Id = " << m_pathId;
 }
 
+bool
+Ipv4XPathTag::PeekFrom (Ptr<const Packet> packet)
+{
+  const LbMetadata &metadata = packet->GetLbMetadata ();
+  if (!metadata.Has (LbMetadata::PATH_ID))
+    {
+      return false;
+    }
+  m_pathId = metadata.GetPathId ();
+  return true;
+}
+
+void
+Ipv4XPathTag::AddTo (Ptr<const Packet> packet) const
+{
+  packet->GetLbMetadata ().SetPathId (m_pathId);
+}
+
+bool
+Ipv4XPathTag::RemoveFrom (Ptr<const Packet> packet)
+{
+  if (!PeekFrom (packet))
+    {
+      return false;
+    }
+  packet->GetLbMetadata ().Remove (LbMetadata::PATH_ID);
+  return true;
+}
+
 }
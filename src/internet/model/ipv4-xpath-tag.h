@@ -2,9 +2,12 @@
 #define NS3_IPV4_XPATH_TAG
 
 #include "ns3/tag.h"
+#include "ns3/ptr.h"
 
 namespace ns3 {
 
+class Packet;
+
 class Ipv4XPathTag: public Tag
 {
 public:
@@ -26,6 +29,13 @@ public:
 
     virtual void Print (std::ostream &os) const;
 
+    // Adapters on the LbMetadata of the packet, AddTo replaces an existing value
+    bool PeekFrom (Ptr<const Packet> packet);
+
+    void AddTo (Ptr<const Packet> packet) const;
+
+    bool RemoveFrom (Ptr<const Packet> packet);
+
 private:
     uint32_t m_pathId;
 };
@@ -19,6 +19,7 @@
 #include "tcp-congestion-ops.h"
 #include "tcp-socket-base.h"
 #include "ns3/log.h"
+#include "ns3/boolean.h"
 
 namespace ns3 {
 
@@ -80,17 +81,25 @@ TcpNewReno::GetTypeId (void)
     .SetParent<TcpCongestionOps> ()
     .SetGroupName ("Internet")
     .AddConstructor<TcpNewReno> ()
+    .AddAttribute ("ByteCounting",
+                   "Increase cWnd in slow start by the segments acked, as Linux does",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpNewReno::m_byteCounting),
+                   MakeBooleanChecker ())
   ;
   return tid;
 }
 
-TcpNewReno::TcpNewReno (void) : TcpCongestionOps ()
+TcpNewReno::TcpNewReno (void)
+  : TcpCongestionOps (),
+    m_byteCounting (false)
 {
   NS_LOG_FUNCTION (this);
 }
 
 TcpNewReno::TcpNewReno (const TcpNewReno& sock)
-  : TcpCongestionOps (sock)
+  : TcpCongestionOps (sock),
+    m_byteCounting (sock.m_byteCounting)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -137,6 +146,23 @@ u32 tcp_slow_start(struct tcp_sock *tp, u32 acked)
  * than a segment size, but we keep count of how many segments we have ignored,
  * and return them.
  *
+ * With the ByteCounting attribute we follow the current Linux instead, which
+ * caps cWnd at ssthresh rather than one segment above it:
+ * \verbatim
+u32 tcp_slow_start(struct tcp_sock *tp, u32 acked)
+  {
+    u32 cwnd = min(tp->snd_cwnd + acked, tp->snd_ssthresh);
+
+    acked -= cwnd - tp->snd_cwnd;
+    tp->snd_cwnd = min(cwnd, tp->snd_cwnd_clamp);
+
+    return acked;
+  }
+  \endverbatim
+ *
+ * This keeps slow start working with stretch ACKs, e.g. the ones of a
+ * receiver doing GRO.
+ *
  * \param tcb internal congestion state
  * \param segmentsAcked count of segments acked
  * \return the number of segments not considered for increasing the cWnd
@@ -146,6 +172,18 @@ TcpNewReno::SlowStart (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked)
 {
   NS_LOG_FUNCTION (this << tcb << segmentsAcked);
 
+  if (m_byteCounting && segmentsAcked >= 1)
+    {
+      // Up to ssthresh, the rest is left to the congestion avoidance
+      uint32_t room = tcb->m_ssThresh.Get () - tcb->m_cWnd.Get ();
+      uint32_t acked = std::min (segmentsAcked,
+                                 (room + tcb->m_segmentSize - 1) / tcb->m_segmentSize);
+      tcb->m_cWnd = std::min (tcb->m_cWnd.Get () + acked * tcb->m_segmentSize,
+                              tcb->m_ssThresh.Get ());
+      NS_LOG_INFO ("In SlowStart, updated to cwnd " << tcb->m_cWnd << " ssthresh " << tcb->m_ssThresh);
+      return segmentsAcked - acked;
+    }
+
   if (segmentsAcked >= 1)
     {
       tcb->m_cWnd += tcb->m_segmentSize;
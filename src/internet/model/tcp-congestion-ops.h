@@ -190,6 +190,8 @@ public:
 protected:
   virtual uint32_t SlowStart (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
   virtual void CongestionAvoidance (Ptr<TcpSocketState> tcb, uint32_t segmentsAcked);
+
+  bool m_byteCounting; //!< Increase cWnd by the segments acked in slow start
 };
 
 } // namespace ns3
@@ -2,16 +2,185 @@
 
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/node.h"
 #include "ns3/tcp-header.h"
 #include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 #include "ns3/tcp-socket-base.h"
 #include "ns3/flow-id-tag.h"
+#include "ipv4-ecn-tag.h"
+#include "ipv4-flowcell-tag.h"
+
+#include <algorithm>
 
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE ("TcpResequenceBuffer");
 
+NS_OBJECT_ENSURE_REGISTERED (TcpResequenceTimerWheel);
+
+TypeId
+TcpResequenceTimerWheel::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::TcpResequenceTimerWheel")
+    .SetParent<Object> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<TcpResequenceTimerWheel> ()
+    .AddAttribute ("Tick",
+                   "The granularity of the wheel, the checks are rounded up to it",
+                   TimeValue (MicroSeconds (1)),
+                   MakeTimeAccessor (&TcpResequenceTimerWheel::m_tick),
+                   MakeTimeChecker  ())
+    .AddAttribute ("Slots",
+                   "The number of slots of the wheel",
+                   UintegerValue (64),
+                   MakeUintegerAccessor (&TcpResequenceTimerWheel::m_slotNumber),
+                   MakeUintegerChecker<uint32_t> (1))
+    ;
+
+  return tid;
+}
+
+TcpResequenceTimerWheel::TcpResequenceTimerWheel ():
+    m_tick (MicroSeconds (1)),
+    m_slotNumber (64),
+    m_pending (0),
+    m_currentTick (0),
+    m_nextTick (0),
+    m_event (),
+    m_expiring (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TcpResequenceTimerWheel::~TcpResequenceTimerWheel ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+TcpResequenceTimerWheel::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_event.Cancel ();
+  m_slots.clear ();
+  m_pending = 0;
+  Object::DoDispose ();
+}
+
+Ptr<TcpResequenceTimerWheel>
+TcpResequenceTimerWheel::GetWheel (Ptr<Node> node)
+{
+  Ptr<TcpResequenceTimerWheel> wheel = node->GetObject<TcpResequenceTimerWheel> ();
+  if (wheel == 0)
+  {
+    wheel = CreateObject<TcpResequenceTimerWheel> ();
+    node->AggregateObject (wheel);
+  }
+  return wheel;
+}
+
+void
+TcpResequenceTimerWheel::Schedule (Ptr<TcpResequenceBuffer> buffer, Time delay)
+{
+  if (m_slots.empty ())
+  {
+    m_slots.resize (m_slotNumber);
+  }
+
+  // Round up to the next tick, strictly after the current one
+  int64_t tick = m_tick.GetTimeStep ();
+  int64_t now = Simulator::Now ().GetTimeStep ();
+  uint64_t dueTick = (now + delay.GetTimeStep () + tick - 1) / tick;
+  if (dueTick <= static_cast<uint64_t> (now / tick))
+  {
+    dueTick = now / tick + 1;
+  }
+
+  Entry entry;
+  entry.buffer = buffer;
+  entry.dueTick = dueTick;
+  m_slots[dueTick % m_slots.size ()].push_back (entry);
+  m_pending++;
+
+  // While expiring, the next tick is found once all the due checks have run
+  if (!m_expiring && (!m_event.IsRunning () || dueTick < m_nextTick))
+  {
+    TcpResequenceTimerWheel::ScheduleTick (dueTick);
+  }
+}
+
+void
+TcpResequenceTimerWheel::ScheduleTick (uint64_t tick)
+{
+  m_event.Cancel ();
+  m_nextTick = tick;
+  Time at = TimeStep (tick * m_tick.GetTimeStep ());
+  m_event = Simulator::Schedule (at - Simulator::Now (), &TcpResequenceTimerWheel::Expire, this);
+}
+
+void
+TcpResequenceTimerWheel::Expire (void)
+{
+  m_currentTick = m_nextTick;
+
+  // Swap the slot out, the checks may schedule themselves again into it
+  std::vector<Entry> &slot = m_slots[m_currentTick % m_slots.size ()];
+  std::vector<Entry> entries;
+  entries.swap (slot);
+
+  m_expiring = true;
+  std::vector<Entry>::iterator itr = entries.begin ();
+  for ( ; itr != entries.end (); ++itr)
+  {
+    if (itr->dueTick > m_currentTick)
+    {
+      // Due in a later round of the wheel
+      m_slots[m_currentTick % m_slots.size ()].push_back (*itr);
+      continue;
+    }
+    m_pending--;
+    itr->buffer->PeriodicalCheck ();
+  }
+  m_expiring = false;
+
+  if (m_pending == 0)
+  {
+    return;
+  }
+
+  // Find the next tick with a due entry, in this round first
+  uint64_t nextTick = 0;
+  for (uint64_t t = m_currentTick + 1; t <= m_currentTick + m_slots.size () && nextTick == 0; ++t)
+  {
+    std::vector<Entry> &candidates = m_slots[t % m_slots.size ()];
+    for (itr = candidates.begin (); itr != candidates.end (); ++itr)
+    {
+      if (itr->dueTick == t)
+      {
+        nextTick = t;
+        break;
+      }
+    }
+  }
+  if (nextTick == 0)
+  {
+    std::vector<std::vector<Entry> >::iterator slotItr = m_slots.begin ();
+    for ( ; slotItr != m_slots.end (); ++slotItr)
+    {
+      for (itr = slotItr->begin (); itr != slotItr->end (); ++itr)
+      {
+        if (nextTick == 0 || itr->dueTick < nextTick)
+        {
+          nextTick = itr->dueTick;
+        }
+      }
+    }
+  }
+  TcpResequenceTimerWheel::ScheduleTick (nextTick);
+}
+
 NS_OBJECT_ENSURE_REGISTERED (TcpResequenceBuffer);
 
 TypeId
@@ -37,10 +206,15 @@ TcpResequenceBuffer::GetTypeId (void)
                    MakeTimeAccessor (&TcpResequenceBuffer::m_outOrderQueueTimerLimit),
                    MakeTimeChecker  ())
     .AddAttribute ("PeriodicalCheckTime",
-                   "Periodical check time",
+                   "Periodical check time, rounded up to the tick of the node TcpResequenceTimerWheel",
                    TimeValue (MicroSeconds (10)),
                    MakeTimeAccessor (&TcpResequenceBuffer::m_periodicalCheckTime),
                    MakeTimeChecker  ())
+    .AddAttribute ("Gro",
+                   "Merge the in order segments of a flowcell into one segment before forwarding them up",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&TcpResequenceBuffer::m_gro),
+                   MakeBooleanChecker ())
     .AddTraceSource ("Buffer",
                      "When one packet is buffered",
                      MakeTraceSourceAccessor (&TcpResequenceBuffer::m_tcpRBBuffer),
@@ -60,15 +234,18 @@ TcpResequenceBuffer::TcpResequenceBuffer ():
     m_inOrderQueueTimerLimit (MicroSeconds (20)),
     m_outOrderQueueTimerLimit (MicroSeconds (50)),
     m_periodicalCheckTime (MicroSeconds (10)),
+    m_gro (false),
     m_traceFlowId (0),
  	// Variables
     m_size (0),
     m_inOrderQueueTimer (Simulator::Now ()),
     m_outOrderQueueTimer (Simulator::Now ()),
-    m_checkEvent (),
     m_hasStopped (false),
     m_firstSeq (SequenceNumber32 (0)),
-    m_nextSeq (SequenceNumber32 (0))
+    m_nextSeq (SequenceNumber32 (0)),
+    m_checkScheduled (false),
+    m_hasAddress (false),
+    m_tcp (NULL)
 {
   NS_LOG_FUNCTION (this);
 }
@@ -83,11 +260,8 @@ TcpResequenceBuffer::DoDispose (void)
 {
   NS_LOG_FUNCTION (this);
   m_inOrderQueue.clear ();
-  while (!m_outOrderQueue.empty ())
-  {
-    m_outOrderQueue.pop ();
-  }
-  m_outOrderSeqSet.clear ();
+  m_outOrderQueue.clear ();
+  m_wheel = 0;
 }
 
 void
@@ -103,18 +277,25 @@ TcpResequenceBuffer::BufferPacket (Ptr<Packet> packet,
   }
 
   // Turn on the periodical check and reset the timer
-  if (!m_checkEvent.IsRunning ())
+  if (!m_checkScheduled)
   {
     NS_LOG_LOGIC ("Turn on periodical check");
-    m_checkEvent = Simulator::Schedule (m_periodicalCheckTime, &TcpResequenceBuffer::PeriodicalCheck, this);
+    TcpResequenceBuffer::SchedulePeriodicalCheck ();
     m_inOrderQueueTimer = Simulator::Now ();
     m_outOrderQueueTimer = Simulator::Now ();
   }
 
+  if (!m_hasAddress)
+  {
+    m_fromAddress = fromAddress;
+    m_toAddress = toAddress;
+    m_hasAddress = true;
+  }
+
   if (m_traceFlowId == 0)
   {
     FlowIdTag flowIdTag;
-    packet->PeekPacketTag (flowIdTag);
+    flowIdTag.PeekFrom (packet);
     m_traceFlowId = flowIdTag.GetFlowId ();
   }
 
@@ -135,9 +316,11 @@ TcpResequenceBuffer::BufferPacket (Ptr<Packet> packet,
   element.m_isSyn = (tcpHeader.GetFlags () & TcpHeader::SYN) == TcpHeader::SYN ? true: false;
   element.m_isFin = (tcpHeader.GetFlags () & TcpHeader::FIN) == TcpHeader::FIN ? true: false;
   element.m_dataSize = packet->GetSize () - tcpHeader.GetLength () * 4;
+  Ipv4FlowcellTag flowcellTag;
+  element.m_flowcellId = flowcellTag.PeekFrom (packet) ? flowcellTag.GetFlowcellId () : 0;
+  Ipv4EcnTag ecnTag;
+  element.m_ecn = ecnTag.PeekFrom (packet) ? ecnTag.GetEcn () : Ipv4Header::ECN_NotECT;
   element.m_packet = packet;
-  element.m_fromAddress = fromAddress;
-  element.m_toAddress = toAddress;
 
   NS_LOG_INFO ("\tThe packet seq is: " << element.m_seq
     << " and the expected next seq is: " << TcpResequenceBuffer::CalculateNextSeq (element));
@@ -159,7 +342,7 @@ TcpResequenceBuffer::BufferPacket (Ptr<Packet> packet,
     {
       m_nextSeq = TcpResequenceBuffer::CalculateNextSeq (element);
     }
-    TcpResequenceBuffer::FlushOneElement (element, RE_TRANS);
+    TcpResequenceBuffer::FlushOneElement (element, RE_TRANS, m_outOrderQueue.size ());
 
     // After flush, the first and next seq would be the same
     m_firstSeq = m_nextSeq;
@@ -175,18 +358,11 @@ TcpResequenceBuffer::BufferPacket (Ptr<Packet> packet,
   // If the seq == next seq
   else if (TcpResequenceBuffer::PutInTheInOrderQueue (element))
   {
-    // Try to fill the in order queue from the out order queue
-    while (!m_outOrderQueue.empty ())
+    // Try to fill the in order queue from the head of the out order queue
+    while (!m_outOrderQueue.empty ()
+           && TcpResequenceBuffer::PutInTheInOrderQueue (m_outOrderQueue.front ()))
     {
-      if (TcpResequenceBuffer::PutInTheInOrderQueue (m_outOrderQueue.top ()))
-      {
-        m_outOrderSeqSet.erase (m_outOrderQueue.top ().m_seq);
-        m_outOrderQueue.pop ();
-      }
-      else
-      {
-        break;
-      }
+      m_outOrderQueue.pop_front ();
       m_outOrderQueueTimer = Simulator::Now ();
     }
     // If the size exceeds the limit
@@ -197,13 +373,18 @@ TcpResequenceBuffer::BufferPacket (Ptr<Packet> packet,
         m_firstSeq = m_nextSeq;
     }
   }
-  // If the seq > next seq
+  // If the seq > next seq, keep the out order queue sorted and drop duplicates
+  else if (m_outOrderQueue.empty () || m_outOrderQueue.back ().m_seq < element.m_seq)
+  {
+    m_outOrderQueue.push_back (element);
+  }
   else
   {
-    if (m_outOrderSeqSet.find (element.m_seq) == m_outOrderSeqSet.end())
+    std::deque<TcpResequenceBufferElement>::iterator itr =
+        std::lower_bound (m_outOrderQueue.begin (), m_outOrderQueue.end (), element);
+    if (itr->m_seq != element.m_seq)
     {
-      m_outOrderQueue.push (element);
-      m_outOrderSeqSet.insert (element.m_seq);
+      m_outOrderQueue.insert (itr, element);
     }
   }
 }
@@ -219,18 +400,32 @@ void
 TcpResequenceBuffer::Stop (void)
 {
   // After the hasStopped flag turned into true, it would never activate the
-  // periodical check event again to prepare for the destruction
+  // periodical check event again to prepare for the destruction, a check
+  // already in the wheel returns at once
   m_hasStopped = true;
-  m_checkEvent.Cancel ();
   m_tcp = NULL;
 }
 
+bool
+TcpResequenceBuffer::IsStopped (void) const
+{
+  return m_hasStopped;
+}
+
 bool
 TcpResequenceBuffer::PutInTheInOrderQueue (const TcpResequenceBufferElement &element)
 {
   if (m_nextSeq == SequenceNumber32 (0) // For the fist packet
         || m_nextSeq == element.m_seq)
   {
+    // With GRO, a new flowcell means the previous one has been received, push it up
+    if (m_gro && !m_inOrderQueue.empty ()
+            && m_inOrderQueue.back ().m_flowcellId != element.m_flowcellId)
+    {
+      NS_LOG_LOGIC ("Flowcell " << m_inOrderQueue.back ().m_flowcellId << " completes");
+      TcpResequenceBuffer::FlushInOrderQueue (IN_ORDER_FLOWCELL);
+      m_firstSeq = m_nextSeq;
+    }
     m_inOrderQueue.push_back (element);
     m_size += element.m_dataSize;
     m_nextSeq = TcpResequenceBuffer::CalculateNextSeq (element);
@@ -257,9 +452,21 @@ TcpResequenceBuffer::CalculateNextSeq (const TcpResequenceBufferElement &element
   return newSeq;
 }
 
+void
+TcpResequenceBuffer::SchedulePeriodicalCheck (void)
+{
+  if (m_wheel == 0)
+  {
+    m_wheel = TcpResequenceTimerWheel::GetWheel (m_tcp->GetNode ());
+  }
+  m_wheel->Schedule (this, m_periodicalCheckTime);
+  m_checkScheduled = true;
+}
+
 void
 TcpResequenceBuffer::PeriodicalCheck ()
 {
+  m_checkScheduled = false;
   if (m_hasStopped)
   {
     return;
@@ -280,7 +487,7 @@ TcpResequenceBuffer::PeriodicalCheck ()
 
   if (!m_inOrderQueue.empty () || !m_outOrderQueue.empty ())
   {
-    m_checkEvent = Simulator::Schedule (m_periodicalCheckTime, &TcpResequenceBuffer::PeriodicalCheck, this);
+    TcpResequenceBuffer::SchedulePeriodicalCheck ();
   }
   else
   {
@@ -288,8 +495,49 @@ TcpResequenceBuffer::PeriodicalCheck ()
   }
 }
 
+bool
+TcpResequenceBuffer::CanMerge (const TcpResequenceBufferElement &prev, const TcpResequenceBufferElement &element)
+{
+  return prev.m_dataSize > 0 && element.m_dataSize > 0
+    && !prev.m_isSyn && !prev.m_isFin && !element.m_isSyn && !element.m_isFin
+    && prev.m_flowcellId == element.m_flowcellId
+    && prev.m_ecn == element.m_ecn
+    && TcpResequenceBuffer::CalculateNextSeq (prev) == element.m_seq;
+}
+
+TcpResequenceBufferElement
+TcpResequenceBuffer::MergeElements (std::vector<TcpResequenceBufferElement>::const_iterator first,
+        std::vector<TcpResequenceBufferElement>::const_iterator last)
+{
+  // The merged segment keeps the metadata of the first segment and the header
+  // (ack, window and options) of the last one
+  TcpResequenceBufferElement element = *first;
+  TcpHeader tcpHeader;
+  Ptr<Packet> merged = first->m_packet->Copy ();
+  merged->RemoveHeader (tcpHeader);
+  uint8_t flags = tcpHeader.GetFlags ();
+
+  for (++first; first != last; ++first)
+  {
+    Ptr<Packet> segment = first->m_packet->Copy ();
+    segment->RemoveHeader (tcpHeader);
+    flags |= tcpHeader.GetFlags ();
+    merged->AddAtEnd (segment);
+    element.m_dataSize += first->m_dataSize;
+  }
+
+  tcpHeader.SetSequenceNumber (element.m_seq);
+  tcpHeader.SetFlags (flags);
+  merged->AddHeader (tcpHeader);
+  element.m_packet = merged;
+
+  NS_LOG_LOGIC ("Merge segments from seq: " << element.m_seq << " of size: " << element.m_dataSize);
+  return element;
+}
+
 void
-TcpResequenceBuffer::FlushOneElement (const TcpResequenceBufferElement &element, TcpRBPopReason reason)
+TcpResequenceBuffer::FlushOneElement (const TcpResequenceBufferElement &element, TcpRBPopReason reason,
+        uint32_t outOrderLength)
 {
   if (m_hasStopped)
   {
@@ -297,8 +545,8 @@ TcpResequenceBuffer::FlushOneElement (const TcpResequenceBufferElement &element,
   }
   NS_LOG_INFO ("Flush packet: " << element.m_packet);
   m_tcpRBFlush (m_traceFlowId, Simulator::Now (), element.m_seq, m_inOrderQueue.size (),
-          m_outOrderQueue.size (), reason);
-  m_tcp->DoForwardUp (element.m_packet, element.m_fromAddress, element.m_toAddress);
+          outOrderLength, reason);
+  m_tcp->DoForwardUp (element.m_packet, m_fromAddress, m_toAddress);
 }
 
 void
@@ -306,15 +554,32 @@ TcpResequenceBuffer::FlushInOrderQueue (TcpRBPopReason reason)
 {
   NS_LOG_FUNCTION (this);
   // Flush the data
-  std::vector<TcpResequenceBufferElement>::iterator itr = m_inOrderQueue.begin ();
+  std::vector<TcpResequenceBufferElement>::const_iterator itr = m_inOrderQueue.begin ();
 
-  for ( ; itr != m_inOrderQueue.end (); ++itr)
+  while (itr != m_inOrderQueue.end ())
   {
     if (m_hasStopped)
     {
       break;
     }
-    TcpResequenceBuffer::FlushOneElement (*itr, reason);
+    std::vector<TcpResequenceBufferElement>::const_iterator last = itr + 1;
+    if (m_gro)
+    {
+      while (last != m_inOrderQueue.end () && TcpResequenceBuffer::CanMerge (*(last - 1), *last))
+      {
+        ++last;
+      }
+    }
+    if (last - itr > 1)
+    {
+      TcpResequenceBuffer::FlushOneElement (TcpResequenceBuffer::MergeElements (itr, last), reason,
+              m_outOrderQueue.size ());
+    }
+    else
+    {
+      TcpResequenceBuffer::FlushOneElement (*itr, reason, m_outOrderQueue.size ());
+    }
+    itr = last;
   }
 
   m_inOrderQueue.clear ();
@@ -330,17 +595,14 @@ void
 TcpResequenceBuffer::FlushOutOrderQueue (TcpRBPopReason reason)
 {
   NS_LOG_FUNCTION (this);
-  // Flush the data
-  while (!m_outOrderQueue.empty ())
+  // Flush the data, the trace reports the elements left as they are popped
+  uint32_t outOrderLength = m_outOrderQueue.size ();
+  std::deque<TcpResequenceBufferElement>::const_iterator itr = m_outOrderQueue.begin ();
+  for ( ; itr != m_outOrderQueue.end () && !m_hasStopped; ++itr)
   {
-    if (m_hasStopped)
-    {
-      break;
-    }
-    TcpResequenceBuffer::FlushOneElement (m_outOrderQueue.top (), reason);
-    m_outOrderQueue.pop ();
+    TcpResequenceBuffer::FlushOneElement (*itr, reason, outOrderLength--);
   }
-  m_outOrderSeqSet.clear ();
+  m_outOrderQueue.clear ();
 
   // Reset the timer
   m_outOrderQueueTimer = Simulator::Now ();
@@ -10,8 +10,7 @@
 #include "ns3/traced-value.h"
 
 #include <vector>
-#include <queue>
-#include <set>
+#include <deque>
 
 namespace ns3
 {
@@ -21,10 +20,13 @@ enum TcpRBPopReason
   IN_ORDER_FULL = 0,
   IN_ORDER_TIMEOUT,
   OUT_ORDER_TIMEOUT,
-  RE_TRANS
+  RE_TRANS,
+  IN_ORDER_FLOWCELL
 };
 
 class TcpSocketBase;
+class TcpResequenceBuffer;
+class Node;
 
 class TcpResequenceBufferElement
 {
@@ -38,18 +40,74 @@ public:
 
   uint32_t m_dataSize; // In bytes
 
-  Ptr<Packet> m_packet;
+  uint32_t m_flowcellId; // 0 if the packet carries no flowcell id
 
-  Address m_fromAddress;
+  uint8_t m_ecn;
 
-  Address m_toAddress;
+  Ptr<Packet> m_packet;
 
-  friend inline bool operator > (const TcpResequenceBufferElement &l, const TcpResequenceBufferElement &r)
+  friend inline bool operator < (const TcpResequenceBufferElement &l, const TcpResequenceBufferElement &r)
   {
-    return l.m_seq > r.m_seq;
+    return l.m_seq < r.m_seq;
   }
 };
 
+/**
+ * \brief Per node timer wheel running the periodical checks of the resequence buffers
+ *
+ * Aggregated to the node, it keeps one simulator event per node instead of
+ * one per socket. A check runs at the first tick at or after its due time.
+ */
+class TcpResequenceTimerWheel : public Object
+{
+
+public:
+
+  static TypeId GetTypeId (void);
+
+  TcpResequenceTimerWheel ();
+  ~TcpResequenceTimerWheel ();
+
+  virtual void DoDispose (void);
+
+  // Get the wheel aggregated to the node, aggregating a new one if there is none
+  static Ptr<TcpResequenceTimerWheel> GetWheel (Ptr<Node> node);
+
+  void Schedule (Ptr<TcpResequenceBuffer> buffer, Time delay);
+
+private:
+
+  struct Entry
+  {
+    Ptr<TcpResequenceBuffer> buffer;
+    uint64_t dueTick;
+  };
+
+  void ScheduleTick (uint64_t tick);
+  void Expire (void);
+
+  Time m_tick;
+  uint32_t m_slotNumber;
+
+  std::vector<std::vector<Entry> > m_slots;
+  uint32_t m_pending;
+
+  uint64_t m_currentTick;
+  uint64_t m_nextTick;
+  EventId m_event;
+  bool m_expiring;
+};
+
+/**
+ * \brief Per connection resequencing of the segments sprayed over several paths
+ *
+ * The in order run is a vector appended in O(1) and delivered to TcpSocketBase
+ * segment by segment when it is flushed. The out of order segments are kept in a
+ * ring sorted by sequence number: the common cases, a segment after the last
+ * one and the head segment filling the gap, are O(1) at its ends. The
+ * addresses are the ones of the connection and are stored once.
+ */
+
 class TcpResequenceBuffer : public Object
 {
 
@@ -69,6 +127,8 @@ public:
 
   void Stop (void);
 
+  bool IsStopped (void) const;
+
   TracedCallback <uint32_t, Time, SequenceNumber32, SequenceNumber32> m_tcpRBBuffer;
   TracedCallback <uint32_t, Time, SequenceNumber32, uint32_t, uint32_t, TcpRBPopReason> m_tcpRBFlush;
 
@@ -77,9 +137,18 @@ private:
   bool PutInTheInOrderQueue (const TcpResequenceBufferElement &element);
   SequenceNumber32 CalculateNextSeq (const TcpResequenceBufferElement &element);
 
+  friend class TcpResequenceTimerWheel;
+
+  void SchedulePeriodicalCheck (void);
   void PeriodicalCheck ();
 
-  void FlushOneElement (const TcpResequenceBufferElement &element, TcpRBPopReason reason);
+  // GRO, merge the contiguous data segments of the same flowcell
+  bool CanMerge (const TcpResequenceBufferElement &prev, const TcpResequenceBufferElement &element);
+  TcpResequenceBufferElement MergeElements (std::vector<TcpResequenceBufferElement>::const_iterator first,
+          std::vector<TcpResequenceBufferElement>::const_iterator last);
+
+  void FlushOneElement (const TcpResequenceBufferElement &element, TcpRBPopReason reason,
+          uint32_t outOrderLength);
   void FlushInOrderQueue (TcpRBPopReason reason);
   void FlushOutOrderQueue (TcpRBPopReason reason);
 
@@ -91,6 +160,8 @@ private:
 
   Time m_periodicalCheckTime;
 
+  bool m_gro;
+
   uint32_t m_traceFlowId;
 
   // Variables
@@ -98,7 +169,6 @@ private:
   Time m_inOrderQueueTimer;
   Time m_outOrderQueueTimer;
 
-  EventId m_checkEvent;
   bool m_hasStopped;
 
   SequenceNumber32 m_firstSeq;
@@ -106,11 +176,15 @@ private:
 
   std::vector<TcpResequenceBufferElement> m_inOrderQueue;
 
-  std::priority_queue<TcpResequenceBufferElement,
-      std::vector<TcpResequenceBufferElement>,
-      std::greater<TcpResequenceBufferElement> > m_outOrderQueue;
+  // Sorted by sequence number, without duplicates
+  std::deque<TcpResequenceBufferElement> m_outOrderQueue;
+
+  Ptr<TcpResequenceTimerWheel> m_wheel;
+  bool m_checkScheduled;
 
-  std::set<SequenceNumber32> m_outOrderSeqSet;
+  bool m_hasAddress;
+  Address m_fromAddress;
+  Address m_toAddress;
 
   TcpSocketBase *m_tcp;
 
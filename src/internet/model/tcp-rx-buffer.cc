@@ -52,7 +52,8 @@ TcpRxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpRxBuffer::TcpRxBuffer (uint32_t n)
-  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0)
+  : m_nextRxSeq (n), m_gotFin (false), m_size (0), m_maxBuffer (32768), m_availBytes (0),
+    m_headSeq (n)
 {
 }
 
@@ -114,9 +115,9 @@ TcpRxBuffer::MaxRxSequence (void) const
     { // No data allowed beyond FIN
       return m_finSeq;
     }
-  else if (m_data.size ())
+  else if (m_size)
     { // No data allowed beyond Rx window allowed
-      return m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      return FirstSequence () + SequenceNumber32 (m_maxBuffer);
     }
   return m_nextRxSeq + SequenceNumber32 (m_maxBuffer);
 }
@@ -131,6 +132,17 @@ TcpRxBuffer::SetFinSequence (const SequenceNumber32& s)
   if (m_nextRxSeq == m_finSeq) ++m_nextRxSeq;
 }
 
+SequenceNumber32
+TcpRxBuffer::FirstSequence (void) const
+{
+  NS_ASSERT (m_size);
+  if (!m_inSequence.empty ())
+    {
+      return m_headSeq;
+    }
+  return m_data.begin ()->first;
+}
+
 bool
 TcpRxBuffer::Finished (void)
 {
@@ -150,14 +162,19 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
 
   // Trim packet to fit Rx window specification
   if (headSeq < m_nextRxSeq) headSeq = m_nextRxSeq;
-  if (m_data.size ())
+  if (m_size)
     {
-      SequenceNumber32 maxSeq = m_data.begin ()->first + SequenceNumber32 (m_maxBuffer);
+      SequenceNumber32 maxSeq = FirstSequence () + SequenceNumber32 (m_maxBuffer);
       if (maxSeq < tailSeq) tailSeq = maxSeq;
       if (tailSeq < headSeq) headSeq = tailSeq;
     }
-  // Remove overlapped bytes from packet
-  BufIterator i = m_data.begin ();
+  // Remove overlapped bytes from packet. The data in sequence ends before
+  // headSeq, and so do the blocks before the last one starting at headSeq
+  BufIterator i = m_data.upper_bound (headSeq);
+  if (i != m_data.begin ())
+    {
+      --i;
+    }
   while (i != m_data.end () && i->first <= tailSeq)
     {
       SequenceNumber32 lastByteSeq = i->first + SequenceNumber32 (i->second->GetSize ());
@@ -193,24 +210,30 @@ TcpRxBuffer::Add (Ptr<Packet> p, TcpHeader const& tcph)
       p = p->CreateFragment (start, length);
       NS_ASSERT (length == p->GetSize ());
     }
-  // Insert packet into buffer
-  NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
-  m_data [ headSeq ] = p;
   NS_LOG_LOGIC ("Buffered packet of seqno=" << headSeq << " len=" << p->GetSize ());
-  // Update variables
   m_size += p->GetSize ();      // Occupancy
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
-    {
-      if (i->first < m_nextRxSeq)
+  if (headSeq != m_nextRxSeq)
+    { // After a hole, wait for it to be filled
+      NS_ASSERT (m_data.find (headSeq) == m_data.end ()); // Shouldn't be there yet
+      m_data [ headSeq ] = p;
+    }
+  else
+    { // In sequence, along with the blocks it joins
+      if (m_inSequence.empty ())
         {
-          continue;
+          m_headSeq = headSeq;
         }
-      else if (i->first > m_nextRxSeq)
+      m_inSequence.push_back (p);
+      m_nextRxSeq = tailSeq;
+      m_availBytes += p->GetSize ();
+      i = m_data.begin ();
+      while (i != m_data.end () && i->first == m_nextRxSeq)
         {
-          break;
-        };
-      m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
-      m_availBytes += i->second->GetSize ();
+          m_inSequence.push_back (i->second);
+          m_nextRxSeq = i->first + SequenceNumber32 (i->second->GetSize ());
+          m_availBytes += i->second->GetSize ();
+          m_data.erase (i++);
+        }
     }
   NS_LOG_LOGIC ("Updated buffer occupancy=" << m_size << " nextRxSeq=" << m_nextRxSeq);
   if (m_gotFin && m_nextRxSeq == m_finSeq)
@@ -228,28 +251,27 @@ TcpRxBuffer::Extract (uint32_t maxSize)
   uint32_t extractSize = std::min (maxSize, m_availBytes);
   NS_LOG_LOGIC ("Requested to extract " << extractSize << " bytes from TcpRxBuffer of size=" << m_size);
   if (extractSize == 0) return 0;  // No contiguous block to return
-  NS_ASSERT (m_data.size ()); // At least we have something to extract
+  NS_ASSERT (m_inSequence.size ()); // At least we have something to extract
   Ptr<Packet> outPkt = Create<Packet> (); // The packet that contains all the data to return
-  BufIterator i;
   while (extractSize)
     { // Check the buffered data for delivery
-      i = m_data.begin ();
-      NS_ASSERT (i->first <= m_nextRxSeq); // in-sequence data expected
+      Ptr<Packet> head = m_inSequence.front ();
       // Check if we send the whole pkt or just a partial
-      uint32_t pktSize = i->second->GetSize ();
+      uint32_t pktSize = head->GetSize ();
       if (pktSize <= extractSize)
         { // Whole packet is extracted
-          outPkt->AddAtEnd (i->second);
-          m_data.erase (i);
+          outPkt->AddAtEnd (head);
+          m_inSequence.pop_front ();
+          m_headSeq += pktSize;
           m_size -= pktSize;
           m_availBytes -= pktSize;
           extractSize -= pktSize;
         }
       else
         { // Partial is extracted and done
-          outPkt->AddAtEnd (i->second->CreateFragment (0, extractSize));
-          m_data[i->first + SequenceNumber32 (extractSize)] = i->second->CreateFragment (extractSize, pktSize - extractSize);
-          m_data.erase (i);
+          outPkt->AddAtEnd (head->CreateFragment (0, extractSize));
+          m_inSequence.front () = head->CreateFragment (extractSize, pktSize - extractSize);
+          m_headSeq += extractSize;
           m_size -= extractSize;
           m_availBytes -= extractSize;
           extractSize = 0;
@@ -261,7 +283,7 @@ TcpRxBuffer::Extract (uint32_t maxSize)
       return 0;
     }
   NS_LOG_LOGIC ("Extracted " << outPkt->GetSize ( ) << " bytes, bufsize=" << m_size
-                             << ", num pkts in buffer=" << m_data.size ());
+                             << ", num pkts in buffer=" << m_inSequence.size () + m_data.size ());
   return outPkt;
 }
 
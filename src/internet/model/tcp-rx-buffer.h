@@ -22,6 +22,7 @@
 #define TCP_RX_BUFFER_H
 
 #include <map>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/sequence-number.h"
@@ -36,6 +37,12 @@ class Packet;
  *
  * \brief class for the reordering buffer that keeps the data from lower layer, i.e.
  *        TcpL4Protocol, sent to the application
+ *
+ * The data in sequence, ready for the application, is a double ended queue
+ * of packets, appended and extracted in constant time. Only the data after
+ * a hole waits in a map by sequence number, so that a segment in sequence
+ * never walks through it, and a reordered one only through the blocks it
+ * overlaps.
  */
 class TcpRxBuffer : public Object
 {
@@ -126,7 +133,13 @@ public:
   Ptr<Packet> Extract (uint32_t maxSize);
 
 private:
-  /// container for data stored in the buffer
+  /**
+   * \brief Get the sequence number of the first byte in the buffer
+   * \returns the sequence number of the first byte in the buffer
+   */
+  SequenceNumber32 FirstSequence (void) const;
+
+  /// container for the data after a hole
   typedef std::map<SequenceNumber32, Ptr<Packet> >::iterator BufIterator;
   TracedValue<SequenceNumber32> m_nextRxSeq; //!< Seqnum of the first missing byte in data (RCV.NXT)
   SequenceNumber32 m_finSeq;                 //!< Seqnum of the FIN packet
@@ -134,7 +147,9 @@ private:
   uint32_t m_size;                           //!< Number of total data bytes in the buffer, not necessarily contiguous
   uint32_t m_maxBuffer;                      //!< Upper bound of the number of data bytes in buffer (RCV.WND)
   uint32_t m_availBytes;                     //!< Number of bytes available to read, i.e. contiguous block at head
-  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Corresponding data (may be null)
+  SequenceNumber32 m_headSeq;                //!< Seqnum of the first byte available to read
+  std::deque<Ptr<Packet> > m_inSequence;     //!< Data available to read, m_availBytes bytes from m_headSeq
+  std::map<SequenceNumber32, Ptr<Packet> > m_data; //!< Data after the first hole, by seqnum
 };
 
 } //namepsace ns3
@@ -40,6 +40,7 @@
 #include "ns3/uinteger.h"
 #include "ns3/double.h"
 #include "ns3/pointer.h"
+#include "ns3/object-factory.h"
 #include "ns3/trace-source-accessor.h"
 #include "tcp-socket-base.h"
 #include "tcp-l4-protocol.h"
@@ -52,11 +53,7 @@
 #include "rtt-estimator.h"
 #include "ipv4-ecn-tag.h"
 #include "ns3/flow-id-tag.h"
-#include "ns3/ipv4-xpath-tag.h"
-#include "ns3/tcp-tlb-tag.h"
-#include "ns3/ipv4-clove.h"
-#include "ns3/tcp-clove-tag.h"
-#include "ns3/hash.h"
+#include "ns3/flow-hash.h"
 
 #include <math.h>
 #include <algorithm>
@@ -139,6 +136,10 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (true),
                    MakeBooleanAccessor (&TcpSocketBase::m_ecn),
                    MakeBooleanChecker ())
+    .AddAttribute ("MaxBurst", "Max segments sent at once when the window opens, 0 for no limit",
+                   UintegerValue (2),
+                   MakeUintegerAccessor (&TcpSocketBase::m_maxBurst),
+                   MakeUintegerChecker<uint32_t> ())
     .AddAttribute ("ResequenceBuffer", "Enable Resequence Buffer",
                    BooleanValue (false),
                    MakeBooleanAccessor (&TcpSocketBase::m_resequenceBufferEnabled),
@@ -159,6 +160,10 @@ TcpSocketBase::GetTypeId (void)
                    BooleanValue (false),
                    MakeBooleanAccessor (&TcpSocketBase::m_CloveEnabled),
                    MakeBooleanChecker ())
+    .AddAttribute ("PathSelector", "Another host path selector, after the TLB, Clove and FlowBender ones",
+                   TypeIdValue (HostPathSelector::GetTypeId ()),
+                   MakeTypeIdAccessor (&TcpSocketBase::m_pathSelectorTypeId),
+                   MakeTypeIdChecker ())
     .AddAttribute ("Pause", "Whether TCP should pause in FlowBender & TLB",
                    BooleanValue (false),
                    MakeBooleanAccessor (&TcpSocketBase::m_isPauseEnabled),
@@ -350,17 +355,13 @@ TcpSocketBase::TcpSocketBase (void)
     m_limitedTx (false),
     m_retransOut (0),
     m_ecn (true),
+    m_maxBurst (2),
     m_resequenceBufferEnabled (false),
     m_flowBenderEnabled (false),
-    // TLB
     m_TLBEnabled (false),
-    m_TLBSendSide (false),
-    m_piggybackTLBInfo (false),
     m_TLBReverseAckEnabled (false),
-    // Clove
     m_CloveEnabled (false),
-    m_CloveSendSide (false),
-    m_piggybackCloveInfo (false),
+    m_pathSelectorTypeId (HostPathSelector::GetTypeId ()),
     // Pause
     m_isPauseEnabled (false),
     m_isPause (false),
@@ -387,9 +388,6 @@ TcpSocketBase::TcpSocketBase (void)
   m_resequenceBuffer->SetTcp (this);
 
 
-  // Flow Bender support
-  m_flowBender = CreateObject<TcpFlowBender> ();
-
   // Pause support
   m_pauseBuffer = CreateObject<TcpPauseBuffer> ();
 
@@ -456,17 +454,13 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
     m_limitedTx (sock.m_limitedTx),
     m_retransOut (sock.m_retransOut),
     m_ecn (sock.m_ecn),
+    m_maxBurst (sock.m_maxBurst),
     m_resequenceBufferEnabled (sock.m_resequenceBufferEnabled),
     m_flowBenderEnabled (sock.m_flowBenderEnabled),
-    // TLB
     m_TLBEnabled (sock.m_TLBEnabled),
-    m_TLBSendSide (false),
-    m_piggybackTLBInfo (false),
     m_TLBReverseAckEnabled (sock.m_TLBReverseAckEnabled),
-    // Clove
     m_CloveEnabled (sock.m_CloveEnabled),
-    m_CloveSendSide (false),
-    m_piggybackCloveInfo (false),
+    m_pathSelectorTypeId (sock.m_pathSelectorTypeId),
     // Pause
     m_isPauseEnabled (sock.m_isPauseEnabled),
     m_isPause (false),
@@ -509,9 +503,6 @@ TcpSocketBase::TcpSocketBase (const TcpSocketBase& sock)
   m_resequenceBuffer->m_tcpRBBuffer = sock.m_resequenceBuffer->m_tcpRBBuffer;
   m_resequenceBuffer->SetTcp (this);
 
-  // Flow Bender support
-  m_flowBender = CreateObject<TcpFlowBender> ();
-
   // Pause support
   m_pauseBuffer = CreateObject<TcpPauseBuffer> ();
 
@@ -539,6 +530,11 @@ TcpSocketBase::~TcpSocketBase (void)
 {
   NS_LOG_FUNCTION (this);
   m_node = 0;
+  // A periodical check of the buffer may still be in the node timer wheel
+  if (m_resequenceBuffer != 0)
+    {
+      m_resequenceBuffer->Stop ();
+    }
   if (m_endPoint != 0)
     {
       NS_ASSERT (m_tcp != 0);
@@ -1145,14 +1141,10 @@ TcpSocketBase::DoConnect (void)
         sendflags |= (TcpHeader::ECE | TcpHeader::CWR);
         NS_LOG_LOGIC (this << " ECN capable connection, sending ECN setup SYN");
       }
-      if (m_TLBEnabled)
-      {
-          m_TLBSendSide = true;
-      }
-      if (m_CloveEnabled)
-      {
-          m_CloveSendSide = true;
-      }
+      if (m_pathSelectors.empty () && m_endPoint != 0)
+        {
+          BindPathSelectors (true);
+        }
       SendEmptyPacket (sendflags);
 
       // XXX Resequence Buffer Support, disable resequence buffer on sender side
@@ -1271,10 +1263,12 @@ TcpSocketBase::ForwardUp (Ptr<Packet> packet, Ipv4Header header, uint16_t port,
   // ECN Support - Extract the ECN information in IP header
   Ipv4EcnTag ipv4EcnTag;
   ipv4EcnTag.SetEcn(header.GetEcn());
-  packet->AddPacketTag(ipv4EcnTag);
+  ipv4EcnTag.AddTo (packet);
 
   // XXX Resequence Buffer Support
-  if (m_resequenceBufferEnabled)
+  // A listening socket gets the SYNs of many connections, which all start from
+  // the same sequence number and must not be resequenced against each other
+  if (m_resequenceBufferEnabled && m_state != LISTEN)
   {
     // If the resequence buffer is enabled, forwarding the packet is deferred to the resequence buffer
     m_resequenceBuffer->BufferPacket (packet, fromAddress, toAddress);
@@ -1637,34 +1631,11 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
     withECE = true;
   }
 
-  // XXX TLB Support
-  if (m_TLBEnabled && m_TLBSendSide)
-  {
-    TcpTLBTag tcpTLBTag;
-    bool found = packet->RemovePacketTag(tcpTLBTag);
-    if (found)
-    {
-        uint32_t flowId = TcpSocketBase::CalFlowId (m_endPoint->GetLocalAddress (),
-                m_endPoint->GetPeerAddress (), m_endPoint->GetLocalPort (), m_endPoint->GetPeerPort ());
-        Ptr<Ipv4TLB> ipv4TLB = m_node->GetObject<Ipv4TLB> ();
-        m_pathAcked = tcpTLBTag.GetPath ();
-        // std::cout << this << " Path acked: " << m_pathAcked << std::endl;
-        ipv4TLB->FlowRecv (flowId, m_pathAcked, m_endPoint->GetPeerAddress (), bytesAcked, withECE, tcpTLBTag.GetTime ());
-    }
-  }
-
-  // XXX Clove Support
-  if (m_CloveEnabled && m_CloveSendSide)
-  {
-    TcpCloveTag tcpCloveTag;
-    bool found = packet->RemovePacketTag(tcpCloveTag);
-    if (found)
+  for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+       it != m_pathSelectors.end (); ++it)
     {
-        Ptr<Ipv4Clove> ipv4Clove = m_node->GetObject<Ipv4Clove> ();
-        m_pathAcked = tcpCloveTag.GetPath ();
-        ipv4Clove->FlowRecv (m_pathAcked, m_endPoint->GetPeerAddress (), withECE);
+      (*it)->OnAck (packet, bytesAcked, withECE);
     }
-  }
 
   if (ackNumber == m_txBuffer->HeadSequence ()
       && ackNumber < m_nextTxSequence
@@ -1728,11 +1699,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       // Artificially call PktsAcked. After all, one segment has been ACKed.
       m_congestionControl->PktsAcked (m_tcb, 1, m_lastRtt, withECE, m_highTxMark, ackNumber);
 
-      // XXX FlowBender
-      if (m_flowBenderEnabled)
-      {
-        m_flowBender->ReceivedPacket (m_highTxMark, ackNumber, m_tcb->m_segmentSize, withECE);
-      }
+      PathSelectorsAcked (ackNumber, m_tcb->m_segmentSize, withECE);
 
     }
   else if (ackNumber == m_txBuffer->HeadSequence ()
@@ -1769,11 +1736,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
       if (m_tcb->m_congState == TcpSocketState::CA_OPEN)
         {
             m_congestionControl->PktsAcked (m_tcb, segsAcked, m_lastRtt, withECE, m_highTxMark, ackNumber);
-            // XXX FlowBender
-            if (m_flowBenderEnabled)
-            {
-              m_flowBender->ReceivedPacket (m_highTxMark, ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
-            }
+            PathSelectorsAcked (ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
         }
       // XXX After the CWR has been acked, the CA_CWR exits
       else if (m_tcb->m_congState == TcpSocketState::CA_CWR)
@@ -1788,11 +1751,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
           m_retransOut = 0;
 
           m_congestionControl->PktsAcked(m_tcb, segsAcked, m_lastRtt, withECE, m_highTxMark, ackNumber);
-          // XXX FlowBender
-          if (m_flowBenderEnabled)
-          {
-              m_flowBender->ReceivedPacket (m_highTxMark, ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
-          }
+          PathSelectorsAcked (ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
 
         }
       else if (m_tcb->m_congState == TcpSocketState::CA_DISORDER)
@@ -1801,11 +1760,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
           // packet algorithm from FACK to NewReno. We simply go back in Open.
           m_tcb->m_congState = TcpSocketState::CA_OPEN;
           m_congestionControl->PktsAcked (m_tcb, segsAcked, m_lastRtt, withECE, m_highTxMark, ackNumber);
-          // XXX FlowBender
-          if (m_flowBenderEnabled)
-          {
-              m_flowBender->ReceivedPacket (m_highTxMark, ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
-          }
+          PathSelectorsAcked (ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
 
           m_dupAckCount = 0;
           m_retransOut = 0;
@@ -1859,11 +1814,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
                * been processed when they come under the form of dupACKs
                */
               m_congestionControl->PktsAcked (m_tcb, 1, m_lastRtt, withECE, m_highTxMark, ackNumber);
-              // XXX FlowBender
-              if (m_flowBenderEnabled)
-              {
-                  m_flowBender->ReceivedPacket (m_highTxMark, ackNumber, m_tcb->m_segmentSize, withECE);
-              }
+              PathSelectorsAcked (ackNumber, m_tcb->m_segmentSize, withECE);
 
               NS_LOG_INFO ("Partial ACK for seq " << ackNumber <<
                            " in fast recovery: cwnd set to " << m_tcb->m_cWnd <<
@@ -1884,11 +1835,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
                * except the (maybe) new ACKs which come from a new window
                */
               m_congestionControl->PktsAcked (m_tcb, segsAcked, m_lastRtt, withECE, m_highTxMark, ackNumber);
-              // XXX FlowBender
-              if (m_flowBenderEnabled)
-              {
-                m_flowBender->ReceivedPacket (m_highTxMark, ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
-              }
+              PathSelectorsAcked (ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
 
               newSegsAcked = (ackNumber - m_recover) / m_tcb->m_segmentSize;
               m_tcb->m_congState = TcpSocketState::CA_OPEN;
@@ -1903,11 +1850,7 @@ TcpSocketBase::ReceivedAck (Ptr<Packet> packet, const TcpHeader& tcpHeader)
           // Go back in OPEN state
           m_isFirstPartialAck = true;
           m_congestionControl->PktsAcked (m_tcb, segsAcked, m_lastRtt, withECE, m_highTxMark, ackNumber);
-          // XXX FlowBender
-          if (m_flowBenderEnabled)
-          {
-            m_flowBender->ReceivedPacket (m_highTxMark, ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
-          }
+          PathSelectorsAcked (ackNumber, m_tcb->m_segmentSize * segsAcked, withECE);
 
           m_dupAckCount = 0;
           m_retransOut = 0;
@@ -2524,107 +2467,12 @@ TcpSocketBase::SendEmptyPacket (uint8_t flags)
         }
     }
 
-  // XXX TLB Support
-  if (m_TLBEnabled)
-  {
-    if (m_TLBSendSide)
+  for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+       it != m_pathSelectors.end (); ++it)
     {
-      uint32_t flowId = TcpSocketBase::CalFlowId (m_endPoint->GetLocalAddress (),
-                         m_endPoint->GetPeerAddress (), header.GetSourcePort (), header.GetDestinationPort ());
-
-      Ptr<Ipv4TLB> ipv4TLB = m_node->GetObject<Ipv4TLB> ();
-      uint32_t path = ipv4TLB->GetPath (flowId, m_endPoint->GetLocalAddress (), m_endPoint->GetPeerAddress ());
-      // std::cout << this << " Get Path From TLB: " << path << std::endl;
-
-      // XPath Support
-      Ipv4XPathTag ipv4XPathTag;
-      ipv4XPathTag.SetPathId (path);
-      p->AddPacketTag (ipv4XPathTag);
-
-      // TLB Support
-      TcpTLBTag tcpTLBTag;
-      tcpTLBTag.SetPath (path);
-      tcpTLBTag.SetTime (Simulator::Now ());
-      p->AddPacketTag (tcpTLBTag);
-
-      bool synRetrans = hasSyn && (m_synCount != m_synRetries - 1);
-      ipv4TLB->FlowSend (flowId, m_endPoint->GetPeerAddress (), path, p->GetSize (), synRetrans);
-      if (synRetrans)
-      {
-          ipv4TLB->FlowTimeout (flowId, m_endPoint->GetPeerAddress (), path);
-      }
-
-      // Pause Support
-      if (m_isPauseEnabled && m_oldPath == 0)
-      {
-          m_oldPath = path;
-      }
-
-      if (m_isPauseEnabled
-            && !m_isPause
-            && m_oldPath != path)
-      {
-          std::cout << "Turning on pause" << std::endl;
-          m_isPause = true;
-          m_oldPath = path;
-          Time pauseTime = ipv4TLB->GetPauseTime (flowId);
-          Simulator::Schedule (pauseTime, &TcpSocketBase::RecoverFromPause, this);
-      }
-    }
-
-    if (m_piggybackTLBInfo)
-    {
-      TcpTLBTag tcpTLBTag;
-      tcpTLBTag.SetPath (m_TLBPath);
-      tcpTLBTag.SetTime (m_onewayRtt);
-      p->AddPacketTag (tcpTLBTag);
+      (*it)->OnSend (p, flags, false, hasSyn && (m_synCount != m_synRetries - 1));
     }
 
-    if (m_TLBReverseAckEnabled && (hasSyn || isAck) && !m_TLBSendSide)
-    {
-      uint32_t flowId = TcpSocketBase::CalFlowId (m_endPoint->GetLocalAddress (),
-                        m_endPoint->GetPeerAddress (), header.GetSourcePort (), header.GetDestinationPort ());
-
-      Ptr<Ipv4TLB> ipv4TLB = m_node->GetObject<Ipv4TLB> ();
-      uint32_t path = ipv4TLB->GetAckPath (flowId, m_endPoint->GetLocalAddress (), m_endPoint->GetPeerAddress ());
-
-      // XPath Support
-      Ipv4XPathTag ipv4XPathTag;
-      ipv4XPathTag.SetPathId (path);
-      p->AddPacketTag (ipv4XPathTag);
-    }
-  }
-
-  // XXX Clove Support
-  if (m_CloveEnabled)
-  {
-    if (m_CloveSendSide)
-    {
-      uint32_t flowId = TcpSocketBase::CalFlowId (m_endPoint->GetLocalAddress (),
-                         m_endPoint->GetPeerAddress (), header.GetSourcePort (), header.GetDestinationPort ());
-
-      Ptr<Ipv4Clove> ipv4Clove = m_node->GetObject<Ipv4Clove> ();
-      uint32_t path = ipv4Clove->GetPath (flowId, m_endPoint->GetLocalAddress (), m_endPoint->GetPeerAddress ());
-
-      // XPath Support
-      Ipv4XPathTag ipv4XPathTag;
-      ipv4XPathTag.SetPathId (path);
-      p->AddPacketTag (ipv4XPathTag);
-
-      // Clove Support
-      TcpCloveTag tcpCloveTag;
-      tcpCloveTag.SetPath (path);
-      p->AddPacketTag (tcpCloveTag);
-    }
-
-    if (m_piggybackCloveInfo)
-    {
-      TcpCloveTag tcpCloveTag;
-      tcpCloveTag.SetPath (m_ClovePath);
-      p->AddPacketTag (tcpCloveTag);
-    }
-  }
-
   m_txTrace (p, header, this);
 
   if (m_endPoint != 0)
@@ -2820,6 +2668,10 @@ TcpSocketBase::CompleteFork (Ptr<Packet> p, const TcpHeader& h,
     m_tcb->m_ecnConn = false;
   }
 
+  if (m_endPoint != 0)
+    {
+      BindPathSelectors (false);
+    }
   SendEmptyPacket (sendflags);
 }
 
@@ -2909,7 +2761,7 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
     }
     Ipv4EcnTag ipv4EcnTag;
     ipv4EcnTag.SetEcn(Ipv4Header::ECN_ECT1);
-    p->AddPacketTag (ipv4EcnTag);
+    ipv4EcnTag.AddTo (p);
   }
 
   if (m_closeOnEmpty && (remainingData == 0))
@@ -2966,67 +2818,11 @@ TcpSocketBase::SendDataPacket (SequenceNumber32 seq, uint32_t maxSize, bool with
     {
       TcpSocketBase::AttachFlowId (p, m_endPoint->GetLocalAddress (),
                          m_endPoint->GetPeerAddress (), header.GetSourcePort (), header.GetDestinationPort ());
-      // XXX TLB Support
-      if (m_TLBEnabled && m_TLBSendSide)
-      {
-        uint32_t flowId = TcpSocketBase::CalFlowId (m_endPoint->GetLocalAddress (),
-                         m_endPoint->GetPeerAddress (), header.GetSourcePort (), header.GetDestinationPort ());
-        Ptr<Ipv4TLB> ipv4TLB = m_node->GetObject<Ipv4TLB> ();
-        uint32_t path = ipv4TLB->GetPath (flowId, m_endPoint->GetLocalAddress (), m_endPoint->GetPeerAddress ());
-        // std::cout << this << " Get Path From TLB: " << path << std::endl;
-
-        // XPath Support
-        Ipv4XPathTag ipv4XPathTag;
-        ipv4XPathTag.SetPathId (path);
-        p->AddPacketTag (ipv4XPathTag);
-
-        // TLB Support
-        TcpTLBTag tcpTLBTag;
-        tcpTLBTag.SetPath (path);
-        tcpTLBTag.SetTime (Simulator::Now ());
-        p->AddPacketTag (tcpTLBTag);
-        ipv4TLB->FlowSend (flowId, m_endPoint->GetPeerAddress (), path, p->GetSize (), isRetransmission);
-
-        // Pause Support
-        if (m_isPauseEnabled && m_oldPath == 0)
+      for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+           it != m_pathSelectors.end (); ++it)
         {
-            m_oldPath = path;
+          (*it)->OnSend (p, flags, true, isRetransmission);
         }
-        if (m_isPauseEnabled
-            && !m_isPause
-            && m_oldPath != path)
-        {
-            std::cout << "Turning on pause ..." << std::endl;
-            m_isPause = true;
-            m_oldPath = path;
-            Time pauseTime = ipv4TLB->GetPauseTime (flowId);
-            Simulator::Schedule (pauseTime, &TcpSocketBase::RecoverFromPause, this);
-        }
-      }
-
-      // XXX Clove Support
-      if (m_CloveEnabled)
-      {
-        if (m_CloveSendSide)
-        {
-          uint32_t flowId = TcpSocketBase::CalFlowId (m_endPoint->GetLocalAddress (),
-                                 m_endPoint->GetPeerAddress (), header.GetSourcePort (), header.GetDestinationPort ());
-
-          Ptr<Ipv4Clove> ipv4Clove = m_node->GetObject<Ipv4Clove> ();
-          uint32_t path = ipv4Clove->GetPath (flowId, m_endPoint->GetLocalAddress (), m_endPoint->GetPeerAddress ());
-
-          // XPath Support
-          Ipv4XPathTag ipv4XPathTag;
-          ipv4XPathTag.SetPathId (path);
-          p->AddPacketTag (ipv4XPathTag);
-
-          // Clove Support
-          TcpCloveTag tcpCloveTag;
-          tcpCloveTag.SetPath (path);
-          p->AddPacketTag (tcpCloveTag);
-        }
-      }
-
 
       if (m_isPause)
       {
@@ -3140,7 +2936,7 @@ TcpSocketBase::SendPendingData (bool withAck)
       uint32_t sz = SendDataPacket (m_nextTxSequence, s, withAck);
       nPacketsSent++;                             // Count sent this loop
       m_nextTxSequence += sz;                     // Advance next tx sequence
-      if (nPacketsSent == 2)
+      if (nPacketsSent == m_maxBurst)
       {
           break;
       }
@@ -3242,7 +3038,7 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
   if (m_tcb->m_ecnConn) // First, the connection should be ECN capable
   {
     Ipv4EcnTag ipv4EcnTag;
-    bool found = p->RemovePacketTag(ipv4EcnTag);
+    bool found = ipv4EcnTag.RemoveFrom (p);
     if (found && ipv4EcnTag.GetEcn() == Ipv4Header::ECN_NotECT
         && m_tcb->m_ecnSeen) // We have seen ECN before
     {
@@ -3275,32 +3071,12 @@ TcpSocketBase::ReceivedData (Ptr<Packet> p, const TcpHeader& tcpHeader)
     sendflags |= TcpHeader::ECE;
   }
 
-  // XXX TLB Support
-  if (m_TLBEnabled && !m_TLBSendSide)
-  {
-    TcpTLBTag tcpTLBTag;
-    bool found = p->RemovePacketTag(tcpTLBTag);
-    if (found)
-    {
-      m_piggybackTLBInfo = true;
-      m_onewayRtt = Simulator::Now () - tcpTLBTag.GetTime ();
-      m_TLBPath = tcpTLBTag.GetPath ();
-    }
-  }
-
-  // XXX Clove Support
-  if (m_CloveEnabled && !m_CloveSendSide)
-  {
-    TcpCloveTag tcpCloveTag;
-    bool found = p->RemovePacketTag(tcpCloveTag);
-    if (found)
+  for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+       it != m_pathSelectors.end (); ++it)
     {
-      m_piggybackCloveInfo = true;
-      m_ClovePath = tcpCloveTag.GetPath ();
+      (*it)->OnReceive (p);
     }
 
-  }
-
   // Put into Rx buffer
   SequenceNumber32 expectedSeq = m_rxBuffer->NextRxSequence ();
   if (!m_rxBuffer->Add (p, tcpHeader))
@@ -3594,14 +3370,11 @@ TcpSocketBase::Retransmit ()
 
   if (m_tcb->m_congState != TcpSocketState::CA_LOSS)
     {
-      // XXX TLB Support
-      if (m_TLBEnabled)
-      {
-        uint32_t flowId = TcpSocketBase::CalFlowId (m_endPoint->GetLocalAddress (),
-                m_endPoint->GetPeerAddress (), m_endPoint->GetLocalPort (), m_endPoint->GetPeerPort ());
-        Ptr<Ipv4TLB> ipv4TLB = m_node->GetObject<Ipv4TLB> ();
-        ipv4TLB->FlowTimeout (flowId, m_endPoint->GetPeerAddress (), m_pathAcked);
-      }
+      for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+           it != m_pathSelectors.end (); ++it)
+        {
+          (*it)->OnTimeout ();
+        }
       m_tcb->m_congState = TcpSocketState::CA_LOSS;
       m_tcb->m_ssThresh = m_congestionControl->GetSsThresh (m_tcb, BytesInFlight ());
       m_tcb->m_cWnd = m_tcb->m_segmentSize;
@@ -3655,6 +3428,12 @@ TcpSocketBase::DoRetransmit ()
       return;
     }
 
+  for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+       it != m_pathSelectors.end (); ++it)
+    {
+      (*it)->OnRetransmit (m_txBuffer->HeadSequence ());
+    }
+
   // Retransmit a data packet: Call SendDataPacket
   uint32_t sz = SendDataPacket (m_txBuffer->HeadSequence (), m_tcb->m_segmentSize, true);
   ++m_retransOut;
@@ -4112,42 +3891,21 @@ TcpSocketBase::AttachFlowId (Ptr<Packet> packet,
 
   uint32_t flowId = TcpSocketBase::CalFlowId (saddr, daddr, sport, dport);
 
-  // XXX Flow Bender support
-  if (m_flowBenderEnabled)
-  {
-    uint32_t path = m_flowBender->GetV ();
-    flowId += path;
-
-    // Pause Support
-    if (m_isPauseEnabled && m_oldPath == 0)
-    {
-        m_oldPath = path;
-    }
-    if (m_isPauseEnabled
-            && !m_isPause
-            && m_oldPath != 0
-            && m_oldPath != path)
+  for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+       it != m_pathSelectors.end (); ++it)
     {
-        std::cout << "Turning on pause ..." << std::endl;
-        m_isPause = true;
-        m_oldPath = path;
-        Time pauseTime = m_flowBender->GetPauseTime ();
-        Simulator::Schedule (pauseTime, &TcpSocketBase::RecoverFromPause, this);
+      flowId = (*it)->MapFlowId (flowId);
     }
-  }
 
-  packet->AddPacketTag(FlowIdTag(flowId));
+  FlowIdTag (flowId).AddTo (packet);
 }
 
 uint32_t
 TcpSocketBase::CalFlowId (const Ipv4Address &saddr, const Ipv4Address &daddr,
           uint16_t sport, uint16_t dport)
 {
-  std::stringstream hash_string;
-  hash_string << daddr.Get ();
-  hash_string << dport;
-
-  return Hash32 (hash_string.str ());
+  static const FlowHash flowHash;
+  return flowHash.Hash (saddr.Get (), daddr.Get (), sport, dport, TcpL4Protocol::PROT_NUMBER);
 }
 
 void
@@ -4164,6 +3922,74 @@ TcpSocketBase::RecoverFromPause (void)
     m_isPause = false;
 }
 
+void
+TcpSocketBase::BindPathSelectors (bool sendSide)
+{
+  NS_LOG_FUNCTION (this << sendSide);
+  NS_ASSERT (m_endPoint != 0);
+
+  if (m_TLBEnabled)
+    {
+      Ptr<TlbPathSelector> tlb = CreateObject<TlbPathSelector> ();
+      tlb->SetAttribute ("ReverseAck", BooleanValue (m_TLBReverseAckEnabled));
+      m_pathSelectors.push_back (tlb);
+    }
+  if (m_CloveEnabled)
+    {
+      m_pathSelectors.push_back (CreateObject<ClovePathSelector> ());
+    }
+  if (m_flowBenderEnabled)
+    {
+      m_pathSelectors.push_back (CreateObject<FlowBenderPathSelector> ());
+    }
+  if (m_pathSelectorTypeId != HostPathSelector::GetTypeId ())
+    {
+      ObjectFactory factory;
+      factory.SetTypeId (m_pathSelectorTypeId);
+      m_pathSelectors.push_back (factory.Create<HostPathSelector> ());
+    }
+
+  uint32_t flowId = TcpSocketBase::CalFlowId (m_endPoint->GetLocalAddress (),
+          m_endPoint->GetPeerAddress (), m_endPoint->GetLocalPort (), m_endPoint->GetPeerPort ());
+  for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+       it != m_pathSelectors.end (); ++it)
+    {
+      (*it)->SetPathCallback (MakeCallback (&TcpSocketBase::PathChosen, this));
+      (*it)->Bind (m_node, flowId, m_endPoint->GetLocalAddress (),
+                   m_endPoint->GetPeerAddress (), sendSide);
+    }
+}
+
+void
+TcpSocketBase::PathChosen (Ptr<HostPathSelector> selector, uint32_t path)
+{
+  if (!m_isPauseEnabled)
+    {
+      return;
+    }
+  if (m_oldPath == 0)
+    {
+      m_oldPath = path;
+    }
+  if (!m_isPause && m_oldPath != path)
+    {
+      NS_LOG_LOGIC (this << " turning on pause, the path changed to " << path);
+      m_isPause = true;
+      m_oldPath = path;
+      Simulator::Schedule (selector->GetPauseTime (), &TcpSocketBase::RecoverFromPause, this);
+    }
+}
+
+void
+TcpSocketBase::PathSelectorsAcked (SequenceNumber32 ackNumber, uint32_t bytesAcked, bool withECE)
+{
+  for (std::vector<Ptr<HostPathSelector> >::iterator it = m_pathSelectors.begin ();
+       it != m_pathSelectors.end (); ++it)
+    {
+      (*it)->OnAckProcessed (m_highTxMark, ackNumber, bytesAcked, withECE);
+    }
+}
+
 //RttHistory methods
 RttHistory::RttHistory (SequenceNumber32 s, uint32_t c, Time t)
   : seq (s),
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include <queue>
 #include <set>
+#include <vector>
 #include "ns3/callback.h"
 #include "ns3/traced-value.h"
 #include "ns3/tcp-socket.h"
@@ -39,8 +40,7 @@
 #include "rtt-estimator.h"
 #include "tcp-congestion-ops.h"
 #include "tcp-resequence-buffer.h"
-#include "tcp-flow-bender.h"
-#include "ns3/ipv4-tlb.h"
+#include "host-path-selector.h"
 #include "tcp-pause-buffer.h"
 
 namespace ns3 {
@@ -933,6 +933,27 @@ protected:
 
   void RecoverFromPause (void);
 
+  /**
+   * \brief Create the path selectors of the connection and bind them to it
+   * \param sendSide whether this socket opened the connection
+   */
+  void BindPathSelectors (bool sendSide);
+
+  /**
+   * \brief Pause the connection when a selector moves it to another path
+   * \param selector the selector
+   * \param path the path of the segment
+   */
+  void PathChosen (Ptr<HostPathSelector> selector, uint32_t path);
+
+  /**
+   * \brief Tell the path selectors the congestion control accounted for ACKed bytes
+   * \param ackNumber the acknowledgement number
+   * \param bytesAcked the bytes accounted for
+   * \param withECE whether the ACK echoes a congestion mark
+   */
+  void PathSelectorsAcked (SequenceNumber32 ackNumber, uint32_t bytesAcked, bool withECE);
+
 protected:
   // Counters and events
   EventId           m_retxEvent;       //!< Retransmission event
@@ -1011,31 +1032,19 @@ protected:
   // ECN capable connection
   bool m_ecn;   //!< ECN capability
 
+  uint32_t m_maxBurst; //!< Max segments sent by one SendPendingData, 0 for no limit
+
   // Resequence buffer
   bool m_resequenceBufferEnabled;   //!< Whether resequence buffer is enabled
   Ptr<TcpResequenceBuffer>  m_resequenceBuffer;     //!< Resequence buffer
 
-  // Flow Bender
-  bool m_flowBenderEnabled;         //!< Whether the flow bender is enabled
-  Ptr<TcpFlowBender>        m_flowBender;           //!< Flow Bender
-
-  // TLB Support
-  bool                      m_TLBEnabled;
-
-  bool                      m_TLBSendSide;
-  bool                      m_piggybackTLBInfo;
-  Time                      m_onewayRtt;
-  uint32_t                  m_TLBPath;
-
-  uint32_t                  m_pathAcked;
-
-  bool                      m_TLBReverseAckEnabled;
-
-  // Clove Support
-  bool                      m_CloveEnabled;
-  bool                      m_CloveSendSide;
-  bool                      m_piggybackCloveInfo;
-  uint32_t                  m_ClovePath;
+  // Host path selection
+  bool                      m_flowBenderEnabled;    //!< Whether the flow bender is enabled
+  bool                      m_TLBEnabled;           //!< Whether the TLB is enabled
+  bool                      m_TLBReverseAckEnabled; //!< Whether the TLB receiver picks the ACK path
+  bool                      m_CloveEnabled;         //!< Whether the Clove is enabled
+  TypeId                    m_pathSelectorTypeId;   //!< Another selector, if not the base type
+  std::vector<Ptr<HostPathSelector> > m_pathSelectors; //!< Bound to the connection
 
   // Pause Support
   bool                      m_isPauseEnabled;
@@ -57,7 +57,7 @@ TcpTxBuffer::GetTypeId (void)
  * initialized below is insignificant.
  */
 TcpTxBuffer::TcpTxBuffer (uint32_t n)
-  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_data (0)
+  : m_firstByteSeq (n), m_size (0), m_maxBuffer (32768), m_headOffset (0), m_lastSegment (0)
 {
 }
 
@@ -111,7 +111,10 @@ TcpTxBuffer::Add (Ptr<Packet> p)
     {
       if (p->GetSize () > 0)
         {
-          m_data.push_back (p);
+          Segment segment;
+          segment.offset = m_headOffset + m_size;
+          segment.packet = p;
+          m_data.push_back (segment);
           m_size += p->GetSize ();
           NS_LOG_LOGIC ("Updated size=" << m_size << ", lastSeq=" << m_firstByteSeq + SequenceNumber32 (m_size));
         }
@@ -133,6 +136,36 @@ TcpTxBuffer::SizeFromSequence (const SequenceNumber32& seq) const
   return lastSeq - seq;
 }
 
+uint32_t
+TcpTxBuffer::FindSegment (uint32_t offset) const
+{
+  NS_ASSERT (offset < m_size);
+  uint32_t i = m_lastSegment;
+  if (i >= m_data.size () || m_data[i].offset - m_headOffset > offset)
+    { // Not after the last copy, look for the last packet starting before the byte
+      uint32_t low = 0;
+      uint32_t high = m_data.size ();
+      while (high - low > 1)
+        {
+          uint32_t middle = low + (high - low) / 2;
+          if (m_data[middle].offset - m_headOffset <= offset)
+            {
+              low = middle;
+            }
+          else
+            {
+              high = middle;
+            }
+        }
+      return low;
+    }
+  while (m_data[i].offset - m_headOffset + m_data[i].packet->GetSize () <= offset)
+    {
+      ++i;
+    }
+  return i;
+}
+
 Ptr<Packet>
 TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 {
@@ -149,54 +182,41 @@ TcpTxBuffer::CopyFromSequence (uint32_t numBytes, const SequenceNumber32& seq)
 
   // Extract data from the buffer and return
   uint32_t offset = seq - m_firstByteSeq.Get ();
-  uint32_t count = 0;      // Offset of the first byte of a packet in the buffer
-  uint32_t pktSize = 0;
-  bool beginFound = false;
-  int pktCount = 0;
-  Ptr<Packet> outPacket;
-  NS_LOG_LOGIC ("There are " << m_data.size () << " number of packets in buffer");
-  for (BufIterator i = m_data.begin (); i != m_data.end (); ++i)
+  uint32_t i = FindSegment (offset);
+  uint32_t count = m_data[i].offset - m_headOffset; // Offset of the first byte of a packet in the buffer
+  uint32_t pktSize = m_data[i].packet->GetSize ();
+  uint32_t packetOffset = offset - count;
+  uint32_t fragmentLength = pktSize - packetOffset;
+  NS_LOG_LOGIC ("First byte found in packet #" << i << " at buffer offset " << count
+                                               << ", packet len=" << pktSize);
+  if (fragmentLength >= s)
+    { // Data to be copied falls entirely in this packet
+      m_lastSegment = i;
+      return m_data[i].packet->CreateFragment (packetOffset, s);
+    }
+  // This packet only fulfills part of the request
+  Ptr<Packet> outPacket = m_data[i].packet->CreateFragment (packetOffset, fragmentLength);
+  uint32_t remaining = s - fragmentLength;
+  while (remaining > 0)
     {
-      pktCount++;
-      pktSize = (*i)->GetSize ();
-      if (!beginFound)
-        { // Look for first fragment
-          if (count + pktSize > offset)
-            {
-              NS_LOG_LOGIC ("First byte found in packet #" << pktCount << " at buffer offset " << count
-                                                           << ", packet len=" << pktSize);
-              beginFound = true;
-              uint32_t packetOffset = offset - count;
-              uint32_t fragmentLength = count + pktSize - offset;
-              if (fragmentLength >= s)
-                { // Data to be copied falls entirely in this packet
-                  return (*i)->CreateFragment (packetOffset, s);
-                }
-              else
-                { // This packet only fulfills part of the request
-                  outPacket = (*i)->CreateFragment (packetOffset, fragmentLength);
-                }
-              NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-            }
-        }
-      else if (count + pktSize >= offset + s)
+      ++i;
+      NS_ASSERT (i < m_data.size ());
+      pktSize = m_data[i].packet->GetSize ();
+      if (pktSize >= remaining)
         { // Last packet fragment found
-          NS_LOG_LOGIC ("Last byte found in packet #" << pktCount << " at buffer offset " << count
-                                                      << ", packet len=" << pktSize);
-          uint32_t fragmentLength = offset + s - count;
-          Ptr<Packet> endFragment = (*i)->CreateFragment (0, fragmentLength);
-          outPacket->AddAtEnd (endFragment);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
-          break;
+          NS_LOG_LOGIC ("Last byte found in packet #" << i << ", packet len=" << pktSize);
+          outPacket->AddAtEnd (m_data[i].packet->CreateFragment (0, remaining));
+          remaining = 0;
         }
       else
         {
-          NS_LOG_LOGIC ("Appending to output the packet #" << pktCount << " of offset " << count << " len=" << pktSize);
-          outPacket->AddAtEnd (*i);
-          NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
+          NS_LOG_LOGIC ("Appending to output the packet #" << i << " len=" << pktSize);
+          outPacket->AddAtEnd (m_data[i].packet);
+          remaining -= pktSize;
         }
-      count += pktSize;
+      NS_LOG_LOGIC ("Output packet is now of size " << outPacket->GetSize ());
     }
+  m_lastSegment = i;
   NS_ASSERT (outPacket->GetSize () == s);
   return outPacket;
 }
@@ -217,29 +237,31 @@ TcpTxBuffer::DiscardUpTo (const SequenceNumber32& seq)
   // Cases do not need to scan the buffer
   if (m_firstByteSeq >= seq) return;
 
-  // Scan the buffer and discard packets
+  // Release the packets from the front of the buffer
   uint32_t offset = seq - m_firstByteSeq.Get ();  // Number of bytes to remove
   uint32_t pktSize;
   NS_LOG_LOGIC ("Offset=" << offset);
-  BufIterator i = m_data.begin ();
-  while (i != m_data.end ())
+  while (offset > 0 && !m_data.empty ())
     {
-      if (offset > (*i)->GetSize ())
+      pktSize = m_data.front ().packet->GetSize ();
+      if (offset >= pktSize)
         { // This packet is behind the seqnum. Remove this packet from the buffer
-          pktSize = (*i)->GetSize ();
           m_size -= pktSize;
           offset -= pktSize;
           m_firstByteSeq += pktSize;
-          i = m_data.erase (i);
+          m_headOffset += pktSize;
+          m_data.pop_front ();
+          m_lastSegment = m_lastSegment > 0 ? m_lastSegment - 1 : 0;
           NS_LOG_LOGIC ("Removed one packet of size " << pktSize << ", offset=" << offset);
         }
-      else if (offset > 0)
+      else
         { // Part of the packet is behind the seqnum. Fragment
-          pktSize = (*i)->GetSize () - offset;
-          *i = (*i)->CreateFragment (offset, pktSize);
+          m_data.front ().packet = m_data.front ().packet->CreateFragment (offset, pktSize - offset);
           m_size -= offset;
           m_firstByteSeq += offset;
-          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize);
+          m_headOffset += offset;
+          m_data.front ().offset = m_headOffset;
+          NS_LOG_LOGIC ("Fragmented one packet by size " << offset << ", new size=" << pktSize - offset);
           break;
         }
     }
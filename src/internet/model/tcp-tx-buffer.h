@@ -21,7 +21,7 @@
 #ifndef TCP_TX_BUFFER_H
 #define TCP_TX_BUFFER_H
 
-#include <list>
+#include <deque>
 #include "ns3/traced-value.h"
 #include "ns3/trace-source-accessor.h"
 #include "ns3/object.h"
@@ -36,6 +36,11 @@ class Packet;
  *
  * \brief class for keeping the data sent by the application to the TCP socket, i.e.
  *        the sending buffer.
+ *
+ * The packets of the application are kept as they are, in a double ended
+ * queue indexed by their offset: the ACKs release them from the front and
+ * the application appends to the back, both in constant time. The segments
+ * are fragments of these packets, which share their data.
  */
 class TcpTxBuffer : public Object
 {
@@ -128,13 +133,35 @@ public:
   void DiscardUpTo (const SequenceNumber32& seq);
 
 private:
-  /// container for data stored in the buffer
-  typedef std::list<Ptr<Packet> >::iterator BufIterator;
+  /**
+   * \brief A packet of the application in the buffer
+   *
+   * The offset counts the bytes added before the packet since the buffer
+   * was created, so that it does not depend on the head sequence number.
+   */
+  struct Segment
+  {
+    uint32_t offset;     //!< Bytes added before this packet, modulo 2^32
+    Ptr<Packet> packet;  //!< The data
+  };
+
+  /**
+   * \brief Find the packet holding a byte of the buffer
+   *
+   * Starting from the packet of the last copy, a transmission in sequence
+   * finds its packet in constant time, other ones by a binary search.
+   *
+   * \param offset the offset of the byte from the head of the buffer
+   * \returns the index of the packet in m_data
+   */
+  uint32_t FindSegment (uint32_t offset) const;
 
   TracedValue<SequenceNumber32> m_firstByteSeq; //!< Sequence number of the first byte in data (SND.UNA)
   uint32_t m_size;                              //!< Number of data bytes
   uint32_t m_maxBuffer;                         //!< Max number of data bytes in buffer (SND.WND)
-  std::list<Ptr<Packet> > m_data;               //!< Corresponding data (may be null)
+  uint32_t m_headOffset;                        //!< Offset of the first byte in data
+  std::deque<Segment> m_data;                   //!< Corresponding data, the oldest first
+  uint32_t m_lastSegment;                       //!< Index of the packet where the last copy ended
 };
 
 } // namepsace ns3
@@ -0,0 +1,387 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/host-path-selector.h"
+#include "ns3/tcp-header.h"
+#include "ns3/ipv4-xpath-tag.h"
+#include "ns3/ipv4-tlb.h"
+#include "ns3/tcp-tlb-tag.h"
+#include "ns3/ipv4-clove.h"
+#include "ns3/tcp-clove-tag.h"
+#include "tcp-general-test.h"
+
+using namespace ns3;
+
+/**
+ * Test that the base selector leaves the segments alone, and that the
+ * FlowBender one moves the flow id once the ACKs carry congestion marks
+ */
+
+class HostPathSelectorTestCase : public TestCase
+{
+public:
+  HostPathSelectorTestCase ();
+  virtual ~HostPathSelectorTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  void PathChosen (Ptr<HostPathSelector> selector, uint32_t path);
+
+  uint32_t m_paths;
+  uint32_t m_lastPath;
+};
+
+HostPathSelectorTestCase::HostPathSelectorTestCase ()
+  : TestCase ("Test the hooks of the host path selectors"),
+    m_paths (0),
+    m_lastPath (0)
+{
+}
+
+HostPathSelectorTestCase::~HostPathSelectorTestCase ()
+{
+}
+
+void
+HostPathSelectorTestCase::PathChosen (Ptr<HostPathSelector> selector, uint32_t path)
+{
+  m_paths++;
+  m_lastPath = path;
+}
+
+void HostPathSelectorTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer ("10.0.0.2");
+
+  Ptr<HostPathSelector> base = CreateObject<HostPathSelector> ();
+  base->SetPathCallback (MakeCallback (&HostPathSelectorTestCase::PathChosen, this));
+  base->Bind (node, 100, local, peer, true);
+  Ptr<Packet> p = Create<Packet> (1000);
+  base->OnSend (p, TcpHeader::ACK, true, false);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 1000, "The base selector should not change the segment");
+  NS_TEST_ASSERT_MSG_EQ (base->MapFlowId (100), 100, "The base selector should keep the flow id");
+  NS_TEST_ASSERT_MSG_EQ (m_paths, 0, "The base selector should not report any path");
+
+  Ptr<HostPathSelector> flowBender = CreateObject<FlowBenderPathSelector> ();
+  flowBender->SetPathCallback (MakeCallback (&HostPathSelectorTestCase::PathChosen, this));
+  flowBender->Bind (node, 100, local, peer, true);
+  NS_TEST_ASSERT_MSG_EQ (flowBender->MapFlowId (100), 101, "FlowBender should start on its first path");
+  NS_TEST_ASSERT_MSG_EQ (m_paths, 1, "FlowBender should report the path of each segment");
+  NS_TEST_ASSERT_MSG_EQ (m_lastPath, 1, "FlowBender reported a wrong path");
+
+  // One RTT without marks keeps the path, one fully marked moves the flow
+  flowBender->OnAckProcessed (SequenceNumber32 (1000), SequenceNumber32 (0), 1000, false);
+  NS_TEST_ASSERT_MSG_EQ (flowBender->MapFlowId (100), 101, "FlowBender should not move without marks");
+  flowBender->OnAckProcessed (SequenceNumber32 (2000), SequenceNumber32 (1000), 1000, true);
+  NS_TEST_ASSERT_MSG_EQ (flowBender->MapFlowId (100), 102, "FlowBender should move a congested flow");
+  NS_TEST_ASSERT_MSG_EQ (m_lastPath, 2, "FlowBender reported a wrong path");
+  NS_TEST_ASSERT_MSG_EQ ((flowBender->GetPauseTime () > Seconds (0)), true, "FlowBender should pause on a move");
+
+  flowBender->Dispose ();
+  base->Dispose ();
+  node->Dispose ();
+}
+
+/**
+ * Test that the TLB and Clove selectors tag the segments of the sender with
+ * the path of their node, and that the receiver echoes it in its ACKs
+ */
+
+class EdgePathSelectorTestCase : public TestCase
+{
+public:
+  EdgePathSelectorTestCase (bool clove);
+  virtual ~EdgePathSelectorTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  void PathChosen (Ptr<HostPathSelector> selector, uint32_t path);
+
+  /**
+   * \param packet the packet
+   * \return the path echoed in the packet, 0 if none
+   */
+  uint32_t GetEchoedPath (Ptr<const Packet> packet);
+
+  bool m_clove;
+  uint32_t m_paths;
+  uint32_t m_lastPath;
+};
+
+EdgePathSelectorTestCase::EdgePathSelectorTestCase (bool clove)
+  : TestCase (clove ? "Test the Clove path selector" : "Test the TLB path selector"),
+    m_clove (clove),
+    m_paths (0),
+    m_lastPath (0)
+{
+}
+
+EdgePathSelectorTestCase::~EdgePathSelectorTestCase ()
+{
+}
+
+void
+EdgePathSelectorTestCase::PathChosen (Ptr<HostPathSelector> selector, uint32_t path)
+{
+  m_paths++;
+  m_lastPath = path;
+}
+
+uint32_t
+EdgePathSelectorTestCase::GetEchoedPath (Ptr<const Packet> packet)
+{
+  if (m_clove)
+    {
+      TcpCloveTag tag;
+      return tag.PeekFrom (packet) ? tag.GetPath () : 0;
+    }
+  TcpTLBTag tag;
+  return tag.PeekFrom (packet) ? tag.GetPath () : 0;
+}
+
+void
+EdgePathSelectorTestCase::DoRun (void)
+{
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer ("10.0.1.1");
+  uint32_t path = 7;
+
+  // The sender in rack 1 has one path to the rack 2 of the receiver
+  NodeContainer nodes;
+  nodes.Create (2);
+  for (uint32_t i = 0; i < 2; i++)
+    {
+      if (m_clove)
+        {
+          Ptr<Ipv4Clove> clove = CreateObject<Ipv4Clove> ();
+          clove->AddAddressWithTor (local, 1);
+          clove->AddAddressWithTor (peer, 2);
+          clove->AddAvailPath (2 - i, path);
+          nodes.Get (i)->AggregateObject (clove);
+        }
+      else
+        {
+          Ptr<Ipv4TLB> tlb = CreateObject<Ipv4TLB> ();
+          tlb->AddAddressWithTor (local, 1);
+          tlb->AddAddressWithTor (peer, 2);
+          tlb->AddAvailPath (2 - i, path);
+          nodes.Get (i)->AggregateObject (tlb);
+        }
+    }
+
+  Ptr<HostPathSelector> sender;
+  Ptr<HostPathSelector> receiver;
+  if (m_clove)
+    {
+      sender = CreateObject<ClovePathSelector> ();
+      receiver = CreateObject<ClovePathSelector> ();
+    }
+  else
+    {
+      sender = CreateObject<TlbPathSelector> ();
+      receiver = CreateObject<TlbPathSelector> ();
+    }
+  sender->SetPathCallback (MakeCallback (&EdgePathSelectorTestCase::PathChosen, this));
+  receiver->SetPathCallback (MakeCallback (&EdgePathSelectorTestCase::PathChosen, this));
+  sender->Bind (nodes.Get (0), 100, local, peer, true);
+  receiver->Bind (nodes.Get (1), 100, peer, local, false);
+
+  Ptr<Packet> data = Create<Packet> (1000);
+  sender->OnSend (data, TcpHeader::ACK, true, false);
+  Ipv4XPathTag xpathTag;
+  NS_TEST_ASSERT_MSG_EQ (xpathTag.PeekFrom (data), true, "The sender should route the segment");
+  NS_TEST_ASSERT_MSG_EQ (xpathTag.GetPathId (), path, "The sender should take the path of its node");
+  NS_TEST_ASSERT_MSG_EQ (GetEchoedPath (data), path, "The sender should tell the path to the receiver");
+  // Only TLB pauses the socket on a path change
+  uint32_t reported = m_clove ? 0 : 1;
+  NS_TEST_ASSERT_MSG_EQ (m_paths, reported, "TLB should report the path of each segment");
+  uint32_t reportedPath = m_clove ? 0 : path;
+  NS_TEST_ASSERT_MSG_EQ (m_lastPath, reportedPath, "The sender reported a wrong path");
+  NS_TEST_ASSERT_MSG_EQ (sender->MapFlowId (100), 100, "The flow id should not change");
+
+  // The receiver echoes the path on its ACKs only
+  receiver->OnReceive (data);
+  NS_TEST_ASSERT_MSG_EQ (GetEchoedPath (data), 0, "The receiver should consume the path");
+  Ptr<Packet> reply = Create<Packet> (100);
+  receiver->OnSend (reply, TcpHeader::ACK, true, false);
+  NS_TEST_ASSERT_MSG_EQ (GetEchoedPath (reply), 0, "The receiver should not echo on data");
+  Ptr<Packet> ack = Create<Packet> ();
+  receiver->OnSend (ack, TcpHeader::ACK, false, false);
+  NS_TEST_ASSERT_MSG_EQ (GetEchoedPath (ack), path, "The receiver should echo the path on its ACKs");
+  NS_TEST_ASSERT_MSG_EQ (xpathTag.PeekFrom (ack), false, "The receiver should not route its ACKs");
+  NS_TEST_ASSERT_MSG_EQ (m_paths, reported, "The receiver should not report any path");
+
+  sender->OnAck (ack, 1000, false);
+  NS_TEST_ASSERT_MSG_EQ (GetEchoedPath (ack), 0, "The sender should consume the echoed path");
+  NS_TEST_ASSERT_MSG_EQ (sender->GetPauseTime (), Seconds (0), "No pause without a path change");
+
+  sender->Dispose ();
+  receiver->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * A selector counting the calls of the sockets, with the path of all the
+ * segments of the sender
+ */
+
+class CountingPathSelector : public HostPathSelector
+{
+public:
+  static TypeId GetTypeId (void);
+
+  virtual void Bind (Ptr<Node> node, uint32_t flowId,
+                     Ipv4Address local, Ipv4Address peer, bool sendSide)
+  {
+    HostPathSelector::Bind (node, flowId, local, peer, sendSide);
+    (sendSide ? s_senderBinds : s_receiverBinds)++;
+  }
+
+  virtual void OnSend (Ptr<Packet> packet, uint8_t flags, bool hasData, bool isRetransmission)
+  {
+    if (m_sendSide && hasData)
+      {
+        s_dataSent++;
+        NotifyPath (3);
+      }
+  }
+
+  virtual void OnAck (Ptr<Packet> packet, uint32_t bytesAcked, bool withECE)
+  {
+    if (m_sendSide)
+      {
+        s_acks++;
+      }
+  }
+
+  virtual void OnReceive (Ptr<Packet> packet)
+  {
+    if (!m_sendSide)
+      {
+        s_dataReceived++;
+      }
+  }
+
+  static uint32_t s_senderBinds;
+  static uint32_t s_receiverBinds;
+  static uint32_t s_dataSent;
+  static uint32_t s_acks;
+  static uint32_t s_dataReceived;
+};
+
+uint32_t CountingPathSelector::s_senderBinds = 0;
+uint32_t CountingPathSelector::s_receiverBinds = 0;
+uint32_t CountingPathSelector::s_dataSent = 0;
+uint32_t CountingPathSelector::s_acks = 0;
+uint32_t CountingPathSelector::s_dataReceived = 0;
+
+TypeId
+CountingPathSelector::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::CountingPathSelector")
+    .SetParent<HostPathSelector> ()
+    .SetGroupName ("Internet")
+    .AddConstructor<CountingPathSelector> ()
+  ;
+  return tid;
+}
+
+/**
+ * Test that the sockets of a connection bind the selector of their
+ * PathSelector attribute, and call it for each segment
+ */
+
+class PathSelectorSocketTestCase : public TcpGeneralTest
+{
+public:
+  PathSelectorSocketTestCase ();
+
+protected:
+  virtual Ptr<TcpSocketMsgBase> CreateSenderSocket (Ptr<Node> node);
+  virtual Ptr<TcpSocketMsgBase> CreateReceiverSocket (Ptr<Node> node);
+  virtual void ConfigureEnvironment (void);
+  virtual void FinalChecks (void);
+};
+
+PathSelectorSocketTestCase::PathSelectorSocketTestCase ()
+  : TcpGeneralTest ("Test the calls of TcpSocketBase to its path selector")
+{
+}
+
+void
+PathSelectorSocketTestCase::ConfigureEnvironment (void)
+{
+  TcpGeneralTest::ConfigureEnvironment ();
+  SetAppPktCount (10);
+  CountingPathSelector::s_senderBinds = 0;
+  CountingPathSelector::s_receiverBinds = 0;
+  CountingPathSelector::s_dataSent = 0;
+  CountingPathSelector::s_acks = 0;
+  CountingPathSelector::s_dataReceived = 0;
+}
+
+Ptr<TcpSocketMsgBase>
+PathSelectorSocketTestCase::CreateSenderSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateSenderSocket (node);
+  socket->SetAttribute ("PathSelector", TypeIdValue (CountingPathSelector::GetTypeId ()));
+  return socket;
+}
+
+Ptr<TcpSocketMsgBase>
+PathSelectorSocketTestCase::CreateReceiverSocket (Ptr<Node> node)
+{
+  Ptr<TcpSocketMsgBase> socket = TcpGeneralTest::CreateReceiverSocket (node);
+  socket->SetAttribute ("PathSelector", TypeIdValue (CountingPathSelector::GetTypeId ()));
+  return socket;
+}
+
+void
+PathSelectorSocketTestCase::FinalChecks (void)
+{
+  NS_TEST_ASSERT_MSG_EQ (CountingPathSelector::s_senderBinds, 1, "The sender should bind its selector once");
+  NS_TEST_ASSERT_MSG_EQ (CountingPathSelector::s_receiverBinds, 1, "The forked socket should bind its selector once");
+  NS_TEST_ASSERT_MSG_EQ (CountingPathSelector::s_dataSent, GetPktCount (), "The selector should see each data segment sent");
+  NS_TEST_ASSERT_MSG_EQ (CountingPathSelector::s_dataReceived, GetPktCount (), "The selector should see each data segment received");
+  NS_TEST_ASSERT_MSG_GT (CountingPathSelector::s_acks, 0, "The selector should see the ACKs");
+}
+
+class HostPathSelectorTestSuite : public TestSuite
+{
+public:
+  HostPathSelectorTestSuite ();
+};
+
+HostPathSelectorTestSuite::HostPathSelectorTestSuite ()
+  : TestSuite ("host-path-selector", UNIT)
+{
+  // First, the TCP test enables the packet printing before any packet exists
+  AddTestCase (new PathSelectorSocketTestCase, TestCase::QUICK);
+  AddTestCase (new HostPathSelectorTestCase, TestCase::QUICK);
+  AddTestCase (new EdgePathSelectorTestCase (false), TestCase::QUICK);
+  AddTestCase (new EdgePathSelectorTestCase (true), TestCase::QUICK);
+}
+
+static HostPathSelectorTestSuite hostPathSelectorTestSuite;
@@ -0,0 +1,117 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/ipv4-interface.h"
+#include "../model/ipv4-end-point.h"
+#include "../model/ipv4-end-point-demux.h"
+
+using namespace ns3;
+
+/**
+ * Test that the demux returns the most exact endpoints, as the endpoints
+ * are allocated, connected and removed
+ */
+
+class Ipv4EndPointDemuxTestCase : public TestCase
+{
+public:
+  Ipv4EndPointDemuxTestCase ();
+  virtual ~Ipv4EndPointDemuxTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+};
+
+Ipv4EndPointDemuxTestCase::Ipv4EndPointDemuxTestCase ()
+  : TestCase ("Test the priority of the matches of the IPv4 endpoint demux")
+{
+}
+
+Ipv4EndPointDemuxTestCase::~Ipv4EndPointDemuxTestCase ()
+{
+}
+
+void Ipv4EndPointDemuxTestCase::DoRun (void)
+{
+  Ptr<Ipv4Interface> interface = CreateObject<Ipv4Interface> ();
+  interface->AddAddress (Ipv4InterfaceAddress ("10.0.0.1", "255.255.255.0"));
+
+  Ipv4Address local ("10.0.0.1");
+  Ipv4Address peer ("10.0.0.2");
+  Ipv4Address other ("10.0.0.3");
+
+  Ipv4EndPointDemux demux;
+  Ipv4EndPoint *wildcard = demux.Allocate (80);
+  Ipv4EndPoint *listening = demux.Allocate (local, 80);
+  Ipv4EndPoint *connected = demux.Allocate (local, 80, peer, 1000);
+  NS_TEST_ASSERT_MSG_EQ ((demux.Allocate (local, 80) == 0), true, "Duplicate address and port");
+  NS_TEST_ASSERT_MSG_EQ ((demux.Allocate (local, 80, peer, 1000) == 0), true, "Duplicate four-tuple");
+
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 80, peer, 1000, interface), connected, "Exact match");
+  Ipv4EndPointDemux::EndPoints endPoints = demux.Lookup (local, 80, peer, 1000, interface);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 1, "Only the exact match");
+  NS_TEST_ASSERT_MSG_EQ (endPoints.front (), connected, "Exact match");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 80, peer, 1001, interface), listening, "Local address and port match");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (Ipv4Address ("10.0.1.1"), 80, peer, 1000, interface), wildcard, "Local port match");
+  NS_TEST_ASSERT_MSG_EQ ((demux.LookupBest (local, 81, peer, 1000, interface) == 0), true, "No match");
+
+  // A broadcast goes to the endpoints of the address of the interface and
+  // to the wildcard ones
+  endPoints = demux.Lookup (Ipv4Address ("10.0.0.255"), 80, peer, 1001, interface);
+  NS_TEST_ASSERT_MSG_EQ (endPoints.size (), 2, "Broadcast matches");
+  NS_TEST_ASSERT_MSG_EQ (endPoints.front (), wildcard, "Broadcast matches in allocation order");
+
+  // Connected after the allocation, with a wildcard local address
+  Ipv4EndPoint *client = demux.Allocate ();
+  client->SetPeer (other, 2000);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, client->GetLocalPort (), other, 2000, interface), client,
+                         "All but local address match");
+  NS_TEST_ASSERT_MSG_EQ ((demux.LookupBest (local, client->GetLocalPort (), other, 2001, interface) == 0), true,
+                         "A connected endpoint only matches its peer");
+  client->SetLocalAddress (local);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, client->GetLocalPort (), other, 2000, interface), client,
+                         "Exact match after the local address is set");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (client->GetLocalPort ()), true, "Allocated ephemeral port");
+
+  connected->SetRxEnabled (false);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 80, peer, 1000, interface), listening,
+                         "Endpoints which cannot receive are skipped");
+
+  demux.DeAllocate (listening);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupBest (local, 80, peer, 1001, interface), wildcard, "Removed endpoint");
+  demux.DeAllocate (wildcard);
+  NS_TEST_ASSERT_MSG_EQ ((demux.LookupBest (local, 80, peer, 1001, interface) == 0), true, "Removed endpoint");
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (80), true, "Port still in use");
+  demux.DeAllocate (connected);
+  NS_TEST_ASSERT_MSG_EQ (demux.LookupPortLocal (80), false, "Port no more in use");
+  NS_TEST_ASSERT_MSG_EQ (demux.GetAllEndPoints ().size (), 1, "Remaining endpoints");
+}
+
+class Ipv4EndPointDemuxTestSuite : public TestSuite
+{
+public:
+  Ipv4EndPointDemuxTestSuite ();
+};
+
+Ipv4EndPointDemuxTestSuite::Ipv4EndPointDemuxTestSuite ()
+  : TestSuite ("ipv4-end-point-demux", UNIT)
+{
+  AddTestCase (new Ipv4EndPointDemuxTestCase, TestCase::QUICK);
+}
+
+static Ipv4EndPointDemuxTestSuite ipv4EndPointDemuxTestSuite;
@@ -15,12 +15,19 @@
  */
 
 #include <vector>
+#include <sstream>
+#include <algorithm>
 #include "ns3/boolean.h"
 #include "ns3/config.h"
 #include "ns3/inet-socket-address.h"
 #include "ns3/internet-stack-helper.h"
 #include "ns3/ipv4-address-helper.h"
 #include "ns3/ipv4-global-routing-helper.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/global-router-interface.h"
+#include "ns3/global-value.h"
+#include "ns3/ipv4-lpm-trie.h"
+#include "ns3/ipv4-route.h"
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/node.h"
 #include "ns3/node-container.h"
@@ -419,6 +426,275 @@ Ipv4GlobalRoutingSlash32TestCase::DoRun (void)
   Simulator::Destroy ();
 }
 
+class Ipv4GlobalRoutingUpdateTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingUpdateTestCase ();
+  virtual ~Ipv4GlobalRoutingUpdateTestCase ();
+
+private:
+  /**
+   * \brief Print the global routes of every node
+   * \param nodes the nodes
+   * \param sorted sort the routes of each node
+   * \returns one string per route
+   */
+  std::vector<std::string> GetRoutes (NodeContainer nodes, bool sorted);
+  virtual void DoRun (void);
+};
+
+Ipv4GlobalRoutingUpdateTestCase::Ipv4GlobalRoutingUpdateTestCase ()
+  : TestCase ("Parallel and incremental global route computation")
+{
+}
+
+Ipv4GlobalRoutingUpdateTestCase::~Ipv4GlobalRoutingUpdateTestCase ()
+{
+}
+
+std::vector<std::string>
+Ipv4GlobalRoutingUpdateTestCase::GetRoutes (NodeContainer nodes, bool sorted)
+{
+  std::vector<std::string> routes;
+  for (uint32_t i = 0; i < nodes.GetN (); i++)
+    {
+      Ptr<Ipv4GlobalRouting> gr = nodes.Get (i)->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+      std::vector<std::string>::size_type first = routes.size ();
+      for (uint32_t j = 0; j < gr->GetNRoutes (); j++)
+        {
+          std::ostringstream oss;
+          oss << i << " " << *gr->GetRoute (j);
+          routes.push_back (oss.str ());
+        }
+      if (sorted)
+        {
+          std::sort (routes.begin () + first, routes.end ());
+        }
+    }
+  return routes;
+}
+
+// Test program for a leaf-spine fabric with one host per leaf
+//
+//          S0    S1       (every leaf is connected to every spine)
+//      L0    L1    L2
+//      |     |     |
+//      H0    H1    H2
+//
+void
+Ipv4GlobalRoutingUpdateTestCase::DoRun (void)
+{
+  UintegerValue threads;
+  GlobalValue::GetValueByName ("GlobalRoutingThreads", threads);
+
+  NodeContainer spines;
+  spines.Create (2);
+  NodeContainer leaves;
+  leaves.Create (3);
+  NodeContainer hosts;
+  hosts.Create (3);
+  NodeContainer all (spines, leaves, hosts);
+
+  InternetStackHelper internet;
+  internet.Install (all);
+
+  SimpleNetDeviceHelper devHelper;
+  devHelper.SetNetDevicePointToPointMode (true);
+  Ipv4AddressHelper ipv4;
+  ipv4.SetBase ("10.1.0.0", "255.255.255.252");
+  NetDeviceContainer failed;
+  for (uint32_t l = 0; l < leaves.GetN (); l++)
+    {
+      ipv4.Assign (devHelper.Install (NodeContainer (leaves.Get (l), hosts.Get (l))));
+      ipv4.NewNetwork ();
+      for (uint32_t s = 0; s < spines.GetN (); s++)
+        {
+          NetDeviceContainer d = devHelper.Install (NodeContainer (leaves.Get (l), spines.Get (s)));
+          ipv4.Assign (d);
+          ipv4.NewNetwork ();
+          if (l == 0 && s == 0)
+            {
+              failed = d;
+            }
+        }
+    }
+
+  // The same routes, in the same order, with one or several threads
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (1));
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+  std::vector<std::string> serial = GetRoutes (all, false);
+  NS_TEST_ASSERT_MSG_NE (serial.size (), 0, "No global routes");
+
+  Config::SetGlobal ("GlobalRoutingThreads", UintegerValue (4));
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  NS_TEST_EXPECT_MSG_EQ ((GetRoutes (all, false) == serial), true, "The parallel computation gave different routes");
+
+  // Take the L0-S0 link down; the update must give the routes of a full recomputation
+  for (uint32_t i = 0; i < failed.GetN (); i++)
+    {
+      Ptr<Ipv4> ip = failed.Get (i)->GetNode ()->GetObject<Ipv4> ();
+      ip->SetDown (ip->GetInterfaceForDevice (failed.Get (i)));
+    }
+  Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+  std::vector<std::string> updated = GetRoutes (all, true);
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::vector<std::string> recomputed = GetRoutes (all, true);
+  NS_TEST_EXPECT_MSG_EQ ((updated == recomputed), true, "The update gave different routes than a full recomputation");
+  NS_TEST_EXPECT_MSG_EQ ((updated == GetRoutes (all, true)), true, "The recomputation is not stable");
+  NS_TEST_EXPECT_MSG_NE (updated.size (), serial.size (), "The failed link did not change the routes");
+
+  // Bring the link back up: this adds links, so it takes the full recomputation path
+  for (uint32_t i = 0; i < failed.GetN (); i++)
+    {
+      Ptr<Ipv4> ip = failed.Get (i)->GetNode ()->GetObject<Ipv4> ();
+      ip->SetUp (ip->GetInterfaceForDevice (failed.Get (i)));
+    }
+  Ipv4GlobalRoutingHelper::UpdateRoutingTables ();
+  NS_TEST_EXPECT_MSG_EQ ((GetRoutes (all, false) == serial), true, "The update after the repair gave different routes");
+
+  Config::SetGlobal ("GlobalRoutingThreads", threads);
+  Simulator::Destroy ();
+}
+
+class Ipv4GlobalRoutingFibTestCase : public TestCase
+{
+public:
+  Ipv4GlobalRoutingFibTestCase ();
+  virtual ~Ipv4GlobalRoutingFibTestCase ();
+
+private:
+  /**
+   * \brief Look up a route
+   * \param dest the destination
+   * \param oif the output device, 0 for any
+   * \returns the gateway, 0.0.0.0 if there is no route
+   */
+  Ipv4Address Lookup (std::string dest, Ptr<NetDevice> oif = 0);
+  /**
+   * \brief ECMP selection callback, records the group size
+   * \returns m_select
+   */
+  uint32_t Select (Ptr<const Packet> packet, const Ipv4Header &header, uint32_t flowId, uint32_t n);
+  virtual void DoRun (void);
+
+  Ptr<Ipv4GlobalRouting> m_routing; //!< the routing protocol under test
+  uint32_t m_select;                //!< the member returned by Select
+  uint32_t m_groupSize;             //!< the group size seen by Select
+};
+
+Ipv4GlobalRoutingFibTestCase::Ipv4GlobalRoutingFibTestCase ()
+  : TestCase ("Compiled forwarding table of global routing"),
+    m_select (0),
+    m_groupSize (0)
+{
+}
+
+Ipv4GlobalRoutingFibTestCase::~Ipv4GlobalRoutingFibTestCase ()
+{
+}
+
+Ipv4Address
+Ipv4GlobalRoutingFibTestCase::Lookup (std::string dest, Ptr<NetDevice> oif)
+{
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address (dest.c_str ()));
+  Socket::SocketErrno sockerr;
+  Ptr<Ipv4Route> route = m_routing->RouteOutput (Create<Packet> (), header, oif, sockerr);
+  return route ? route->GetGateway () : Ipv4Address::GetZero ();
+}
+
+uint32_t
+Ipv4GlobalRoutingFibTestCase::Select (Ptr<const Packet> packet, const Ipv4Header &header, uint32_t flowId, uint32_t n)
+{
+  m_groupSize = n;
+  return m_select;
+}
+
+void
+Ipv4GlobalRoutingFibTestCase::DoRun (void)
+{
+  Ipv4LpmTrie trie;
+  NS_TEST_EXPECT_MSG_EQ (trie.Lookup (Ipv4Address ("10.1.2.3")), 0, "Empty trie");
+  trie.Insert (Ipv4Address ("10.16.0.0"), 12, 1);
+  trie.Insert (Ipv4Address ("10.17.32.0"), 20, 2);
+  trie.Insert (Ipv4Address ("10.17.32.7"), 32, 3);
+  trie.Insert (Ipv4Address ("10.0.0.0"), 8, 4);
+  NS_TEST_EXPECT_MSG_EQ (trie.Lookup (Ipv4Address ("10.31.255.255")), 1, "/12 expanded over its slots");
+  NS_TEST_EXPECT_MSG_EQ (trie.Lookup (Ipv4Address ("10.32.0.0")), 4, "Outside the /12");
+  NS_TEST_EXPECT_MSG_EQ (trie.Lookup (Ipv4Address ("10.17.47.1")), 2, "/20 below the /12");
+  NS_TEST_EXPECT_MSG_EQ (trie.Lookup (Ipv4Address ("10.17.32.7")), 3, "/32");
+  NS_TEST_EXPECT_MSG_EQ (trie.Lookup (Ipv4Address ("10.17.48.1")), 1, "Back to the /12");
+  NS_TEST_EXPECT_MSG_EQ (trie.Lookup (Ipv4Address ("11.0.0.1")), 0, "No route");
+
+  Ptr<Node> node = CreateObject<Node> ();
+  InternetStackHelper internet;
+  internet.Install (node);
+  Ptr<Ipv4> ipv4 = node->GetObject<Ipv4> ();
+  std::vector<Ptr<NetDevice> > devices;
+  for (uint32_t i = 1; i <= 3; i++)
+    {
+      Ptr<SimpleNetDevice> device = CreateObject<SimpleNetDevice> ();
+      device->SetAddress (Mac48Address::Allocate ());
+      node->AddDevice (device);
+      devices.push_back (device);
+      int32_t ifIndex = ipv4->AddInterface (device);
+      std::ostringstream address;
+      address << "10.0." << i << ".1";
+      ipv4->AddAddress (ifIndex, Ipv4InterfaceAddress (Ipv4Address (address.str ().c_str ()), Ipv4Mask ("/24")));
+      ipv4->SetUp (ifIndex);
+    }
+  m_routing = node->GetObject<GlobalRouter> ()->GetRoutingProtocol ();
+
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.0.0"), Ipv4Mask ("/16"), Ipv4Address ("10.0.1.2"), 1);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.2.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.2.2"), 2);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.2.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.3.2"), 3);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.2.3"), Ipv4Mask ("/32"), Ipv4Address ("10.0.3.2"), 3);
+  m_routing->AddHostRouteTo (Ipv4Address ("10.1.2.3"), Ipv4Address ("10.0.1.2"), 1);
+  m_routing->AddNetworkRouteTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("/0"), Ipv4Address ("10.0.3.2"), 3);
+
+  // Longest prefix match, first member of the group by default
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.5.5"), Ipv4Address ("10.0.1.2"), "/16 route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.2.9"), Ipv4Address ("10.0.2.2"), "/24 route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.2.3"), Ipv4Address ("10.0.1.2"), "Host route before the /32 network route");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("192.168.0.1"), Ipv4Address ("10.0.3.2"), "Default route");
+
+  // The routes are built once
+  Ipv4Header header;
+  header.SetDestination (Ipv4Address ("10.1.2.9"));
+  Socket::SocketErrno sockerr;
+  NS_TEST_EXPECT_MSG_EQ (m_routing->RouteOutput (0, header, 0, sockerr),
+                         m_routing->RouteOutput (0, header, 0, sockerr), "The route is not cached");
+
+  // Selection callback and weights
+  m_routing->SetEcmpSelectCallback (MakeCallback (&Ipv4GlobalRoutingFibTestCase::Select, this));
+  m_select = 1;
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.2.9"), Ipv4Address ("10.0.3.2"), "Second member of the /24 group");
+  NS_TEST_EXPECT_MSG_EQ (m_groupSize, 2, "Two members in the /24 group");
+  m_routing->SetEcmpWeight (2, 3);
+  m_select = 2;
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.2.9"), Ipv4Address ("10.0.2.2"), "Interface 2 repeated by its weight");
+  NS_TEST_EXPECT_MSG_EQ (m_groupSize, 4, "Weights 3 and 1");
+  m_routing->SetEcmpWeight (2, 0);
+  m_select = 0;
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.2.9"), Ipv4Address ("10.0.3.2"), "Interface 2 removed by a zero weight");
+  NS_TEST_EXPECT_MSG_EQ (m_groupSize, 1, "Weights 0 and 1");
+  m_routing->SetEcmpWeight (2, 1);
+  m_routing->SetEcmpSelectCallback (Ipv4GlobalRouting::EcmpSelectCallback ());
+
+  // Routes restricted to an output device
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.5.5", devices[2]), Ipv4Address ("10.0.3.2"), "Default route through interface 3");
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.2.9", devices[2]), Ipv4Address ("10.0.3.2"), "/24 route through interface 3");
+
+  // Adding a route recompiles the table
+  m_routing->AddNetworkRouteTo (Ipv4Address ("10.1.5.0"), Ipv4Mask ("/24"), Ipv4Address ("10.0.2.2"), 2);
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("10.1.5.5"), Ipv4Address ("10.0.2.2"), "New /24 route");
+  m_routing->RemoveNetworkRoutesTo (Ipv4Address ("0.0.0.0"), Ipv4Mask ("/0"));
+  NS_TEST_EXPECT_MSG_EQ (Lookup ("192.168.0.1"), Ipv4Address::GetZero (), "Default route removed");
+
+  m_routing = 0;
+  Simulator::Destroy ();
+}
+
 
 class Ipv4GlobalRoutingTestSuite : public TestSuite
 {
@@ -431,6 +707,8 @@ Ipv4GlobalRoutingTestSuite::Ipv4GlobalRoutingTestSuite ()
 {
   AddTestCase (new Ipv4DynamicGlobalRoutingTestCase, TestCase::QUICK);
   AddTestCase (new Ipv4GlobalRoutingSlash32TestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingUpdateTestCase, TestCase::QUICK);
+  AddTestCase (new Ipv4GlobalRoutingFibTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
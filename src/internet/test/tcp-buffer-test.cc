@@ -0,0 +1,230 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/packet.h"
+#include "ns3/tcp-tx-buffer.h"
+#include "ns3/tcp-rx-buffer.h"
+#include "ns3/tcp-header.h"
+
+#include <vector>
+
+using namespace ns3;
+
+static const uint32_t DATA_SIZE = 1000;
+
+static std::vector<uint8_t>
+MakeData (void)
+{
+  std::vector<uint8_t> data (DATA_SIZE);
+  for (uint32_t i = 0; i < DATA_SIZE; i++)
+    {
+      data[i] = i % 251;
+    }
+  return data;
+}
+
+// Whether the packet holds the bytes of the data from the offset
+static bool
+HasData (Ptr<Packet> p, const std::vector<uint8_t> &data, uint32_t offset)
+{
+  std::vector<uint8_t> copy (p->GetSize ());
+  if (copy.empty ())
+    {
+      return true;
+    }
+  p->CopyData (&copy[0], copy.size ());
+  for (uint32_t i = 0; i < copy.size (); i++)
+    {
+      if (copy[i] != data[offset + i])
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+/**
+ * Test that the segments copied from a TcpTxBuffer hold the data of the
+ * application, in sequence, on retransmissions and after ACKs
+ */
+
+class TcpTxBufferTestCase : public TestCase
+{
+public:
+  TcpTxBufferTestCase ();
+  virtual ~TcpTxBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+};
+
+TcpTxBufferTestCase::TcpTxBufferTestCase ()
+  : TestCase ("Test the data of the segments of the TcpTxBuffer")
+{
+}
+
+TcpTxBufferTestCase::~TcpTxBufferTestCase ()
+{
+}
+
+void TcpTxBufferTestCase::DoRun (void)
+{
+  std::vector<uint8_t> data = MakeData ();
+  SequenceNumber32 head (4294966800U); // Wraps around in the buffer
+  Ptr<TcpTxBuffer> buffer = CreateObject<TcpTxBuffer> ();
+  buffer->SetMaxBufferSize (DATA_SIZE);
+  buffer->SetHeadSequence (head);
+
+  // Packets of the application of 1 to 199 bytes
+  uint32_t added = 0;
+  for (uint32_t size = 1; added + size <= DATA_SIZE; size = (size * 7) % 199 + 1)
+    {
+      NS_TEST_ASSERT_MSG_EQ (buffer->Add (Create<Packet> (&data[added], size)), true, "The packet should fit");
+      added += size;
+    }
+  NS_TEST_ASSERT_MSG_EQ (buffer->Add (Create<Packet> (DATA_SIZE)), false, "The buffer should be full");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), added, "Wrong size of the buffer");
+  NS_TEST_ASSERT_MSG_EQ (buffer->TailSequence (), head + added, "Wrong tail of the buffer");
+
+  // Segments in sequence, then again from the head and from the middle
+  uint32_t starts[] = { 0, 0, added / 2 };
+  for (uint32_t k = 0; k < 3; k++)
+    {
+      for (uint32_t offset = starts[k]; offset < added; offset += 97)
+        {
+          Ptr<Packet> p = buffer->CopyFromSequence (97, head + offset);
+          NS_TEST_ASSERT_MSG_EQ (p->GetSize (), std::min (97U, added - offset), "Wrong size of the segment");
+          NS_TEST_ASSERT_MSG_EQ (HasData (p, data, offset), true, "Wrong data in the segment at " << offset);
+        }
+    }
+
+  // ACKs in the middle of the packets
+  uint32_t acked = 0;
+  for (uint32_t step = 1; acked + step < added; step += 41)
+    {
+      acked += step;
+      buffer->DiscardUpTo (head + acked);
+      NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), head + acked, "Wrong head after an ACK");
+      NS_TEST_ASSERT_MSG_EQ (buffer->Size (), added - acked, "Wrong size after an ACK");
+      Ptr<Packet> p = buffer->CopyFromSequence (150, head + acked);
+      NS_TEST_ASSERT_MSG_EQ (HasData (p, data, acked), true, "Wrong data after an ACK at " << acked);
+    }
+
+  // The ACK of a FIN empties the buffer
+  buffer->DiscardUpTo (head + added + 1);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 0, "The buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (buffer->HeadSequence (), head + added + 1, "Wrong head after a FIN");
+}
+
+/**
+ * Test that a TcpRxBuffer delivers the data in sequence whatever the order
+ * and the overlaps of the segments
+ */
+
+class TcpRxBufferTestCase : public TestCase
+{
+public:
+  TcpRxBufferTestCase ();
+  virtual ~TcpRxBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  bool AddSegment (Ptr<TcpRxBuffer> buffer, uint32_t offset, uint32_t size);
+
+  std::vector<uint8_t> m_data;
+  SequenceNumber32 m_head;
+};
+
+TcpRxBufferTestCase::TcpRxBufferTestCase ()
+  : TestCase ("Test the reordering of the TcpRxBuffer"),
+    m_data (MakeData ()),
+    m_head (4294967000U)
+{
+}
+
+TcpRxBufferTestCase::~TcpRxBufferTestCase ()
+{
+}
+
+bool
+TcpRxBufferTestCase::AddSegment (Ptr<TcpRxBuffer> buffer, uint32_t offset, uint32_t size)
+{
+  TcpHeader header;
+  header.SetSequenceNumber (m_head + offset);
+  return buffer->Add (Create<Packet> (&m_data[offset], size), header);
+}
+
+void TcpRxBufferTestCase::DoRun (void)
+{
+  Ptr<TcpRxBuffer> buffer = CreateObject<TcpRxBuffer> ();
+  buffer->SetMaxBufferSize (DATA_SIZE);
+  buffer->SetNextRxSequence (m_head);
+
+  // Segments of 100 bytes, the first one late, with a duplicate, an
+  // overlapping one and one covering another
+  AddSegment (buffer, 300, 100);
+  AddSegment (buffer, 500, 100);
+  AddSegment (buffer, 700, 100);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 0, "No data should be in sequence");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 300, "Wrong occupancy");
+  NS_TEST_ASSERT_MSG_EQ (AddSegment (buffer, 500, 100), false, "A duplicate should not be buffered");
+  AddSegment (buffer, 350, 200);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 400, "Wrong occupancy after an overlap");
+  AddSegment (buffer, 650, 300);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 600, "Wrong occupancy after a covering segment");
+  AddSegment (buffer, 100, 100);
+  NS_TEST_ASSERT_MSG_EQ (buffer->MaxRxSequence (), m_head + 100 + DATA_SIZE, "Wrong window");
+
+  AddSegment (buffer, 0, 100);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 200, "The first segments should be in sequence");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), m_head + 200, "Wrong next sequence");
+  AddSegment (buffer, 150, 150);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 600, "The hole up to 600 should be filled");
+  AddSegment (buffer, 600, 50);
+  NS_TEST_ASSERT_MSG_EQ (buffer->Available (), 950, "The hole up to 950 should be filled");
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), m_head + 950, "Wrong next sequence");
+
+  Ptr<Packet> p = buffer->Extract (120);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), 120, "Wrong size of the first read");
+  NS_TEST_ASSERT_MSG_EQ (HasData (p, m_data, 0), true, "Wrong data of the first read");
+  NS_TEST_ASSERT_MSG_EQ (buffer->MaxRxSequence (), m_head + 120 + DATA_SIZE, "Wrong window after a read");
+  AddSegment (buffer, 950, 50);
+  buffer->SetFinSequence (m_head + DATA_SIZE);
+  NS_TEST_ASSERT_MSG_EQ (buffer->NextRxSequence (), m_head + DATA_SIZE + 1, "The FIN should be accounted");
+  p = buffer->Extract (DATA_SIZE);
+  NS_TEST_ASSERT_MSG_EQ (p->GetSize (), DATA_SIZE - 120, "Wrong size of the last read");
+  NS_TEST_ASSERT_MSG_EQ (HasData (p, m_data, 120), true, "Wrong data of the last read");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Size (), 0, "The buffer should be empty");
+  NS_TEST_ASSERT_MSG_EQ (buffer->Finished (), true, "The buffer should be finished");
+}
+
+class TcpBufferTestSuite : public TestSuite
+{
+public:
+  TcpBufferTestSuite ();
+};
+
+TcpBufferTestSuite::TcpBufferTestSuite ()
+  : TestSuite ("tcp-buffer", UNIT)
+{
+  AddTestCase (new TcpTxBufferTestCase, TestCase::QUICK);
+  AddTestCase (new TcpRxBufferTestCase, TestCase::QUICK);
+}
+
+static TcpBufferTestSuite tcpBufferTestSuite;
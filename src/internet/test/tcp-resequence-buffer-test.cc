@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/node.h"
+#include "ns3/packet.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/tcp-header.h"
+#include "ns3/tcp-socket-base.h"
+#include "ns3/tcp-resequence-buffer.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief A socket recording the sequence numbers flushed by its resequence buffer
+ */
+class TcpResequenceBufferTestSocket : public TcpSocketBase
+{
+public:
+  std::vector<SequenceNumber32> m_received;
+
+protected:
+  virtual void DoForwardUp (Ptr<Packet> packet, const Address &fromAddress,
+                            const Address &toAddress)
+  {
+    TcpHeader tcpHeader;
+    packet->PeekHeader (tcpHeader);
+    m_received.push_back (tcpHeader.GetSequenceNumber ());
+  }
+};
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief Check the reordering, the duplicate removal and the timeouts of the
+ * resequence buffer, with two sockets sharing the timer wheel of their node
+ */
+class TcpResequenceBufferTestCase : public TestCase
+{
+public:
+  TcpResequenceBufferTestCase ();
+
+private:
+  virtual void DoRun (void);
+
+  void Buffer (Ptr<TcpResequenceBufferTestSocket> socket, uint32_t seq);
+  void CheckReceived (Ptr<TcpResequenceBufferTestSocket> socket, uint32_t count);
+};
+
+TcpResequenceBufferTestCase::TcpResequenceBufferTestCase ()
+  : TestCase ("Resequence buffer reorders segments and flushes them on timeouts")
+{
+}
+
+void
+TcpResequenceBufferTestCase::Buffer (Ptr<TcpResequenceBufferTestSocket> socket, uint32_t seq)
+{
+  TcpHeader tcpHeader;
+  tcpHeader.SetSequenceNumber (SequenceNumber32 (seq));
+  tcpHeader.SetFlags (TcpHeader::ACK);
+  Ptr<Packet> packet = Create<Packet> (100);
+  packet->AddHeader (tcpHeader);
+  socket->GetResequenceBuffer ()->BufferPacket (packet,
+                                                InetSocketAddress (Ipv4Address ("10.0.0.1"), 1000),
+                                                InetSocketAddress (Ipv4Address ("10.0.0.2"), 2000));
+}
+
+void
+TcpResequenceBufferTestCase::CheckReceived (Ptr<TcpResequenceBufferTestSocket> socket, uint32_t count)
+{
+  NS_TEST_EXPECT_MSG_EQ (socket->m_received.size (), count,
+                         "Unexpected number of segments at " << Simulator::Now ().GetMicroSeconds () << "us");
+}
+
+void
+TcpResequenceBufferTestCase::DoRun (void)
+{
+  Ptr<Node> node = CreateObject<Node> ();
+
+  // The gap is filled: the run is flushed in order after the in order timeout
+  Ptr<TcpResequenceBufferTestSocket> filled = CreateObject<TcpResequenceBufferTestSocket> ();
+  filled->SetNode (node);
+  Buffer (filled, 1);
+  Buffer (filled, 201);
+  Buffer (filled, 301);
+  Buffer (filled, 201);
+  Buffer (filled, 101);
+
+  // The gap stays open: everything is flushed after the out of order timeout
+  Ptr<TcpResequenceBufferTestSocket> gap = CreateObject<TcpResequenceBufferTestSocket> ();
+  gap->SetNode (node);
+  Simulator::Schedule (MicroSeconds (3), &TcpResequenceBufferTestCase::Buffer, this, gap, 1);
+  Simulator::Schedule (MicroSeconds (3), &TcpResequenceBufferTestCase::Buffer, this, gap, 201);
+
+  Simulator::Schedule (MicroSeconds (15), &TcpResequenceBufferTestCase::CheckReceived, this, filled, 0);
+  Simulator::Schedule (MicroSeconds (45), &TcpResequenceBufferTestCase::CheckReceived, this, filled, 4);
+  Simulator::Schedule (MicroSeconds (45), &TcpResequenceBufferTestCase::CheckReceived, this, gap, 1);
+  Simulator::Schedule (MicroSeconds (100), &TcpResequenceBufferTestCase::CheckReceived, this, gap, 2);
+
+  Simulator::Run ();
+
+  NS_TEST_ASSERT_MSG_NE (node->GetObject<TcpResequenceTimerWheel> (), 0, "The node has no timer wheel");
+
+  NS_TEST_ASSERT_MSG_EQ (filled->m_received.size (), 4, "Duplicate or lost segment");
+  for (uint32_t i = 0; i < filled->m_received.size (); ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ (filled->m_received[i], SequenceNumber32 (1 + 100 * i), "Segment out of order");
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (gap->m_received.size (), 2, "Lost segment");
+  NS_TEST_EXPECT_MSG_EQ (gap->m_received[0], SequenceNumber32 (1), "Segment out of order");
+  NS_TEST_EXPECT_MSG_EQ (gap->m_received[1], SequenceNumber32 (201), "Segment out of order");
+
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup internet-test
+ * \ingroup tests
+ *
+ * \brief TCP resequence buffer TestSuite
+ */
+class TcpResequenceBufferTestSuite : public TestSuite
+{
+public:
+  TcpResequenceBufferTestSuite () : TestSuite ("tcp-resequence-buffer", UNIT)
+  {
+    AddTestCase (new TcpResequenceBufferTestCase (), TestCase::QUICK);
+  }
+};
+
+static TcpResequenceBufferTestSuite g_tcpResequenceBufferTestSuite;
@@ -173,6 +173,52 @@ TcpSlowStartAttackerTest::CreateReceiverSocket (Ptr<Node> node)
   return socket;
 }
 
+/**
+ * \brief Slow start with ByteCounting on a stretch ACK
+ *
+ * A cumulative ACK of several segments grows cWnd by all of them, up to
+ * ssThresh, and the remaining ones go to congestion avoidance.
+ */
+class TcpSlowStartByteCountingTest : public TestCase
+{
+public:
+  TcpSlowStartByteCountingTest (uint32_t ssThresh, uint32_t segmentsAcked,
+                                uint32_t expectedCWnd, const std::string &name);
+
+private:
+  virtual void DoRun (void);
+
+  uint32_t m_ssThresh;
+  uint32_t m_segmentsAcked;
+  uint32_t m_expectedCWnd;
+};
+
+TcpSlowStartByteCountingTest::TcpSlowStartByteCountingTest (uint32_t ssThresh,
+                                                            uint32_t segmentsAcked,
+                                                            uint32_t expectedCWnd,
+                                                            const std::string &name)
+  : TestCase (name),
+    m_ssThresh (ssThresh),
+    m_segmentsAcked (segmentsAcked),
+    m_expectedCWnd (expectedCWnd)
+{
+}
+
+void
+TcpSlowStartByteCountingTest::DoRun ()
+{
+  Ptr<TcpSocketState> state = CreateObject<TcpSocketState> ();
+  state->m_cWnd = 1000;
+  state->m_ssThresh = m_ssThresh;
+  state->m_segmentSize = 500;
+
+  Ptr<TcpNewReno> cong = CreateObject<TcpNewReno> ();
+  cong->SetAttribute ("ByteCounting", BooleanValue (true));
+  cong->IncreaseWindow (state, m_segmentsAcked);
+
+  NS_TEST_ASSERT_MSG_EQ (state->m_cWnd.Get (), m_expectedCWnd,
+                         "CWnd has not increased by the segments acked");
+}
 
 //-----------------------------------------------------------------------------
 
@@ -204,6 +250,18 @@ public:
                                                    "slow start ack attacker, 1000 byte, " + (*it).GetName ()),
                      TestCase::QUICK);
       }
+
+    AddTestCase (new TcpSlowStartByteCountingTest (10000, 4, 3000,
+                                                   "slow start byte counting, stretch ack"),
+                 TestCase::QUICK);
+    // A segment only partly under ssThresh stops at ssThresh
+    AddTestCase (new TcpSlowStartByteCountingTest (1800, 4, 1938,
+                                                   "slow start byte counting, capped at ssThresh"),
+                 TestCase::QUICK);
+    // 2 segments bring cWnd to ssThresh, the last two are congestion avoidance
+    AddTestCase (new TcpSlowStartByteCountingTest (2000, 4, 2125,
+                                                   "slow start byte counting, limited by ssThresh"),
+                 TestCase::QUICK);
   }
 } g_tcpSlowStartTestSuite;
 
@@ -22,6 +22,8 @@ Ipv4LetFlowRouting::Ipv4LetFlowRouting ():
     m_ipv4 (0)
 {
   NS_LOG_FUNCTION (this);
+  m_flowletTable = CreateObject<FlowletTable> ();
+  m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4LetFlowRouting::~Ipv4LetFlowRouting ()
@@ -45,43 +47,7 @@ void
 Ipv4LetFlowRouting::AddRoute (Ipv4Address network, Ipv4Mask networkMask, uint32_t port)
 {
   NS_LOG_LOGIC (this << " Add LetFlow routing entry: " << network << "/" << networkMask << " would go through port: " << port);
-  LetFlowRouteEntry letFlowRouteEntry;
-  letFlowRouteEntry.network = network;
-  letFlowRouteEntry.networkMask = networkMask;
-  letFlowRouteEntry.port = port;
-  m_routeEntryList.push_back (letFlowRouteEntry);
-}
-
-std::vector<LetFlowRouteEntry>
-Ipv4LetFlowRouting::LookupLetFlowRouteEntries (Ipv4Address dest)
-{
-  std::vector<LetFlowRouteEntry> letFlowRouteEntries;
-  std::vector<LetFlowRouteEntry>::iterator itr = m_routeEntryList.begin ();
-  for ( ; itr != m_routeEntryList.end (); ++itr)
-  {
-    if((*itr).networkMask.IsMatch(dest, (*itr).network))
-    {
-      letFlowRouteEntries.push_back (*itr);
-    }
-  }
-  return letFlowRouteEntries;
-}
-
-Ptr<Ipv4Route>
-Ipv4LetFlowRouting::ConstructIpv4Route (uint32_t port, Ipv4Address destAddress)
-{
-  Ptr<NetDevice> dev = m_ipv4->GetNetDevice (port);
-  Ptr<Channel> channel = dev->GetChannel ();
-  uint32_t otherEnd = (channel->GetDevice (0) == dev) ? 1 : 0;
-  Ptr<Node> nextHop = channel->GetDevice (otherEnd)->GetNode ();
-  uint32_t nextIf = channel->GetDevice (otherEnd)->GetIfIndex ();
-  Ipv4Address nextHopAddr = nextHop->GetObject<Ipv4>()->GetAddress(nextIf,0).GetLocal();
-  Ptr<Ipv4Route> route = Create<Ipv4Route> ();
-  route->SetOutputDevice (m_ipv4->GetNetDevice (port));
-  route->SetGateway (nextHopAddr);
-  route->SetSource (m_ipv4->GetAddress (port, 0).GetLocal ());
-  route->SetDestination (destAddress);
-  return route;
+  m_nextHopCache.AddRoute (network, networkMask, port);
 }
 
 void
@@ -90,6 +56,13 @@ Ipv4LetFlowRouting::SetFlowletTimeout (Time timeout)
   m_flowletTimeout = timeout;
 }
 
+int64_t
+Ipv4LetFlowRouting::AssignStreams (int64_t stream)
+{
+  m_rand->SetStream (stream);
+  return 1;
+}
+
 Ptr<Ipv4Route>
 Ipv4LetFlowRouting::RouteOutput (Ptr<Packet> packet, const Ipv4Header &header, Ptr<NetDevice> oif, Socket::SocketErrno &sockerr)
 {
@@ -131,7 +104,7 @@ Ipv4LetFlowRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, P
   // Extract the flow id
   uint32_t flowId = 0;
   FlowIdTag flowIdTag;
-  bool flowIdFound = packet->PeekPacketTag(flowIdTag);
+  bool flowIdFound = flowIdTag.PeekFrom (packet);
   if (!flowIdFound)
   {
     NS_LOG_ERROR (this << " LetFlow routing cannot extract the flow id");
@@ -140,9 +113,9 @@ Ipv4LetFlowRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, P
   }
   flowId = flowIdTag.GetFlowId ();
 
-  std::vector<LetFlowRouteEntry> routeEntries = Ipv4LetFlowRouting::LookupLetFlowRouteEntries (destAddress);
+  const std::vector<uint32_t> &routePorts = m_nextHopCache.LookupPorts (destAddress);
 
-  if (routeEntries.empty ())
+  if (routePorts.empty ())
   {
     NS_LOG_ERROR (this << " LetFlow routing cannot find routing entry");
     ecb (packet, header, Socket::ERROR_NOROUTETOHOST);
@@ -152,61 +125,66 @@ Ipv4LetFlowRouting::RouteInput (Ptr<const Packet> p, const Ipv4Header &header, P
   uint32_t selectedPort;
 
   // If the flowlet table entry is valid, return the port
-  std::map<uint32_t, struct LetFlowFlowlet>::iterator flowletItr = m_flowletTable.find (flowId);
-  if (flowletItr != m_flowletTable.end ())
+  FlowletEntry *flowlet = m_flowletTable->Lookup (flowId);
+  if (flowlet != NULL)
   {
-    LetFlowFlowlet flowlet = flowletItr->second;
-    if (now - flowlet.activeTime <= m_flowletTimeout)
+    if (now - flowlet->activeTime <= m_flowletTimeout)
     {
       // Do not forget to update the flowlet active time
-      flowlet.activeTime = now;
+      flowlet->activeTime = now;
 
       // Return the port information used for routing routine to select the port
-      selectedPort = flowlet.port;
+      selectedPort = flowlet->path;
 
-      Ptr<Ipv4Route> route = Ipv4LetFlowRouting::ConstructIpv4Route (selectedPort, destAddress);
+      Ptr<Ipv4Route> route = m_nextHopCache.GetRoute (selectedPort);
       ucb (route, packet, header);
 
-      m_flowletTable[flowId] = flowlet;
-
       return true;
     }
   }
+  else
+  {
+    flowlet = m_flowletTable->Insert (flowId, m_flowletTimeout);
+  }
 
   // Not hit. Random Select the Port
-  selectedPort = routeEntries[rand () % routeEntries.size ()].port;
-
-  LetFlowFlowlet flowlet;
+  selectedPort = routePorts[m_rand->GetInteger (0, routePorts.size () - 1)];
 
-  flowlet.port = selectedPort;
-  flowlet.activeTime = now;
+  // Without an entry, the packets of the flow are routed one by one
+  if (flowlet != NULL)
+  {
+    flowlet->path = selectedPort;
+    flowlet->activeTime = now;
+  }
 
-  Ptr<Ipv4Route> route = Ipv4LetFlowRouting::ConstructIpv4Route (selectedPort, destAddress);
+  Ptr<Ipv4Route> route = m_nextHopCache.GetRoute (selectedPort);
   ucb (route, packet, header);
 
-  m_flowletTable[flowId] = flowlet;
-
   return true;
 }
 
 void
 Ipv4LetFlowRouting::NotifyInterfaceUp (uint32_t interface)
 {
+  m_nextHopCache.Invalidate ();
 }
 
 void
 Ipv4LetFlowRouting::NotifyInterfaceDown (uint32_t interface)
 {
+  m_nextHopCache.Invalidate ();
 }
 
 void
 Ipv4LetFlowRouting::NotifyAddAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_nextHopCache.Invalidate ();
 }
 
 void
 Ipv4LetFlowRouting::NotifyRemoveAddress (uint32_t interface, Ipv4InterfaceAddress address)
 {
+  m_nextHopCache.Invalidate ();
 }
 
 void
@@ -215,6 +193,7 @@ Ipv4LetFlowRouting::SetIpv4 (Ptr<Ipv4> ipv4)
   NS_LOG_LOGIC (this << "Setting up Ipv4: " << ipv4);
   NS_ASSERT (m_ipv4 == 0 && ipv4 != 0);
   m_ipv4 = ipv4;
+  m_nextHopCache.SetIpv4 (ipv4);
 }
 
 void
@@ -226,6 +205,10 @@ Ipv4LetFlowRouting::PrintRoutingTable (Ptr<OutputStreamWrapper> stream) const
 void
 Ipv4LetFlowRouting::DoDispose (void)
 {
+  m_flowletTable->Dispose ();
+  m_flowletTable = 0;
+  m_rand = 0;
+  m_nextHopCache.Clear ();
   m_ipv4=0;
   Ipv4RoutingProtocol::DoDispose ();
 }
@@ -10,20 +10,12 @@
 #include "ns3/data-rate.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/ipv4-next-hop-cache.h"
+#include "ns3/flowlet-table.h"
 
 namespace ns3 {
 
-struct LetFlowFlowlet {
-  uint32_t port;
-  Time activeTime;
-};
-
-struct LetFlowRouteEntry {
-  Ipv4Address network;
-  Ipv4Mask networkMask;
-  uint32_t port;
-};
-
 class Ipv4LetFlowRouting : public Ipv4RoutingProtocol
 {
 public:
@@ -48,11 +40,17 @@ public:
 
   virtual void DoDispose (void);
 
-  std::vector<LetFlowRouteEntry> LookupLetFlowRouteEntries (Ipv4Address dest);
-  Ptr<Ipv4Route> ConstructIpv4Route (uint32_t port, Ipv4Address destAddress);
-
   void SetFlowletTimeout (Time timeout);
 
+  /**
+   * Assign a fixed random variable stream number to the random variables
+   * used by this model.
+   *
+   * \param stream first stream index to use
+   * \return the number of stream indices assigned by this model
+   */
+  int64_t AssignStreams (int64_t stream);
+
 private:
   // Flowlet Timeout
   Time m_flowletTimeout;
@@ -60,11 +58,14 @@ private:
   // Ipv4 associated with this router
   Ptr<Ipv4> m_ipv4;
 
-  // Flowlet Table
-  std::map<uint32_t, LetFlowFlowlet> m_flowletTable;
+  // Flowlet Table, the path of the entries is the port
+  Ptr<FlowletTable> m_flowletTable;
+
+  // Route table and per port routes
+  Ipv4NextHopCache m_nextHopCache;
 
-  // Route table
-  std::vector<LetFlowRouteEntry> m_routeEntryList;
+  // Picks the port of a new flowlet
+  Ptr<UniformRandomVariable> m_rand;
 };
 
 }
@@ -31,18 +31,21 @@ Ipv4LinkProbe::Ipv4LinkProbe (Ptr<Node> node, Ptr<LinkMonitor> linkMonitor)
 {
   NS_LOG_FUNCTION (this);
 
-  m_ipv4 = m_ipv4 = node->GetObject<Ipv4L3Protocol> ();
+  m_ipv4 = node->GetObject<Ipv4L3Protocol> ();
+
+  uint32_t nInterfaces = m_ipv4->GetNInterfaces ();
+  m_queueProbe.resize (nInterfaces);
+  m_accumulatedTxBytes.assign (nInterfaces, 0);
+  m_accumulatedDequeueBytes.assign (nInterfaces, 0);
+  m_NPacketsInQueue.assign (nInterfaces, 0);
+  m_NBytesInQueue.assign (nInterfaces, 0);
+  m_NPacketsInQueueDisc.assign (nInterfaces, 0);
+  m_NBytesInQueueDisc.assign (nInterfaces, 0);
+  m_dataRate.assign (nInterfaces, DataRate (0));
 
   // Notice, the interface at 0 is loopback, we simply ignore it
-  for (uint32_t interface = 1; interface < m_ipv4->GetNInterfaces (); ++interface)
+  for (uint32_t interface = 1; interface < nInterfaces; ++interface)
   {
-    m_accumulatedTxBytes[interface] = 0;
-    m_accumulatedDequeueBytes[interface] = 0;
-    m_NPacketsInQueue[interface] = 0;
-    m_NBytesInQueue[interface] = 0;
-    m_NPacketsInQueueDisc[interface] = 0;
-    m_NBytesInQueueDisc[interface] = 0;
-
     m_queueProbe[interface] = Create<Ipv4QueueProbe> ();
     m_queueProbe[interface]->SetInterfaceId (interface);
     m_queueProbe[interface]->SetIpv4LinkProbe (this);
@@ -84,7 +87,7 @@ Ipv4LinkProbe::Ipv4LinkProbe (Ptr<Node> node, Ptr<LinkMonitor> linkMonitor)
 void
 Ipv4LinkProbe::SetDataRateAll (DataRate dataRate)
 {
-  for (uint32_t interface = 1; interface < m_ipv4->GetNInterfaces (); ++interface)
+  for (uint32_t interface = 1; interface < m_dataRate.size (); ++interface)
   {
     m_dataRate[interface] = dataRate;
   }
@@ -95,7 +98,10 @@ Ipv4LinkProbe::TxLogger (Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t inte
 {
   uint32_t size = packet->GetSize ();
   NS_LOG_LOGIC ("Trace " << size << " bytes TX on port: " << interface);
-  m_accumulatedTxBytes[interface] = m_accumulatedTxBytes[interface] + size;
+  if (interface < m_accumulatedTxBytes.size ())
+  {
+    m_accumulatedTxBytes[interface] += size;
+  }
 }
 
 void
@@ -103,7 +109,7 @@ Ipv4LinkProbe::DequeueLogger (Ptr<const Packet> packet, uint32_t interface)
 {
   uint32_t size = packet->GetSize ();
   NS_LOG_LOGIC ("Trace " << size << " bytes dequeued on port: " << interface);
-  m_accumulatedDequeueBytes[interface] = m_accumulatedDequeueBytes[interface] + size;
+  m_accumulatedDequeueBytes[interface] += size;
 }
 
 void
@@ -137,48 +143,31 @@ Ipv4LinkProbe::BytesInQueueDiscLogger (uint32_t NBytes, uint32_t interface)
 void
 Ipv4LinkProbe::CheckCurrentStatus ()
 {
-  for (uint32_t interface = 1; interface < m_ipv4->GetNInterfaces (); ++interface)
+  for (uint32_t interface = 1; interface < m_accumulatedTxBytes.size (); ++interface)
   {
     uint64_t lastTxBytes = 0;
     uint64_t lastDequeueBytes = 0;
 
-    std::map<uint32_t, std::vector<struct LinkProbe::LinkStats> >::iterator itr = m_stats.find (interface);
-    if (itr == m_stats.end ())
+    const struct LinkProbe::LinkStats *last = GetLastStats (interface);
+    if (last != 0)
     {
-      struct LinkProbe::LinkStats newStats;
-      newStats.checkTime = Simulator::Now ();
-      newStats.accumulatedTxBytes = m_accumulatedTxBytes[interface];
-      newStats.txLinkUtility =
-          Ipv4LinkProbe::GetLinkUtility (interface, m_accumulatedTxBytes[interface] - lastTxBytes, m_checkTime);
-      newStats.accumulatedDequeueBytes = m_accumulatedDequeueBytes[interface];
-      newStats.dequeueLinkUtility =
-          Ipv4LinkProbe::GetLinkUtility (interface, m_accumulatedDequeueBytes[interface] - lastDequeueBytes, m_checkTime);
-      newStats.packetsInQueue = m_NPacketsInQueue[interface];
-      newStats.bytesInQueue = m_NBytesInQueue[interface];
-      newStats.packetsInQueueDisc = m_NPacketsInQueueDisc[interface];
-      newStats.bytesInQueueDisc = m_NBytesInQueueDisc[interface];
-      std::vector<struct LinkProbe::LinkStats> newVector;
-      newVector.push_back (newStats);
-      m_stats[interface] = newVector;
-    }
-    else
-    {
-      lastTxBytes = (itr->second).back ().accumulatedTxBytes;
-      lastDequeueBytes = (itr->second).back ().accumulatedDequeueBytes;
-      struct LinkProbe::LinkStats newStats;
-      newStats.checkTime = Simulator::Now ();
-      newStats.accumulatedTxBytes = m_accumulatedTxBytes[interface];
-      newStats.txLinkUtility =
-          Ipv4LinkProbe::GetLinkUtility (interface, m_accumulatedTxBytes[interface] - lastTxBytes, m_checkTime);
-      newStats.accumulatedDequeueBytes = m_accumulatedDequeueBytes[interface];
-      newStats.dequeueLinkUtility =
-          Ipv4LinkProbe::GetLinkUtility (interface, m_accumulatedDequeueBytes[interface] - lastDequeueBytes, m_checkTime);
-      newStats.packetsInQueue = m_NPacketsInQueue[interface];
-      newStats.bytesInQueue = m_NBytesInQueue[interface];
-      newStats.packetsInQueueDisc = m_NPacketsInQueueDisc[interface];
-      newStats.bytesInQueueDisc = m_NPacketsInQueueDisc[interface];
-      (itr->second).push_back (newStats);
+      lastTxBytes = last->accumulatedTxBytes;
+      lastDequeueBytes = last->accumulatedDequeueBytes;
     }
+
+    struct LinkProbe::LinkStats newStats;
+    newStats.checkTime = Simulator::Now ();
+    newStats.accumulatedTxBytes = m_accumulatedTxBytes[interface];
+    newStats.txLinkUtility =
+        Ipv4LinkProbe::GetLinkUtility (interface, m_accumulatedTxBytes[interface] - lastTxBytes, m_checkTime);
+    newStats.accumulatedDequeueBytes = m_accumulatedDequeueBytes[interface];
+    newStats.dequeueLinkUtility =
+        Ipv4LinkProbe::GetLinkUtility (interface, m_accumulatedDequeueBytes[interface] - lastDequeueBytes, m_checkTime);
+    newStats.packetsInQueue = m_NPacketsInQueue[interface];
+    newStats.bytesInQueue = m_NBytesInQueue[interface];
+    newStats.packetsInQueueDisc = m_NPacketsInQueueDisc[interface];
+    newStats.bytesInQueueDisc = m_NBytesInQueueDisc[interface];
+    AddStats (interface, newStats);
   }
 
   m_checkEvent = Simulator::Schedule (m_checkTime, &Ipv4LinkProbe::CheckCurrentStatus, this);
@@ -200,13 +189,12 @@ Ipv4LinkProbe::Stop ()
 double
 Ipv4LinkProbe::GetLinkUtility (uint32_t interface, uint64_t bytes, Time time)
 {
-  std::map<uint32_t, DataRate>::iterator itr = m_dataRate.find (interface);
-  if (itr == m_dataRate.end ())
+  if (m_dataRate[interface].GetBitRate () == 0)
   {
     return 0.0f;
   }
 
-  return static_cast<double> (bytes * 8) / ((itr->second).GetBitRate () * time.GetSeconds ());
+  return static_cast<double> (bytes * 8) / (m_dataRate[interface].GetBitRate () * time.GetSeconds ());
 }
 
 void
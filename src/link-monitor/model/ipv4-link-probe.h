@@ -51,18 +51,20 @@ private:
 
   EventId m_checkEvent;
 
-  std::map<uint32_t, Ptr<Ipv4QueueProbe> > m_queueProbe;
+  // Indexed by interface, the loopback at 0 is unused
+  std::vector<Ptr<Ipv4QueueProbe> > m_queueProbe;
 
-  std::map<uint32_t, uint64_t> m_accumulatedTxBytes;
-  std::map<uint32_t, uint64_t> m_accumulatedDequeueBytes;
+  std::vector<uint64_t> m_accumulatedTxBytes;
+  std::vector<uint64_t> m_accumulatedDequeueBytes;
 
-  std::map<uint32_t, uint32_t> m_NPacketsInQueue;
-  std::map<uint32_t, uint32_t> m_NBytesInQueue;
+  std::vector<uint32_t> m_NPacketsInQueue;
+  std::vector<uint32_t> m_NBytesInQueue;
 
-  std::map<uint32_t, uint32_t> m_NPacketsInQueueDisc;
-  std::map<uint32_t, uint32_t> m_NBytesInQueueDisc;
+  std::vector<uint32_t> m_NPacketsInQueueDisc;
+  std::vector<uint32_t> m_NBytesInQueueDisc;
 
-  std::map<uint32_t, DataRate> m_dataRate;
+  // Zero if unknown
+  std::vector<DataRate> m_dataRate;
 
   Ptr<Ipv4L3Protocol> m_ipv4;
 };
@@ -4,6 +4,8 @@
 
 #include "ns3/log.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
 
 #include <fstream>
 #include <sstream>
@@ -20,20 +22,51 @@ LinkMonitor::GetTypeId (void)
   static TypeId tid = TypeId ("ns3::LinkMonitor")
             .SetParent<Object> ()
             .SetGroupName ("LinkMonitor")
-            .AddConstructor<LinkMonitor> ();
+            .AddConstructor<LinkMonitor> ()
+            .AddAttribute ("FlushSize",
+                           "The number of samples of each port written at once to the stream, for the probes added afterwards. Without stream, all the samples stay in memory",
+                           UintegerValue (1024),
+                           MakeUintegerAccessor (&LinkMonitor::m_flushSize),
+                           MakeUintegerChecker<uint32_t> (1))
+            .AddAttribute ("Aggregate",
+                           "Whether to summarize the samples of each port during the simulation, for the probes added afterwards",
+                           BooleanValue (false),
+                           MakeBooleanAccessor (&LinkMonitor::m_aggregate),
+                           MakeBooleanChecker ());
 
   return tid;
 }
 
+const uint16_t LinkMonitor::VERSION;
+
 LinkMonitor::LinkMonitor ()
+  : m_flushSize (1024),
+    m_aggregate (false)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+LinkMonitor::~LinkMonitor ()
 {
   NS_LOG_FUNCTION (this);
 }
 
+void
+LinkMonitor::DoDispose (void)
+{
+  CloseStream ();
+  m_linkProbes.clear ();
+  Object::DoDispose ();
+}
+
 void
 LinkMonitor::AddLinkProbe (Ptr<LinkProbe> probe)
 {
+  probe->m_probeId = m_linkProbes.size ();
+  probe->m_flushSize = m_flushSize;
+  probe->m_aggregate = m_aggregate;
   m_linkProbes.push_back (probe);
+  m_nameWritten.push_back (false);
 }
 
 void
@@ -78,17 +111,17 @@ LinkMonitor::OutputToFile (std::string filename, std::string (*formatFunc)(struc
   for ( ; itr != m_linkProbes.end (); ++itr)
   {
     Ptr<LinkProbe> linkProbe = *itr;
-    std::map<uint32_t, std::vector<struct LinkProbe::LinkStats> > stats = linkProbe->GetLinkStats ();
+    const std::map<uint32_t, struct LinkProbe::PortStats> &stats = linkProbe->GetPortStats ();
     os << linkProbe->GetProbeName () << ": (contain: " << stats.size () << " ports)" << std::endl;
-    std::map<uint32_t, std::vector<struct LinkProbe::LinkStats> >::iterator portItr = stats.begin ();
+    std::map<uint32_t, struct LinkProbe::PortStats>::const_iterator portItr = stats.begin ();
     for ( ; portItr != stats.end (); ++portItr)
     {
-      os << "\tPort: " << portItr->first << " (contain " << (portItr->second).size ()  << " entries)"<< std::endl;
+      const struct LinkProbe::PortStats &port = portItr->second;
+      os << "\tPort: " << portItr->first << " (contain " << port.GetSize ()  << " entries)"<< std::endl;
       os << "\t\t";
-      std::vector<struct LinkProbe::LinkStats>::iterator timeItr = (portItr->second).begin ();
-      for ( ; timeItr != (portItr->second).end (); ++timeItr)
+      for (uint32_t i = 0; i < port.GetSize (); ++i)
       {
-        os << formatFunc (*timeItr) << "\t";
+        os << formatFunc (port.Get (i)) << "\t";
       }
       os << std::endl;
     }
@@ -98,6 +131,150 @@ LinkMonitor::OutputToFile (std::string filename, std::string (*formatFunc)(struc
   os.close ();
 }
 
+void
+LinkMonitor::OutputAggregateToFile (std::string filename)
+{
+  std::ofstream os (filename.c_str (), std::ios::out);
+  os << "probe,port,samples,tx_util_avg,tx_util_p50,tx_util_p99,tx_util_max,"
+     << "queue_bytes_avg,queue_bytes_p50,queue_bytes_p99,queue_bytes_max" << std::endl;
+
+  std::vector<Ptr<LinkProbe> >::iterator itr = m_linkProbes.begin ();
+  for ( ; itr != m_linkProbes.end (); ++itr)
+  {
+    const std::map<uint32_t, struct LinkProbe::PortStats> &stats = (*itr)->GetPortStats ();
+    std::map<uint32_t, struct LinkProbe::PortStats>::const_iterator portItr = stats.begin ();
+    for ( ; portItr != stats.end (); ++portItr)
+    {
+      const QuantileSketch &util = (portItr->second).txLinkUtility;
+      const QuantileSketch &queue = (portItr->second).bytesInQueue;
+      os << (*itr)->GetProbeName () << "," << portItr->first << "," << util.Count () << ","
+         << util.Avg () << "," << util.GetQuantile (0.5) << "," << util.GetQuantile (0.99) << "," << util.Max () << ","
+         << queue.Avg () << "," << queue.GetQuantile (0.5) << "," << queue.GetQuantile (0.99) << "," << queue.Max ()
+         << std::endl;
+    }
+  }
+
+  os.close ();
+}
+
+bool
+LinkMonitor::OpenStream (std::string filename)
+{
+  CloseStream ();
+  if (!m_stream.Open (filename, "LMON", VERSION))
+  {
+    NS_LOG_ERROR ("Cannot open the link monitor stream: " << filename);
+    return false;
+  }
+  m_nameWritten.assign (m_linkProbes.size (), false);
+  // The samples already in memory start the stream
+  Flush ();
+  return true;
+}
+
+void
+LinkMonitor::CloseStream (void)
+{
+  if (m_stream.IsOpen ())
+  {
+    Flush ();
+    m_stream.Close ();
+  }
+}
+
+bool
+LinkMonitor::IsStreaming (void) const
+{
+  return m_stream.IsOpen ();
+}
+
+void
+LinkMonitor::Flush (void)
+{
+  if (!m_stream.IsOpen ())
+  {
+    return;
+  }
+  std::vector<Ptr<LinkProbe> >::iterator itr = m_linkProbes.begin ();
+  for ( ; itr != m_linkProbes.end (); ++itr)
+  {
+    const std::map<uint32_t, struct LinkProbe::PortStats> &stats = (*itr)->GetPortStats ();
+    std::map<uint32_t, struct LinkProbe::PortStats>::const_iterator portItr = stats.begin ();
+    for ( ; portItr != stats.end (); ++portItr)
+    {
+      Flush (PeekPointer (*itr), portItr->first);
+    }
+  }
+  m_stream.Flush ();
+}
+
+void
+LinkMonitor::Flush (LinkProbe *probe, uint32_t interface)
+{
+  if (!m_stream.IsOpen ())
+  {
+    return;
+  }
+  const struct LinkProbe::PortStats &port = probe->GetPortStats ().find (interface)->second;
+  if (port.GetSize () == 0)
+  {
+    return;
+  }
+
+  if (!m_nameWritten[probe->m_probeId])
+  {
+    std::string name = probe->GetProbeName ();
+    m_stream.WriteU8 ('N');
+    m_stream.WriteU32 (probe->m_probeId);
+    m_stream.WriteU32 (name.size ());
+    m_stream.Write (name);
+    m_nameWritten[probe->m_probeId] = true;
+  }
+
+  uint32_t n = port.GetSize ();
+  m_stream.WriteU8 ('S');
+  m_stream.WriteU32 (probe->m_probeId);
+  m_stream.WriteU32 (interface);
+  m_stream.WriteU32 (n);
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteU64 (static_cast<uint64_t> (port.Get (i).checkTime.GetNanoSeconds ()));
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteU64 (port.Get (i).accumulatedTxBytes);
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteU64 (port.Get (i).accumulatedDequeueBytes);
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteFloat (port.Get (i).txLinkUtility);
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteFloat (port.Get (i).dequeueLinkUtility);
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteU32 (port.Get (i).packetsInQueue);
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteU32 (port.Get (i).bytesInQueue);
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteU32 (port.Get (i).packetsInQueueDisc);
+  }
+  for (uint32_t i = 0; i < n; ++i)
+  {
+    m_stream.WriteU32 (port.Get (i).bytesInQueueDisc);
+  }
+  probe->ClearSamples (interface);
+}
+
 std::string
 LinkMonitor::DefaultFormat (struct LinkProbe::LinkStats stat)
 {
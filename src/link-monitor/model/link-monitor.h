@@ -4,6 +4,7 @@
 
 #include "ns3/object.h"
 #include "ns3/nstime.h"
+#include "ns3/binary-file-writer.h"
 #include "link-probe.h"
 
 #include <vector>
@@ -11,24 +12,69 @@
 
 namespace ns3 {
 
+/*
+ * Without stream, the probes keep all the samples of each port in memory.
+ * Once a stream is open, the samples of a port are appended to the stream
+ * file every FlushSize samples, so the memory stays bounded however long
+ * the run and however short the check interval.
+ *
+ * The stream file is little endian. It starts with the magic "LMON", a
+ * uint16_t version and a uint16_t reserved field, followed by blocks
+ * starting with a one byte type:
+ *
+ *   'N': uint32_t probe, uint32_t name length, the probe name
+ *   'S': uint32_t probe, uint32_t port, uint32_t n, then n samples by
+ *        column: int64_t check time in ns, uint64_t accumulated TX bytes,
+ *        uint64_t accumulated dequeue bytes, float TX utility, float
+ *        dequeue utility, uint32_t packets in queue, uint32_t bytes in
+ *        queue, uint32_t packets in queue disc, uint32_t bytes in queue
+ *        disc
+ *
+ * With Aggregate, the TX utility and the bytes in queue of all the samples
+ * are also summarized per port during the simulation.
+ */
 class LinkMonitor : public Object
 {
 public:
 
+  static const uint16_t VERSION = 1;
+
   static TypeId GetTypeId (void);
 
   static std::string DefaultFormat (struct LinkProbe::LinkStats stat);
 
   LinkMonitor ();
 
+  ~LinkMonitor ();
+
   void AddLinkProbe (Ptr<LinkProbe> probe);
 
   void Start (Time startTime);
 
   void Stop (Time stopTime);
 
+  // Print the samples still in memory, all of them without stream
   void OutputToFile (std::string filename, std::string (*formatFunc)(struct LinkProbe::LinkStats));
 
+  // Print the count, average, p50, p99 and max of the aggregates of each port
+  void OutputAggregateToFile (std::string filename);
+
+  bool OpenStream (std::string filename);
+
+  // Flush all the samples and close the stream
+  void CloseStream (void);
+
+  bool IsStreaming (void) const;
+
+  // Append the samples in memory of all the ports to the stream
+  void Flush (void);
+
+  // Append the samples in memory of a port to the stream
+  void Flush (LinkProbe *probe, uint32_t interface);
+
+protected:
+  virtual void DoDispose (void);
+
 private:
 
   void DoStart (void);
@@ -37,9 +83,14 @@ private:
 
   std::vector<Ptr<LinkProbe> > m_linkProbes;
 
+  uint32_t m_flushSize;
+  bool m_aggregate;
+
+  BinaryFileWriter m_stream;
+  std::vector<bool> m_nameWritten;
+
 };
 
 }
 
 #endif /* LINK_MONITOR_H */
-
@@ -21,13 +21,45 @@ LinkProbe::GetTypeId (void)
   return tid;
 }
 
+uint32_t
+LinkProbe::PortStats::GetSize (void) const
+{
+  return samples.size ();
+}
+
+const struct LinkProbe::LinkStats &
+LinkProbe::PortStats::Get (uint32_t i) const
+{
+  return samples[i];
+}
+
 LinkProbe::LinkProbe (Ptr<LinkMonitor> linkMonitor)
+  : m_linkMonitor (PeekPointer (linkMonitor)),
+    m_probeId (0),
+    m_flushSize (1),
+    m_aggregate (false)
 {
   linkMonitor->AddLinkProbe (this);
 }
 
 std::map<uint32_t, std::vector<struct LinkProbe::LinkStats> >
 LinkProbe::GetLinkStats (void)
+{
+  std::map<uint32_t, std::vector<struct LinkStats> > stats;
+  std::map<uint32_t, struct PortStats>::const_iterator itr = m_stats.begin ();
+  for ( ; itr != m_stats.end (); ++itr)
+  {
+    std::vector<struct LinkStats> &samples = stats[itr->first];
+    for (uint32_t i = 0; i < (itr->second).GetSize (); ++i)
+    {
+      samples.push_back ((itr->second).Get (i));
+    }
+  }
+  return stats;
+}
+
+const std::map<uint32_t, struct LinkProbe::PortStats> &
+LinkProbe::GetPortStats (void) const
 {
   return m_stats;
 }
@@ -44,5 +76,40 @@ LinkProbe::GetProbeName (void)
   return m_probeName;
 }
 
+const struct LinkProbe::LinkStats *
+LinkProbe::GetLastStats (uint32_t interface) const
+{
+  std::map<uint32_t, struct PortStats>::const_iterator itr = m_stats.find (interface);
+  if (itr == m_stats.end ())
+  {
+    return 0;
+  }
+  return &(itr->second).last;
+}
+
+void
+LinkProbe::AddStats (uint32_t interface, const struct LinkStats &stats)
+{
+  struct PortStats &port = m_stats[interface];
+  port.last = stats;
+  if (m_aggregate)
+  {
+    port.txLinkUtility.Update (stats.txLinkUtility);
+    port.bytesInQueue.Update (stats.bytesInQueue);
+  }
+
+  port.samples.push_back (stats);
+  // Without stream, all the samples stay in memory for OutputToFile
+  if (port.samples.size () >= m_flushSize && m_linkMonitor->IsStreaming ())
+  {
+    m_linkMonitor->Flush (this, interface);
+  }
+}
+
+void
+LinkProbe::ClearSamples (uint32_t interface)
+{
+  m_stats[interface].samples.clear ();
 }
 
+}
@@ -4,6 +4,7 @@
 
 #include "ns3/object.h"
 #include "ns3/nstime.h"
+#include "ns3/quantile-sketch.h"
 
 #include <map>
 #include <vector>
@@ -43,12 +44,34 @@ public:
     uint32_t    bytesInQueueDisc;
   };
 
+  // The samples of a port kept in memory, and its aggregates
+  struct PortStats
+  {
+    // The samples not yet flushed to the stream, in time order
+    std::vector<struct LinkStats> samples;
+
+    // The last sample, even once flushed
+    struct LinkStats last;
+
+    // All the samples since the start, when the monitor aggregates them
+    QuantileSketch txLinkUtility;
+    QuantileSketch bytesInQueue;
+
+    uint32_t GetSize (void) const;
+
+    // The i th sample in memory, from the oldest
+    const struct LinkStats &Get (uint32_t i) const;
+  };
+
   static TypeId GetTypeId (void);
 
   LinkProbe (Ptr<LinkMonitor> linkMonitor);
 
+  // The samples still in memory, in time order
   std::map<uint32_t, std::vector<struct LinkStats> > GetLinkStats (void);
 
+  const std::map<uint32_t, struct PortStats> &GetPortStats (void) const;
+
   void SetProbeName (std::string name);
 
   std::string GetProbeName (void);
@@ -58,15 +81,32 @@ public:
   virtual void Stop () = 0;
 
 protected:
-  // map <interface, list of link stats collected at different time point>
-  // The later ones are inserted at the tail of the list
-  std::map<uint32_t, std::vector<struct LinkStats> > m_stats;
+  // The last sample of a port, null before the first one
+  const struct LinkStats *GetLastStats (uint32_t interface) const;
+
+  // Add a sample to a port. Once the monitor streams, the samples are
+  // flushed to the stream every FlushSize samples.
+  void AddStats (uint32_t interface, const struct LinkStats &stats);
 
   // Used to help identifying the probe
   std::string m_probeName;
+
+private:
+  friend class LinkMonitor;
+
+  // Forget the samples in memory of a port, once flushed
+  void ClearSamples (uint32_t interface);
+
+  // map <interface, samples>
+  std::map<uint32_t, struct PortStats> m_stats;
+
+  // Not a Ptr, the monitor holds the probes
+  LinkMonitor *m_linkMonitor;
+  uint32_t m_probeId;
+  uint32_t m_flushSize;
+  bool m_aggregate;
 };
 
 }
 
 #endif /* LINK_PROBE_H */
-
@@ -5,6 +5,10 @@
 
 // An essential include is test.h
 #include "ns3/test.h"
+#include "ns3/uinteger.h"
+#include "ns3/boolean.h"
+
+#include <fstream>
 
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
@@ -46,6 +50,112 @@ LinkMonitorTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// A probe taking the samples given by the test
+class TestLinkProbe : public LinkProbe
+{
+public:
+  TestLinkProbe (Ptr<LinkMonitor> linkMonitor)
+    : LinkProbe (linkMonitor)
+  {
+  }
+
+  void Add (uint32_t interface, uint32_t i)
+  {
+    struct LinkProbe::LinkStats stats;
+    stats.checkTime = MicroSeconds (i);
+    stats.accumulatedTxBytes = i * 1000;
+    stats.txLinkUtility = i / 10.0;
+    stats.accumulatedDequeueBytes = i * 1000;
+    stats.dequeueLinkUtility = i / 10.0;
+    stats.packetsInQueue = i;
+    stats.bytesInQueue = i * 1000;
+    stats.packetsInQueueDisc = 0;
+    stats.bytesInQueueDisc = 0;
+    AddStats (interface, stats);
+  }
+
+  virtual void Start ()
+  {
+  }
+
+  virtual void Stop ()
+  {
+  }
+};
+
+// The samples all stay in memory without stream, and are flushed to the
+// stream every FlushSize samples otherwise
+class LinkMonitorFlushTestCase : public TestCase
+{
+public:
+  LinkMonitorFlushTestCase ();
+  virtual ~LinkMonitorFlushTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+LinkMonitorFlushTestCase::LinkMonitorFlushTestCase ()
+  : TestCase ("LinkMonitor flushes, stream and aggregates")
+{
+}
+
+LinkMonitorFlushTestCase::~LinkMonitorFlushTestCase ()
+{
+}
+
+void
+LinkMonitorFlushTestCase::DoRun (void)
+{
+  Ptr<LinkMonitor> monitor = CreateObject<LinkMonitor> ();
+  monitor->SetAttribute ("FlushSize", UintegerValue (4));
+  monitor->SetAttribute ("Aggregate", BooleanValue (true));
+  Ptr<TestLinkProbe> probe = Create<TestLinkProbe> (monitor);
+  probe->SetProbeName ("probe");
+
+  for (uint32_t i = 0; i < 10; i++)
+    {
+      probe->Add (1, i);
+    }
+  std::vector<struct LinkProbe::LinkStats> samples = probe->GetLinkStats ()[1];
+  NS_TEST_ASSERT_MSG_EQ (samples.size (), 10, "Without stream, all the samples should stay in memory");
+  NS_TEST_ASSERT_MSG_EQ (samples.front ().checkTime, MicroSeconds (0), "The first sample should be kept");
+  NS_TEST_ASSERT_MSG_EQ (samples.back ().checkTime, MicroSeconds (9), "The samples should keep the time order");
+
+  std::string text = CreateTempDirFilename ("link-monitor.txt");
+  monitor->OutputToFile (text, &LinkMonitor::DefaultFormat);
+  std::ifstream output (text.c_str ());
+  std::string line;
+  std::getline (output, line);
+  NS_TEST_ASSERT_MSG_EQ (line, "probe: (contain: 1 ports)", "Wrong probe line");
+  std::getline (output, line);
+  NS_TEST_ASSERT_MSG_EQ (line, "\tPort: 1 (contain 10 entries)", "Wrong port line");
+  std::getline (output, line);
+  NS_TEST_ASSERT_MSG_EQ (line.substr (0, 23), "\t\t0/0/0/0/0\t0.1/1/1000/", "Wrong samples line");
+
+  const struct LinkProbe::PortStats &port = probe->GetPortStats ().find (1)->second;
+  NS_TEST_ASSERT_MSG_EQ (port.txLinkUtility.Count (), 10, "All the samples should be aggregated");
+  NS_TEST_ASSERT_MSG_EQ_TOL (port.txLinkUtility.Max (), 0.9, 1e-9, "Wrong maximum utility");
+  NS_TEST_ASSERT_MSG_EQ_TOL (port.txLinkUtility.Avg (), 0.45, 1e-9, "Wrong average utility");
+
+  // The samples in memory written at the opening, two flushes of four while
+  // sampling, and the last two samples at the end
+  std::string filename = CreateTempDirFilename ("link-monitor.bin");
+  NS_TEST_ASSERT_MSG_EQ (monitor->OpenStream (filename), true, "Cannot open the stream");
+  for (uint32_t i = 10; i < 20; i++)
+    {
+      probe->Add (1, i);
+    }
+  NS_TEST_ASSERT_MSG_EQ (probe->GetLinkStats ()[1].size (), 2, "Every FlushSize samples should be flushed");
+  monitor->CloseStream ();
+  NS_TEST_ASSERT_MSG_EQ (probe->GetLinkStats ()[1].size (), 0, "The stream should be flushed when closed");
+
+  // Header, name block, then four sample blocks of 48 bytes per sample
+  std::ifstream stream (filename.c_str (), std::ios::binary | std::ios::ate);
+  NS_TEST_ASSERT_MSG_EQ (static_cast<uint32_t> (stream.tellg ()), 8 + 14 + 4 * 13 + 20 * 48,
+                         "The stream should hold all the samples since it was opened");
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +171,7 @@ LinkMonitorTestSuite::LinkMonitorTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new LinkMonitorTestCase1, TestCase::QUICK);
+  AddTestCase (new LinkMonitorFlushTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -0,0 +1,136 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *
+ * A leaf-spine network run by the MultithreadedSimulatorImpl, each leaf
+ * and its servers in a partition and each spine in another one. Every
+ * server sends a TCP flow to a server of the next rack.
+ *
+ * The bytes received do not depend on the number of threads. Use
+ * --threads=0 to run the DefaultSimulatorImpl instead. Configure ns-3
+ * with --enable-mtp to run the partitions on several threads.
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/applications-module.h"
+
+#include <iostream>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedLeafSpine");
+
+int
+main (int argc, char *argv[])
+{
+  uint32_t threads = 1;
+  uint32_t spines = 4;
+  uint32_t leaves = 4;
+  uint32_t servers = 8;
+  double endTime = 0.05;
+
+  CommandLine cmd;
+  cmd.AddValue ("threads", "Threads of the multithreaded simulator, 0 for the default simulator", threads);
+  cmd.AddValue ("spines", "Number of spine switches", spines);
+  cmd.AddValue ("leaves", "Number of leaf switches", leaves);
+  cmd.AddValue ("servers", "Number of servers per leaf", servers);
+  cmd.AddValue ("endTime", "Simulated time in seconds", endTime);
+  cmd.Parse (argc, argv);
+
+  if (threads > 0)
+    {
+      GlobalValue::Bind ("SimulatorImplementationType",
+                         StringValue ("ns3::MultithreadedSimulatorImpl"));
+      Config::SetDefault ("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue (threads));
+    }
+  Config::SetDefault ("ns3::Ipv4GlobalRouting::PerflowEcmpRouting", BooleanValue (true));
+
+  NodeContainer spineNodes;
+  spineNodes.Create (spines);
+  NodeContainer leafNodes;
+  leafNodes.Create (leaves);
+  std::vector<NodeContainer> serverNodes (leaves);
+  for (uint32_t i = 0; i < leaves; ++i)
+    {
+      serverNodes[i].Create (servers);
+    }
+
+  InternetStackHelper internet;
+  internet.Install (spineNodes);
+  internet.Install (leafNodes);
+  for (uint32_t i = 0; i < leaves; ++i)
+    {
+      internet.Install (serverNodes[i]);
+    }
+
+  PointToPointHelper link;
+  link.SetDeviceAttribute ("DataRate", StringValue ("10Gbps"));
+  link.SetChannelAttribute ("Delay", StringValue ("1us"));
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.0.0.0", "255.255.255.0");
+  std::vector<Ipv4InterfaceContainer> serverInterfaces (leaves);
+  for (uint32_t i = 0; i < leaves; ++i)
+    {
+      for (uint32_t j = 0; j < servers; ++j)
+        {
+          NetDeviceContainer devices = link.Install (serverNodes[i].Get (j), leafNodes.Get (i));
+          serverInterfaces[i].Add (address.Assign (devices).Get (0));
+          address.NewNetwork ();
+        }
+      for (uint32_t j = 0; j < spines; ++j)
+        {
+          address.Assign (link.Install (leafNodes.Get (i), spineNodes.Get (j)));
+          address.NewNetwork ();
+        }
+    }
+  Ipv4GlobalRoutingHelper::PopulateRoutingTables ();
+
+  uint16_t port = 5000;
+  ApplicationContainer sinks;
+  for (uint32_t i = 0; i < leaves; ++i)
+    {
+      for (uint32_t j = 0; j < servers; ++j)
+        {
+          PacketSinkHelper sink ("ns3::TcpSocketFactory",
+                                 InetSocketAddress (Ipv4Address::GetAny (), port));
+          sinks.Add (sink.Install (serverNodes[i].Get (j)));
+
+          Ipv4Address destination = serverInterfaces[(i + 1) % leaves].GetAddress (j);
+          BulkSendHelper source ("ns3::TcpSocketFactory", InetSocketAddress (destination, port));
+          ApplicationContainer sourceApp = source.Install (serverNodes[i].Get (j));
+          sourceApp.Start (MicroSeconds (10 * j));
+        }
+    }
+
+  Simulator::Stop (Seconds (endTime));
+  SystemWallClockMs clock;
+  clock.Start ();
+  Simulator::Run ();
+  int64_t elapsed = clock.End ();
+
+  uint64_t received = 0;
+  for (ApplicationContainer::Iterator i = sinks.Begin (); i != sinks.End (); ++i)
+    {
+      received += DynamicCast<PacketSink> (*i)->GetTotalRx ();
+    }
+  std::cout << "Received " << received << " bytes in " << elapsed << " ms" << std::endl;
+
+  Simulator::Destroy ();
+  return 0;
+}
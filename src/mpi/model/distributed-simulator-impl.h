@@ -141,8 +141,8 @@ private:
   bool m_stop;
   bool m_globalFinished;     // Are all parallel instances completed.
   Ptr<Scheduler> m_events;
-  uint32_t m_uid;
-  uint32_t m_currentUid;
+  uint64_t m_uid;
+  uint64_t m_currentUid;
   uint64_t m_currentTs;
   uint32_t m_currentContext;
   // number of events that have been inserted but not yet scheduled,
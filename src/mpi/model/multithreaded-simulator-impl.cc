@@ -0,0 +1,926 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/simulator.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/channel.h"
+#include "ns3/channel-list.h"
+#include "ns3/net-device.h"
+#include "ns3/node.h"
+#include "ns3/node-list.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/assert.h"
+#include "ns3/log.h"
+#include "ns3/partitioned-counter.h"
+#include "ns3/core-config.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <set>
+
+#if defined (NS3_MTP) && defined (HAVE_PTHREAD_H)
+#define MTP_THREADS
+#include <unistd.h>
+#include <sched.h>
+#include "ns3/system-thread.h"
+#endif
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED (MultithreadedSimulatorImpl);
+
+/// Time stamp of an empty event list
+static const uint64_t NO_EVENT = std::numeric_limits<uint64_t>::max ();
+/// Context of the events not bound to a node
+static const uint32_t NO_CONTEXT = 0xffffffff;
+/// Polls of a waiting thread before it yields its processor
+static const uint32_t SPIN_LIMIT = 1000;
+
+#ifdef NS3_MTP
+thread_local MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::g_current = 0;
+#else
+MultithreadedSimulatorImpl::Partition *MultithreadedSimulatorImpl::g_current = 0;
+#endif
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::MultithreadedSimulatorImpl")
+    .SetParent<SimulatorImpl> ()
+    .SetGroupName ("Mpi")
+    .AddConstructor<MultithreadedSimulatorImpl> ()
+    .AddAttribute ("MaxThreads",
+                   "The number of threads running the partitions, "
+                   "0 means one per processor.",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&MultithreadedSimulatorImpl::m_maxThreads),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("Lookahead",
+                   "The smallest delay of an event sent to another partition, "
+                   "0 means the smallest delay of the channels between partitions.",
+                   TimeValue (Seconds (0)),
+                   MakeTimeAccessor (&MultithreadedSimulatorImpl::m_lookaheadAttribute),
+                   MakeTimeChecker ())
+  ;
+  return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl ()
+  : m_maxThreads (0),
+    m_nThreads (1),
+    m_lookahead (NO_EVENT),
+    m_uidStride (1),
+    m_window (0),
+    m_windowEnd (0),
+    m_running (false),
+    m_stop (false)
+{
+  NS_LOG_FUNCTION (this);
+  // uids are allocated from 4.
+  // uid 0 is "invalid" events
+  // uid 1 is "now" events
+  // uid 2 is "destroy" events
+  m_global.uid = 4;
+  // before ::Run is entered, the m_currentUid will be zero
+  m_global.currentUid = 0;
+  m_global.currentTs = 0;
+  m_global.currentContext = NO_CONTEXT;
+  m_global.nextTs = NO_EVENT;
+  m_global.sentMin = NO_EVENT;
+#ifdef NS3_MTP
+  m_exit = false;
+  m_generation = 0;
+  m_done = 0;
+#endif
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose (void)
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_global.events->IsEmpty ())
+    {
+      Scheduler::Event next = m_global.events->RemoveNext ();
+      next.impl->Unref ();
+    }
+  m_global.events = 0;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      delete *i;
+    }
+  m_partitions.clear ();
+  SimulatorImpl::DoDispose ();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy ()
+{
+  NS_LOG_FUNCTION (this);
+  while (!m_destroyEvents.empty ())
+    {
+      Ptr<EventImpl> ev = m_destroyEvents.front ().PeekEventImpl ();
+      m_destroyEvents.pop_front ();
+      NS_LOG_LOGIC ("handle destroy " << ev);
+      if (!ev->IsCancelled ())
+        {
+          ev->Invoke ();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler (ObjectFactory schedulerFactory)
+{
+  NS_LOG_FUNCTION (this << schedulerFactory);
+  NS_ASSERT_MSG (!m_running, "Cannot change the scheduler while running");
+  // Outside of Run all the events are in the global list
+  Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler> ();
+  if (m_global.events != 0)
+    {
+      while (!m_global.events->IsEmpty ())
+        {
+          scheduler->Insert (m_global.events->RemoveNext ());
+        }
+    }
+  m_global.events = scheduler;
+  m_schedulerFactory = schedulerFactory;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      (*i)->events = schedulerFactory.Create<Scheduler> ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetPartition (uint32_t nodeId, uint32_t partition)
+{
+  NS_LOG_FUNCTION (this << nodeId << partition);
+  m_manualPartition[nodeId] = partition;
+  // Partition again at the next Run
+  m_nodePartition.clear ();
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId (void) const
+{
+  return 0;
+}
+
+void
+MultithreadedSimulatorImpl::Partitioning (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nNodes = NodeList::GetNNodes ();
+  std::vector<std::set<uint32_t> > neighbours (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      Ptr<Node> node = NodeList::GetNode (i);
+      for (uint32_t j = 0; j < node->GetNDevices (); ++j)
+        {
+          Ptr<Channel> channel = node->GetDevice (j)->GetChannel ();
+          if (channel == 0)
+            {
+              continue;
+            }
+          for (uint32_t k = 0; k < channel->GetNDevices (); ++k)
+            {
+              uint32_t other = channel->GetDevice (k)->GetNode ()->GetId ();
+              if (other != i)
+                {
+                  neighbours[i].insert (other);
+                }
+            }
+        }
+    }
+
+  // A host, linked to a single switch, joins the partition of the switch.
+  // The partitions given by SetPartition come first.
+  std::vector<std::pair<uint32_t, uint32_t> > keys (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      keys[i] = std::make_pair (1, i);
+      std::map<uint32_t, uint32_t>::const_iterator manual = m_manualPartition.find (i);
+      if (manual != m_manualPartition.end ())
+        {
+          keys[i] = std::make_pair (0, manual->second);
+        }
+    }
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      if (keys[i].first == 1 && neighbours[i].size () == 1)
+        {
+          uint32_t neighbour = *neighbours[i].begin ();
+          if (neighbours[neighbour].size () > 1)
+            {
+              keys[i] = keys[neighbour];
+            }
+        }
+    }
+
+  std::map<std::pair<uint32_t, uint32_t>, uint32_t> numbers;
+  m_nodePartition.assign (nNodes, 0);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      std::map<std::pair<uint32_t, uint32_t>, uint32_t>::iterator number = numbers.find (keys[i]);
+      if (number == numbers.end ())
+        {
+          number = numbers.insert (std::make_pair (keys[i], numbers.size ())).first;
+        }
+      m_nodePartition[i] = number->second;
+    }
+
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      delete *i;
+    }
+  m_partitions.clear ();
+  for (uint32_t i = 0; i < numbers.size (); ++i)
+    {
+      Partition *partition = new Partition ();
+      partition->events = m_schedulerFactory.Create<Scheduler> ();
+      partition->outbox[0].resize (numbers.size () + 1);
+      partition->outbox[1].resize (numbers.size () + 1);
+      partition->requests[0].resize (numbers.size () + 1);
+      partition->requests[1].resize (numbers.size () + 1);
+      m_partitions.push_back (partition);
+    }
+  NS_LOG_INFO (nNodes << " nodes in " << m_partitions.size () << " partitions");
+}
+
+void
+MultithreadedSimulatorImpl::CalculateLookahead (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_lookaheadAttribute.IsStrictlyPositive ())
+    {
+      m_lookahead = m_lookaheadAttribute.GetTimeStep ();
+      return;
+    }
+  m_lookahead = NO_EVENT;
+  for (ChannelList::Iterator i = ChannelList::Begin (); i != ChannelList::End (); ++i)
+    {
+      Ptr<Channel> channel = *i;
+      std::set<uint32_t> partitions;
+      for (uint32_t j = 0; j < channel->GetNDevices (); ++j)
+        {
+          partitions.insert (m_nodePartition[channel->GetDevice (j)->GetNode ()->GetId ()]);
+        }
+      if (partitions.size () < 2)
+        {
+          continue;
+        }
+      TimeValue delay;
+      if (!channel->GetAttributeFailSafe ("Delay", delay))
+        {
+          NS_FATAL_ERROR ("Channel " << channel->GetId () << " links two partitions but has no Delay attribute");
+        }
+      if (!delay.Get ().IsStrictlyPositive ())
+        {
+          NS_FATAL_ERROR ("Channel " << channel->GetId () << " links two partitions without delay");
+        }
+      m_lookahead = std::min (m_lookahead, static_cast<uint64_t> (delay.Get ().GetTimeStep ()));
+    }
+  NS_LOG_INFO ("Lookahead " << m_lookahead);
+}
+
+void
+MultithreadedSimulatorImpl::AssignThreads (void)
+{
+  NS_LOG_FUNCTION (this);
+  m_nThreads = m_maxThreads;
+#ifdef MTP_THREADS
+  if (m_nThreads == 0)
+    {
+      long nProcessors = sysconf (_SC_NPROCESSORS_ONLN);
+      m_nThreads = nProcessors > 0 ? nProcessors : 1;
+    }
+#else
+  if (m_nThreads != 1)
+    {
+      NS_LOG_WARN ("Multithreading is not compiled in, running on a single thread");
+    }
+  m_nThreads = 1;
+#endif /* MTP_THREADS */
+  m_nThreads = std::max (std::min<uint32_t> (m_nThreads, m_partitions.size ()), 1u);
+
+  std::vector<std::pair<uint32_t, uint32_t> > sizes;
+  for (uint32_t i = 0; i < m_partitions.size (); ++i)
+    {
+      sizes.push_back (std::make_pair (0, i));
+    }
+  for (uint32_t i = 0; i < m_nodePartition.size (); ++i)
+    {
+      sizes[m_nodePartition[i]].first++;
+    }
+  // Largest partition first, to the thread with the fewest nodes
+  std::stable_sort (sizes.begin (), sizes.end (), std::greater<std::pair<uint32_t, uint32_t> > ());
+  std::vector<uint32_t> load (m_nThreads, 0);
+  m_threadPartitions.assign (m_nThreads, std::vector<uint32_t> ());
+  for (std::vector<std::pair<uint32_t, uint32_t> >::const_iterator i = sizes.begin (); i != sizes.end (); ++i)
+    {
+      uint32_t thread = std::min_element (load.begin (), load.end ()) - load.begin ();
+      load[thread] += i->first;
+      m_threadPartitions[thread].push_back (i->second);
+    }
+  NS_LOG_INFO (m_partitions.size () << " partitions on " << m_nThreads << " threads");
+}
+
+void
+MultithreadedSimulatorImpl::Distribute (void)
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t nPartitions = m_partitions.size ();
+  m_uidStride = nPartitions + 1;
+  for (uint32_t i = 0; i < nPartitions; ++i)
+    {
+      Partition *partition = m_partitions[i];
+      partition->currentTs = m_global.currentTs;
+      partition->currentUid = m_global.currentUid;
+      partition->currentContext = NO_CONTEXT;
+      partition->uid = m_global.uid + i;
+      partition->sentMin = NO_EVENT;
+      partition->windowTs = partition->currentTs;
+      partition->windowUid = partition->currentUid;
+      partition->stop = false;
+    }
+  m_global.uid += nPartitions;
+
+  // The events keep their uid, the EventIds stay valid
+  Ptr<Scheduler> global = m_schedulerFactory.Create<Scheduler> ();
+  while (!m_global.events->IsEmpty ())
+    {
+      Scheduler::Event ev = m_global.events->RemoveNext ();
+      if (ev.key.m_context < m_nodePartition.size ())
+        {
+          m_partitions[m_nodePartition[ev.key.m_context]]->events->Insert (ev);
+        }
+      else
+        {
+          global->Insert (ev);
+        }
+    }
+  m_global.events = global;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      (*i)->nextTs = PeekTs (*i);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Collect (void)
+{
+  NS_LOG_FUNCTION (this);
+  // Requests sent in the window the simulation stopped in
+  for (uint32_t parity = 0; parity < 2; ++parity)
+    {
+      for (uint32_t i = 0; i <= m_partitions.size (); ++i)
+        {
+          ApplyRequests (i, parity);
+        }
+    }
+  m_uidStride = 1;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      m_global.uid = std::max (m_global.uid, partition->uid);
+      if (partition->currentTs > m_global.currentTs)
+        {
+          m_global.currentTs = partition->currentTs;
+          m_global.currentUid = partition->currentUid;
+        }
+    }
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      Partition *partition = *i;
+      while (!partition->events->IsEmpty ())
+        {
+          m_global.events->Insert (partition->events->RemoveNext ());
+        }
+      // Events sent in the window the simulation stopped in
+      for (uint32_t parity = 0; parity < 2; ++parity)
+        {
+          std::vector<std::vector<Scheduler::Event> > &outbox = partition->outbox[parity];
+          for (std::vector<std::vector<Scheduler::Event> >::iterator j = outbox.begin (); j != outbox.end (); ++j)
+            {
+              for (std::vector<Scheduler::Event>::iterator ev = j->begin (); ev != j->end (); ++ev)
+                {
+                  Insert (&m_global, *ev);
+                }
+              j->clear ();
+            }
+        }
+    }
+}
+
+MultithreadedSimulatorImpl::Partition *
+MultithreadedSimulatorImpl::GetPartition (uint32_t context) const
+{
+  if (m_running && context < m_nodePartition.size ())
+    {
+      return m_partitions[m_nodePartition[context]];
+    }
+  return const_cast<Partition *> (&m_global);
+}
+
+bool
+MultithreadedSimulatorImpl::DeferRequest (const EventId &id, bool remove)
+{
+  // The global events run while the partitions wait
+  if (g_current == 0)
+    {
+      return false;
+    }
+  Partition *target = GetPartition (id.GetContext ());
+  if (target == g_current)
+    {
+      return false;
+    }
+  uint32_t index = target == &m_global ? m_partitions.size () : m_nodePartition[id.GetContext ()];
+  g_current->requests[m_window & 1][index].push_back (std::make_pair (id, remove));
+  return true;
+}
+
+void
+MultithreadedSimulatorImpl::ApplyRequests (uint32_t index, uint32_t parity)
+{
+  for (std::vector<Partition *>::const_iterator source = m_partitions.begin (); source != m_partitions.end (); ++source)
+    {
+      std::vector<std::pair<EventId, bool> > &requests = (*source)->requests[parity][index];
+      for (std::vector<std::pair<EventId, bool> >::const_iterator i = requests.begin (); i != requests.end (); ++i)
+        {
+          if (i->second)
+            {
+              Remove (i->first);
+            }
+          else
+            {
+              Cancel (i->first);
+            }
+        }
+      requests.clear ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Insert (Partition *partition, Scheduler::Event &ev)
+{
+  ev.key.m_uid = partition->uid;
+  partition->uid += m_uidStride;
+  partition->events->Insert (ev);
+  if (ev.key.m_ts < partition->nextTs)
+    {
+      partition->nextTs = ev.key.m_ts;
+    }
+}
+
+uint64_t
+MultithreadedSimulatorImpl::PeekTs (const Partition *partition) const
+{
+  return partition->events->IsEmpty () ? NO_EVENT : partition->events->PeekNext ().key.m_ts;
+}
+
+void
+MultithreadedSimulatorImpl::ProcessGlobalEvent (void)
+{
+  Scheduler::Event next = m_global.events->RemoveNext ();
+  NS_ASSERT (next.key.m_ts >= m_global.currentTs);
+  NS_LOG_LOGIC ("handle global " << next.key.m_ts);
+  m_global.currentTs = next.key.m_ts;
+  m_global.currentContext = next.key.m_context;
+  m_global.currentUid = next.key.m_uid;
+  next.impl->Invoke ();
+  next.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow (uint32_t thread)
+{
+  // The events received in the previous window
+  uint32_t parity = (m_window + 1) & 1;
+  const std::vector<uint32_t> &partitions = m_threadPartitions[thread];
+  for (std::vector<uint32_t>::const_iterator i = partitions.begin (); i != partitions.end (); ++i)
+    {
+      Partition *partition = m_partitions[*i];
+      g_current = partition;
+      PartitionedCounter::SetCurrentPartition (*i);
+      partition->sentMin = NO_EVENT;
+      for (std::vector<Partition *>::const_iterator source = m_partitions.begin (); source != m_partitions.end (); ++source)
+        {
+          std::vector<Scheduler::Event> &inbox = (*source)->outbox[parity][*i];
+          for (std::vector<Scheduler::Event>::iterator ev = inbox.begin (); ev != inbox.end (); ++ev)
+            {
+              Insert (partition, *ev);
+            }
+          inbox.clear ();
+        }
+      ApplyRequests (*i, parity);
+
+      Scheduler *events = PeekPointer (partition->events);
+      while (!events->IsEmpty () && !partition->stop)
+        {
+          if (events->PeekNext ().key.m_ts >= m_windowEnd)
+            {
+              break;
+            }
+          Scheduler::Event next = events->RemoveNext ();
+          NS_ASSERT (next.key.m_ts >= partition->currentTs);
+          partition->currentTs = next.key.m_ts;
+          partition->currentContext = next.key.m_context;
+          partition->currentUid = next.key.m_uid;
+          next.impl->Invoke ();
+          next.impl->Unref ();
+        }
+      partition->nextTs = PeekTs (partition);
+    }
+  g_current = 0;
+  PartitionedCounter::SetCurrentPartition (m_partitions.size ());
+}
+
+void
+MultithreadedSimulatorImpl::RunWindow (uint64_t windowEnd)
+{
+  m_windowEnd = windowEnd;
+  m_window++;
+  for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      (*i)->windowTs = (*i)->currentTs;
+      (*i)->windowUid = (*i)->currentUid;
+    }
+#ifdef MTP_THREADS
+  if (m_nThreads > 1)
+    {
+      m_done = 0;
+      m_generation++;
+      ProcessWindow (0);
+      uint32_t spins = 0;
+      while (m_done != m_nThreads - 1)
+        {
+          if (++spins > SPIN_LIMIT)
+            {
+              sched_yield ();
+            }
+        }
+      return;
+    }
+#endif /* MTP_THREADS */
+  ProcessWindow (0);
+}
+
+void
+MultithreadedSimulatorImpl::RunWorker (MultithreadedSimulatorImpl *impl, uint32_t thread)
+{
+#ifdef MTP_THREADS
+  uint32_t generation = 0;
+  while (true)
+    {
+      uint32_t spins = 0;
+      while (impl->m_generation == generation)
+        {
+          if (++spins > SPIN_LIMIT)
+            {
+              sched_yield ();
+            }
+        }
+      generation = impl->m_generation;
+      if (impl->m_exit)
+        {
+          return;
+        }
+      impl->ProcessWindow (thread);
+      impl->m_done++;
+    }
+#endif /* MTP_THREADS */
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished (void) const
+{
+  if (m_stop)
+    {
+      return true;
+    }
+  for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+    {
+      if (!(*i)->events->IsEmpty ())
+        {
+          return false;
+        }
+    }
+  return m_global.events->IsEmpty ();
+}
+
+void
+MultithreadedSimulatorImpl::Run (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (m_nodePartition.size () != NodeList::GetNNodes ())
+    {
+      Partitioning ();
+      CalculateLookahead ();
+      AssignThreads ();
+    }
+  m_running = true;
+  m_stop = false;
+  m_window = 0;
+  Distribute ();
+  PartitionedCounter::BeginPartitions (m_partitions.size ());
+
+#ifdef MTP_THREADS
+  // The main thread runs the partitions of thread 0
+  m_exit = false;
+  m_generation = 0;
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 1; i < m_nThreads; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&MultithreadedSimulatorImpl::RunWorker, this, i)));
+      threads.back ()->Start ();
+    }
+#endif /* MTP_THREADS */
+
+  uint32_t global = m_partitions.size ();
+  while (true)
+    {
+      // The events sent to the global list in the last window
+      for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          std::vector<Scheduler::Event> &inbox = (*i)->outbox[m_window & 1][global];
+          for (std::vector<Scheduler::Event>::iterator ev = inbox.begin (); ev != inbox.end (); ++ev)
+            {
+              Insert (&m_global, *ev);
+            }
+          inbox.clear ();
+        }
+      ApplyRequests (global, m_window & 1);
+      for (std::vector<Partition *>::iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          if ((*i)->stop)
+            {
+              (*i)->stop = false;
+              m_stop = true;
+            }
+        }
+      if (m_stop)
+        {
+          break;
+        }
+
+      // No partition can receive an event before the lookahead after the
+      // earliest event, either in a list or sent in the last window
+      uint64_t minNext = NO_EVENT;
+      for (std::vector<Partition *>::const_iterator i = m_partitions.begin (); i != m_partitions.end (); ++i)
+        {
+          minNext = std::min (minNext, std::min ((*i)->nextTs, (*i)->sentMin));
+        }
+      uint64_t globalNext = PeekTs (&m_global);
+      if (minNext == NO_EVENT && globalNext == NO_EVENT)
+        {
+          break;
+        }
+      if (globalNext <= minNext)
+        {
+          // The partitions wait, a global event may touch any node
+          ProcessGlobalEvent ();
+          continue;
+        }
+      uint64_t windowEnd = NO_EVENT - minNext > m_lookahead ? minNext + m_lookahead : NO_EVENT;
+      RunWindow (std::min (windowEnd, globalNext));
+    }
+
+#ifdef MTP_THREADS
+  m_exit = true;
+  m_generation++;
+  for (std::vector<Ptr<SystemThread> >::iterator i = threads.begin (); i != threads.end (); ++i)
+    {
+      (*i)->Join ();
+    }
+#endif /* MTP_THREADS */
+
+  Collect ();
+  PartitionedCounter::EndPartitions ();
+  m_running = false;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (void)
+{
+  NS_LOG_FUNCTION (this);
+  if (g_current != 0)
+    {
+      g_current->stop = true;
+      return;
+    }
+  m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop (Time const &delay)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep ());
+  Simulator::Schedule (delay, &Simulator::Stop);
+}
+
+EventId
+MultithreadedSimulatorImpl::Schedule (Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << delay.GetTimeStep () << event);
+  Partition *partition = g_current != 0 ? g_current : &m_global;
+
+  Time tAbsolute = delay + TimeStep (partition->currentTs);
+  NS_ASSERT (tAbsolute.IsPositive ());
+  NS_ASSERT (tAbsolute >= TimeStep (partition->currentTs));
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = (uint64_t) tAbsolute.GetTimeStep ();
+  ev.key.m_context = partition->currentContext;
+  Insert (partition, ev);
+  return EventId (event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event)
+{
+  NS_LOG_FUNCTION (this << context << delay.GetTimeStep () << event);
+  Partition *source = g_current != 0 ? g_current : &m_global;
+  Partition *destination = GetPartition (context);
+
+  Scheduler::Event ev;
+  ev.impl = event;
+  ev.key.m_ts = source->currentTs + delay.GetTimeStep ();
+  ev.key.m_context = context;
+  // The global events run while the partitions wait
+  if (source == destination || source == &m_global)
+    {
+      Insert (destination, ev);
+      return;
+    }
+
+  if (static_cast<uint64_t> (delay.GetTimeStep ()) < m_lookahead)
+    {
+      NS_FATAL_ERROR ("Event for context " << context << " from context " << source->currentContext <<
+                      " in " << delay << ", less than the lookahead " << TimeStep (m_lookahead));
+    }
+  uint32_t index = destination == &m_global ? m_partitions.size () : m_nodePartition[context];
+  source->outbox[m_window & 1][index].push_back (ev);
+  source->sentMin = std::min (source->sentMin, ev.key.m_ts);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow (EventImpl *event)
+{
+  return Schedule (TimeStep (0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy (EventImpl *event)
+{
+  CriticalSection cs (m_destroyMutex);
+  EventId id (Ptr<EventImpl> (event, false), Now ().GetTimeStep (), NO_CONTEXT, 2);
+  m_destroyEvents.push_back (id);
+  return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now (void) const
+{
+  // Do not add function logging here, to avoid stack overflow
+  return TimeStep (g_current != 0 ? g_current->currentTs : m_global.currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft (const EventId &id) const
+{
+  if (IsExpired (id))
+    {
+      return TimeStep (0);
+    }
+  else
+    {
+      return TimeStep (id.GetTs ()) - Now ();
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove (const EventId &id)
+{
+  if (id.GetUid () == 2)
+    {
+      // destroy events.
+      CriticalSection cs (m_destroyMutex);
+      for (DestroyEvents::iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              m_destroyEvents.erase (i);
+              break;
+            }
+        }
+      return;
+    }
+  if (DeferRequest (id, true) || IsExpired (id))
+    {
+      return;
+    }
+  Scheduler::Event event;
+  event.impl = id.PeekEventImpl ();
+  event.key.m_ts = id.GetTs ();
+  event.key.m_context = id.GetContext ();
+  event.key.m_uid = id.GetUid ();
+  GetPartition (id.GetContext ())->events->Remove (event);
+  event.impl->Cancel ();
+  // whenever we remove an event from the event list, we have to unref it.
+  event.impl->Unref ();
+}
+
+void
+MultithreadedSimulatorImpl::Cancel (const EventId &id)
+{
+  if (!DeferRequest (id, false) && !IsExpired (id))
+    {
+      id.PeekEventImpl ()->Cancel ();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired (const EventId &id) const
+{
+  if (id.GetUid () == 2)
+    {
+      if (id.PeekEventImpl () == 0 ||
+          id.PeekEventImpl ()->IsCancelled ())
+        {
+          return true;
+        }
+      // destroy events.
+      CriticalSection cs (const_cast<SystemMutex &> (m_destroyMutex));
+      for (DestroyEvents::const_iterator i = m_destroyEvents.begin (); i != m_destroyEvents.end (); i++)
+        {
+          if (*i == id)
+            {
+              return false;
+            }
+        }
+      return true;
+    }
+  const Partition *partition = GetPartition (id.GetContext ());
+  if (id.PeekEventImpl () == 0)
+    {
+      return true;
+    }
+  if (g_current != 0 && partition != g_current && partition != &m_global)
+    {
+      // Another partition is running: its clock at the start of the
+      // window, and not its cancelled flag, which it may be writing
+      return id.GetTs () < partition->windowTs ||
+             (id.GetTs () == partition->windowTs &&
+              id.GetUid () <= partition->windowUid);
+    }
+  if (id.GetTs () < partition->currentTs ||
+      (id.GetTs () == partition->currentTs &&
+       id.GetUid () <= partition->currentUid) ||
+      id.PeekEventImpl ()->IsCancelled ())
+    {
+      return true;
+    }
+  else
+    {
+      return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime (void) const
+{
+  return TimeStep (0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext (void) const
+{
+  return g_current != 0 ? g_current->currentContext : m_global.currentContext;
+}
+
+} // namespace ns3
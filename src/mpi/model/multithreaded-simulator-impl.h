@@ -0,0 +1,196 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_MULTITHREADED_SIMULATOR_IMPL_H
+#define NS3_MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/simulator-impl.h"
+#include "ns3/scheduler.h"
+#include "ns3/event-impl.h"
+#include "ns3/system-mutex.h"
+#include "ns3/nstime.h"
+#include "ns3/ptr.h"
+
+#include <list>
+#include <map>
+#include <vector>
+#ifdef NS3_MTP
+#include <atomic>
+#endif
+
+namespace ns3 {
+
+/**
+ * \ingroup simulator
+ * \ingroup mpi
+ * \brief Conservative parallel simulator running the partitions of one
+ * process on several threads
+ *
+ * The nodes are split into partitions, by default one per switch with
+ * the hosts attached to it, and each partition has its own event list.
+ * The simulation advances in windows as long as the lookahead: within a
+ * window no partition can receive an event from another one, so the
+ * worker threads run their partitions without locks. The events crossing
+ * partitions wait in per pair buffers, each one written by a single
+ * thread, and are inserted by the receiving partition at the start of the
+ * next window. The events without a node context run alone on the main
+ * thread between the windows.
+ *
+ * The lookahead is the smallest "Delay" attribute of the channels linking
+ * two partitions, and an event scheduled for another partition sooner
+ * than that is a fatal error.
+ *
+ * An event of another partition is never touched during a window: Remove
+ * and Cancel are applied by its partition at the start of the next
+ * window, and IsExpired tells whether it had run at the start of the
+ * current window, without seeing whether it was cancelled. Stop from a
+ * partition stops it at once and the others at the end of the window.
+ * The packet uids, the flow ids and the random streams assigned during
+ * Run come from a PartitionedCounter, so that each partition gets the
+ * same values with any number of threads.
+ *
+ * ns-3 must be configured with --enable-mtp to make the packets safe to
+ * hand between threads, otherwise the partitions run on the main thread.
+ * The results then do not depend on the number of threads as long as the
+ * models do not share state between the nodes of two partitions.
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+public:
+  static TypeId GetTypeId (void);
+
+  MultithreadedSimulatorImpl ();
+  ~MultithreadedSimulatorImpl ();
+
+  // virtual from SimulatorImpl
+  virtual void Destroy ();
+  virtual bool IsFinished (void) const;
+  virtual void Stop (void);
+  virtual void Stop (Time const &delay);
+  virtual EventId Schedule (Time const &delay, EventImpl *event);
+  virtual void ScheduleWithContext (uint32_t context, Time const &delay, EventImpl *event);
+  virtual EventId ScheduleNow (EventImpl *event);
+  virtual EventId ScheduleDestroy (EventImpl *event);
+  virtual void Remove (const EventId &id);
+  virtual void Cancel (const EventId &id);
+  virtual bool IsExpired (const EventId &id) const;
+  virtual void Run (void);
+  virtual Time Now (void) const;
+  virtual Time GetDelayLeft (const EventId &id) const;
+  virtual Time GetMaximumSimulationTime (void) const;
+  virtual void SetScheduler (ObjectFactory schedulerFactory);
+  virtual uint32_t GetSystemId (void) const;
+  virtual uint32_t GetContext (void) const;
+
+  /**
+   * Put a node in a partition instead of the automatic partitioning.
+   * The nodes which are not given a partition get one of their own.
+   *
+   * \param nodeId the node id
+   * \param partition the partition number
+   */
+  void SetPartition (uint32_t nodeId, uint32_t partition);
+
+private:
+  virtual void DoDispose (void);
+
+  /// The event list and the clock of one partition
+  struct Partition
+  {
+    Ptr<Scheduler> events;
+    uint64_t currentTs;
+    uint64_t currentUid;
+    uint32_t currentContext;
+    uint64_t uid;
+    // Time stamp of the first event left after the last window
+    uint64_t nextTs;
+    // Smallest time stamp of the events sent to other partitions in the last window
+    uint64_t sentMin;
+    // Events for each partition, the global one last, double buffered by window
+    std::vector<std::vector<Scheduler::Event> > outbox[2];
+    // Remove and Cancel of the events of each partition, the global one last
+    std::vector<std::vector<std::pair<EventId, bool> > > requests[2];
+    // Clock at the start of the window, seen by the other partitions
+    uint64_t windowTs;
+    uint64_t windowUid;
+    // Stop called by one of the events of the window
+    bool stop;
+  };
+
+  // Split the nodes into partitions, one per switch with its hosts
+  void Partitioning (void);
+  void CalculateLookahead (void);
+  // Spread the partitions on the threads, the largest first
+  void AssignThreads (void);
+  // Move the events with a node context to their partition, at the start of Run
+  void Distribute (void);
+  // Move all the events back to the global list, at the end of Run
+  void Collect (void);
+
+  Partition *GetPartition (uint32_t context) const;
+  // Send a Remove (or a Cancel) of an event of another partition to it
+  bool DeferRequest (const EventId &id, bool remove);
+  // Apply the requests of the last window to a partition, the global one last
+  void ApplyRequests (uint32_t index, uint32_t parity);
+  void Insert (Partition *partition, Scheduler::Event &ev);
+  uint64_t PeekTs (const Partition *partition) const;
+
+  void ProcessGlobalEvent (void);
+  // Run the partitions of a thread up to the end of the window
+  void ProcessWindow (uint32_t thread);
+  void RunWindow (uint64_t windowEnd);
+  static void RunWorker (MultithreadedSimulatorImpl *impl, uint32_t thread);
+
+  typedef std::list<EventId> DestroyEvents;
+
+  DestroyEvents m_destroyEvents;
+  SystemMutex m_destroyMutex;
+  ObjectFactory m_schedulerFactory;
+
+  // The events without a node context, and all of them before Run
+  Partition m_global;
+  std::vector<Partition *> m_partitions;
+  // Partition of each node
+  std::vector<uint32_t> m_nodePartition;
+  std::map<uint32_t, uint32_t> m_manualPartition;
+
+  uint32_t m_maxThreads;
+  uint32_t m_nThreads;
+  std::vector<std::vector<uint32_t> > m_threadPartitions;
+  Time m_lookaheadAttribute;
+  uint64_t m_lookahead;
+  // The uids of the partitions are interleaved, so that they stay unique,
+  // and 64 bits wide, so that the stride does not make them wrap
+  uint32_t m_uidStride;
+  uint32_t m_window;
+  uint64_t m_windowEnd;
+  bool m_running;
+
+  // Only set by the main thread, the partitions stop through their flag
+  bool m_stop;
+#ifdef NS3_MTP
+  std::atomic<bool> m_exit;
+  std::atomic<uint32_t> m_generation;
+  std::atomic<uint32_t> m_done;
+  static thread_local Partition *g_current;
+#else
+  static Partition *g_current;
+#endif
+};
+
+} // namespace ns3
+
+#endif /* NS3_MULTITHREADED_SIMULATOR_IMPL_H */
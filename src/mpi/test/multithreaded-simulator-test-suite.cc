@@ -0,0 +1,340 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/test.h"
+#include "ns3/simulator.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/rng-seed-manager.h"
+#include "ns3/random-variable-stream.h"
+#include "ns3/uinteger.h"
+#include "ns3/nstime.h"
+#include "ns3/node.h"
+#include "ns3/node-container.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/mac48-address.h"
+#include "ns3/packet.h"
+#include "ns3/flow-id-tag.h"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+namespace {
+
+const uint32_t SWITCHES = 4;
+const uint32_t HOSTS_PER_SWITCH = 2;
+const uint32_t HOSTS = SWITCHES * HOSTS_PER_SWITCH;
+
+/**
+ * Switches linked in a full mesh, each one with its hosts in a partition.
+ * The hosts send packets to random hosts, drawing their random streams,
+ * flow ids and packet uids during the run. The events of one host also
+ * remove, cancel and check the events of another partition, and one of
+ * them stops the simulation. Everything the hosts see is logged.
+ */
+class MultithreadedScenario
+{
+public:
+  /**
+   * Run the scenario on the multithreaded simulator.
+   * \param threads the number of threads
+   * \returns the logs of the hosts and of the global events
+   */
+  std::string Run (uint32_t threads);
+
+  /** \returns the time the simulation stopped at */
+  Time GetStopTime (void) const;
+
+private:
+  void Build (void);
+  void Send (uint32_t host);
+  bool SwitchReceive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  bool HostReceive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from);
+  // Events of the last host, touched by the first one
+  void ScheduleTargets (uint32_t host);
+  void Target (uint32_t host, std::string name);
+  void Meddle (uint32_t host);
+  void StopFrom (uint32_t host);
+  void GlobalEvent (void);
+
+  std::vector<Ptr<NetDevice> > m_hostDevice;
+  // The device of the switch toward each host
+  std::vector<Ptr<NetDevice> > m_switchToHost;
+  // The device of a switch toward another one
+  std::vector<std::vector<Ptr<NetDevice> > > m_switchToSwitch;
+  std::vector<Ptr<UniformRandomVariable> > m_rand;
+  std::vector<std::ostringstream *> m_logs;
+  std::ostringstream m_globalLog;
+  EventId m_early;
+  EventId m_removed;
+  EventId m_cancelled;
+  uint64_t m_uidBase;
+  uint32_t m_flowIdBase;
+  Time m_stopTime;
+};
+
+void
+MultithreadedScenario::Build (void)
+{
+  NodeContainer switches;
+  switches.Create (SWITCHES);
+  NodeContainer hosts;
+  hosts.Create (HOSTS);
+
+  SimpleNetDeviceHelper hostLink;
+  hostLink.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (1)));
+  SimpleNetDeviceHelper switchLink;
+  switchLink.SetChannelAttribute ("Delay", TimeValue (MicroSeconds (10)));
+
+  m_hostDevice.assign (HOSTS, 0);
+  m_switchToHost.assign (HOSTS, 0);
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      NetDeviceContainer devices = hostLink.Install (NodeContainer (hosts.Get (i), switches.Get (i / HOSTS_PER_SWITCH)));
+      m_hostDevice[i] = devices.Get (0);
+      m_switchToHost[i] = devices.Get (1);
+      m_hostDevice[i]->SetReceiveCallback (MakeCallback (&MultithreadedScenario::HostReceive, this));
+      m_switchToHost[i]->SetReceiveCallback (MakeCallback (&MultithreadedScenario::SwitchReceive, this));
+    }
+  m_switchToSwitch.assign (SWITCHES, std::vector<Ptr<NetDevice> > (SWITCHES));
+  for (uint32_t i = 0; i < SWITCHES; ++i)
+    {
+      for (uint32_t j = i + 1; j < SWITCHES; ++j)
+        {
+          NetDeviceContainer devices = switchLink.Install (NodeContainer (switches.Get (i), switches.Get (j)));
+          m_switchToSwitch[i][j] = devices.Get (0);
+          m_switchToSwitch[j][i] = devices.Get (1);
+          devices.Get (0)->SetReceiveCallback (MakeCallback (&MultithreadedScenario::SwitchReceive, this));
+          devices.Get (1)->SetReceiveCallback (MakeCallback (&MultithreadedScenario::SwitchReceive, this));
+        }
+    }
+}
+
+std::string
+MultithreadedScenario::Run (uint32_t threads)
+{
+  Simulator::Destroy ();
+  RngSeedManager::SetSeed (3);
+  RngSeedManager::SetRun (5);
+  RngSeedManager::ResetNextStreamIndex ();
+  Ptr<MultithreadedSimulatorImpl> impl = CreateObject<MultithreadedSimulatorImpl> ();
+  impl->SetAttribute ("MaxThreads", UintegerValue (threads));
+  Simulator::SetImplementation (impl);
+
+  Build ();
+  m_rand.assign (HOSTS, 0);
+  m_logs.clear ();
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      m_logs.push_back (new std::ostringstream ());
+    }
+  m_globalLog.str ("");
+  m_early = EventId ();
+  m_removed = EventId ();
+  m_cancelled = EventId ();
+  // The values drawn during the run, relative to the ones before
+  m_uidBase = Create<Packet> ()->GetUid ();
+  m_flowIdBase = FlowIdTag::AllocateFlowId ();
+
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      Simulator::ScheduleWithContext (m_hostDevice[i]->GetNode ()->GetId (), MicroSeconds (i),
+                                      &MultithreadedScenario::Send, this, i);
+    }
+  Simulator::ScheduleWithContext (m_hostDevice[HOSTS - 1]->GetNode ()->GetId (), MicroSeconds (3),
+                                  &MultithreadedScenario::ScheduleTargets, this, HOSTS - 1);
+  Simulator::ScheduleWithContext (m_hostDevice[0]->GetNode ()->GetId (), MicroSeconds (300),
+                                  &MultithreadedScenario::Meddle, this, 0);
+  Simulator::Schedule (MicroSeconds (1000), &MultithreadedScenario::GlobalEvent, this);
+  Simulator::ScheduleWithContext (m_hostDevice[HOSTS_PER_SWITCH]->GetNode ()->GetId (), MicroSeconds (2000),
+                                  &MultithreadedScenario::StopFrom, this, HOSTS_PER_SWITCH);
+  Simulator::Run ();
+  m_stopTime = Simulator::Now ();
+
+  std::ostringstream logs;
+  for (uint32_t i = 0; i < HOSTS; ++i)
+    {
+      logs << "host " << i << std::endl << m_logs[i]->str ();
+      delete m_logs[i];
+    }
+  m_logs.clear ();
+  logs << "global" << std::endl << m_globalLog.str ();
+  m_rand.clear ();
+  m_hostDevice.clear ();
+  m_switchToHost.clear ();
+  m_switchToSwitch.clear ();
+  Simulator::Destroy ();
+  return logs.str ();
+}
+
+Time
+MultithreadedScenario::GetStopTime (void) const
+{
+  return m_stopTime;
+}
+
+void
+MultithreadedScenario::Send (uint32_t host)
+{
+  // The random streams are assigned in the partition of the host
+  if (m_rand[host] == 0)
+    {
+      m_rand[host] = CreateObject<UniformRandomVariable> ();
+    }
+  uint8_t data[2];
+  uint32_t destination = m_rand[host]->GetInteger (0, HOSTS - 2);
+  data[0] = destination < host ? destination : destination + 1;
+  data[1] = host;
+  Ptr<Packet> packet = Create<Packet> (data, 2);
+  uint32_t flowId = FlowIdTag::AllocateFlowId ();
+  FlowIdTag (flowId).AddTo (packet);
+  *m_logs[host] << Simulator::Now ().GetNanoSeconds () << " send " << (uint32_t) data[0]
+                << " flow " << flowId - m_flowIdBase << " uid " << packet->GetUid () - m_uidBase << std::endl;
+  m_hostDevice[host]->Send (packet, Mac48Address::GetBroadcast (), 0x0800);
+  Simulator::Schedule (NanoSeconds (m_rand[host]->GetInteger (1000, 20000)), &MultithreadedScenario::Send, this, host);
+}
+
+bool
+MultithreadedScenario::SwitchReceive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  uint32_t sw = device->GetNode ()->GetId ();
+  uint8_t data[2];
+  packet->CopyData (data, 2);
+  uint32_t destinationSwitch = data[0] / HOSTS_PER_SWITCH;
+  Ptr<NetDevice> out = destinationSwitch == sw ? m_switchToHost[data[0]] : m_switchToSwitch[sw][destinationSwitch];
+  out->Send (packet->Copy (), Mac48Address::GetBroadcast (), protocol);
+  return true;
+}
+
+bool
+MultithreadedScenario::HostReceive (Ptr<NetDevice> device, Ptr<const Packet> packet, uint16_t protocol, const Address &from)
+{
+  uint32_t host = device->GetNode ()->GetId () - SWITCHES;
+  uint8_t data[2];
+  packet->CopyData (data, 2);
+  FlowIdTag flowId;
+  flowId.PeekFrom (packet);
+  *m_logs[host] << Simulator::Now ().GetNanoSeconds () << " recv " << (uint32_t) data[1]
+                << " flow " << flowId.GetFlowId () - m_flowIdBase << " uid " << packet->GetUid () - m_uidBase << std::endl;
+  return true;
+}
+
+void
+MultithreadedScenario::ScheduleTargets (uint32_t host)
+{
+  m_early = Simulator::Schedule (MicroSeconds (10), &MultithreadedScenario::Target, this, host, "early");
+  m_removed = Simulator::Schedule (MicroSeconds (500), &MultithreadedScenario::Target, this, host, "removed");
+  m_cancelled = Simulator::Schedule (MicroSeconds (500), &MultithreadedScenario::Target, this, host, "cancelled");
+}
+
+void
+MultithreadedScenario::Target (uint32_t host, std::string name)
+{
+  *m_logs[host] << Simulator::Now ().GetNanoSeconds () << " target " << name << std::endl;
+}
+
+void
+MultithreadedScenario::Meddle (uint32_t host)
+{
+  *m_logs[host] << Simulator::Now ().GetNanoSeconds () << " expired " << m_early.IsExpired ()
+                << " " << m_removed.IsExpired () << std::endl;
+  Simulator::Remove (m_removed);
+  Simulator::Cancel (m_cancelled);
+}
+
+void
+MultithreadedScenario::StopFrom (uint32_t host)
+{
+  *m_logs[host] << Simulator::Now ().GetNanoSeconds () << " stop" << std::endl;
+  Simulator::Stop ();
+}
+
+void
+MultithreadedScenario::GlobalEvent (void)
+{
+  Ptr<UniformRandomVariable> rand = CreateObject<UniformRandomVariable> ();
+  m_globalLog << Simulator::Now ().GetNanoSeconds () << " rand " << rand->GetInteger (0, 1000000)
+              << " flow " << FlowIdTag::AllocateFlowId () - m_flowIdBase
+              << " uid " << Create<Packet> ()->GetUid () - m_uidBase << std::endl;
+}
+
+} // anonymous namespace
+
+/**
+ * \ingroup mpi
+ * Run the same scenario with 1 and several threads and compare what the
+ * hosts saw.
+ */
+class MultithreadedSimulatorThreadsTestCase : public TestCase
+{
+public:
+  MultithreadedSimulatorThreadsTestCase ();
+  virtual void DoRun (void);
+};
+
+MultithreadedSimulatorThreadsTestCase::MultithreadedSimulatorThreadsTestCase ()
+  : TestCase ("Check that the results do not depend on the number of threads")
+{
+}
+
+void
+MultithreadedSimulatorThreadsTestCase::DoRun (void)
+{
+  uint32_t seed = RngSeedManager::GetSeed ();
+  uint64_t run = RngSeedManager::GetRun ();
+  MultithreadedScenario scenario;
+  std::string reference = scenario.Run (1);
+  Time stopTime = scenario.GetStopTime ();
+  NS_TEST_ASSERT_MSG_NE (reference.find (" recv "), std::string::npos, "The hosts should receive packets");
+  NS_TEST_EXPECT_MSG_NE (reference.find (" target early"), std::string::npos, "The early event should run");
+  NS_TEST_EXPECT_MSG_EQ (reference.find (" target removed"), std::string::npos, "The removed event should not run");
+  NS_TEST_EXPECT_MSG_EQ (reference.find (" target cancelled"), std::string::npos, "The cancelled event should not run");
+  NS_TEST_EXPECT_MSG_NE (reference.find ("300000 expired 1 0"), std::string::npos,
+                         "The early event should be expired, the removed one not yet");
+  NS_TEST_EXPECT_MSG_NE (reference.find ("1000000 rand "), std::string::npos, "The global event should run");
+  NS_TEST_EXPECT_MSG_EQ ((stopTime >= MicroSeconds (2000) && stopTime < MicroSeconds (2010)), true,
+                         "The simulation should stop within a lookahead after the Stop, at " << stopTime);
+
+  for (uint32_t threads = 2; threads <= 4; threads += 2)
+    {
+      std::string logs = scenario.Run (threads);
+      NS_TEST_EXPECT_MSG_EQ (logs, reference, "Different results with " << threads << " threads");
+      NS_TEST_EXPECT_MSG_EQ (scenario.GetStopTime (), stopTime, "Different stop time with " << threads << " threads");
+    }
+  RngSeedManager::SetSeed (seed);
+  RngSeedManager::SetRun (run);
+}
+
+/**
+ * \ingroup mpi
+ * The multithreaded simulator test suite.
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+public:
+  MultithreadedSimulatorTestSuite ();
+};
+
+MultithreadedSimulatorTestSuite::MultithreadedSimulatorTestSuite ()
+  : TestSuite ("multithreaded-simulator", UNIT)
+{
+  AddTestCase (new MultithreadedSimulatorThreadsTestCase, TestCase::QUICK);
+}
+
+static MultithreadedSimulatorTestSuite g_multithreadedSimulatorTestSuite;
@@ -23,6 +23,9 @@
 #include <stdint.h>
 #include <vector>
 #include <ostream>
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 #include "ns3/assert.h"
 
 #define BUFFER_FREE_LIST 1
@@ -657,7 +660,11 @@ private:
      * The reference count of an instance of this data structure.
      * Each buffer which references an instance holds a count.
      */
+#ifdef NS3_MTP
+    std::atomic<uint32_t> m_count;
+#else
     uint32_t m_count;
+#endif
     /**
      * the size of the m_data field below.
      */
@@ -761,7 +768,11 @@ private:
    * writing data. i.e., m_start should be initialized to this 
    * value.
    */
+#ifdef NS3_MTP
+  static thread_local uint32_t g_recommendedStart;
+#else
   static uint32_t g_recommendedStart;
+#endif
 
   /**
    * offset to the start of the virtual zero area from the start
@@ -792,10 +803,17 @@ private:
   {
     ~LocalStaticDestructor ();
   };
+#ifdef NS3_MTP
+  // One free list per thread, a buffer freed by another thread joins its list
+  static thread_local uint32_t g_maxSize; //!< Max observed data size
+  static thread_local FreeList *g_freeList; //!< Buffer data container
+  static thread_local struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
+#else
   static uint32_t g_maxSize; //!< Max observed data size
   static FreeList *g_freeList; //!< Buffer data container
   static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
 #endif
+#endif
 };
 
 } // namespace ns3
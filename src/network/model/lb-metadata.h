@@ -0,0 +1,122 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LB_METADATA_H
+#define LB_METADATA_H
+
+#include "ns3/nstime.h"
+#include "ns3/ipv4-address.h"
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup packet
+ *
+ * \brief Fixed fields for the per packet state of the load balancing protocols
+ *
+ * Every Packet carries one LbMetadata by value, so reading or writing a
+ * field is a member access and copying a packet copies the fields, instead
+ * of allocating, linking and searching PacketTagList nodes at every hop.
+ * A bit per group of fields tells whether the group is present, which gives
+ * the same add / peek / remove semantics as a packet tag.
+ *
+ * The packet tags of these protocols (FlowIdTag, Ipv4XPathTag, Ipv4CongaTag,
+ * TcpTLBTag, TcpCloveTag, Ipv4DrbTag, Ipv4EcnTag and Ipv4FlowcellTag) are kept
+ * as adapters: their PeekFrom, AddTo and RemoveFrom methods read and write these fields.
+ */
+class LbMetadata
+{
+public:
+  /// Groups of fields
+  enum Field
+  {
+    FLOW_ID  = 1 << 0,  //!< Flow id of the transport connection
+    PATH_ID  = 1 << 1,  //!< XPath source routed path
+    CONGA    = 1 << 2,  //!< Conga lbTag, CE and feedback
+    TLB      = 1 << 3,  //!< TLB path and timestamp echoed by the receiver
+    CLOVE    = 1 << 4,  //!< Clove path echoed by the receiver
+    OVERLAY  = 1 << 5,  //!< DRB overlay destination
+    ECN      = 1 << 6,  //!< ECN codepoint seen by the transport
+    FLOWCELL = 1 << 7   //!< Presto flowcell id
+  };
+
+  LbMetadata ()
+    : m_fields (0)
+  {
+  }
+
+  bool Has (Field field) const
+  {
+    return (m_fields & field) != 0;
+  }
+
+  void Remove (Field field)
+  {
+    m_fields &= ~static_cast<uint32_t> (field);
+  }
+
+  void RemoveAll (void)
+  {
+    m_fields = 0;
+  }
+
+  uint32_t GetFlowId (void) const { return m_flowId; }
+  void SetFlowId (uint32_t flowId) { m_flowId = flowId; m_fields |= FLOW_ID; }
+
+  uint32_t GetPathId (void) const { return m_pathId; }
+  void SetPathId (uint32_t pathId) { m_pathId = pathId; m_fields |= PATH_ID; }
+
+  uint32_t GetCongaLbTag (void) const { return m_congaLbTag; }
+  uint32_t GetCongaCe (void) const { return m_congaCe; }
+  uint32_t GetCongaFbLbTag (void) const { return m_congaFbLbTag; }
+  uint32_t GetCongaFbMetric (void) const { return m_congaFbMetric; }
+  void SetConga (uint32_t lbTag, uint32_t ce, uint32_t fbLbTag, uint32_t fbMetric)
+  {
+    m_congaLbTag = lbTag;
+    m_congaCe = ce;
+    m_congaFbLbTag = fbLbTag;
+    m_congaFbMetric = fbMetric;
+    m_fields |= CONGA;
+  }
+
+  uint32_t GetTlbPath (void) const { return m_tlbPath; }
+  Time GetTlbTime (void) const { return TimeStep (m_tlbTime); }
+  void SetTlb (uint32_t path, Time time)
+  {
+    m_tlbPath = path;
+    m_tlbTime = time.GetTimeStep ();
+    m_fields |= TLB;
+  }
+
+  uint32_t GetClovePath (void) const { return m_clovePath; }
+  void SetClovePath (uint32_t path) { m_clovePath = path; m_fields |= CLOVE; }
+
+  Ipv4Address GetOverlayDestination (void) const { return Ipv4Address (m_overlayDestination); }
+  void SetOverlayDestination (Ipv4Address address) { m_overlayDestination = address.Get (); m_fields |= OVERLAY; }
+
+  uint8_t GetEcn (void) const { return m_ecn; }
+  void SetEcn (uint8_t ecn) { m_ecn = ecn; m_fields |= ECN; }
+
+  uint32_t GetFlowcellId (void) const { return m_flowcellId; }
+  void SetFlowcellId (uint32_t flowcellId) { m_flowcellId = flowcellId; m_fields |= FLOWCELL; }
+
+private:
+  uint32_t m_fields;             //!< Present groups of fields
+
+  uint32_t m_flowId;             //!< FLOW_ID
+  uint32_t m_pathId;             //!< PATH_ID
+  uint32_t m_congaLbTag;         //!< CONGA, forward path
+  uint32_t m_congaCe;            //!< CONGA, forward path congestion
+  uint32_t m_congaFbLbTag;       //!< CONGA, feedback path
+  uint32_t m_congaFbMetric;      //!< CONGA, feedback path congestion
+  uint32_t m_tlbPath;            //!< TLB
+  int64_t m_tlbTime;             //!< TLB, in time steps
+  uint32_t m_clovePath;          //!< CLOVE
+  uint32_t m_overlayDestination; //!< OVERLAY
+  uint32_t m_flowcellId;         //!< FLOWCELL
+  uint8_t m_ecn;                 //!< ECN
+};
+
+} // namespace ns3
+
+#endif /* LB_METADATA_H */
@@ -27,6 +27,9 @@
 
 #include <stdint.h>
 #include <ostream>
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 #include "ns3/type-id.h"
 
 namespace ns3 {
@@ -164,7 +167,11 @@ public:
     uint8_t data[MAX_SIZE];   /**< Serialization buffer */
     struct TagData * next;   /**< Pointer to next in list */
     TypeId tid;               /**< Type of the tag serialized into #data */
+#ifdef NS3_MTP
+    std::atomic<uint32_t> count; /**< Number of incoming links */
+#else
     uint32_t count;           /**< Number of incoming links */
+#endif
   };  /* struct TagData */
 
   /**
@@ -286,6 +293,13 @@ private:
    * \returns True, since tag value will definitely be replaced.
    */
   bool ReplaceWriter (Tag & tag, bool preMerge, struct TagData * cur, struct TagData ** prevNext);
+  /**
+   * Drop one incoming link of a tag, deleting it and the tags after it
+   * which are no longer linked.
+   *
+   * \param [in] first Pointer to the tag.
+   */
+  static inline void Release (struct TagData * first);
 
   /**
    * Pointer to first \ref TagData on the list
@@ -339,12 +353,18 @@ PacketTagList::~PacketTagList ()
 
 void
 PacketTagList::RemoveAll (void)
+{
+  Release (m_next);
+  m_next = 0;
+}
+
+void
+PacketTagList::Release (struct TagData *first)
 {
   struct TagData *prev = 0;
-  for (struct TagData *cur = m_next; cur != 0; cur = cur->next)
+  for (struct TagData *cur = first; cur != 0; cur = cur->next)
     {
-      cur->count--;
-      if (cur->count > 0) 
+      if (--cur->count > 0) 
         {
           break;
         }
@@ -358,7 +378,6 @@ PacketTagList::RemoveAll (void)
     {
       delete prev;
     }
-  m_next = 0;
 }
 
 } // namespace ns3
@@ -29,6 +29,7 @@
 #include "byte-tag-list.h"
 #include "packet-tag-list.h"
 #include "nix-vector.h"
+#include "lb-metadata.h"
 #include "ns3/mac48-address.h"
 #include "ns3/callback.h"
 #include "ns3/assert.h"
@@ -634,6 +635,16 @@ public:
    */
   PacketTagIterator GetPacketTagIterator (void) const;
 
+  /**
+   * \brief Get the load balancing metadata of this packet.
+   *
+   * The metadata is copied with the packet and, like the packet tags,
+   * it can be changed on a const packet. RemoveAllPacketTags clears it.
+   *
+   * \returns a reference to the load balancing metadata
+   */
+  LbMetadata &GetLbMetadata (void) const;
+
   /**
    * \brief Set the packet nix-vector.
    *
@@ -717,11 +728,13 @@ private:
   ByteTagList m_byteTagList;      //!< the ByteTag list
   PacketTagList m_packetTagList;  //!< the packet's Tag list
   PacketMetadata m_metadata;      //!< the packet's metadata
+  mutable LbMetadata m_lbMetadata; //!< the load balancing metadata
 
   /* Please see comments above about nix-vector */
   Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
 
-  static uint32_t m_globalUid; //!< Global counter of packets Uid
+  /** \returns the global counter of packets Uid */
+  static uint32_t AllocateUid (void);
 };
 
 /**
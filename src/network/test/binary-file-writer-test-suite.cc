@@ -0,0 +1,82 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/binary-file-writer.h"
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace ns3;
+
+class BinaryFileWriterTestCase : public TestCase
+{
+public:
+  BinaryFileWriterTestCase ();
+  virtual void DoRun (void);
+};
+
+BinaryFileWriterTestCase::BinaryFileWriterTestCase ()
+  : TestCase ("Check the header, the byte order and the buffering of BinaryFileWriter")
+{
+}
+
+void
+BinaryFileWriterTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("binary-file-writer.bin");
+  BinaryFileWriter writer;
+  NS_TEST_ASSERT_MSG_EQ (writer.Open (filename, "TEST", 3), true, "Cannot open " << filename);
+  writer.WriteU8 (0x01);
+  writer.WriteU16 (0x0302);
+  writer.WriteU32 (0x07060504);
+  writer.WriteU64 (0x0f0e0d0c0b0a0908ULL);
+  writer.WriteFloat (1.0f);
+  writer.Write ("ab");
+  // Go past the buffer so that part of the file is written before Close
+  for (uint32_t i = 0; i < BinaryFileWriter::BUFFER_SIZE; ++i)
+    {
+      writer.WriteU8 (i & 0xff);
+    }
+  writer.Close ();
+  NS_TEST_ASSERT_MSG_EQ (writer.IsOpen (), false, "The file should be closed");
+
+  std::ifstream in (filename.c_str (), std::ios::binary);
+  std::vector<uint8_t> bytes ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+  uint32_t offset = 8 + 15 + 4 + 2;
+  NS_TEST_ASSERT_MSG_EQ (bytes.size (), offset + BinaryFileWriter::BUFFER_SIZE, "Wrong file size");
+
+  const uint8_t header[] = {'T', 'E', 'S', 'T', 3, 0, 0, 0};
+  for (uint32_t i = 0; i < 8; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t) bytes[i], (uint32_t) header[i], "Wrong header byte " << i);
+    }
+  for (uint32_t i = 1; i <= 15; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t) bytes[7 + i], i, "The integers should be little endian");
+    }
+  const uint8_t one[] = {0x00, 0x00, 0x80, 0x3f};
+  for (uint32_t i = 0; i < 4; ++i)
+    {
+      NS_TEST_EXPECT_MSG_EQ ((uint32_t) bytes[23 + i], (uint32_t) one[i], "Wrong float byte " << i);
+    }
+  NS_TEST_EXPECT_MSG_EQ (bytes[27], 'a', "Wrong string");
+  NS_TEST_EXPECT_MSG_EQ (bytes[28], 'b', "Wrong string");
+  for (uint32_t i = 0; i < BinaryFileWriter::BUFFER_SIZE; ++i)
+    {
+      if (bytes[offset + i] != (i & 0xff))
+        {
+          NS_TEST_ASSERT_MSG_EQ ((uint32_t) bytes[offset + i], (i & 0xff), "Wrong byte at " << offset + i);
+        }
+    }
+}
+
+static class BinaryFileWriterTestSuite : public TestSuite
+{
+public:
+  BinaryFileWriterTestSuite ()
+    : TestSuite ("binary-file-writer", UNIT)
+  {
+    AddTestCase (new BinaryFileWriterTestCase (), TestCase::QUICK);
+  }
+} g_binaryFileWriterTestSuite;
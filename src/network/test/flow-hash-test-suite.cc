@@ -0,0 +1,77 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/flow-hash.h"
+
+#include <cstring>
+
+using namespace ns3;
+
+class FlowHashVectorTestCase : public TestCase
+{
+public:
+  FlowHashVectorTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowHashVectorTestCase::FlowHashVectorTestCase ()
+  : TestCase ("Check the flow hash functions against their reference values")
+{
+}
+
+void
+FlowHashVectorTestCase::DoRun (void)
+{
+  const char *check = "123456789";
+  const uint8_t *data = reinterpret_cast<const uint8_t *> (check);
+  uint32_t length = std::strlen (check);
+
+  NS_TEST_EXPECT_MSG_EQ (FlowHash (FlowHash::CRC16, 0).Hash (data, length), 0x29b1, "CRC-16/CCITT");
+  NS_TEST_EXPECT_MSG_EQ (FlowHash (FlowHash::CRC32, 0).Hash (data, length), 0xcbf43926, "CRC-32");
+
+  const char *test = "test";
+  NS_TEST_EXPECT_MSG_EQ (FlowHash (FlowHash::MURMUR3, 0).Hash (reinterpret_cast<const uint8_t *> (test), 4),
+                         0xba6bd213, "Murmur3");
+
+  // 66.9.149.187:2794 -> 161.142.100.80:1766, from the RSS verification suite
+  uint8_t rss[12] = { 66, 9, 149, 187, 161, 142, 100, 80, 0x0a, 0xea, 0x06, 0xe6 };
+  NS_TEST_EXPECT_MSG_EQ (FlowHash (FlowHash::TOEPLITZ, 0).Hash (rss, sizeof (rss)), 0x51ccc178, "Toeplitz");
+}
+
+class FlowHashSeedTestCase : public TestCase
+{
+public:
+  FlowHashSeedTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowHashSeedTestCase::FlowHashSeedTestCase ()
+  : TestCase ("Check that the seed changes the flow hash")
+{
+}
+
+void
+FlowHashSeedTestCase::DoRun (void)
+{
+  FlowHash::Algorithm algorithms[4] = { FlowHash::MURMUR3, FlowHash::CRC16, FlowHash::CRC32, FlowHash::TOEPLITZ };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      FlowHash hash (algorithms[i], 0);
+      FlowHash otherHash (algorithms[i], 0x12345678);
+      uint32_t h = hash.Hash (0x0a000001, 0x0a000102, 10000, 80, 6);
+      NS_TEST_EXPECT_MSG_EQ (h, hash.Hash (0x0a000001, 0x0a000102, 10000, 80, 6), "The hash should be deterministic");
+      NS_TEST_EXPECT_MSG_NE (h, hash.Hash (0x0a000001, 0x0a000102, 10001, 80, 6), "The source port should be hashed");
+      NS_TEST_EXPECT_MSG_NE (h, otherHash.Hash (0x0a000001, 0x0a000102, 10000, 80, 6), "The seed should be hashed");
+    }
+}
+
+static class FlowHashTestSuite : public TestSuite
+{
+public:
+  FlowHashTestSuite ()
+    : TestSuite ("flow-hash", UNIT)
+  {
+    AddTestCase (new FlowHashVectorTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowHashSeedTestCase (), TestCase::QUICK);
+  }
+} g_flowHashTestSuite;
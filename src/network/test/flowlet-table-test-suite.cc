@@ -0,0 +1,116 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/flowlet-table.h"
+#include "ns3/uinteger.h"
+#include "ns3/enum.h"
+#include "ns3/simulator.h"
+
+using namespace ns3;
+
+class FlowletTableExactTestCase : public TestCase
+{
+public:
+  FlowletTableExactTestCase ();
+  virtual void DoRun (void);
+
+private:
+  void CheckReuse (Ptr<FlowletTable> table);
+};
+
+FlowletTableExactTestCase::FlowletTableExactTestCase ()
+  : TestCase ("Check the reuse of timed out entries in the exact flowlet table")
+{
+}
+
+void
+FlowletTableExactTestCase::DoRun (void)
+{
+  Ptr<FlowletTable> table = CreateObject<FlowletTable> ();
+  table->SetAttribute ("Buckets", UintegerValue (1));
+  table->SetAttribute ("Ways", UintegerValue (2));
+  NS_TEST_EXPECT_MSG_EQ (table->GetCapacity (), 2, "The table should hold two entries");
+  NS_TEST_EXPECT_MSG_EQ ((table->Lookup (1) == 0), true, "The table should be empty");
+
+  FlowletEntry *entry = table->Insert (1, MicroSeconds (5));
+  entry->path = 10;
+  entry->activeTime = MicroSeconds (0);
+  entry = table->Insert (2, MicroSeconds (5));
+  entry->path = 20;
+  entry->activeTime = MicroSeconds (0);
+
+  NS_TEST_EXPECT_MSG_EQ (table->Lookup (1)->path, 10, "Flow 1 should be found");
+  NS_TEST_EXPECT_MSG_EQ (table->Lookup (2)->path, 20, "Flow 2 should be found");
+  NS_TEST_EXPECT_MSG_EQ ((table->Lookup (3) == 0), true, "Flow 3 has not been inserted");
+  NS_TEST_EXPECT_MSG_EQ (table->Insert (2, MicroSeconds (5)), table->Lookup (2), "Flow 2 should keep its entry");
+
+  // Both flowlets are live, flow 3 gets no entry
+  NS_TEST_EXPECT_MSG_EQ ((table->Insert (3, MicroSeconds (5)) == 0), true, "Live flowlets should not be evicted");
+  NS_TEST_EXPECT_MSG_EQ (table->GetCollisions (), 1, "The collision should be counted");
+  NS_TEST_EXPECT_MSG_EQ (table->Lookup (1)->path, 10, "Flow 1 should still be there");
+
+  Simulator::Schedule (MicroSeconds (10), &FlowletTableExactTestCase::CheckReuse, this, table);
+  Simulator::Run ();
+  Simulator::Destroy ();
+
+  table->Clear ();
+  NS_TEST_EXPECT_MSG_EQ ((table->Lookup (2) == 0), true, "The table should be empty");
+}
+
+void
+FlowletTableExactTestCase::CheckReuse (Ptr<FlowletTable> table)
+{
+  // Flow 2 is active again, only the flowlet of flow 1 timed out
+  table->Lookup (2)->activeTime = MicroSeconds (8);
+  FlowletEntry *entry = table->Insert (3, MicroSeconds (5));
+  NS_TEST_ASSERT_MSG_NE ((entry == 0), true, "Flow 3 should reuse a timed out entry");
+  entry->path = 30;
+  entry->activeTime = Simulator::Now ();
+  NS_TEST_EXPECT_MSG_EQ ((table->Lookup (1) == 0), true, "Flow 1 should have been evicted");
+  NS_TEST_EXPECT_MSG_EQ (table->Lookup (2)->path, 20, "Flow 2 should still be there");
+  NS_TEST_EXPECT_MSG_EQ (table->Lookup (3)->path, 30, "Flow 3 should be found");
+
+  NS_TEST_EXPECT_MSG_EQ ((table->Insert (4, MicroSeconds (5)) == 0), true, "Live flowlets should not be evicted");
+  NS_TEST_EXPECT_MSG_EQ (table->GetCollisions (), 2, "The collision should be counted");
+}
+
+class FlowletTableHashedTestCase : public TestCase
+{
+public:
+  FlowletTableHashedTestCase ();
+  virtual void DoRun (void);
+};
+
+FlowletTableHashedTestCase::FlowletTableHashedTestCase ()
+  : TestCase ("Check that colliding flows share the entry in hashed mode")
+{
+}
+
+void
+FlowletTableHashedTestCase::DoRun (void)
+{
+  Ptr<FlowletTable> table = CreateObject<FlowletTable> ();
+  table->SetAttribute ("Mode", EnumValue (FlowletTable::FLOWLET_TABLE_HASHED));
+  table->SetAttribute ("Buckets", UintegerValue (1));
+  NS_TEST_EXPECT_MSG_EQ (table->GetCapacity (), 1, "The table should hold one entry");
+
+  FlowletEntry *entry = table->Insert (1, MicroSeconds (5));
+  entry->path = 10;
+  entry->activeTime = MicroSeconds (1);
+
+  NS_TEST_EXPECT_MSG_EQ (table->Lookup (2), entry, "Flow 2 should hit the entry of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (table->Insert (2, MicroSeconds (5)), entry, "Flow 2 should reuse the entry of flow 1");
+  NS_TEST_EXPECT_MSG_EQ (entry->flowId, 2, "The entry should now belong to flow 2");
+  NS_TEST_EXPECT_MSG_EQ (entry->path, 10, "The path is kept until the caller updates it");
+}
+
+static class FlowletTableTestSuite : public TestSuite
+{
+public:
+  FlowletTableTestSuite ()
+    : TestSuite ("flowlet-table", UNIT)
+  {
+    AddTestCase (new FlowletTableExactTestCase (), TestCase::QUICK);
+    AddTestCase (new FlowletTableHashedTestCase (), TestCase::QUICK);
+  }
+} g_flowletTableTestSuite;
@@ -0,0 +1,97 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "ns3/test.h"
+#include "ns3/lazy-dre.h"
+
+using namespace ns3;
+
+class LazyDreExactTestCase : public TestCase
+{
+public:
+  LazyDreExactTestCase ();
+  virtual void DoRun (void);
+};
+
+LazyDreExactTestCase::LazyDreExactTestCase ()
+  : TestCase ("Check that the exact lazy DRE matches the periodic decay")
+{
+}
+
+void
+LazyDreExactTestCase::DoRun (void)
+{
+  Time period = MicroSeconds (200);
+  double alpha = 0.2;
+
+  LazyDre dre;
+  dre.SetPeriod (period);
+  dre.SetAlpha (alpha);
+  dre.SetExact (true);
+  dre.Start (MicroSeconds (10));
+
+  uint32_t lazyValue = 0;
+  uint64_t lazyTick = 0;
+  uint32_t periodicValue = 0;
+  Time nextDecay = MicroSeconds (10) + period;
+
+  // Add 1500 bytes every 70us, then let the values decay without traffic
+  for (Time now = MicroSeconds (10); now < MilliSeconds (20); now += MicroSeconds (70))
+    {
+      while (nextDecay <= now)
+        {
+          periodicValue = periodicValue * (1 - alpha);
+          nextDecay += period;
+        }
+      if (now < MilliSeconds (5))
+        {
+          periodicValue += 1500;
+          dre.Update (lazyValue, lazyTick, now);
+          lazyValue += 1500;
+        }
+      NS_TEST_EXPECT_MSG_EQ (dre.Update (lazyValue, lazyTick, now), periodicValue,
+                             "The lazy DRE should match the periodic one at " << now);
+    }
+  NS_TEST_EXPECT_MSG_EQ (lazyValue, 0, "The DRE should have decayed to zero");
+}
+
+class LazyDreClosedFormTestCase : public TestCase
+{
+public:
+  LazyDreClosedFormTestCase ();
+  virtual void DoRun (void);
+};
+
+LazyDreClosedFormTestCase::LazyDreClosedFormTestCase ()
+  : TestCase ("Check the closed form decay of the lazy DRE")
+{
+}
+
+void
+LazyDreClosedFormTestCase::DoRun (void)
+{
+  LazyDre dre;
+  dre.SetPeriod (MicroSeconds (100));
+  dre.SetAlpha (0.5);
+  dre.SetExact (false);
+
+  uint32_t value = 1000;
+  uint64_t tick = 0;
+  NS_TEST_EXPECT_MSG_EQ (dre.Update (value, tick, MicroSeconds (500)), 1000, "The DRE is not running yet");
+
+  dre.Start (MicroSeconds (0));
+  NS_TEST_EXPECT_MSG_EQ (dre.GetTick (MicroSeconds (99)), 0, "No decay before one period");
+  NS_TEST_EXPECT_MSG_EQ (dre.GetTick (MicroSeconds (100)), 1, "One decay after one period");
+  NS_TEST_EXPECT_MSG_EQ (dre.Update (value, tick, MicroSeconds (350)), 125, "Three decays by half");
+  NS_TEST_EXPECT_MSG_EQ (tick, 3, "The tick should be updated");
+}
+
+static class LazyDreTestSuite : public TestSuite
+{
+public:
+  LazyDreTestSuite ()
+    : TestSuite ("lazy-dre", UNIT)
+  {
+    AddTestCase (new LazyDreExactTestCase (), TestCase::QUICK);
+    AddTestCase (new LazyDreClosedFormTestCase (), TestCase::QUICK);
+  }
+} g_lazyDreTestSuite;
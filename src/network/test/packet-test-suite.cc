@@ -19,8 +19,14 @@
  */
 #include "ns3/packet.h"
 #include "ns3/packet-tag-list.h"
+#include "ns3/flow-id-tag.h"
 #include "ns3/test.h"
 #include "ns3/unused.h"
+#include "ns3/core-config.h"
+#if defined (NS3_MTP) && defined (HAVE_PTHREAD_H)
+#define MTP_THREADS
+#include "ns3/system-thread.h"
+#endif
 #include <limits>     // std:numeric_limits
 #include <string>
 #include <cstdarg>
@@ -847,6 +853,187 @@ PacketTagListTest::DoRun (void)
     
 }
 
+//-----------------------------------------------------------------------------
+class LbMetadataTest : public TestCase
+{
+public:
+  LbMetadataTest ();
+  virtual void DoRun (void);
+};
+
+LbMetadataTest::LbMetadataTest ()
+  : TestCase ("LbMetadata")
+{
+}
+
+void
+LbMetadataTest::DoRun (void)
+{
+  Ptr<Packet> p = Create<Packet> (1000);
+  FlowIdTag tag;
+  NS_TEST_EXPECT_MSG_EQ (tag.PeekFrom (p), false, "No flow id yet");
+
+  FlowIdTag (7).AddTo (p);
+  p->GetLbMetadata ().SetConga (1, 2, 3, 4);
+  NS_TEST_EXPECT_MSG_EQ (tag.PeekFrom (p), true, "The flow id should be set");
+  NS_TEST_EXPECT_MSG_EQ (tag.GetFlowId (), 7, "Wrong flow id");
+
+  // Adding again replaces the value
+  FlowIdTag (8).AddTo (p);
+  tag.PeekFrom (p);
+  NS_TEST_EXPECT_MSG_EQ (tag.GetFlowId (), 8, "The flow id should be replaced");
+
+  // Copies and fragments take the metadata by value
+  Ptr<Packet> copy = p->Copy ();
+  Ptr<Packet> fragment = p->CreateFragment (100, 200);
+  NS_TEST_EXPECT_MSG_EQ (tag.RemoveFrom (p), true, "The flow id should be removed");
+  NS_TEST_EXPECT_MSG_EQ (tag.PeekFrom (p), false, "The flow id was removed");
+  NS_TEST_EXPECT_MSG_EQ (p->GetLbMetadata ().Has (LbMetadata::CONGA), true, "Other fields are kept");
+  NS_TEST_EXPECT_MSG_EQ (tag.PeekFrom (copy), true, "The copy keeps its flow id");
+  NS_TEST_EXPECT_MSG_EQ (tag.PeekFrom (fragment), true, "The fragment keeps its flow id");
+  NS_TEST_EXPECT_MSG_EQ (fragment->GetLbMetadata ().GetCongaFbMetric (), 4, "Wrong Conga feedback");
+
+  copy->RemoveAllPacketTags ();
+  NS_TEST_EXPECT_MSG_EQ (copy->GetLbMetadata ().Has (LbMetadata::CONGA), false,
+                         "RemoveAllPacketTags clears the metadata");
+  NS_TEST_EXPECT_MSG_EQ (fragment->GetLbMetadata ().Has (LbMetadata::CONGA), true,
+                         "The fragment is not changed by its source");
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * The copies of a packet share their buffer data and the tail of their
+ * tag list, with reference counts which are atomic with --enable-mtp.
+ * Changing or dropping a copy, in any order and from any thread, must
+ * leave the other copies untouched.
+ */
+class SharedPacketTest : public TestCase
+{
+public:
+  SharedPacketTest ();
+  virtual void DoRun (void);
+private:
+  /**
+   * \param p the packet
+   * \returns the bytes of the packet
+   */
+  static std::string Bytes (Ptr<const Packet> p);
+  /**
+   * Copy, change and drop copies of a packet, as the threads of the
+   * multithreaded simulator do.
+   * \param source the packet to copy
+   * \param errors incremented for each copy found corrupted
+   */
+  static void ChangeCopies (Ptr<const Packet> source, uint32_t *errors);
+};
+
+SharedPacketTest::SharedPacketTest ()
+  : TestCase ("Shared buffers and tags of packet copies")
+{
+}
+
+std::string
+SharedPacketTest::Bytes (Ptr<const Packet> p)
+{
+  std::string bytes (p->GetSize (), 0);
+  p->CopyData (reinterpret_cast<uint8_t *> (&bytes[0]), bytes.size ());
+  return bytes;
+}
+
+void
+SharedPacketTest::ChangeCopies (Ptr<const Packet> source, uint32_t *errors)
+{
+  std::string expected = Bytes (source);
+  for (uint32_t i = 0; i < 1000; ++i)
+    {
+      Ptr<Packet> copy = source->Copy ();
+      Ptr<Packet> other = copy->Copy ();
+      ATestHeader<4> header;
+      copy->AddHeader (header);
+      copy->AddPaddingAtEnd (i % 7);
+      ATestTag<2> tag (i % 256);
+      copy->ReplacePacketTag (tag);
+      ATestTag<1> first;
+      copy->RemovePacketTag (first);
+      other->RemoveAllPacketTags ();
+
+      ATestTag<2> peeked;
+      if (!copy->PeekPacketTag (peeked) || peeked.GetData () != static_cast<int> (i % 256)
+          || copy->PeekPacketTag (first)
+          || copy->GetSize () != expected.size () + 4 + i % 7
+          || Bytes (copy).compare (4, expected.size (), expected) != 0
+          || Bytes (other) != expected)
+        {
+          (*errors)++;
+        }
+    }
+}
+
+void
+SharedPacketTest::DoRun (void)
+{
+  const char data[] = "shared packet data";
+  Ptr<Packet> p = Create<Packet> (reinterpret_cast<const uint8_t *> (data), sizeof (data));
+  ATestTag<1> t1 (1);
+  ATestTag<2> t2 (2);
+  ATestTag<3> t3 (3);
+  p->AddPacketTag (t1);
+  p->AddPacketTag (t2);
+  p->AddPacketTag (t3);
+  std::string bytes = Bytes (p);
+
+  // The copy outlives the packet it shares its tags and buffer with
+  Ptr<Packet> copy = p->Copy ();
+  copy->RemovePacketTag (t2);
+  ATestTag<1> replaced (9);
+  copy->ReplacePacketTag (replaced);
+  p = 0;
+  ATestTag<1> peek1;
+  ATestTag<2> peek2;
+  ATestTag<3> peek3;
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (peek1), true, "Replaced tag");
+  NS_TEST_EXPECT_MSG_EQ (peek1.GetData (), 9, "Wrong replaced tag");
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (peek2), false, "Removed tag");
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (peek3), true, "Shared tag");
+  NS_TEST_EXPECT_MSG_EQ (peek3.GetData (), 3, "Wrong shared tag");
+
+  // Growing a copy does not write into the shared buffer
+  Ptr<Packet> other = copy->Copy ();
+  ATestHeader<4> header;
+  other->AddHeader (header);
+  other->AddPaddingAtEnd (3);
+  copy->AddPaddingAtEnd (5);
+  NS_TEST_EXPECT_MSG_EQ (Bytes (copy).substr (0, bytes.size ()), bytes, "Copy changed by the other");
+  NS_TEST_EXPECT_MSG_EQ (copy->GetSize (), bytes.size () + 5, "Wrong padding");
+  NS_TEST_EXPECT_MSG_EQ (Bytes (other).substr (4, bytes.size ()), bytes, "Other changed by the copy");
+  NS_TEST_EXPECT_MSG_EQ (other->GetSize (), 4 + bytes.size () + 3, "Wrong padding");
+
+  uint32_t errors = 0;
+  ChangeCopies (copy, &errors);
+  NS_TEST_EXPECT_MSG_EQ (errors, 0, "Copies changed by each other");
+
+#ifdef MTP_THREADS
+  // The copies of one packet changed and dropped on several threads
+  const uint32_t nThreads = 4;
+  std::vector<uint32_t> threadErrors (nThreads, 0);
+  std::vector<Ptr<SystemThread> > threads;
+  for (uint32_t i = 0; i < nThreads; ++i)
+    {
+      threads.push_back (Create<SystemThread> (MakeBoundCallback (&SharedPacketTest::ChangeCopies,
+                                                                  Ptr<const Packet> (copy),
+                                                                  &threadErrors[i])));
+      threads.back ()->Start ();
+    }
+  for (uint32_t i = 0; i < nThreads; ++i)
+    {
+      threads[i]->Join ();
+      NS_TEST_EXPECT_MSG_EQ (threadErrors[i], 0, "Copies changed by another thread");
+    }
+#endif /* MTP_THREADS */
+  NS_TEST_EXPECT_MSG_EQ (Bytes (copy).substr (0, bytes.size ()), bytes, "Packet changed by its copies");
+  NS_TEST_EXPECT_MSG_EQ (copy->PeekPacketTag (peek3), true, "Tag changed by the copies");
+}
+
 //-----------------------------------------------------------------------------
 class PacketTestSuite : public TestSuite
 {
@@ -859,6 +1046,8 @@ PacketTestSuite::PacketTestSuite ()
 {
   AddTestCase (new PacketTest, TestCase::QUICK);
   AddTestCase (new PacketTagListTest, TestCase::QUICK);
+  AddTestCase (new LbMetadataTest, TestCase::QUICK);
+  AddTestCase (new SharedPacketTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite;
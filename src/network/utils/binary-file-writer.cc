@@ -0,0 +1,121 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "binary-file-writer.h"
+
+#include <cstring>
+
+namespace ns3 {
+
+const uint32_t BinaryFileWriter::BUFFER_SIZE;
+
+BinaryFileWriter::BinaryFileWriter ()
+{
+}
+
+BinaryFileWriter::~BinaryFileWriter ()
+{
+  Close ();
+}
+
+bool
+BinaryFileWriter::Open (std::string filename, const char *magic, uint16_t version)
+{
+  Close ();
+  m_out.open (filename.c_str (), std::ios::out | std::ios::binary | std::ios::trunc);
+  if (!m_out.is_open ())
+    {
+      return false;
+    }
+  m_buffer.reserve (BUFFER_SIZE);
+  m_buffer.insert (m_buffer.end (), magic, magic + 4);
+  WriteU16 (version);
+  WriteU16 (0);
+  return true;
+}
+
+void
+BinaryFileWriter::Close (void)
+{
+  if (m_out.is_open ())
+    {
+      WriteBuffer ();
+      m_out.close ();
+    }
+  m_buffer.clear ();
+}
+
+bool
+BinaryFileWriter::IsOpen (void) const
+{
+  return m_out.is_open ();
+}
+
+void
+BinaryFileWriter::Flush (void)
+{
+  if (m_out.is_open ())
+    {
+      WriteBuffer ();
+      m_out.flush ();
+    }
+}
+
+void
+BinaryFileWriter::WriteU8 (uint8_t value)
+{
+  m_buffer.push_back (value);
+  if (m_buffer.size () >= BUFFER_SIZE)
+    {
+      WriteBuffer ();
+    }
+}
+
+void
+BinaryFileWriter::WriteU16 (uint16_t value)
+{
+  WriteU8 (value & 0xff);
+  WriteU8 ((value >> 8) & 0xff);
+}
+
+void
+BinaryFileWriter::WriteU32 (uint32_t value)
+{
+  WriteU16 (value & 0xffff);
+  WriteU16 ((value >> 16) & 0xffff);
+}
+
+void
+BinaryFileWriter::WriteU64 (uint64_t value)
+{
+  WriteU32 (value & 0xffffffff);
+  WriteU32 ((value >> 32) & 0xffffffff);
+}
+
+void
+BinaryFileWriter::WriteFloat (float value)
+{
+  uint32_t bits;
+  std::memcpy (&bits, &value, sizeof (bits));
+  WriteU32 (bits);
+}
+
+void
+BinaryFileWriter::Write (const std::string &bytes)
+{
+  for (std::string::const_iterator itr = bytes.begin (); itr != bytes.end (); ++itr)
+    {
+      WriteU8 (*itr);
+    }
+}
+
+void
+BinaryFileWriter::WriteBuffer (void)
+{
+  if (m_out.is_open () && !m_buffer.empty ())
+    {
+      m_out.write (reinterpret_cast<const char *> (&m_buffer[0]), m_buffer.size ());
+    }
+  m_buffer.clear ();
+}
+
+}
@@ -0,0 +1,65 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef BINARY_FILE_WRITER_H
+#define BINARY_FILE_WRITER_H
+
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Buffered writer of little endian binary files
+ *
+ * The file starts with a 4 character magic, a uint16_t version and a
+ * uint16_t reserved field. The values are appended to a buffer which is
+ * written to the file each time it reaches BUFFER_SIZE bytes.
+ */
+class BinaryFileWriter
+{
+public:
+  static const uint32_t BUFFER_SIZE = 65536;
+
+  BinaryFileWriter ();
+
+  ~BinaryFileWriter ();
+
+  /**
+   * Truncate the file and write the file header.
+   *
+   * \param magic the 4 first characters of the file
+   * \return false if the file cannot be opened
+   */
+  bool Open (std::string filename, const char *magic, uint16_t version);
+
+  void Close (void);
+
+  bool IsOpen (void) const;
+
+  // Write the buffer to the file and flush the file
+  void Flush (void);
+
+  void WriteU8 (uint8_t value);
+  void WriteU16 (uint16_t value);
+  void WriteU32 (uint32_t value);
+  void WriteU64 (uint64_t value);
+  // The IEEE 754 bits of value
+  void WriteFloat (float value);
+  void Write (const std::string &bytes);
+
+private:
+  BinaryFileWriter (const BinaryFileWriter &);
+  BinaryFileWriter &operator = (const BinaryFileWriter &);
+
+  void WriteBuffer (void);
+
+  std::ofstream m_out;
+  std::vector<uint8_t> m_buffer;
+};
+
+}
+
+#endif /* BINARY_FILE_WRITER_H */
@@ -0,0 +1,220 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "flow-hash.h"
+
+#include "ns3/assert.h"
+
+namespace ns3 {
+
+namespace {
+
+// The default RSS key, see the Microsoft "Verifying the RSS Hash Calculation"
+const uint8_t g_toeplitzKey[40] = {
+  0x6d, 0x5a, 0x56, 0xda, 0x25, 0x5b, 0x0e, 0xc2,
+  0x41, 0x67, 0x25, 0x3d, 0x43, 0xa3, 0x8f, 0xb0,
+  0xd0, 0xca, 0x2b, 0xcb, 0xae, 0x7b, 0x30, 0xb4,
+  0x77, 0xcb, 0x2d, 0xa3, 0x80, 0x30, 0xf2, 0x0c,
+  0x6a, 0x42, 0xb7, 0x3b, 0xbe, 0xac, 0x01, 0xfa
+};
+
+// CRC tables, built once when the library is loaded
+struct CrcTables
+{
+  CrcTables ()
+  {
+    for (uint32_t i = 0; i < 256; i++)
+      {
+        uint16_t crc16 = i << 8;
+        uint32_t crc32 = i;
+        for (uint32_t bit = 0; bit < 8; bit++)
+          {
+            crc16 = (crc16 & 0x8000) ? (crc16 << 1) ^ 0x1021 : (crc16 << 1);
+            crc32 = (crc32 & 1) ? (crc32 >> 1) ^ 0xedb88320 : (crc32 >> 1);
+          }
+        crc16Table[i] = crc16;
+        crc32Table[i] = crc32;
+      }
+  }
+
+  uint16_t crc16Table[256];
+  uint32_t crc32Table[256];
+};
+
+const CrcTables g_crcTables;
+
+inline uint32_t
+Rotl32 (uint32_t x, uint32_t r)
+{
+  return (x << r) | (x >> (32 - r));
+}
+
+} // anonymous namespace
+
+FlowHash::FlowHash ()
+  : m_algorithm (MURMUR3),
+    m_seed (0)
+{
+}
+
+FlowHash::FlowHash (Algorithm algorithm, uint32_t seed)
+  : m_algorithm (algorithm),
+    m_seed (seed)
+{
+}
+
+uint32_t
+FlowHash::Hash (const uint8_t *data, uint32_t length) const
+{
+  switch (m_algorithm)
+    {
+    case CRC16:
+      return Crc16 (data, length);
+    case CRC32:
+      return Crc32 (data, length);
+    case TOEPLITZ:
+      return Toeplitz (data, length);
+    case MURMUR3:
+    default:
+      return Murmur3 (data, length);
+    }
+}
+
+uint32_t
+FlowHash::Hash (uint32_t saddr, uint32_t daddr, uint16_t sport, uint16_t dport, uint8_t protocol) const
+{
+  uint8_t key[13];
+  key[0] = saddr >> 24;
+  key[1] = saddr >> 16;
+  key[2] = saddr >> 8;
+  key[3] = saddr;
+  key[4] = daddr >> 24;
+  key[5] = daddr >> 16;
+  key[6] = daddr >> 8;
+  key[7] = daddr;
+  key[8] = sport >> 8;
+  key[9] = sport;
+  key[10] = dport >> 8;
+  key[11] = dport;
+  key[12] = protocol;
+  return Hash (key, sizeof (key));
+}
+
+uint32_t
+FlowHash::Hash (uint32_t flowId, uint32_t perturbation) const
+{
+  uint8_t key[8];
+  key[0] = flowId >> 24;
+  key[1] = flowId >> 16;
+  key[2] = flowId >> 8;
+  key[3] = flowId;
+  key[4] = perturbation >> 24;
+  key[5] = perturbation >> 16;
+  key[6] = perturbation >> 8;
+  key[7] = perturbation;
+  return Hash (key, sizeof (key));
+}
+
+uint32_t
+FlowHash::Murmur3 (const uint8_t *data, uint32_t length) const
+{
+  const uint32_t c1 = 0xcc9e2d51;
+  const uint32_t c2 = 0x1b873593;
+
+  uint32_t h = m_seed;
+  uint32_t nblocks = length / 4;
+
+  for (uint32_t i = 0; i < nblocks; i++)
+    {
+      const uint8_t *block = data + i * 4;
+      uint32_t k = block[0] | (block[1] << 8) | (block[2] << 16) | (block[3] << 24);
+      k *= c1;
+      k = Rotl32 (k, 15);
+      k *= c2;
+      h ^= k;
+      h = Rotl32 (h, 13);
+      h = h * 5 + 0xe6546b64;
+    }
+
+  const uint8_t *tail = data + nblocks * 4;
+  uint32_t k = 0;
+  switch (length & 3)
+    {
+    case 3:
+      k ^= tail[2] << 16;
+      /* fall through */
+    case 2:
+      k ^= tail[1] << 8;
+      /* fall through */
+    case 1:
+      k ^= tail[0];
+      k *= c1;
+      k = Rotl32 (k, 15);
+      k *= c2;
+      h ^= k;
+    }
+
+  h ^= length;
+  return Mix (h);
+}
+
+uint32_t
+FlowHash::Mix (uint32_t h)
+{
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+uint32_t
+FlowHash::Crc16 (const uint8_t *data, uint32_t length) const
+{
+  uint16_t crc = 0xffff ^ static_cast<uint16_t> (m_seed);
+  for (uint32_t i = 0; i < length; i++)
+    {
+      crc = (crc << 8) ^ g_crcTables.crc16Table[((crc >> 8) ^ data[i]) & 0xff];
+    }
+  return crc;
+}
+
+uint32_t
+FlowHash::Crc32 (const uint8_t *data, uint32_t length) const
+{
+  uint32_t crc = 0xffffffff ^ m_seed;
+  for (uint32_t i = 0; i < length; i++)
+    {
+      crc = (crc >> 8) ^ g_crcTables.crc32Table[(crc ^ data[i]) & 0xff];
+    }
+  return crc ^ 0xffffffff;
+}
+
+uint32_t
+FlowHash::Toeplitz (const uint8_t *data, uint32_t length) const
+{
+  NS_ASSERT_MSG (length + 4 <= sizeof (g_toeplitzKey), "Key too long for the Toeplitz hash");
+
+  uint8_t key[sizeof (g_toeplitzKey)];
+  for (uint32_t i = 0; i < length + 4; i++)
+    {
+      key[i] = g_toeplitzKey[i] ^ static_cast<uint8_t> (m_seed >> (8 * (3 - i % 4)));
+    }
+
+  uint32_t result = 0;
+  uint32_t window = (key[0] << 24) | (key[1] << 16) | (key[2] << 8) | key[3];
+  for (uint32_t i = 0; i < length; i++)
+    {
+      for (uint32_t bit = 0; bit < 8; bit++)
+        {
+          if (data[i] & (0x80 >> bit))
+            {
+              result ^= window;
+            }
+          window = (window << 1) | ((key[i + 4] >> (7 - bit)) & 1);
+        }
+    }
+  return result;
+}
+
+}
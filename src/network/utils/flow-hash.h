@@ -0,0 +1,76 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef FLOW_HASH_H
+#define FLOW_HASH_H
+
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Allocation free hashing of packed flow keys
+ *
+ * Implements the hash functions commonly found in switch ASICs and NICs so
+ * that ECMP and flow id computations can be done on integers instead of
+ * formatted strings. Each function takes a seed, which lets every switch
+ * hash the same flow differently (or identically, to study polarization):
+ *
+ *  - MURMUR3: murmur3 32 bits, the seed is the initial state
+ *  - CRC16: CRC-16/CCITT, the seed is xored into the initial value 0xffff
+ *  - CRC32: CRC-32 (IEEE 802.3), the seed is xored into the initial value
+ *  - TOEPLITZ: the RSS hash, the seed is xored into the default RSS key
+ *
+ * With a zero seed, CRC16, CRC32 and TOEPLITZ return the standard values.
+ */
+class FlowHash
+{
+public:
+  enum Algorithm
+  {
+    MURMUR3,
+    CRC16,
+    CRC32,
+    TOEPLITZ
+  };
+
+  FlowHash ();
+  FlowHash (Algorithm algorithm, uint32_t seed);
+
+  /**
+   * \param data the key to hash
+   * \param length the length of the key in bytes, at most 36 for TOEPLITZ
+   * \return the hash of the key
+   */
+  uint32_t Hash (const uint8_t *data, uint32_t length) const;
+
+  /**
+   * Hash the 5-tuple, packed in network order as source address,
+   * destination address, source port, destination port and protocol.
+   */
+  uint32_t Hash (uint32_t saddr, uint32_t daddr, uint16_t sport, uint16_t dport, uint8_t protocol) const;
+
+  /**
+   * Hash an existing flow id together with a perturbation (e.g. the TTL).
+   */
+  uint32_t Hash (uint32_t flowId, uint32_t perturbation) const;
+
+  /**
+   * The murmur3 finalizer, which spreads the bits of an integer key over the
+   * whole word. Cheap enough to index hash tables by flow id or packed tuple.
+   */
+  static uint32_t Mix (uint32_t h);
+
+private:
+  uint32_t Murmur3 (const uint8_t *data, uint32_t length) const;
+  uint32_t Crc16 (const uint8_t *data, uint32_t length) const;
+  uint32_t Crc32 (const uint8_t *data, uint32_t length) const;
+  uint32_t Toeplitz (const uint8_t *data, uint32_t length) const;
+
+  Algorithm m_algorithm;
+  uint32_t m_seed;
+};
+
+}
+
+#endif /* FLOW_HASH_H */
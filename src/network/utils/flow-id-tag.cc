@@ -18,7 +18,9 @@
  * Author: Mathieu Lacage <mathieu.lacage@sophia.inria.fr>
  */
 #include "flow-id-tag.h"
+#include "ns3/packet.h"
 #include "ns3/log.h"
+#include "ns3/partitioned-counter.h"
 
 namespace ns3 {
 
@@ -95,10 +97,38 @@ uint32_t
 FlowIdTag::AllocateFlowId (void)
 {
   NS_LOG_FUNCTION_NOARGS ();
-  static uint32_t nextFlowId = 1;
-  uint32_t flowId = nextFlowId;
-  nextFlowId++;
-  return flowId;
+  // Each partition of a parallel simulator draws its own flow ids
+  static PartitionedCounter nextFlowId (1);
+  return static_cast<uint32_t> (nextFlowId.Next ());
+}
+
+bool
+FlowIdTag::PeekFrom (Ptr<const Packet> packet)
+{
+  const LbMetadata &metadata = packet->GetLbMetadata ();
+  if (!metadata.Has (LbMetadata::FLOW_ID))
+    {
+      return false;
+    }
+  m_flowId = metadata.GetFlowId ();
+  return true;
+}
+
+void
+FlowIdTag::AddTo (Ptr<const Packet> packet) const
+{
+  packet->GetLbMetadata ().SetFlowId (m_flowId);
+}
+
+bool
+FlowIdTag::RemoveFrom (Ptr<const Packet> packet)
+{
+  if (!PeekFrom (packet))
+    {
+      return false;
+    }
+  packet->GetLbMetadata ().Remove (LbMetadata::FLOW_ID);
+  return true;
 }
 
 } // namespace ns3
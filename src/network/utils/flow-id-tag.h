@@ -21,9 +21,12 @@
 #define FLOW_ID_TAG_H
 
 #include "ns3/tag.h"
+#include "ns3/ptr.h"
 
 namespace ns3 {
 
+class Packet;
+
 class FlowIdTag : public Tag
 {
 public:
@@ -37,6 +40,25 @@ public:
   virtual void Serialize (TagBuffer buf) const;
   virtual void Deserialize (TagBuffer buf);
   virtual void Print (std::ostream &os) const;
+  /**
+   * \brief Read the flow id from the load balancing metadata of a packet
+   * \param packet the packet
+   * \returns true if the packet carries a flow id
+   */
+  bool PeekFrom (Ptr<const Packet> packet);
+  /**
+   * \brief Set the flow id in the load balancing metadata of a packet
+   *
+   * Unlike Packet::AddPacketTag, an existing flow id is replaced.
+   * \param packet the packet
+   */
+  void AddTo (Ptr<const Packet> packet) const;
+  /**
+   * \brief Read and remove the flow id from the load balancing metadata of a packet
+   * \param packet the packet
+   * \returns true if the packet carried a flow id
+   */
+  bool RemoveFrom (Ptr<const Packet> packet);
   FlowIdTag ();
   
   /**
@@ -56,7 +78,8 @@ public:
    */
   uint32_t GetFlowId (void) const;
   /**
-   *  Uses a static variable to generate sequential flow id
+   *  Uses a static PartitionedCounter to generate flow ids, sequential
+   *  outside of the partitions of a parallel simulator
    *  \returns flow id allocated
    */
   static uint32_t AllocateFlowId (void);
@@ -0,0 +1,179 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "flowlet-table.h"
+
+#include "flow-hash.h"
+
+#include "ns3/log.h"
+#include "ns3/enum.h"
+#include "ns3/uinteger.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("FlowletTable");
+
+NS_OBJECT_ENSURE_REGISTERED (FlowletTable);
+
+TypeId
+FlowletTable::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::FlowletTable")
+    .SetParent<Object> ()
+    .SetGroupName ("Network")
+    .AddConstructor<FlowletTable> ()
+    .AddAttribute ("Mode",
+                   "Whether flows are matched exactly or share the entry of their bucket (hash collision like real ASIC).",
+                   EnumValue (FLOWLET_TABLE_EXACT),
+                   MakeEnumAccessor (&FlowletTable::m_mode),
+                   MakeEnumChecker (FLOWLET_TABLE_EXACT, "FLOWLET_TABLE_EXACT",
+                                    FLOWLET_TABLE_HASHED, "FLOWLET_TABLE_HASHED"))
+    .AddAttribute ("Buckets",
+                   "The number of hashed buckets of the table.",
+                   UintegerValue (1024),
+                   MakeUintegerAccessor (&FlowletTable::m_buckets),
+                   MakeUintegerChecker<uint32_t> (1))
+    .AddAttribute ("Ways",
+                   "The number of entries per bucket in exact mode.",
+                   UintegerValue (4),
+                   MakeUintegerAccessor (&FlowletTable::m_ways),
+                   MakeUintegerChecker<uint32_t> (1))
+  ;
+
+  return tid;
+}
+
+FlowletTable::FlowletTable ()
+  : m_mode (FLOWLET_TABLE_EXACT),
+    m_buckets (1024),
+    m_ways (4),
+    m_collisions (0)
+{
+  NS_LOG_FUNCTION (this);
+}
+
+FlowletTable::~FlowletTable ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+void
+FlowletTable::DoDispose (void)
+{
+  Clear ();
+  Object::DoDispose ();
+}
+
+uint32_t
+FlowletTable::GetCapacity (void) const
+{
+  return m_mode == FLOWLET_TABLE_EXACT ? m_buckets * m_ways : m_buckets;
+}
+
+uint64_t
+FlowletTable::GetCollisions (void) const
+{
+  return m_collisions;
+}
+
+void
+FlowletTable::Clear (void)
+{
+  std::vector<FlowletEntry> ().swap (m_entries);
+}
+
+void
+FlowletTable::Allocate (void)
+{
+  NS_LOG_FUNCTION (this << GetCapacity ());
+  FlowletEntry emptyEntry;
+  emptyEntry.flowId = 0;
+  emptyEntry.path = 0;
+  emptyEntry.activeTime = Time (0);
+  emptyEntry.valid = false;
+  m_entries.assign (GetCapacity (), emptyEntry);
+}
+
+uint32_t
+FlowletTable::GetBucket (uint32_t flowId) const
+{
+  // The flow ids of consecutive flows should not land in consecutive buckets
+  return FlowHash::Mix (flowId) % m_buckets;
+}
+
+FlowletEntry *
+FlowletTable::Lookup (uint32_t flowId)
+{
+  if (m_entries.empty ())
+    {
+      return 0;
+    }
+
+  if (m_mode == FLOWLET_TABLE_HASHED)
+    {
+      FlowletEntry *entry = &m_entries[GetBucket (flowId)];
+      return entry->valid ? entry : 0;
+    }
+
+  FlowletEntry *bucket = &m_entries[GetBucket (flowId) * m_ways];
+  for (uint32_t way = 0; way < m_ways; way++)
+    {
+      if (bucket[way].valid && bucket[way].flowId == flowId)
+        {
+          return &bucket[way];
+        }
+    }
+  return 0;
+}
+
+FlowletEntry *
+FlowletTable::Insert (uint32_t flowId, Time timeout)
+{
+  if (m_entries.empty ())
+    {
+      Allocate ();
+    }
+
+  FlowletEntry *entry = 0;
+
+  if (m_mode == FLOWLET_TABLE_HASHED)
+    {
+      entry = &m_entries[GetBucket (flowId)];
+    }
+  else
+    {
+      Time now = Simulator::Now ();
+      FlowletEntry *bucket = &m_entries[GetBucket (flowId) * m_ways];
+      for (uint32_t way = 0; way < m_ways; way++)
+        {
+          if (!bucket[way].valid || bucket[way].flowId == flowId)
+            {
+              entry = &bucket[way];
+              break;
+            }
+          // Among the timed out flowlets, the least recently active one
+          if (now - bucket[way].activeTime > timeout
+              && (entry == 0 || bucket[way].activeTime < entry->activeTime))
+            {
+              entry = &bucket[way];
+            }
+        }
+      if (entry == 0)
+        {
+          NS_LOG_LOGIC (this << " Flow: " << flowId << " collides with live flowlets, no entry");
+          m_collisions++;
+          return 0;
+        }
+    }
+
+  if (entry->valid && entry->flowId != flowId)
+    {
+      NS_LOG_LOGIC (this << " Flow: " << flowId << " reuses the entry of flow: " << entry->flowId);
+    }
+
+  entry->flowId = flowId;
+  entry->valid = true;
+  return entry;
+}
+
+}
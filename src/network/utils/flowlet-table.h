@@ -0,0 +1,104 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef FLOWLET_TABLE_H
+#define FLOWLET_TABLE_H
+
+#include "ns3/object.h"
+#include "ns3/nstime.h"
+
+#include <vector>
+
+namespace ns3 {
+
+struct FlowletEntry
+{
+  uint32_t flowId;
+  uint32_t path;
+  Time activeTime;
+  bool valid;
+};
+
+/**
+ * \ingroup network
+ *
+ * \brief Fixed capacity flowlet table shared by the flowlet based load balancers
+ *
+ * The table is organized as hashed buckets like the flowlet tables found in
+ * switch ASICs, so its memory footprint is bounded by Buckets * Ways entries
+ * no matter how many flows go through it.
+ *
+ * In FLOWLET_TABLE_EXACT mode, each bucket holds Ways entries keyed by the
+ * flow id. Entries are never removed explicitly: a new flow reuses an entry of
+ * its bucket once the flowlet of this entry timed out. When all the entries of
+ * the bucket hold live flowlets, the new flow gets no entry and the collision
+ * is counted, so that live flowlets are never rerouted.
+ *
+ * In FLOWLET_TABLE_HASHED mode, the table is direct mapped and flows hashing
+ * to the same bucket share the same entry, as it happens in hardware.
+ *
+ * The entries are allocated on first use and their addresses remain stable
+ * until the table is cleared.
+ */
+class FlowletTable : public Object
+{
+public:
+  enum FlowletTableMode
+  {
+    FLOWLET_TABLE_EXACT,    /**< Entries are matched on the flow id */
+    FLOWLET_TABLE_HASHED,   /**< Flows colliding on a bucket share the entry */
+  };
+
+  static TypeId GetTypeId (void);
+
+  FlowletTable ();
+  virtual ~FlowletTable ();
+
+  /**
+   * \param flowId the flow id
+   * \return the entry of this flow, or 0 if there is none
+   */
+  FlowletEntry * Lookup (uint32_t flowId);
+
+  /**
+   * Get an entry for the flow, reusing an entry of the bucket whose flowlet
+   * has been inactive for more than the timeout. The path and the active time
+   * of the returned entry should be filled by the caller.
+   *
+   * \param flowId the flow id
+   * \param timeout the flowlet timeout of the caller
+   * \return the entry assigned to this flow, or 0 if the bucket only holds
+   * live flowlets (exact mode)
+   */
+  FlowletEntry * Insert (uint32_t flowId, Time timeout);
+
+  /**
+   * \return the maximum number of entries of the table
+   */
+  uint32_t GetCapacity (void) const;
+
+  /**
+   * \return the number of flows which got no entry since their bucket was full
+   */
+  uint64_t GetCollisions (void) const;
+
+  void Clear (void);
+
+protected:
+  virtual void DoDispose (void);
+
+private:
+  void Allocate (void);
+
+  uint32_t GetBucket (uint32_t flowId) const;
+
+  FlowletTableMode m_mode;
+  uint32_t m_buckets;
+  uint32_t m_ways;
+
+  std::vector<FlowletEntry> m_entries;
+
+  uint64_t m_collisions;
+};
+
+}
+
+#endif /* FLOWLET_TABLE_H */
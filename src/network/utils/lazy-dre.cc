@@ -0,0 +1,99 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "lazy-dre.h"
+
+#include "ns3/assert.h"
+
+#include <cmath>
+
+namespace ns3 {
+
+LazyDre::LazyDre ()
+  : m_period (MicroSeconds (200)),
+    m_alpha (0.2),
+    m_exact (true),
+    m_running (false),
+    m_start (Time (0))
+{
+}
+
+void
+LazyDre::SetPeriod (Time period)
+{
+  NS_ASSERT (period.IsStrictlyPositive ());
+  m_period = period;
+}
+
+void
+LazyDre::SetAlpha (double alpha)
+{
+  m_alpha = alpha;
+}
+
+void
+LazyDre::SetExact (bool exact)
+{
+  m_exact = exact;
+}
+
+void
+LazyDre::Start (Time now)
+{
+  m_running = true;
+  m_start = now;
+}
+
+void
+LazyDre::Stop (void)
+{
+  m_running = false;
+}
+
+bool
+LazyDre::IsRunning (void) const
+{
+  return m_running;
+}
+
+uint64_t
+LazyDre::GetTick (Time now) const
+{
+  if (!m_running || now <= m_start)
+    {
+      return 0;
+    }
+  return (now - m_start).GetTimeStep () / m_period.GetTimeStep ();
+}
+
+uint32_t
+LazyDre::Update (uint32_t &value, uint64_t &tick, Time now) const
+{
+  uint64_t currentTick = GetTick (now);
+  if (currentTick > tick)
+    {
+      value = Decay (value, currentTick - tick);
+    }
+  tick = currentTick;
+  return value;
+}
+
+uint32_t
+LazyDre::Decay (uint32_t value, uint64_t ticks) const
+{
+  if (ticks == 0 || m_alpha <= 0)
+    {
+      return value;
+    }
+  if (m_exact)
+    {
+      // Same truncation as the periodic DRE, stop as soon as we reach zero
+      for (uint64_t i = 0; i < ticks && value != 0; i++)
+        {
+          value = value * (1 - m_alpha);
+        }
+      return value;
+    }
+  return value * std::pow (1 - m_alpha, static_cast<double> (ticks));
+}
+
+}
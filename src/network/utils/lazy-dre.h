@@ -0,0 +1,69 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef LAZY_DRE_H
+#define LAZY_DRE_H
+
+#include "ns3/nstime.h"
+
+namespace ns3 {
+
+/**
+ * \ingroup network
+ *
+ * \brief Discounting Rate Estimator decayed on access instead of by a timer
+ *
+ * The periodic DRE multiplies every counter by (1 - alpha) every period,
+ * starting one period after it has been started. LazyDre keeps the same tick
+ * grid and lets its owner store (value, tick) pairs: the pending decays are
+ * applied when a value is read or updated, so no event has to be scheduled.
+ *
+ * In exact mode, the decay is applied once per elapsed tick with the same
+ * truncation to uint32_t as the periodic version, so both give the same
+ * values. Otherwise, value * (1 - alpha)^ticks is computed at once.
+ */
+class LazyDre
+{
+public:
+  LazyDre ();
+
+  void SetPeriod (Time period);
+  void SetAlpha (double alpha);
+  void SetExact (bool exact);
+
+  /**
+   * Start the tick grid, the first decay happens one period after now.
+   */
+  void Start (Time now);
+  void Stop (void);
+  bool IsRunning (void) const;
+
+  /**
+   * \return the number of decays which have happened from the start up to
+   * now (included), 0 if the estimator is not running
+   */
+  uint64_t GetTick (Time now) const;
+
+  /**
+   * Apply the decays which happened since tick to value, and set tick to
+   * the current tick.
+   *
+   * \return the decayed value
+   */
+  uint32_t Update (uint32_t &value, uint64_t &tick, Time now) const;
+
+  /**
+   * \return value decayed ticks times
+   */
+  uint32_t Decay (uint32_t value, uint64_t ticks) const;
+
+private:
+  Time m_period;
+  double m_alpha;
+  bool m_exact;
+
+  bool m_running;
+  Time m_start;
+};
+
+}
+
+#endif /* LAZY_DRE_H */
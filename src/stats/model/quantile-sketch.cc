@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "quantile-sketch.h"
+
+#include "ns3/assert.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+QuantileSketch::QuantileSketch (double accuracy)
+  : m_accuracy (accuracy)
+{
+  NS_ASSERT_MSG (accuracy > 0 && accuracy < 1, "The accuracy should be in (0, 1)");
+  m_gamma = (1 + accuracy) / (1 - accuracy);
+  m_logGamma = std::log (m_gamma);
+  Reset ();
+}
+
+void
+QuantileSketch::Update (double x)
+{
+  if (x > 0)
+    {
+      int32_t index = static_cast<int32_t> (std::ceil (std::log (x) / m_logGamma));
+      m_buckets[index]++;
+    }
+  else
+    {
+      m_zeroCount++;
+    }
+  if (m_count == 0)
+    {
+      m_min = x;
+      m_max = x;
+    }
+  else
+    {
+      m_min = std::min (m_min, x);
+      m_max = std::max (m_max, x);
+    }
+  m_count++;
+  m_sum += x;
+}
+
+void
+QuantileSketch::Merge (const QuantileSketch &other)
+{
+  NS_ASSERT_MSG (m_accuracy == other.m_accuracy, "Cannot merge sketches with different accuracies");
+  if (other.m_count == 0)
+    {
+      return;
+    }
+  for (std::map<int32_t, uint64_t>::const_iterator it = other.m_buckets.begin ();
+       it != other.m_buckets.end (); ++it)
+    {
+      m_buckets[it->first] += it->second;
+    }
+  m_min = m_count == 0 ? other.m_min : std::min (m_min, other.m_min);
+  m_max = m_count == 0 ? other.m_max : std::max (m_max, other.m_max);
+  m_zeroCount += other.m_zeroCount;
+  m_count += other.m_count;
+  m_sum += other.m_sum;
+}
+
+void
+QuantileSketch::Reset (void)
+{
+  m_buckets.clear ();
+  m_zeroCount = 0;
+  m_count = 0;
+  m_sum = 0;
+  m_min = 0;
+  m_max = 0;
+}
+
+double
+QuantileSketch::GetQuantile (double q) const
+{
+  if (m_count == 0)
+    {
+      return 0;
+    }
+  q = std::min (std::max (q, 0.0), 1.0);
+  // Rank of the quantile among the sorted samples, starting from 0
+  uint64_t rank = static_cast<uint64_t> (q * (m_count - 1));
+  // The extreme samples are known exactly
+  if (rank == 0)
+    {
+      return m_min;
+    }
+  if (rank == m_count - 1)
+    {
+      return m_max;
+    }
+  if (rank < m_zeroCount)
+    {
+      return std::min (m_min, 0.0);
+    }
+  uint64_t seen = m_zeroCount;
+  for (std::map<int32_t, uint64_t>::const_iterator it = m_buckets.begin ();
+       it != m_buckets.end (); ++it)
+    {
+      seen += it->second;
+      if (seen > rank)
+        {
+          // The bucket covers (gamma^(i-1), gamma^i]
+          double estimate = 2 * std::pow (m_gamma, it->first) / (m_gamma + 1);
+          return std::min (std::max (estimate, m_min), m_max);
+        }
+    }
+  return m_max;
+}
+
+uint64_t
+QuantileSketch::Count (void) const
+{
+  return m_count;
+}
+
+double
+QuantileSketch::Min (void) const
+{
+  return m_min;
+}
+
+double
+QuantileSketch::Max (void) const
+{
+  return m_max;
+}
+
+double
+QuantileSketch::Avg (void) const
+{
+  return m_count == 0 ? 0 : m_sum / m_count;
+}
+
+double
+QuantileSketch::GetAccuracy (void) const
+{
+  return m_accuracy;
+}
+
+} // namespace ns3
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <map>
+#include <stdint.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup stats
+ *
+ * Streaming quantile estimator with a bounded relative error
+ *
+ * The samples are counted in logarithmic buckets: a positive sample x goes
+ * to the bucket ceil (log (x) / log (gamma)) with
+ * gamma = (1 + accuracy) / (1 - accuracy), and a quantile is estimated by
+ * the middle of its bucket, which is within the relative accuracy of the
+ * exact sample. The memory grows with the logarithm of the range of the
+ * samples, not with their number. Samples which are not positive are
+ * counted together as zero.
+ */
+class QuantileSketch
+{
+public:
+  /**
+   * \param accuracy the relative accuracy of the quantiles, in (0, 1)
+   */
+  QuantileSketch (double accuracy = 0.01);
+
+  /// Add a new sample
+  void Update (double x);
+  /// Add all the samples of another sketch with the same accuracy
+  void Merge (const QuantileSketch &other);
+  /// Forget all the samples
+  void Reset (void);
+
+  /**
+   * \param q the quantile, in [0, 1]
+   * \return the estimated quantile, 0 without samples
+   */
+  double GetQuantile (double q) const;
+
+  /// Number of samples
+  uint64_t Count (void) const;
+  /// Minimum sample
+  double Min (void) const;
+  /// Maximum sample
+  double Max (void) const;
+  /// Average of the samples
+  double Avg (void) const;
+  /// Relative accuracy of the quantiles
+  double GetAccuracy (void) const;
+
+private:
+  double m_accuracy;         //!< Relative accuracy
+  double m_gamma;            //!< Ratio between the bounds of a bucket
+  double m_logGamma;         //!< log (m_gamma)
+
+  std::map<int32_t, uint64_t> m_buckets; //!< Sample count per bucket index
+  uint64_t m_zeroCount;      //!< Samples which are not positive
+  uint64_t m_count;          //!< Total number of samples
+  double m_sum;              //!< Sum of the samples
+  double m_min;              //!< Minimum sample
+  double m_max;              //!< Maximum sample
+};
+
+} // namespace ns3
+
+#endif /* QUANTILE_SKETCH_H */
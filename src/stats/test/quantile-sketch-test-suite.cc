@@ -0,0 +1,141 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cmath>
+
+#include "ns3/test.h"
+#include "ns3/quantile-sketch.h"
+
+using namespace ns3;
+
+// ===========================================================================
+// Test case for the quantiles of a uniform sequence.
+// ===========================================================================
+
+class QuantileSketchAccuracyTestCase : public TestCase
+{
+public:
+  QuantileSketchAccuracyTestCase ();
+  virtual ~QuantileSketchAccuracyTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+QuantileSketchAccuracyTestCase::QuantileSketchAccuracyTestCase ()
+  : TestCase ("Quantile sketch keeps the quantiles within its relative accuracy")
+{
+}
+
+QuantileSketchAccuracyTestCase::~QuantileSketchAccuracyTestCase ()
+{
+}
+
+void
+QuantileSketchAccuracyTestCase::DoRun (void)
+{
+  QuantileSketch sketch (0.01);
+
+  // Add 1 to 100000 out of order
+  for (uint32_t i = 0; i < 100000; i++)
+    {
+      sketch.Update ((i * 7919) % 100000 + 1);
+    }
+
+  NS_TEST_ASSERT_MSG_EQ (sketch.Count (), 100000, "Count is wrong");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sketch.Min (), 1, 1e-12, "Min is wrong");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sketch.Max (), 100000, 1e-12, "Max is wrong");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sketch.Avg (), 50000.5, 1e-6, "Avg is wrong");
+
+  double quantiles[4] = { 0.5, 0.9, 0.99, 0.999 };
+  for (uint32_t i = 0; i < 4; i++)
+    {
+      double exact = std::floor (quantiles[i] * 99999) + 1;
+      NS_TEST_ASSERT_MSG_EQ_TOL (sketch.GetQuantile (quantiles[i]), exact, exact * 0.01,
+                                 "Quantile " << quantiles[i] << " is out of the accuracy");
+    }
+  NS_TEST_ASSERT_MSG_EQ_TOL (sketch.GetQuantile (0), 1, 1e-12, "The quantile 0 should be the min");
+  NS_TEST_ASSERT_MSG_EQ_TOL (sketch.GetQuantile (1), 100000, 1e-12, "The quantile 1 should be the max");
+}
+
+// ===========================================================================
+// Test case for merging sketches and for samples which are not positive.
+// ===========================================================================
+
+class QuantileSketchMergeTestCase : public TestCase
+{
+public:
+  QuantileSketchMergeTestCase ();
+  virtual ~QuantileSketchMergeTestCase ();
+
+private:
+  virtual void DoRun (void);
+};
+
+QuantileSketchMergeTestCase::QuantileSketchMergeTestCase ()
+  : TestCase ("Quantile sketch merge and zero samples")
+{
+}
+
+QuantileSketchMergeTestCase::~QuantileSketchMergeTestCase ()
+{
+}
+
+void
+QuantileSketchMergeTestCase::DoRun (void)
+{
+  QuantileSketch low (0.02);
+  QuantileSketch high (0.02);
+  QuantileSketch all (0.02);
+
+  NS_TEST_ASSERT_MSG_EQ_TOL (all.GetQuantile (0.5), 0, 1e-12, "An empty sketch should give 0");
+
+  for (uint32_t i = 0; i < 1000; i++)
+    {
+      low.Update (i);
+      high.Update (1000 + i);
+      all.Update (i);
+      all.Update (1000 + i);
+    }
+  low.Merge (high);
+
+  NS_TEST_ASSERT_MSG_EQ (low.Count (), all.Count (), "Count is wrong after merge");
+  NS_TEST_ASSERT_MSG_EQ_TOL (low.Min (), 0, 1e-12, "Min is wrong after merge");
+  NS_TEST_ASSERT_MSG_EQ_TOL (low.Max (), 1999, 1e-12, "Max is wrong after merge");
+  NS_TEST_ASSERT_MSG_EQ_TOL (low.GetQuantile (0), 0, 1e-12, "The zero sample should be the quantile 0");
+  NS_TEST_ASSERT_MSG_EQ_TOL (low.GetQuantile (0.5), all.GetQuantile (0.5), 1e-12,
+                             "Merged and direct sketches should agree");
+  NS_TEST_ASSERT_MSG_EQ_TOL (low.GetQuantile (0.99), all.GetQuantile (0.99), 1e-12,
+                             "Merged and direct sketches should agree");
+
+  low.Reset ();
+  NS_TEST_ASSERT_MSG_EQ (low.Count (), 0, "Count is wrong after reset");
+}
+
+class QuantileSketchTestSuite : public TestSuite
+{
+public:
+  QuantileSketchTestSuite ();
+};
+
+QuantileSketchTestSuite::QuantileSketchTestSuite ()
+  : TestSuite ("quantile-sketch", UNIT)
+{
+  AddTestCase (new QuantileSketchAccuracyTestCase, TestCase::QUICK);
+  AddTestCase (new QuantileSketchMergeTestCase, TestCase::QUICK);
+}
+
+static QuantileSketchTestSuite quantileSketchTestSuite;
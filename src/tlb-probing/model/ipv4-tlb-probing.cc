@@ -61,6 +61,7 @@ Ipv4TLBProbing::Ipv4TLBProbing ()
       m_node ()
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4TLBProbing::Ipv4TLBProbing (const Ipv4TLBProbing &other)
@@ -77,6 +78,7 @@ Ipv4TLBProbing::Ipv4TLBProbing (const Ipv4TLBProbing &other)
       m_node ()
 {
     NS_LOG_FUNCTION (this);
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4TLBProbing::~Ipv4TLBProbing ()
@@ -84,6 +86,13 @@ Ipv4TLBProbing::~Ipv4TLBProbing ()
     NS_LOG_FUNCTION (this);
 }
 
+int64_t
+Ipv4TLBProbing::AssignStreams (int64_t stream)
+{
+    m_rand->SetStream (stream);
+    return 1;
+}
+
 void
 Ipv4TLBProbing::DoDispose ()
 {
@@ -147,7 +156,7 @@ Ipv4TLBProbing::SendProbe (uint32_t path)
     // XPath tag
     Ipv4XPathTag ipv4XPathTag;
     ipv4XPathTag.SetPathId (path);
-    packet->AddPacketTag (ipv4XPathTag);
+    ipv4XPathTag.AddTo (packet);
 
     // Probing tag
     Ipv4TLBProbingTag probingTag;
@@ -316,7 +325,7 @@ Ipv4TLBProbing::DoProbe ()
     {
         for (uint32_t i = 0; i < 10; i++) // Try 8 times
         {
-            uint32_t path = availPaths[rand() % availPaths.size ()];
+            uint32_t path = availPaths[m_rand->GetInteger (0, availPaths.size () - 1)];
             if (pathSet.find (path) != pathSet.end ())
             {
                 continue;
@@ -8,6 +8,7 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/nstime.h"
 #include "ns3/event-id.h"
+#include "ns3/random-variable-stream.h"
 
 #include <vector>
 #include <map>
@@ -50,6 +51,15 @@ public:
 
     void StopProbe (Time stopTime);
 
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.
+     *
+     * \param stream first stream index to use
+     * \return the number of stream indices assigned by this model
+     */
+    int64_t AssignStreams (int64_t stream);
+
 private:
 
     void DoProbe ();
@@ -87,6 +97,8 @@ private:
 
     Ptr<Node> m_node;
 
+    Ptr<UniformRandomVariable> m_rand; // Picks the paths to probe
+
 };
 
 }
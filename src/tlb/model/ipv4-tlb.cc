@@ -13,6 +13,7 @@
 
 #define RANDOM_BASE 100
 #define SMOOTH_BASE 100
+#define FLOW_WHEEL_SIZE 256
 
 namespace ns3 {
 
@@ -34,6 +35,7 @@ Ipv4TLB::Ipv4TLB ():
     m_dreDataRate (DataRate ("1Gbps")),
     m_dreQ (3),
     m_dreMultiply (5),
+    m_dreExact (true),
     m_minRtt (MicroSeconds (60)), // 50 70 100
     m_highRtt (MicroSeconds (80)),
     m_ecnSampleMin (14000),
@@ -64,9 +66,15 @@ Ipv4TLB::Ipv4TLB ():
     // Added at Jan 12nd
     m_flowletTimeout (MicroSeconds (5000000)),
     m_rttAlpha(1.0),
-    m_ecnBeta(0.0)
+    m_ecnBeta(0.0),
+    m_flowWheel (FLOW_WHEEL_SIZE),
+    m_flowWheelTick (0),
+    m_agingRunning (false),
+    m_agingStart (Time (0))
 {
     NS_LOG_FUNCTION (this);
+    m_acklets = CreateObject<FlowletTable> ();
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 Ipv4TLB::Ipv4TLB (const Ipv4TLB &other):
@@ -83,6 +91,7 @@ Ipv4TLB::Ipv4TLB (const Ipv4TLB &other):
     m_dreDataRate (other.m_dreDataRate),
     m_dreQ (other.m_dreQ),
     m_dreMultiply (other.m_dreMultiply),
+    m_dreExact (other.m_dreExact),
     m_minRtt (other.m_minRtt),
     m_highRtt (other.m_highRtt),
     m_ecnSampleMin (other.m_ecnSampleMin),
@@ -111,9 +120,15 @@ Ipv4TLB::Ipv4TLB (const Ipv4TLB &other):
     */
     m_flowletTimeout (other.m_flowletTimeout),
     m_rttAlpha (other.m_rttAlpha),
-    m_ecnBeta (other.m_ecnBeta)
+    m_ecnBeta (other.m_ecnBeta),
+    m_flowWheel (FLOW_WHEEL_SIZE),
+    m_flowWheelTick (0),
+    m_agingRunning (false),
+    m_agingStart (Time (0))
 {
     NS_LOG_FUNCTION (this);
+    m_acklets = CreateObject<FlowletTable> ();
+    m_rand = CreateObject<UniformRandomVariable> ();
 }
 
 TypeId
@@ -143,6 +158,10 @@ Ipv4TLB::GetTypeId (void)
                       UintegerValue (5),
                       MakeUintegerAccessor (&Ipv4TLB::m_dreMultiply),
                       MakeUintegerChecker<uint32_t> ())
+        .AddAttribute ("DREExact", "Whether the lazy DRE decay reproduces the truncation of the periodic decay",
+                      BooleanValue (true),
+                      MakeBooleanAccessor (&Ipv4TLB::m_dreExact),
+                      MakeBooleanChecker ())
         .AddAttribute ("S", "The sent size used to judge whether a flow should change path",
                       UintegerValue (64000),
                       MakeUintegerAccessor (&Ipv4TLB::m_S),
@@ -265,22 +284,21 @@ Ipv4TLB::GetAvailPath (Ipv4Address daddr)
 uint32_t
 Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
 {
-    struct TLBAcklet acklet;
-    std::map<uint32_t, TLBAcklet>::iterator ackletItr = m_acklets.find (flowId);
+    Ipv4TLB::AgeFlows ();
+
+    FlowletEntry *acklet = m_acklets->Lookup (flowId);
 
-    if (ackletItr != m_acklets.end ())
+    if (acklet != NULL)
     {
         // Existing flow
-        acklet = ackletItr->second;
-        if (Simulator::Now () - acklet.activeTime <= m_ackletTimeout) // Timeout
+        if (Simulator::Now () - acklet->activeTime <= m_ackletTimeout) // Timeout
         {
-            acklet.activeTime = Simulator::Now ();
-            m_acklets[flowId] = acklet;
-            return acklet.pathId;
+            acklet->activeTime = Simulator::Now ();
+            return acklet->path;
         }
 
         // Bug Fix for bad small flow FCT in black hole case
-        if (Simulator:: Now () - acklet.activeTime >= MilliSeconds (1))
+        if (Simulator:: Now () - acklet->activeTime >= MilliSeconds (1))
         {
             uint32_t destTor = 0;
             if (!Ipv4TLB::FindTorId (daddr, destTor))
@@ -289,7 +307,7 @@ Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
                 return 0;
             }
 
-            uint32_t oldPath = acklet.pathId;
+            uint32_t oldPath = acklet->path;
 
             // Ipv4TLB::TimeoutPath (destTor, oldPath, false, true);
 
@@ -303,10 +321,8 @@ Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
                 }
             }
 
-            acklet.pathId = newPath.pathId;
-            acklet.activeTime = Simulator::Now ();
-
-            m_acklets[flowId] = acklet;
+            acklet->path = newPath.pathId;
+            acklet->activeTime = Simulator::Now ();
 
             return newPath.pathId;
         }
@@ -326,10 +342,16 @@ Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
         newPath = Ipv4TLB::SelectRandomPath (destTor);
     }
 
-    acklet.pathId = newPath.pathId;
-    acklet.activeTime = Simulator::Now ();
-
-    m_acklets[flowId] = acklet;
+    if (acklet == NULL)
+    {
+        acklet = m_acklets->Insert (flowId, m_ackletTimeout);
+    }
+    // Without an entry, the ACKs of the flow are routed one by one
+    if (acklet != NULL)
+    {
+        acklet->path = newPath.pathId;
+        acklet->activeTime = Simulator::Now ();
+    }
 
     return newPath.pathId;
 }
@@ -337,14 +359,19 @@ Ipv4TLB::GetAckPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
 uint32_t
 Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
 {
-    if (!m_agingEvent.IsRunning ())
+    if (!m_agingRunning)
     {
-        m_agingEvent = Simulator::Schedule (m_agingCheckTime, &Ipv4TLB::PathAging, this);
+        m_agingRunning = true;
+        m_agingStart = Simulator::Now ();
     }
+    Ipv4TLB::AgeFlows ();
 
-    if (!m_dreEvent.IsRunning ())
+    if (!m_dre.IsRunning ())
     {
-        m_dreEvent = Simulator::Schedule (m_dreTime, &Ipv4TLB::DreAging, this);
+        m_dre.SetPeriod (m_dreTime);
+        m_dre.SetAlpha (m_dreAlpha);
+        m_dre.SetExact (m_dreExact);
+        m_dre.Start (Simulator::Now ());
     }
 
     uint32_t destTor = 0;
@@ -360,21 +387,21 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
         NS_LOG_ERROR ("Cannot find source tor id based on the given source address");
     }
 
-    std::map<uint32_t, TLBFlowInfo>::iterator flowItr = m_flowInfo.find (flowId);
+    TLBFlowInfo *flowInfo = Ipv4TLB::FindFlow (flowId);
 
     // First check if the flow is a new flow
-    if (flowItr == m_flowInfo.end ())
+    if (flowInfo == NULL)
     {
         // New flow
         struct PathInfo newPath;
         if (Ipv4TLB::WhereToChange (destTor, newPath, false, 0))
         {
-            m_pathSelectTrace (flowId, sourceTor, destTor, newPath.pathId, false, newPath, Ipv4TLB::GatherParallelPaths (destTor));
+            Ipv4TLB::TracePathSelect (flowId, sourceTor, destTor, false, newPath);
         }
         else
         {
             newPath = Ipv4TLB::SelectRandomPath (destTor);
-            m_pathSelectTrace (flowId, sourceTor, destTor, newPath.pathId, true, newPath, Ipv4TLB::GatherParallelPaths (destTor));
+            Ipv4TLB::TracePathSelect (flowId, sourceTor, destTor, true, newPath);
         }
         Ipv4TLB::UpdateFlowPath (flowId, newPath.pathId, destTor);
         Ipv4TLB::AssignFlowToPath (flowId, destTor, newPath.pathId);
@@ -382,22 +409,22 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
     }
     else if (m_rerouteEnable)
     {
-        Time flowActiveTime = (flowItr->second).activeTime;
-        (flowItr->second).activeTime = Simulator::Now ();
+        Time flowActiveTime = flowInfo->activeTime;
+        flowInfo->activeTime = Simulator::Now ();
 
         // Old flow
-        uint32_t oldPath = (flowItr->second).path;
+        uint32_t oldPath = flowInfo->path;
         struct PathInfo oldPathInfo = Ipv4TLB::JudgePath (destTor, oldPath);
         if (m_respondToFailure
-                && ((flowItr->second).retransmissionSize > m_flowRetransVeryHigh
-                || (flowItr->second).timeoutCount >= 1))
+                && (flowInfo->retransmissionSize > m_flowRetransVeryHigh
+                || flowInfo->timeoutCount >= 1))
         {
             struct PathInfo newPath;
             if (Ipv4TLB::WhereToChange (destTor, newPath, true, oldPath))
             {
                 if (newPath.pathId != oldPath)
                 {
-                    m_pathChangeTrace (flowId, sourceTor, destTor, newPath.pathId, oldPath, false, Ipv4TLB::GatherParallelPaths (destTor));
+                    Ipv4TLB::TracePathChange (flowId, sourceTor, destTor, newPath.pathId, oldPath, false);
                 }
             }
             else
@@ -405,7 +432,7 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
                 newPath = Ipv4TLB::SelectRandomPath (destTor);
                 if (newPath.pathId != oldPath)
                 {
-                    m_pathChangeTrace (flowId, sourceTor, destTor, newPath.pathId, oldPath, true, Ipv4TLB::GatherParallelPaths (destTor));
+                    Ipv4TLB::TracePathChange (flowId, sourceTor, destTor, newPath.pathId, oldPath, true);
                 }
             }
 
@@ -421,13 +448,13 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
         }
         else if ((oldPathInfo.pathType == BadPath || Simulator::Now () - flowActiveTime > m_flowletTimeout) // Trigger for rerouting
                 && oldPathInfo.quantifiedDre <= m_dreMultiply * 8  // TODO To be fixed
-                && (flowItr->second).size >= m_S
-                /*&& ((static_cast<double> ((flowItr->second).ecnSize) / (flowItr->second).size > m_ecnPortionHigh && Simulator::Now () - (flowItr->second).timeStamp >= m_T) || (flowItr->second).retransmissionSize > m_flowRetransHigh)*/
-                && Simulator::Now() - (flowItr->second).tryChangePath > MicroSeconds (100))
+                && flowInfo->size >= m_S
+                /*&& ((static_cast<double> (flowInfo->ecnSize) / flowInfo->size > m_ecnPortionHigh && Simulator::Now () - flowInfo->timeStamp >= m_T) || flowInfo->retransmissionSize > m_flowRetransHigh)*/
+                && Simulator::Now() - flowInfo->tryChangePath > MicroSeconds (100))
         {
-            if (rand () % RANDOM_BASE < static_cast<int> (RANDOM_BASE - m_pathChangePoss))
+            if (m_rand->GetInteger (0, RANDOM_BASE - 1) < RANDOM_BASE - m_pathChangePoss)
             {
-                (flowItr->second).tryChangePath = Simulator::Now ();
+                flowInfo->tryChangePath = Simulator::Now ();
                 return oldPath;
             }
             struct PathInfo newPath;
@@ -438,7 +465,7 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
                     return oldPath;
                 }
 
-                m_pathChangeTrace (flowId, sourceTor, destTor, newPath.pathId, oldPath, false, Ipv4TLB::GatherParallelPaths (destTor));
+                Ipv4TLB::TracePathChange (flowId, sourceTor, destTor, newPath.pathId, oldPath, false);
 
                 // Calculate the pause time
                 Time pauseTime = oldPathInfo.rttMin - newPath.rttMin;
@@ -463,9 +490,9 @@ Ipv4TLB::GetPath (uint32_t flowId, Ipv4Address saddr, Ipv4Address daddr)
     }
     else
     {
-        (flowItr->second).activeTime = Simulator::Now ();
+        flowInfo->activeTime = Simulator::Now ();
 
-        uint32_t oldPath = (flowItr->second).path;
+        uint32_t oldPath = flowInfo->path;
         return oldPath;
     }
 }
@@ -484,6 +511,7 @@ Ipv4TLB::GetPauseTime (uint32_t flowId)
 void
 Ipv4TLB::FlowRecv (uint32_t flowId, uint32_t path, Ipv4Address daddr, uint32_t size, bool withECN, Time rtt)
 {
+    Ipv4TLB::AgeFlows ();
     // NS_LOG_FUNCTION (flowId << path << daddr << size << withECN << rtt);
     uint32_t destTor = 0;
     if (!Ipv4TLB::FindTorId (daddr, destTor))
@@ -498,6 +526,7 @@ Ipv4TLB::FlowRecv (uint32_t flowId, uint32_t path, Ipv4Address daddr, uint32_t s
 void
 Ipv4TLB::FlowSend (uint32_t flowId, Ipv4Address daddr, uint32_t path, uint32_t size, bool isRetransmission)
 {
+    Ipv4TLB::AgeFlows ();
     // NS_LOG_FUNCTION (flowId << daddr << path << size << isRetransmission);
     uint32_t destTor = 0;
     if (!Ipv4TLB::FindTorId (daddr, destTor))
@@ -536,6 +565,7 @@ Ipv4TLB::FlowSend (uint32_t flowId, Ipv4Address daddr, uint32_t path, uint32_t s
 void
 Ipv4TLB::FlowTimeout (uint32_t flowId, Ipv4Address daddr, uint32_t path)
 {
+    Ipv4TLB::AgeFlows ();
     uint32_t destTor = 0;
     if (!Ipv4TLB::FindTorId (daddr, destTor))
     {
@@ -555,20 +585,21 @@ Ipv4TLB::FlowTimeout (uint32_t flowId, Ipv4Address daddr, uint32_t path)
 void
 Ipv4TLB::FlowFinish (uint32_t flowId, Ipv4Address daddr)
 {
+    Ipv4TLB::AgeFlows ();
     uint32_t destTor = 0;
     if (!Ipv4TLB::FindTorId (daddr, destTor))
     {
         NS_LOG_ERROR ("Cannot find dest tor id based on the given dest address");
         return;
     }
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = Ipv4TLB::FindFlow (flowId);
+    if (flowInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot finish a non-existing flow");
         return;
     }
 
-    Ipv4TLB::RemoveFlowFromPath (flowId, destTor, (itr->second).path);
+    Ipv4TLB::RemoveFlowFromPath (flowId, destTor, flowInfo->path);
 
 }
 
@@ -581,14 +612,7 @@ Ipv4TLB::ProbeSend (Ipv4Address daddr, uint32_t path)
         NS_LOG_ERROR ("Cannot find dest tor id based on the given dest address");
         return;
     }
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-
-    if (itr == m_pathInfo.end ())
-    {
-        m_pathInfo[key] = Ipv4TLB::GetInitPathInfo (path);
-    }
-
+    Ipv4TLB::GetPathInfo (destTor, path);
 }
 
 void
@@ -623,6 +647,13 @@ Ipv4TLB::SetNode (Ptr<Node> node)
     m_node = node;
 }
 
+int64_t
+Ipv4TLB::AssignStreams (int64_t stream)
+{
+    m_rand->SetStream (stream);
+    return 1;
+}
+
 void
 Ipv4TLB::PacketReceive (uint32_t flowId, uint32_t path, uint32_t destTorId,
                         uint32_t size, bool withECN, Time rtt, bool isProbing)
@@ -643,34 +674,34 @@ Ipv4TLB::PacketReceive (uint32_t flowId, uint32_t path, uint32_t destTorId,
 bool
 Ipv4TLB::UpdateFlowInfo (uint32_t flowId, uint32_t path, uint32_t size, bool withECN, Time rtt)
 {
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = Ipv4TLB::FindFlow (flowId);
+    if (flowInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot update info for a non-existing flow");
         return false;
     }
-    if ((itr->second).path != path)
+    if (flowInfo->path != path)
     {
         return false;
     }
-    (itr->second).size += size;
+    flowInfo->size += size;
     if (withECN)
     {
-        (itr->second).ecnSize += size;
+        flowInfo->ecnSize += size;
     }
-    (itr->second).liveTime = Simulator::Now ();
+    flowInfo->liveTime = Simulator::Now ();
 
     // Added Dec 23rd
     /*
     if (m_isSmooth)
     {
-        (itr->second).rtt = (SMOOTH_BASE - m_smoothAlpha) * (itr->second).rtt / SMOOTH_BASE + m_smoothAlpha * rtt / SMOOTH_BASE;
+        flowInfo->rtt = (SMOOTH_BASE - m_smoothAlpha) * flowInfo->rtt / SMOOTH_BASE + m_smoothAlpha * rtt / SMOOTH_BASE;
     }
     else
     {
-        if (rtt < (itr->second).rtt)
+        if (rtt < flowInfo->rtt)
         {
-            (itr->second).rtt = rtt;
+            flowInfo->rtt = rtt;
         }
     }
     */
@@ -678,19 +709,19 @@ Ipv4TLB::UpdateFlowInfo (uint32_t flowId, uint32_t path, uint32_t size, bool wit
 
     // Added Jan 11st
     /*
-    (itr->second).epAckSize += size;
+    flowInfo->epAckSize += size;
     if (withECN)
     {
-        (itr->second).epEcnSize += size;
+        flowInfo->epEcnSize += size;
     }
-    if (Simulator::Now () - (itr->second).epTimeStamp > m_epCheckTime)
+    if (Simulator::Now () - flowInfo->epTimeStamp > m_epCheckTime)
     {
-        double originalEcnPortion = (itr->second).epEcnPortion;
-        double newEcnPortition = static_cast<double> ((itr->second).epEcnSize) / (itr->second).epAckSize;
-        (itr->second).epAckSize = 1;
-        (itr->second).epEcnSize = 0;
-        (itr->second).epEcnPortion = m_epAlpha * originalEcnPortion + (1.0 - m_epAlpha) * newEcnPortition;
-        (itr->second).epTimeStamp = Simulator::Now ();
+        double originalEcnPortion = flowInfo->epEcnPortion;
+        double newEcnPortition = static_cast<double> (flowInfo->epEcnSize) / flowInfo->epAckSize;
+        flowInfo->epAckSize = 1;
+        flowInfo->epEcnSize = 0;
+        flowInfo->epEcnPortion = m_epAlpha * originalEcnPortion + (1.0 - m_epAlpha) * newEcnPortition;
+        flowInfo->epTimeStamp = Simulator::Now ();
     }
     */
     // --
@@ -701,18 +732,7 @@ Ipv4TLB::UpdateFlowInfo (uint32_t flowId, uint32_t path, uint32_t size, bool wit
 void
 Ipv4TLB::UpdatePathInfo (uint32_t destTor, uint32_t path, uint32_t size, bool withECN, Time rtt)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-
-    TLBPathInfo pathInfo;
-    if (itr == m_pathInfo.end ())
-    {
-        pathInfo = Ipv4TLB::GetInitPathInfo (path);
-    }
-    else
-    {
-        pathInfo = itr->second;
-    }
+    TLBPathInfo &pathInfo = Ipv4TLB::GetPathInfo (destTor, path);
 
     pathInfo.size += size;
     if (withECN)
@@ -750,26 +770,24 @@ Ipv4TLB::UpdatePathInfo (uint32_t destTor, uint32_t path, uint32_t size, bool wi
     }
     */
     // --
-
-    m_pathInfo[key] = pathInfo;
 }
 
 bool
 Ipv4TLB::TimeoutFlow (uint32_t flowId, uint32_t path, bool &isVeryTimeout)
 {
     isVeryTimeout = false;
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = Ipv4TLB::FindFlow (flowId);
+    if (flowInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot timeout a non-existing flow");
         return false;
     }
-    if ((itr->second).path != path)
+    if (flowInfo->path != path)
     {
         return false;
     }
-    (itr->second).timeoutCount ++;
-    if ((itr->second).timeoutCount >= m_flowTimeoutCount)
+    flowInfo->timeoutCount ++;
+    if (flowInfo->timeoutCount >= m_flowTimeoutCount)
     {
         isVeryTimeout = true;
     }
@@ -779,33 +797,32 @@ Ipv4TLB::TimeoutFlow (uint32_t flowId, uint32_t path, bool &isVeryTimeout)
 bool
 Ipv4TLB::SendFlow (uint32_t flowId, uint32_t path, uint32_t size)
 {
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = Ipv4TLB::FindFlow (flowId);
+    if (flowInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot retransmit a non-existing flow");
         return false;
     }
-    if ((itr->second).path != path)
+    if (flowInfo->path != path)
     {
         return false;
     }
-    (itr->second).sendSize += size;
+    flowInfo->sendSize += size;
     return true;
 }
 
 void
 Ipv4TLB::SendPath (uint32_t destTor, uint32_t path, uint32_t size)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-
-    if (itr == m_pathInfo.end ())
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot send a non-existing path");
         return;
     }
 
-    (itr->second).dreValue += size;
+    m_dre.Update (pathInfo->dreValue, pathInfo->dreTick, Simulator::Now ());
+    pathInfo->dreValue += size;
 }
 
 bool
@@ -813,26 +830,26 @@ Ipv4TLB::RetransFlow (uint32_t flowId, uint32_t path, uint32_t size, bool &needR
 {
     needRetranPath = false;
     needHighRetransPath = false;
-    std::map<uint32_t, TLBFlowInfo>::iterator itr = m_flowInfo.find (flowId);
-    if (itr == m_flowInfo.end ())
+    TLBFlowInfo *flowInfo = Ipv4TLB::FindFlow (flowId);
+    if (flowInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot retransmit a non-existing flow");
         return false;
     }
-    if ((itr->second).path != path)
+    if (flowInfo->path != path)
     {
         return false;
     }
-    if (Simulator::Now () - (itr->second).timeStamp < MicroSeconds (1000))
+    if (Simulator::Now () - flowInfo->timeStamp < MicroSeconds (1000))
     {
         return false;
     }
-    (itr->second).retransmissionSize += size;
-    if ((itr->second).retransmissionSize > m_flowRetransHigh)
+    flowInfo->retransmissionSize += size;
+    if (flowInfo->retransmissionSize > m_flowRetransHigh)
     {
         needRetranPath = true;
     }
-    if ((itr->second).retransmissionSize > m_flowRetransVeryHigh)
+    if (flowInfo->retransmissionSize > m_flowRetransVeryHigh)
     {
         needHighRetransPath = true;
     }
@@ -843,41 +860,39 @@ Ipv4TLB::RetransFlow (uint32_t flowId, uint32_t path, uint32_t size, bool &needR
 void
 Ipv4TLB::TimeoutPath (uint32_t destTor, uint32_t path, bool isProbing, bool isVeryTimeout)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-    if (itr == m_pathInfo.end ())
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot timeout a non-existing path");
         return;
     }
     if (!isProbing)
     {
-        (itr->second).isTimeout = true;
+        pathInfo->isTimeout = true;
         if (isVeryTimeout)
         {
-            (itr->second).isVeryTimeout = true;
+            pathInfo->isVeryTimeout = true;
         }
     }
     else
     {
-        (itr->second).isProbingTimeout = true;
+        pathInfo->isProbingTimeout = true;
     }
 }
 
 void
 Ipv4TLB::RetransPath (uint32_t destTor, uint32_t path, bool needHighRetransPath)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-    if (itr == m_pathInfo.end ())
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot timeout a non-existing path");
         return;
     }
-    (itr->second).isRetransmission = true;
+    pathInfo->isRetransmission = true;
     if (needHighRetransPath)
     {
-        (itr->second).isHighRetransmission = true;
+        pathInfo->isHighRetransmission = true;
     }
 }
 
@@ -885,6 +900,7 @@ void
 Ipv4TLB::UpdateFlowPath (uint32_t flowId, uint32_t path, uint32_t destTor)
 {
     TLBFlowInfo flowInfo;
+    flowInfo.flowId = flowId;
     flowInfo.path = path;
     flowInfo.destTor = destTor;
     flowInfo.size = 0;
@@ -912,7 +928,30 @@ Ipv4TLB::UpdateFlowPath (uint32_t flowId, uint32_t path, uint32_t destTor)
     // Added Jan 12nd
     flowInfo.activeTime = Simulator::Now ();
 
-    m_flowInfo[flowId] = flowInfo;
+    flowInfo.inUse = true;
+    flowInfo.inWheel = false;
+
+    uint32_t slot = 0;
+    std::map<uint32_t, uint32_t>::iterator itr = m_flowInfo.find (flowId);
+    if (itr != m_flowInfo.end ())
+    {
+        slot = itr->second;
+    }
+    else if (!m_freeFlowSlots.empty ())
+    {
+        slot = m_freeFlowSlots.back ();
+        m_freeFlowSlots.pop_back ();
+    }
+    else
+    {
+        slot = m_flowSlots.size ();
+        m_flowSlots.push_back (flowInfo);
+    }
+    flowInfo.inWheel = m_flowSlots[slot].inWheel;
+    m_flowSlots[slot] = flowInfo;
+    m_flowInfo[flowId] = slot;
+
+    Ipv4TLB::ScheduleFlowAging (slot);
 }
 
 TLBPathInfo
@@ -934,6 +973,9 @@ Ipv4TLB::GetInitPathInfo (uint32_t path)
     pathInfo.timeStamp2 = Simulator::Now ();
     pathInfo.timeStamp3 = Simulator::Now ();
     pathInfo.dreValue = 0;
+    pathInfo.dreTick = 0;
+    pathInfo.agingTick = Ipv4TLB::GetAgingTick (Simulator::Now ());
+    pathInfo.valid = true;
 
     // Added Jan 11st
     // Path ECN portion default value
@@ -950,39 +992,25 @@ Ipv4TLB::GetInitPathInfo (uint32_t path)
 void
 Ipv4TLB::AssignFlowToPath (uint32_t flowId, uint32_t destTor, uint32_t path)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-
-    TLBPathInfo pathInfo;
-    if (itr == m_pathInfo.end ())
-    {
-        pathInfo = Ipv4TLB::GetInitPathInfo (path);
-    }
-    else
-    {
-        pathInfo = itr->second;
-    }
-
+    TLBPathInfo &pathInfo = Ipv4TLB::GetPathInfo (destTor, path);
     pathInfo.flowCounter ++;
-    m_pathInfo[key] = pathInfo;
 }
 
 void
 Ipv4TLB::RemoveFlowFromPath (uint32_t flowId, uint32_t destTor, uint32_t path)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair(destTor, path);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
-    if (itr == m_pathInfo.end ())
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo == NULL)
     {
         NS_LOG_ERROR ("Cannot remove flow from a non-existing path");
         return;
     }
-    if ((itr->second).flowCounter == 0)
+    if (pathInfo->flowCounter == 0)
     {
         NS_LOG_ERROR ("Cannot decrease from counter while it has reached 0");
         return;
     }
-    (itr->second).flowCounter --;
+    pathInfo->flowCounter --;
 
 }
 
@@ -1086,20 +1114,20 @@ Ipv4TLB::WhereToChange (uint32_t destTor, PathInfo &newPath, bool hasOldPath, ui
         {
             if (minCounter <= m_K)
             {
-                newPath = candidatePaths[rand () % candidatePaths.size ()];
+                newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
             }
         }
         else if (m_runMode == TLB_RUNMODE_MINRTT)
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         else if (m_runMode == TLB_RUNMODE_RTT_COUNTER || m_runMode == TLB_RUNMODE_RTT_DRE)
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         else
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         NS_LOG_LOGIC ("Find Good Path: " << newPath.pathId);
         return true;
@@ -1207,21 +1235,21 @@ Ipv4TLB::WhereToChange (uint32_t destTor, PathInfo &newPath, bool hasOldPath, ui
         {
             if (minCounter <= m_K)
             {
-                newPath = candidatePaths[rand () % candidatePaths.size ()];
+                newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
             }
         }
         else if (m_runMode == TLB_RUNMODE_MINRTT)
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         else if (m_runMode == TLB_RUNMODE_RTT_COUNTER || m_runMode == TLB_RUNMODE_RTT_DRE)
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
 
         else
         {
-            newPath = candidatePaths[rand () % candidatePaths.size ()];
+            newPath = candidatePaths[m_rand->GetInteger (0, candidatePaths.size () - 1)];
         }
         NS_LOG_LOGIC ("Find Grey Path: " << newPath.pathId);
         return true;
@@ -1275,11 +1303,11 @@ Ipv4TLB::SelectRandomPath (uint32_t destTor)
     struct PathInfo newPath;
     if (!availablePaths.empty ())
     {
-        newPath = availablePaths[rand() % availablePaths.size ()];
+        newPath = availablePaths[m_rand->GetInteger (0, availablePaths.size () - 1)];
     }
     else
     {
-        uint32_t pathId = (itr->second)[rand() % (itr->second).size ()];
+        uint32_t pathId = (itr->second)[m_rand->GetInteger (0, (itr->second).size () - 1)];
         newPath = Ipv4TLB::JudgePath (destTor, pathId);
     }
     NS_LOG_LOGIC ("Random selection return path: " << newPath.pathId);
@@ -1289,12 +1317,11 @@ Ipv4TLB::SelectRandomPath (uint32_t destTor)
 struct PathInfo
 Ipv4TLB::JudgePath (uint32_t destTor, uint32_t pathId)
 {
-    std::pair<uint32_t, uint32_t> key = std::make_pair (destTor, pathId);
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.find (key);
+    TLBPathInfo *storedPathInfo = Ipv4TLB::FindPathInfo (destTor, pathId);
 
     struct PathInfo path;
     path.pathId = pathId;
-    if (itr == m_pathInfo.end ())
+    if (storedPathInfo == NULL)
     {
         path.pathType = GreyPath;
         /*path.pathType = GoodPath;*/
@@ -1306,7 +1333,8 @@ Ipv4TLB::JudgePath (uint32_t destTor, uint32_t pathId)
         path.quantifiedDre = 0;
         return path;
     }
-    TLBPathInfo pathInfo = itr->second;
+    m_dre.Update (storedPathInfo->dreValue, storedPathInfo->dreTick, Simulator::Now ());
+    TLBPathInfo pathInfo = *storedPathInfo;
     path.rttMin = pathInfo.minRtt;
     path.size = pathInfo.size;
     path.ecnPortion = static_cast<double>(pathInfo.ecnSize) / pathInfo.size;
@@ -1375,91 +1403,213 @@ Ipv4TLB::FindTorId (Ipv4Address daddr, uint32_t &destTorId)
     return true;
 }
 
+TLBFlowInfo *
+Ipv4TLB::FindFlow (uint32_t flowId)
+{
+    std::map<uint32_t, uint32_t>::iterator itr = m_flowInfo.find (flowId);
+    if (itr == m_flowInfo.end ())
+    {
+        return NULL;
+    }
+    return &m_flowSlots[itr->second];
+}
+
+TLBPathInfo *
+Ipv4TLB::FindPathInfo (uint32_t destTor, uint32_t path)
+{
+    if (destTor >= m_pathInfo.size () || path >= m_pathInfo[destTor].size ())
+    {
+        return NULL;
+    }
+    TLBPathInfo &pathInfo = m_pathInfo[destTor][path];
+    if (!pathInfo.valid)
+    {
+        return NULL;
+    }
+    Ipv4TLB::AgePath (pathInfo);
+    return &pathInfo;
+}
+
+TLBPathInfo &
+Ipv4TLB::GetPathInfo (uint32_t destTor, uint32_t path)
+{
+    TLBPathInfo *pathInfo = Ipv4TLB::FindPathInfo (destTor, path);
+    if (pathInfo != NULL)
+    {
+        return *pathInfo;
+    }
+    if (destTor >= m_pathInfo.size ())
+    {
+        m_pathInfo.resize (destTor + 1);
+    }
+    if (path >= m_pathInfo[destTor].size ())
+    {
+        TLBPathInfo emptyPathInfo = Ipv4TLB::GetInitPathInfo (0);
+        emptyPathInfo.valid = false;
+        m_pathInfo[destTor].resize (path + 1, emptyPathInfo);
+    }
+    m_pathInfo[destTor][path] = Ipv4TLB::GetInitPathInfo (path);
+    return m_pathInfo[destTor][path];
+}
+
+uint64_t
+Ipv4TLB::GetAgingTick (Time now) const
+{
+    if (!m_agingRunning || now <= m_agingStart)
+    {
+        return 0;
+    }
+    return (now - m_agingStart).GetTimeStep () / m_agingCheckTime.GetTimeStep ();
+}
+
+Time
+Ipv4TLB::GetAgingTickTime (uint64_t tick) const
+{
+    return m_agingStart + m_agingCheckTime * static_cast<int64_t> (tick);
+}
+
+uint64_t
+Ipv4TLB::GetAgingCount (uint64_t fromTick, uint64_t toTick, Time timeStamp, Time threshold, uint64_t &lastTick) const
+{
+    // The check at tick k fires if it is more than threshold after timeStamp, and then moves timeStamp to k
+    int64_t checkTime = m_agingCheckTime.GetTimeStep ();
+    int64_t expireTime = (timeStamp + threshold - m_agingStart).GetTimeStep ();
+    uint64_t firstTick = fromTick + 1;
+    if (expireTime >= 0)
+    {
+        firstTick = std::max (firstTick, static_cast<uint64_t> (expireTime / checkTime + 1));
+    }
+    if (firstTick > toTick)
+    {
+        return 0;
+    }
+    uint64_t period = threshold.GetTimeStep () / checkTime + 1;
+    uint64_t count = (toTick - firstTick) / period + 1;
+    lastTick = firstTick + (count - 1) * period;
+    return count;
+}
+
 void
-Ipv4TLB::PathAging (void)
+Ipv4TLB::AgePath (TLBPathInfo &pathInfo)
 {
-    NS_LOG_LOGIC (this << " Path Info: " << (Simulator::Now ()));
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.begin ();
-    for ( ; itr != m_pathInfo.end (); ++itr)
-    {
-        NS_LOG_LOGIC ("<" << (itr->first).first << "," << (itr->first).second << ">");
-        NS_LOG_LOGIC ("\t" << " Size: " << (itr->second).size
-                           << " ECN Size: " << (itr->second).ecnSize
-                           << " Min RTT: " << (itr->second).minRtt
-                           << " Is Retransmission: " << (itr->second).isRetransmission
-                           << " Is HRetransmission: " << (itr->second).isHighRetransmission
-                           << " Is Timeout: " << (itr->second).isTimeout
-                           << " Is VTimeout: " << (itr->second).isVeryTimeout
-                           << " Is ProbingTimeout: " << (itr->second).isProbingTimeout
-                           << " Flow Counter: " << (itr->second).flowCounter);
-        if (Simulator::Now() - (itr->second).timeStamp1 > m_T1)
-        {
-            (itr->second).size = 1;
-            (itr->second).ecnSize = 0;
-            (itr->second).isTimeout = false;
-            (itr->second).timeStamp1 = Simulator::Now ();
-        }
-        if (Simulator::Now () - (itr->second).timeStamp2 > m_T2)
-        {
-            (itr->second).isRetransmission = false;
-            (itr->second).isHighRetransmission = false;
-            (itr->second).isVeryTimeout = false;
-            (itr->second).isProbingTimeout = false;
-            (itr->second).timeStamp2 = Simulator::Now ();
-        }
-        if (Simulator::Now () - (itr->second).timeStamp3 > m_T1)
+    // Replay the periodic checks which have happened since the last access
+    uint64_t tick = Ipv4TLB::GetAgingTick (Simulator::Now ());
+    if (tick <= pathInfo.agingTick)
+    {
+        return;
+    }
+
+    uint64_t lastTick = 0;
+    if (Ipv4TLB::GetAgingCount (pathInfo.agingTick, tick, pathInfo.timeStamp1, m_T1, lastTick) > 0)
+    {
+        pathInfo.size = 1;
+        pathInfo.ecnSize = 0;
+        pathInfo.isTimeout = false;
+        pathInfo.timeStamp1 = Ipv4TLB::GetAgingTickTime (lastTick);
+    }
+    if (Ipv4TLB::GetAgingCount (pathInfo.agingTick, tick, pathInfo.timeStamp2, m_T2, lastTick) > 0)
+    {
+        pathInfo.isRetransmission = false;
+        pathInfo.isHighRetransmission = false;
+        pathInfo.isVeryTimeout = false;
+        pathInfo.isProbingTimeout = false;
+        pathInfo.timeStamp2 = Ipv4TLB::GetAgingTickTime (lastTick);
+    }
+    uint64_t count = Ipv4TLB::GetAgingCount (pathInfo.agingTick, tick, pathInfo.timeStamp3, m_T1, lastTick);
+    if (count > 0)
+    {
+        if (m_isSmooth)
         {
-            if (m_isSmooth)
+            Time desiredRtt = m_minRtt * m_smoothDesired / SMOOTH_BASE;
+            for (uint64_t i = 0; i < count && pathInfo.minRtt != desiredRtt; i++)
             {
-                Time desiredRtt = m_minRtt * m_smoothDesired / SMOOTH_BASE;
-                if ((itr->second).minRtt < desiredRtt)
+                if (pathInfo.minRtt < desiredRtt)
                 {
-                    (itr->second).minRtt = std::min (desiredRtt, (itr->second).minRtt * m_smoothBeta1 / SMOOTH_BASE);
+                    pathInfo.minRtt = std::min (desiredRtt, pathInfo.minRtt * m_smoothBeta1 / SMOOTH_BASE);
                 }
                 else
                 {
-                    (itr->second).minRtt = std::max (desiredRtt, (itr->second).minRtt * m_smoothBeta2 / SMOOTH_BASE);
+                    pathInfo.minRtt = std::max (desiredRtt, pathInfo.minRtt * m_smoothBeta2 / SMOOTH_BASE);
                 }
             }
-            else
-            {
-                (itr->second).minRtt = Seconds (666);
-            }
-            (itr->second).timeStamp3 = Simulator::Now ();
         }
-
-        /*
-        if (Simulator::Now () - (itr->second).epTimeStamp > m_epAgingTime)
+        else
         {
-            (itr->second).epAckSize = 1;
-            (itr->second).epEcnSize = 0;
-            (itr->second).epEcnPortion = m_epDefaultEcnPortion;
-            (itr->second).epTimeStamp = Simulator::Now ();
+            pathInfo.minRtt = Seconds (666);
         }
-        */
+        pathInfo.timeStamp3 = Ipv4TLB::GetAgingTickTime (lastTick);
+    }
+
+    /*
+    if (Simulator::Now () - pathInfo.epTimeStamp > m_epAgingTime)
+    {
+        pathInfo.epAckSize = 1;
+        pathInfo.epEcnSize = 0;
+        pathInfo.epEcnPortion = m_epDefaultEcnPortion;
+        pathInfo.epTimeStamp = Simulator::Now ();
     }
+    */
+
+    pathInfo.agingTick = tick;
+}
 
-    std::map<uint32_t, TLBFlowInfo>::iterator itr2 = m_flowInfo.begin ();
-    for ( ; itr2 != m_flowInfo.end (); ++itr2)
+void
+Ipv4TLB::ScheduleFlowAging (uint32_t slot)
+{
+    TLBFlowInfo &flowInfo = m_flowSlots[slot];
+    if (flowInfo.inWheel)
     {
-        if (Simulator::Now () - (itr2->second).liveTime >= m_flowDieTime)
-        {
-            Ipv4TLB::RemoveFlowFromPath ((itr2->second).flowId, (itr2->second).destTor, (itr2->second).path);
-            m_flowInfo.erase (itr2);
-        }
+        // The pending check will see the new live time
+        return;
+    }
+    // The flow dies at the first check at least m_flowDieTime after its live time
+    int64_t checkTime = m_agingCheckTime.GetTimeStep ();
+    int64_t dieTime = (flowInfo.liveTime + m_flowDieTime - m_agingStart).GetTimeStep ();
+    uint64_t dieTick = dieTime > 0 ? static_cast<uint64_t> ((dieTime + checkTime - 1) / checkTime) : 1;
+    dieTick = std::max (dieTick, m_flowWheelTick + 1);
+    m_flowWheel[dieTick % FLOW_WHEEL_SIZE].push_back (slot);
+    flowInfo.inWheel = true;
+}
 
-        /*
-        else if (Simulator::Now () - (itr2->second).epTimeStamp > m_epAgingTime)
+void
+Ipv4TLB::AgeFlows (void)
+{
+    uint64_t tick = Ipv4TLB::GetAgingTick (Simulator::Now ());
+    if (tick <= m_flowWheelTick)
+    {
+        return;
+    }
+
+    // Visit each due bucket once, the flows which are still alive are pushed to their new die tick
+    uint64_t steps = std::min<uint64_t> (tick - m_flowWheelTick, FLOW_WHEEL_SIZE);
+    uint64_t wheelTick = m_flowWheelTick;
+    m_flowWheelTick = tick;
+    for (uint64_t i = 1; i <= steps; i++)
+    {
+        std::vector<uint32_t> bucket;
+        bucket.swap (m_flowWheel[(wheelTick + i) % FLOW_WHEEL_SIZE]);
+        std::vector<uint32_t>::iterator itr = bucket.begin ();
+        for ( ; itr != bucket.end (); ++itr)
         {
-            (itr2->second).epAckSize = 1;
-            (itr2->second).epEcnSize = 0;
-            (itr2->second).epEcnPortion = m_epDefaultEcnPortion;
-            (itr2->second).epTimeStamp = Simulator::Now ();
+            uint32_t slot = *itr;
+            TLBFlowInfo &flowInfo = m_flowSlots[slot];
+            flowInfo.inWheel = false;
+            if (!flowInfo.inUse)
+            {
+                continue;
+            }
+            if (Ipv4TLB::GetAgingTickTime (tick) - flowInfo.liveTime < m_flowDieTime)
+            {
+                Ipv4TLB::ScheduleFlowAging (slot);
+                continue;
+            }
+            NS_LOG_LOGIC (this << " Flow: " << flowInfo.flowId << " dies");
+            Ipv4TLB::RemoveFlowFromPath (flowInfo.flowId, flowInfo.destTor, flowInfo.path);
+            m_flowInfo.erase (flowInfo.flowId);
+            flowInfo.inUse = false;
+            m_freeFlowSlots.push_back (slot);
         }
-        */
     }
-
-    m_agingEvent = Simulator::Schedule (m_agingCheckTime, &Ipv4TLB::PathAging, this);
 }
 
 std::vector<PathInfo>
@@ -1483,17 +1633,24 @@ Ipv4TLB::GatherParallelPaths (uint32_t destTor)
 }
 
 void
-Ipv4TLB::DreAging (void)
+Ipv4TLB::TracePathSelect (uint32_t flowId, uint32_t fromTor, uint32_t toTor, bool isRandom, const PathInfo &info)
 {
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo>::iterator itr = m_pathInfo.begin ();
-    for ( ; itr != m_pathInfo.end (); ++itr)
+    // Judging every parallel path is expensive, skip it if nobody listens
+    if (m_pathSelectTrace.IsEmpty ())
     {
-        NS_LOG_LOGIC ("<" << (itr->first).first << "," << (itr->first).second << ">");
-        (itr->second).dreValue *= (1 - m_dreAlpha);
-        NS_LOG_LOGIC ("\tDre value :" << Ipv4TLB::QuantifyDre ((itr->second).dreValue));
+        return;
     }
+    m_pathSelectTrace (flowId, fromTor, toTor, info.pathId, isRandom, info, Ipv4TLB::GatherParallelPaths (toTor));
+}
 
-    m_dreEvent = Simulator::Schedule (m_dreTime, &Ipv4TLB::DreAging, this);
+void
+Ipv4TLB::TracePathChange (uint32_t flowId, uint32_t fromTor, uint32_t toTor, uint32_t newPath, uint32_t oldPath, bool isRandom)
+{
+    if (m_pathChangeTrace.IsEmpty ())
+    {
+        return;
+    }
+    m_pathChangeTrace (flowId, fromTor, toTor, newPath, oldPath, isRandom, Ipv4TLB::GatherParallelPaths (toTor));
 }
 
 uint32_t
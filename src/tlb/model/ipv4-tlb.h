@@ -7,7 +7,9 @@
 #include "ns3/traced-value.h"
 #include "ns3/ipv4-address.h"
 #include "ns3/data-rate.h"
-#include "ns3/event-id.h"
+#include "ns3/flowlet-table.h"
+#include "ns3/lazy-dre.h"
+#include "ns3/random-variable-stream.h"
 #include "tlb-flow-info.h"
 #include "tlb-path-info.h"
 
@@ -41,11 +43,6 @@ struct PathInfo {
     uint32_t quantifiedDre;
 };
 
-struct TLBAcklet {
-    uint32_t pathId;
-    Time activeTime;
-};
-
 class Node;
 
 class Ipv4TLB : public Object
@@ -90,6 +87,15 @@ public:
     // Node
     void SetNode (Ptr<Node> node);
 
+    /**
+     * Assign a fixed random variable stream number to the random variables
+     * used by this model.
+     *
+     * \param stream first stream index to use
+     * \return the number of stream indices assigned by this model
+     */
+    int64_t AssignStreams (int64_t stream);
+
     static std::string GetPathType (PathType type);
 
     static std::string GetLogo (void);
@@ -133,12 +139,32 @@ private:
 
     bool FindTorId (Ipv4Address daddr, uint32_t &destTorId);
 
-    void PathAging (void);
+    // Flow and path tables
+    TLBFlowInfo *FindFlow (uint32_t flowId);
+
+    TLBPathInfo *FindPathInfo (uint32_t destTor, uint32_t path);
+
+    TLBPathInfo &GetPathInfo (uint32_t destTor, uint32_t path);
+
+    // Aging, the ticks are counted in m_agingCheckTime since the first path selection
+    uint64_t GetAgingTick (Time now) const;
+
+    Time GetAgingTickTime (uint64_t tick) const;
+
+    uint64_t GetAgingCount (uint64_t fromTick, uint64_t toTick, Time timeStamp, Time threshold, uint64_t &lastTick) const;
+
+    void AgePath (TLBPathInfo &pathInfo);
 
-    void DreAging (void);
+    void AgeFlows (void);
+
+    void ScheduleFlowAging (uint32_t slot);
 
     std::vector<PathInfo> GatherParallelPaths (uint32_t destTor);
 
+    void TracePathSelect (uint32_t flowId, uint32_t fromTor, uint32_t toTor, bool isRandom, const PathInfo &info);
+
+    void TracePathChange (uint32_t flowId, uint32_t fromTor, uint32_t toTor, uint32_t newPath, uint32_t oldPath, bool isRandom);
+
     uint32_t QuantifyRtt (Time rtt);
     uint32_t QuantifyDre (uint32_t dre);
 
@@ -169,6 +195,8 @@ private:
 
     uint32_t m_dreMultiply;
 
+    bool m_dreExact;
+
     Time m_minRtt;
 
     Time m_highRtt;
@@ -222,10 +250,20 @@ private:
     double m_ecnBeta;
 
     // Variables
-    std::map<uint32_t, TLBFlowInfo> m_flowInfo; /* <FlowId, TLBFlowInfo> */
-    std::map<std::pair<uint32_t, uint32_t>, TLBPathInfo> m_pathInfo; /* <DestTorId, PathId>, TLBPathInfo> */
+    std::map<uint32_t, uint32_t> m_flowInfo; /* <FlowId, Slot> */
+    std::vector<TLBFlowInfo> m_flowSlots;
+    std::vector<uint32_t> m_freeFlowSlots;
+
+    std::vector<std::vector<TLBPathInfo> > m_pathInfo; /* [DestTorId][PathId] */
 
-    std::map<uint32_t, TLBAcklet> m_acklets; /* <FlowId, TLBAcklet> */
+    // Flow aging timer wheel, each bucket holds the slots to check at its tick
+    std::vector<std::vector<uint32_t> > m_flowWheel;
+    uint64_t m_flowWheelTick;
+
+    bool m_agingRunning;
+    Time m_agingStart;
+
+    Ptr<FlowletTable> m_acklets; /* <FlowId, PathId> */
 
     std::map<Ipv4Address, uint32_t> m_ipTorMap; /* <DestAddress, DestTorId> */
 
@@ -233,23 +271,24 @@ private:
 
     std::map<uint32_t, Ipv4Address> m_probingAgent; /* <DestTorId, ProbingAgentAddress>*/
 
-    EventId m_agingEvent;
-
-    EventId m_dreEvent;
+    LazyDre m_dre; /* Path DREs are decayed on access */
 
     Ptr<Node> m_node;
 
+    Ptr<UniformRandomVariable> m_rand; /* Random path choices */
+
     std::map<uint32_t, Time> m_pauseTime; // Used in the TCP pause, not mandatory
 
+    // The parallel paths are only gathered when a sink is connected
     typedef void (* TLBPathCallback) (uint32_t flowId, uint32_t fromTor,
-            uint32_t toTor, uint32_t path, bool isRandom, PathInfo info, std::vector<PathInfo> parallelPaths);
+            uint32_t toTor, uint32_t path, bool isRandom, const PathInfo &info, const std::vector<PathInfo> &parallelPaths);
 
     typedef void (* TLBPathChangeCallback) (uint32_t flowId, uint32_t fromTor, uint32_t toTor,
-            uint32_t newPath, uint32_t oldPath, bool isRandom, std::vector<PathInfo> parallelPaths);
+            uint32_t newPath, uint32_t oldPath, bool isRandom, const std::vector<PathInfo> &parallelPaths);
 
-    TracedCallback <uint32_t, uint32_t, uint32_t, uint32_t, bool, PathInfo, std::vector<PathInfo> > m_pathSelectTrace;
+    TracedCallback <uint32_t, uint32_t, uint32_t, uint32_t, bool, const PathInfo &, const std::vector<PathInfo> &> m_pathSelectTrace;
 
-    TracedCallback <uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, bool, std::vector<PathInfo> > m_pathChangeTrace;
+    TracedCallback <uint32_t, uint32_t, uint32_t, uint32_t, uint32_t, bool, const std::vector<PathInfo> &> m_pathChangeTrace;
 
 
 };
@@ -1,4 +1,5 @@
 #include "ns3/tcp-tlb-tag.h"
+#include "ns3/packet.h"
 
 namespace ns3 {
 
@@ -77,4 +78,34 @@ TcpTLBTag::Print (std::ostream &os) const
         <<" time: " << m_time;
 }
 
+bool
+TcpTLBTag::PeekFrom (Ptr<const Packet> packet)
+{
+    const LbMetadata &metadata = packet->GetLbMetadata ();
+    if (!metadata.Has (LbMetadata::TLB))
+    {
+        return false;
+    }
+    m_path = metadata.GetTlbPath ();
+    m_time = metadata.GetTlbTime ();
+    return true;
+}
+
+void
+TcpTLBTag::AddTo (Ptr<const Packet> packet) const
+{
+    packet->GetLbMetadata ().SetTlb (m_path, m_time);
+}
+
+bool
+TcpTLBTag::RemoveFrom (Ptr<const Packet> packet)
+{
+    if (!PeekFrom (packet))
+    {
+        return false;
+    }
+    packet->GetLbMetadata ().Remove (LbMetadata::TLB);
+    return true;
+}
+
 }
@@ -2,10 +2,13 @@
 #define TCP_TLB_TAG_H
 
 #include "ns3/tag.h"
+#include "ns3/ptr.h"
 #include "ns3/nstime.h"
 
 namespace ns3 {
 
+class Packet;
+
 class TcpTLBTag : public Tag
 {
 public:
@@ -32,6 +35,13 @@ public:
 
     virtual void Print (std::ostream &os) const;
 
+    // Adapters on the LbMetadata of the packet, AddTo replaces an existing value
+    bool PeekFrom (Ptr<const Packet> packet);
+
+    void AddTo (Ptr<const Packet> packet) const;
+
+    bool RemoveFrom (Ptr<const Packet> packet);
+
 private:
     uint32_t m_path;
 
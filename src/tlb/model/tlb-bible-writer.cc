@@ -0,0 +1,120 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+
+#include "tlb-bible-writer.h"
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("TLBBibleWriter");
+
+const uint16_t TLBBibleWriter::VERSION;
+const uint32_t TLBBibleWriter::FILE_HEADER_SIZE;
+const uint32_t TLBBibleWriter::RECORD_HEADER_SIZE;
+const uint32_t TLBBibleWriter::PATH_SIZE;
+
+TLBBibleWriter::TLBBibleWriter ()
+    : m_recordCount (0)
+{
+}
+
+TLBBibleWriter::~TLBBibleWriter ()
+{
+    Close ();
+}
+
+bool
+TLBBibleWriter::Open (std::string filename)
+{
+    if (!m_out.Open (filename, "TLBB", VERSION))
+    {
+        NS_LOG_ERROR ("Cannot open the TLB bible file: " << filename);
+        return false;
+    }
+    m_recordCount = 0;
+    return true;
+}
+
+void
+TLBBibleWriter::Close (void)
+{
+    m_out.Close ();
+}
+
+void
+TLBBibleWriter::Flush (void)
+{
+    m_out.Flush ();
+}
+
+void
+TLBBibleWriter::PathSelect (uint32_t flowId, uint32_t fromTor, uint32_t toTor, uint32_t path,
+        bool isRandom, const PathInfo &info, const std::vector<PathInfo> &parallelPaths)
+{
+    if (!m_out.IsOpen ())
+    {
+        return;
+    }
+    WriteHeader (RECORD_SELECT, isRandom, parallelPaths.size (), flowId, fromTor, toTor, path, path);
+    WritePath (info);
+    std::vector<PathInfo>::const_iterator itr = parallelPaths.begin ();
+    for ( ; itr != parallelPaths.end (); ++itr)
+    {
+        WritePath (*itr);
+    }
+}
+
+void
+TLBBibleWriter::PathChange (uint32_t flowId, uint32_t fromTor, uint32_t toTor, uint32_t newPath,
+        uint32_t oldPath, bool isRandom, const std::vector<PathInfo> &parallelPaths)
+{
+    if (!m_out.IsOpen ())
+    {
+        return;
+    }
+    WriteHeader (RECORD_CHANGE, isRandom, parallelPaths.size (), flowId, fromTor, toTor, newPath, oldPath);
+    std::vector<PathInfo>::const_iterator itr = parallelPaths.begin ();
+    for ( ; itr != parallelPaths.end (); ++itr)
+    {
+        WritePath (*itr);
+    }
+}
+
+uint64_t
+TLBBibleWriter::GetRecordCount (void) const
+{
+    return m_recordCount;
+}
+
+void
+TLBBibleWriter::WriteHeader (RecordType type, bool isRandom, uint32_t pathCount, uint32_t flowId,
+        uint32_t fromTor, uint32_t toTor, uint32_t newPath, uint32_t oldPath)
+{
+    m_recordCount++;
+    m_out.WriteU8 (type);
+    m_out.WriteU8 (isRandom ? 1 : 0);
+    m_out.WriteU16 (pathCount);
+    m_out.WriteU32 (flowId);
+    m_out.WriteU64 (Simulator::Now ().GetNanoSeconds ());
+    m_out.WriteU32 (fromTor);
+    m_out.WriteU32 (toTor);
+    m_out.WriteU32 (newPath);
+    m_out.WriteU32 (oldPath);
+}
+
+void
+TLBBibleWriter::WritePath (const PathInfo &info)
+{
+    m_out.WriteU32 (info.pathId);
+    m_out.WriteU8 (info.pathType);
+    m_out.WriteU8 (0);
+    m_out.WriteU16 (0);
+    m_out.WriteU64 (info.rttMin.GetNanoSeconds ());
+    m_out.WriteU32 (info.size);
+    m_out.WriteU32 (info.counter);
+    m_out.WriteU32 (info.quantifiedDre);
+    m_out.WriteU32 (static_cast<uint32_t> (info.ecnPortion * 1000000));
+}
+
+}
@@ -0,0 +1,88 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+#ifndef TLB_BIBLE_WRITER_H
+#define TLB_BIBLE_WRITER_H
+
+#include "ipv4-tlb.h"
+
+#include "ns3/binary-file-writer.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \brief Binary sink for the Ipv4TLB SelectPath and ChangePath traces
+ *
+ * All the integers are little endian. The file starts with the magic "TLBB",
+ * a uint16_t version and a uint16_t reserved field. Then each record is:
+ *
+ *   uint8_t  type (RECORD_SELECT or RECORD_CHANGE)
+ *   uint8_t  isRandom
+ *   uint16_t number of parallel paths
+ *   uint32_t flowId
+ *   int64_t  time in ns
+ *   uint32_t fromTor, toTor, newPath, oldPath (oldPath == newPath for a selection)
+ *
+ * followed, for a selection, by the selected path and then by the parallel
+ * paths, each one being PATH_SIZE bytes:
+ *
+ *   uint32_t pathId
+ *   uint8_t  pathType, 3 bytes of padding
+ *   int64_t  rttMin in ns
+ *   uint32_t size, counter, quantifiedDre
+ *   uint32_t ecnPortion in millionths
+ */
+class TLBBibleWriter
+{
+public:
+
+    static const uint16_t VERSION = 1;
+    static const uint32_t FILE_HEADER_SIZE = 8;
+    static const uint32_t RECORD_HEADER_SIZE = 32;
+    static const uint32_t PATH_SIZE = 32;
+
+    enum RecordType {
+        RECORD_SELECT = 1,
+        RECORD_CHANGE = 2,
+    };
+
+    TLBBibleWriter ();
+
+    ~TLBBibleWriter ();
+
+    /**
+     * Truncate the file and write the file header.
+     */
+    bool Open (std::string filename);
+
+    void Close (void);
+
+    void Flush (void);
+
+    // The signatures match Ipv4TLB::TLBPathCallback and Ipv4TLB::TLBPathChangeCallback
+    void PathSelect (uint32_t flowId, uint32_t fromTor, uint32_t toTor, uint32_t path,
+            bool isRandom, const PathInfo &info, const std::vector<PathInfo> &parallelPaths);
+
+    void PathChange (uint32_t flowId, uint32_t fromTor, uint32_t toTor, uint32_t newPath,
+            uint32_t oldPath, bool isRandom, const std::vector<PathInfo> &parallelPaths);
+
+    uint64_t GetRecordCount (void) const;
+
+private:
+
+    TLBBibleWriter (const TLBBibleWriter &);
+    TLBBibleWriter &operator = (const TLBBibleWriter &);
+
+    void WriteHeader (RecordType type, bool isRandom, uint32_t pathCount, uint32_t flowId,
+            uint32_t fromTor, uint32_t toTor, uint32_t newPath, uint32_t oldPath);
+
+    void WritePath (const PathInfo &info);
+
+    BinaryFileWriter m_out;
+    uint64_t m_recordCount;
+};
+
+}
+
+#endif /* TLB_BIBLE_WRITER_H */
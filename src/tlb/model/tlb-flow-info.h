@@ -24,6 +24,10 @@ public:
   Time activeTime;
   // --
 
+  // Slot state in the Ipv4TLB flow table
+  bool inUse;
+  bool inWheel;
+
   // Added at Jan 12nd
 //  Time tlbFlowletActiveTime;
   // --
@@ -22,6 +22,9 @@ public:
   Time timeStamp2;
   Time timeStamp3;
   uint32_t dreValue;
+  uint64_t dreTick;
+  uint64_t agingTick; // The last aging tick applied to this path
+  bool valid;
 
   // Added at Jan 11st
   /*
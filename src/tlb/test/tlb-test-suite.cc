@@ -3,9 +3,16 @@
 // Include a header file from your module to test.
 #include "ns3/ipv4-tlb.h"
 
+#include "ns3/tlb-bible-writer.h"
+#include "ns3/simulator.h"
+
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include <fstream>
+#include <iterator>
+#include <vector>
+
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
 using namespace ns3;
@@ -46,6 +53,143 @@ TlbTestCase1::DoRun (void)
   NS_TEST_ASSERT_MSG_EQ_TOL (0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Check the layout of the binary TLB bible
+class TlbBibleWriterTestCase : public TestCase
+{
+public:
+  TlbBibleWriterTestCase ();
+
+private:
+  virtual void DoRun (void);
+  uint32_t ReadU32 (const std::vector<uint8_t> &data, uint32_t offset);
+};
+
+TlbBibleWriterTestCase::TlbBibleWriterTestCase ()
+  : TestCase ("Check the records written by the TLB bible writer")
+{
+}
+
+uint32_t
+TlbBibleWriterTestCase::ReadU32 (const std::vector<uint8_t> &data, uint32_t offset)
+{
+  return data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | (data[offset + 3] << 24);
+}
+
+void
+TlbBibleWriterTestCase::DoRun (void)
+{
+  std::string filename = CreateTempDirFilename ("tlb-bible.bin");
+
+  PathInfo path;
+  path.pathId = 7;
+  path.pathType = GreyPath;
+  path.rttMin = MicroSeconds (60);
+  path.size = 1500;
+  path.ecnPortion = 0.5;
+  path.counter = 2;
+  path.quantifiedDre = 3;
+
+  std::vector<PathInfo> parallelPaths;
+  parallelPaths.push_back (path);
+  parallelPaths.push_back (path);
+
+  TLBBibleWriter writer;
+  NS_TEST_ASSERT_MSG_EQ (writer.Open (filename), true, "Cannot open " << filename);
+  writer.PathSelect (100, 1, 2, 7, false, path, parallelPaths);
+  writer.PathChange (100, 1, 2, 8, 7, true, parallelPaths);
+  NS_TEST_ASSERT_MSG_EQ (writer.GetRecordCount (), 2, "Two records should be written");
+  writer.Close ();
+
+  std::ifstream in (filename.c_str (), std::ios::in | std::ios::binary);
+  std::vector<uint8_t> data ((std::istreambuf_iterator<char> (in)), std::istreambuf_iterator<char> ());
+
+  uint32_t selectSize = TLBBibleWriter::RECORD_HEADER_SIZE + 3 * TLBBibleWriter::PATH_SIZE;
+  uint32_t changeSize = TLBBibleWriter::RECORD_HEADER_SIZE + 2 * TLBBibleWriter::PATH_SIZE;
+  NS_TEST_ASSERT_MSG_EQ (data.size (), TLBBibleWriter::FILE_HEADER_SIZE + selectSize + changeSize, "Unexpected file size");
+  NS_TEST_EXPECT_MSG_EQ (data[0], 'T', "Bad magic");
+  NS_TEST_EXPECT_MSG_EQ (data[3], 'B', "Bad magic");
+
+  uint32_t select = TLBBibleWriter::FILE_HEADER_SIZE;
+  NS_TEST_EXPECT_MSG_EQ (data[select], TLBBibleWriter::RECORD_SELECT, "Bad record type");
+  NS_TEST_EXPECT_MSG_EQ (data[select + 2], 2, "Bad parallel path count");
+  NS_TEST_EXPECT_MSG_EQ (ReadU32 (data, select + 4), 100, "Bad flow id");
+  NS_TEST_EXPECT_MSG_EQ (ReadU32 (data, select + 24), 7, "Bad selected path");
+
+  uint32_t selectedPath = select + TLBBibleWriter::RECORD_HEADER_SIZE;
+  NS_TEST_EXPECT_MSG_EQ (ReadU32 (data, selectedPath), 7, "Bad path id");
+  NS_TEST_EXPECT_MSG_EQ (data[selectedPath + 4], GreyPath, "Bad path type");
+  NS_TEST_EXPECT_MSG_EQ (ReadU32 (data, selectedPath + 8), 60000, "Bad min RTT");
+  NS_TEST_EXPECT_MSG_EQ (ReadU32 (data, selectedPath + 28), 500000, "Bad ECN portion");
+
+  uint32_t change = select + selectSize;
+  NS_TEST_EXPECT_MSG_EQ (data[change], TLBBibleWriter::RECORD_CHANGE, "Bad record type");
+  NS_TEST_EXPECT_MSG_EQ (data[change + 1], 1, "Bad random flag");
+  NS_TEST_EXPECT_MSG_EQ (ReadU32 (data, change + 24), 8, "Bad new path");
+  NS_TEST_EXPECT_MSG_EQ (ReadU32 (data, change + 28), 7, "Bad old path");
+}
+
+// Check that idle flows are aged out of the flow table
+class TlbFlowAgingTestCase : public TestCase
+{
+public:
+  TlbFlowAgingTestCase ();
+
+private:
+  virtual void DoRun (void);
+  void PathSelected (uint32_t flowId, uint32_t fromTor, uint32_t toTor, uint32_t path,
+                     bool isRandom, const PathInfo &info, const std::vector<PathInfo> &parallelPaths);
+  void GetPath (uint32_t flowId);
+
+  Ptr<Ipv4TLB> m_tlb;
+  uint32_t m_selections;
+};
+
+TlbFlowAgingTestCase::TlbFlowAgingTestCase ()
+  : TestCase ("Check the TLB flow aging"),
+    m_selections (0)
+{
+}
+
+void
+TlbFlowAgingTestCase::PathSelected (uint32_t flowId, uint32_t fromTor, uint32_t toTor, uint32_t path,
+                                    bool isRandom, const PathInfo &info, const std::vector<PathInfo> &parallelPaths)
+{
+  m_selections++;
+}
+
+void
+TlbFlowAgingTestCase::GetPath (uint32_t flowId)
+{
+  m_tlb->GetPath (flowId, Ipv4Address ("10.1.1.1"), Ipv4Address ("10.1.2.1"));
+}
+
+void
+TlbFlowAgingTestCase::DoRun (void)
+{
+  m_tlb = CreateObject<Ipv4TLB> ();
+  m_tlb->AddAddressWithTor (Ipv4Address ("10.1.1.1"), 1);
+  m_tlb->AddAddressWithTor (Ipv4Address ("10.1.2.1"), 2);
+  m_tlb->AddAvailPath (2, 1);
+  m_tlb->AddAvailPath (2, 2);
+  m_tlb->TraceConnectWithoutContext ("SelectPath", MakeCallback (&TlbFlowAgingTestCase::PathSelected, this));
+
+  // The flows die 1ms after their last acknowledgement
+  Simulator::Schedule (MicroSeconds (0), &TlbFlowAgingTestCase::GetPath, this, 1);
+  Simulator::Schedule (MicroSeconds (10), &TlbFlowAgingTestCase::GetPath, this, 2);
+  Simulator::Schedule (MicroSeconds (500), &TlbFlowAgingTestCase::GetPath, this, 1);
+  Simulator::Schedule (MicroSeconds (900), &TlbFlowAgingTestCase::GetPath, this, 2);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_selections, 2, "Live flows should keep their path");
+
+  Simulator::Schedule (MicroSeconds (2000), &TlbFlowAgingTestCase::GetPath, this, 1);
+  Simulator::Schedule (MicroSeconds (50000), &TlbFlowAgingTestCase::GetPath, this, 2);
+  Simulator::Run ();
+  NS_TEST_EXPECT_MSG_EQ (m_selections, 4, "Dead flows should select a new path");
+
+  Simulator::Destroy ();
+  m_tlb = 0;
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -61,6 +205,8 @@ TlbTestSuite::TlbTestSuite ()
 {
   // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
   AddTestCase (new TlbTestCase1, TestCase::QUICK);
+  AddTestCase (new TlbBibleWriterTestCase, TestCase::QUICK);
+  AddTestCase (new TlbFlowAgingTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
@@ -3,6 +3,7 @@
 #define IPV4_XPATH_ROUTING_H
 
 #include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4-next-hop-cache.h"
 
 #include <map>
 
@@ -34,6 +35,9 @@ public:
 private:
 
   Ptr<Ipv4> m_ipv4;
+
+  // Per port routes
+  Ipv4NextHopCache m_nextHopCache;
 };
 
 }
@@ -0,0 +1,210 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include "ns3/core-module.h"
+
+using namespace ns3;
+
+#define LOG(x)   std::cout << x << std::endl
+
+/**
+ * One scheduler operation: 'i' inserts the event, 'n' removes the next
+ * event, which should be this one, and 'r' removes the event.
+ */
+struct Op
+{
+  char op;
+  uint64_t ts;
+  uint64_t uid;
+};
+
+/**
+ * Read a trace recorded by conga-simulation-large --eventTrace, 17 bytes
+ * per operation: the op, then the uint64_t time stamp and the uint64_t uid.
+ */
+std::vector<Op>
+ReadTrace (std::string filename)
+{
+  std::vector<Op> ops;
+  std::ifstream input (filename.c_str (), std::ios::in | std::ios::binary);
+  if (!input.is_open ())
+    {
+      NS_FATAL_ERROR ("Cannot open " << filename);
+    }
+  Op op;
+  while (input.read (&op.op, sizeof (op.op))
+         && input.read (reinterpret_cast<char *> (&op.ts), sizeof (op.ts))
+         && input.read (reinterpret_cast<char *> (&op.uid), sizeof (op.uid)))
+    {
+      ops.push_back (op);
+    }
+  return ops;
+}
+
+/**
+ * Build a datacenter like trace: most events are a packet transmission a
+ * microsecond or so ahead, the others are timers a few milliseconds ahead.
+ * The MapScheduler serves as the reference order.
+ */
+std::vector<Op>
+GenerateTrace (uint32_t population, uint32_t total, double timerRatio)
+{
+  Ptr<ExponentialRandomVariable> packet = CreateObject<ExponentialRandomVariable> ();
+  packet->SetAttribute ("Mean", DoubleValue (1000));
+  Ptr<UniformRandomVariable> timer = CreateObject<UniformRandomVariable> ();
+  timer->SetAttribute ("Min", DoubleValue (1000000));
+  timer->SetAttribute ("Max", DoubleValue (10000000));
+  Ptr<UniformRandomVariable> choice = CreateObject<UniformRandomVariable> ();
+
+  std::vector<Op> ops;
+  ObjectFactory factory ("ns3::MapScheduler");
+  Ptr<Scheduler> reference = factory.Create<Scheduler> ();
+  uint64_t now = 0;
+  uint64_t uid = 0;
+  for (uint32_t i = 0; i < population + total; ++i)
+    {
+      if (i >= population)
+        {
+          Scheduler::Event ev = reference->RemoveNext ();
+          now = ev.key.m_ts;
+          Op op = { 'n', ev.key.m_ts, ev.key.m_uid };
+          ops.push_back (op);
+        }
+      double delay = choice->GetValue () < timerRatio ? timer->GetValue () : packet->GetValue ();
+      Scheduler::Event ev;
+      ev.impl = 0;
+      ev.key.m_ts = now + static_cast<uint64_t> (delay);
+      ev.key.m_uid = uid++;
+      ev.key.m_context = 0;
+      reference->Insert (ev);
+      Op op = { 'i', ev.key.m_ts, ev.key.m_uid };
+      ops.push_back (op);
+    }
+  return ops;
+}
+
+/**
+ * Replay the trace on one scheduler.
+ *
+ * \returns The number of events which did not come out in the recorded order.
+ */
+uint32_t
+Replay (Ptr<Scheduler> scheduler, const std::vector<Op> &ops)
+{
+  uint32_t mismatches = 0;
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_context = 0;
+  for (std::vector<Op>::const_iterator i = ops.begin (); i != ops.end (); ++i)
+    {
+      switch (i->op)
+        {
+        case 'i':
+          ev.key.m_ts = i->ts;
+          ev.key.m_uid = i->uid;
+          scheduler->Insert (ev);
+          break;
+        case 'n':
+          if (scheduler->RemoveNext ().key.m_uid != i->uid)
+            {
+              mismatches++;
+            }
+          break;
+        case 'r':
+          ev.key.m_ts = i->ts;
+          ev.key.m_uid = i->uid;
+          scheduler->Remove (ev);
+          break;
+        default:
+          NS_FATAL_ERROR ("Unknown operation " << i->op);
+        }
+    }
+  return mismatches;
+}
+
+int main (int argc, char *argv[])
+{
+  bool schedList = false;
+  uint32_t pop   =  100000;
+  uint32_t total = 1000000;
+  double timers  =    0.05;
+  uint32_t runs  =       3;
+  std::string filename = "";
+
+  CommandLine cmd;
+  cmd.Usage ("Benchmark the schedulers on the same sequence of operations.\n"
+             "\n"
+             "The operations are read from a trace recorded by\n"
+             "conga-simulation-large --eventTrace=<filename>, given by the\n"
+             "--file=\"<filename>\" argument, or generated: after the initial\n"
+             "population, each event removed schedules a packet event\n"
+             "about 1 us ahead, or a timer 1 to 10 ms ahead.");
+  cmd.AddValue ("list",   "also run the ListScheduler",                   schedList);
+  cmd.AddValue ("pop",    "generated event population (default 1E5)",     pop);
+  cmd.AddValue ("total",  "generated events removed (default 1E6)",       total);
+  cmd.AddValue ("timers", "generated share of timers (default 0.05)",     timers);
+  cmd.AddValue ("runs",   "number of runs per scheduler (default 3)",     runs);
+  cmd.AddValue ("file",   "trace of scheduler operations",                filename);
+  cmd.Parse (argc, argv);
+
+  std::vector<Op> ops = filename == "" ? GenerateTrace (pop, total, timers) : ReadTrace (filename);
+  LOG ("operations: " << ops.size ());
+
+  std::vector<std::string> schedulers;
+  if (schedList)
+    {
+      schedulers.push_back ("ns3::ListScheduler");
+    }
+  schedulers.push_back ("ns3::MapScheduler");
+  schedulers.push_back ("ns3::HeapScheduler");
+  schedulers.push_back ("ns3::CalendarScheduler");
+  schedulers.push_back ("ns3::TimingWheelScheduler");
+
+  LOG (std::left << std::setw (28) << "Scheduler" <<
+       std::setw (12) << "Time (s)" <<
+       std::setw (14) << "Rate (op/s)" <<
+       std::setw (12) << "Per (ns/op)" <<
+       "Out of order");
+  for (std::vector<std::string>::const_iterator i = schedulers.begin (); i != schedulers.end (); ++i)
+    {
+      ObjectFactory factory (*i);
+      double best = 0;
+      uint32_t mismatches = 0;
+      for (uint32_t run = 0; run < runs; ++run)
+        {
+          Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+          SystemWallClockMs time;
+          time.Start ();
+          mismatches = Replay (scheduler, ops);
+          double elapsed = time.End () / 1000.0;
+          if (run == 0 || elapsed < best)
+            {
+              best = elapsed;
+            }
+        }
+      LOG (std::left << std::setw (28) << *i <<
+           std::setw (12) << best <<
+           std::setw (14) << (best > 0 ? ops.size () / best : 0) <<
+           std::setw (12) << best * 1e9 / ops.size () <<
+           mismatches);
+    }
+  return 0;
+}